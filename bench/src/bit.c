@@ -0,0 +1,90 @@
+#include "mm/bench.h"
+#include "mm/bit.h"
+#include "mm/random.h"
+
+#define WORDS ( 1u << 14 )
+#define ROUNDS 1024
+
+static uint_least64_t *words;
+static uint_least64_t *masks;
+
+// about half the bits set, the portable loops pay per set bit
+static bool setup( void ) {
+	struct mm_random r;
+
+	words = MM_MALLOC( sizeof( *words ) * WORDS );
+	masks = MM_MALLOC( sizeof( *masks ) * WORDS );
+
+	if ( !words || !masks ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < WORDS; ++i ) {
+		words[ i ] = mm_random_u64( &r ) | 1;
+		masks[ i ] = mm_random_u64( &r );
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( words );
+	MM_FREE( masks );
+}
+
+// the array stays in L1 and L2, every result feeds a sum so nothing is hoisted out of the loop
+#define MEASURE( name, expr )\
+	do {\
+		uint_least64_t start = mm_bench_now();\
+		uint_least64_t sum = 0;\
+		\
+		for ( size_t round = 0; round < ROUNDS; ++round ) {\
+			for ( size_t i = 0; i < WORDS; ++i ) {\
+				uint_least64_t w = words[ i ];\
+				uint_least64_t m = masks[ i ];\
+				\
+				( void ) m;\
+				sum += ( expr );\
+			}\
+			\
+			MM_BENCH_KEEP( sum );\
+		}\
+		\
+		mm_bench_report( name, ( double ) ROUNDS * WORDS, mm_bench_now() - start );\
+	} while( 0 )
+
+MM_BENCH_CASE( bit_count_bench, setup, teardown ) {
+	MEASURE( "mm_popcount_u64", mm_popcount_u64( w ) );
+	MEASURE( "mm_popcount_u32", mm_popcount_u32( ( uint_least32_t ) w ) );
+	MEASURE( "mm_parity_u64", mm_parity_u64( w ) );
+	MEASURE( "mm_clz_u64", mm_clz_u64( w ) );
+	MEASURE( "mm_ctz_u64", mm_ctz_u64( w ) );
+}
+
+MM_BENCH_CASE( bit_pow2_bench, setup, teardown ) {
+	MEASURE( "mm_bit_floor_log2_u64", mm_bit_floor_log2_u64( w ) );
+	MEASURE( "mm_bit_ceil_pow2_u64", mm_bit_ceil_pow2_u64( w >> 1 ) );
+	MEASURE( "mm_bit_ceil_pow2_u32", mm_bit_ceil_pow2_u32( ( uint_least32_t ) w >> 1 ) );
+}
+
+MM_BENCH_CASE( bit_pdep_bench, setup, teardown ) {
+	mm_log( MM_INFO, "  BMI2 %s", mm_bit_native_pdep() ? "in use" : "not in use" );
+	MEASURE( "mm_bit_pdep_u64", mm_bit_pdep_u64( w, m ) );
+	MEASURE( "mm_bit_pext_u64", mm_bit_pext_u64( w, m ) );
+	MEASURE( "mm_bit_pdep_soft", mm_bit_pdep_soft( w, m ) );
+	MEASURE( "mm_bit_pext_soft", mm_bit_pext_soft( w, m ) );
+}
+
+MM_BENCH_CASE( bit_rank_select_bench, setup, teardown ) {
+	MEASURE( "mm_bit_rank_u64", mm_bit_rank_u64( w, ( unsigned int ) m & 63 ) );
+	MEASURE( "mm_bit_select_u64", mm_bit_select_u64( w, ( unsigned int ) ( ( m & 0xffff ) * mm_popcount_u64( w ) >> 16 ) ) );
+}
+
+MM_BENCH_SUITE( bit_suite ) {
+	MM_BENCH_RUN( bit_count_bench );
+	MM_BENCH_RUN( bit_pow2_bench );
+	MM_BENCH_RUN( bit_pdep_bench );
+	MM_BENCH_RUN( bit_rank_select_bench );
+}
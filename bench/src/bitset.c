@@ -0,0 +1,154 @@
+#include "mm/bench.h"
+#include "mm/bit.h"
+#include "mm/bitset.h"
+#include "mm/random.h"
+
+#define MASKS 256
+#define MASK_BITS ( 1u << 20 )
+#define QUERIES 16
+
+static struct mm_bitset *masks;
+static struct mm_bitset result;
+
+// random masks, the result empties out quickly but every word is still read
+static bool setup( void ) {
+	struct mm_random r;
+
+	masks = MM_MALLOC( sizeof( *masks ) * MASKS );
+
+	if ( !masks || !mm_bitset_init( &result, MASK_BITS ) ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t m = 0; m < MASKS; ++m ) {
+		mm_bitset_init( &masks[ m ], MASK_BITS );
+		mm_random_fill( &r, masks[ m ].words, MASK_BITS / 8 );
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	for ( size_t m = 0; m < MASKS; ++m ) {
+		mm_bitset_destroy( &masks[ m ] );
+	}
+
+	mm_bitset_destroy( &result );
+	MM_FREE( masks );
+}
+
+// what the filters did before, a word loop the compiler is free to vectorize on its own
+static void scalar_and( uint_least64_t *dst, const uint_least64_t *src, size_t count ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		dst[ i ] &= src[ i ];
+	}
+}
+
+static size_t scalar_and_count( const uint_least64_t *lhs, const uint_least64_t *rhs, size_t count ) {
+	size_t total = 0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		total += mm_popcount_u64( lhs[ i ] & rhs[ i ] );
+	}
+
+	return total;
+}
+
+// one query intersects every mask into the result, 32 MiB of masks stream through per query
+MM_BENCH_CASE( bitset_and_bench, setup, teardown ) {
+	double bytes = ( double ) QUERIES * MASKS * ( MASK_BITS / 8 );
+	uint_least64_t start = mm_bench_now();
+	size_t sum = 0;
+
+	for ( size_t q = 0; q < QUERIES; ++q ) {
+		for ( size_t i = 0; i < MASK_BITS / 64; ++i ) {
+			result.words[ i ] = masks[ q ].words[ i ];
+		}
+
+		for ( size_t m = 0; m < MASKS; ++m ) {
+			scalar_and( result.words, masks[ m ].words, MASK_BITS / 64 );
+		}
+
+		MM_BENCH_KEEP( result.words );
+	}
+
+	mm_bench_report_bytes( "word loop and", bytes, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t q = 0; q < QUERIES; ++q ) {
+		for ( size_t i = 0; i < MASK_BITS / 64; ++i ) {
+			result.words[ i ] = masks[ q ].words[ i ];
+		}
+
+		for ( size_t m = 0; m < MASKS; ++m ) {
+			mm_bitset_and( &result, &masks[ m ] );
+		}
+
+		sum += mm_bitset_count( &result );
+	}
+
+	mm_bench_report_bytes( "mm_bitset_and", bytes, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t q = 0; q < QUERIES; ++q ) {
+		for ( size_t m = 1; m < MASKS; ++m ) {
+			sum += scalar_and_count( masks[ m - 1 ].words, masks[ m ].words, MASK_BITS / 64 );
+		}
+	}
+
+	mm_bench_report_bytes( "word loop and + popcount", ( double ) QUERIES * ( MASKS - 1 ) * ( MASK_BITS / 4 ), mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t q = 0; q < QUERIES; ++q ) {
+		for ( size_t m = 1; m < MASKS; ++m ) {
+			sum += mm_bitset_and_count( &masks[ m - 1 ], &masks[ m ] );
+		}
+	}
+
+	mm_bench_report_bytes( "mm_bitset_and_count", ( double ) QUERIES * ( MASKS - 1 ) * ( MASK_BITS / 4 ), mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+// a mask that fits in L1, where the kernel rather than memory sets the pace
+MM_BENCH_CASE( bitset_l1_bench, setup, teardown ) {
+	struct mm_bitset a, b;
+	uint_least64_t start;
+	size_t sum = 0;
+
+	mm_bitset_init( &a, 8 * 4096 );
+	mm_bitset_init( &b, 8 * 4096 );
+	mm_random_fill( mm_random_local(), a.words, 4096 );
+	mm_random_fill( mm_random_local(), b.words, 4096 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < ( 1u << 18 ); ++i ) {
+		mm_bitset_xor( &a, &b );
+		MM_BENCH_KEEP( a.words );
+	}
+
+	mm_bench_report_bytes( "mm_bitset_xor 4 KiB", ( double ) ( 1u << 18 ) * 8192, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < ( 1u << 18 ); ++i ) {
+		sum += mm_bitset_and_count( &a, &b );
+	}
+
+	mm_bench_report_bytes( "mm_bitset_and_count 4 KiB", ( double ) ( 1u << 18 ) * 8192, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < ( 1u << 18 ); ++i ) {
+		sum += scalar_and_count( a.words, b.words, 512 );
+	}
+
+	mm_bench_report_bytes( "word loop and + popcount 4 KiB", ( double ) ( 1u << 18 ) * 8192, mm_bench_now() - start );
+	mm_bitset_destroy( &a );
+	mm_bitset_destroy( &b );
+	MM_BENCH_KEEP( sum );
+}
+
+MM_BENCH_SUITE( bitset_suite ) {
+	MM_BENCH_RUN( bitset_and_bench );
+	MM_BENCH_RUN( bitset_l1_bench );
+}
@@ -0,0 +1,97 @@
+#include "mm/bench.h"
+#include "mm/bitvector.h"
+#include "mm/random.h"
+
+#define BITS ( UINT64_C( 1 ) << 30 )
+#define QUERIES ( 1u << 22 )
+
+static uint_least64_t *queries;
+
+static bool setup( void ) {
+	queries = MM_MALLOC( sizeof( *queries ) * QUERIES );
+
+	return queries != NULL;
+}
+
+static void teardown( void ) {
+	MM_FREE( queries );
+}
+
+// each bit set with probability density / 64, built from a stream of words
+static void measure( const char *density_name, unsigned int density ) {
+	char name[ 64 ];
+	struct mm_bitvector bv;
+	struct mm_random r;
+	uint_least64_t start;
+	uint_least64_t sum = 0;
+
+	mm_random_reset( &r, 42 );
+
+	if ( !mm_bitvector_init( &bv, BITS ) ) {
+		return;
+	}
+
+	start = mm_bench_now();
+
+	for ( uint_least64_t i = 0; i < BITS / 64; ++i ) {
+		uint_least64_t word = 0;
+
+		if ( density == 32 ) {
+			word = mm_random_u64( &r );
+		} else {
+			for ( unsigned int b = 0; b < density; ++b ) {
+				word |= ( uint_least64_t ) 1 << ( mm_random_u64( &r ) & 63 );
+			}
+		}
+
+		mm_bitvector_append( &bv, word, 64 );
+	}
+
+	mm_bench_report( "mm_bitvector_append 2^30 bits, per word", ( double ) ( BITS / 64 ), mm_bench_now() - start );
+	start = mm_bench_now();
+
+	if ( !mm_bitvector_build( &bv ) ) {
+		mm_bitvector_destroy( &bv );
+		return;
+	}
+
+	mm_bench_report_bytes( "mm_bitvector_build", ( double ) ( BITS / 8 ), mm_bench_now() - start );
+
+	for ( size_t i = 0; i < QUERIES; ++i ) {
+		queries[ i ] = mm_random_u64( &r ) & ( BITS - 1 );
+	}
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < QUERIES; ++i ) {
+		sum += mm_bitvector_rank1( &bv, queries[ i ] );
+	}
+
+	snprintf( name, sizeof( name ), "mm_bitvector_rank1, %s", density_name );
+	mm_bench_report( name, QUERIES, mm_bench_now() - start );
+
+	for ( size_t i = 0; i < QUERIES; ++i ) {
+		queries[ i ] = mm_random_u64( &r ) % bv.ones;
+	}
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < QUERIES; ++i ) {
+		sum += mm_bitvector_select1( &bv, queries[ i ] );
+	}
+
+	snprintf( name, sizeof( name ), "mm_bitvector_select1, %s", density_name );
+	mm_bench_report( name, QUERIES, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	mm_bitvector_destroy( &bv );
+}
+
+// random positions over 128 MiB of bits, nearly every query misses the caches
+MM_BENCH_CASE( bitvector_bench, setup, teardown ) {
+	measure( "50% set", 32 );
+	measure( "about 1.5% set", 1 );
+}
+
+MM_BENCH_SUITE( bitvector_suite ) {
+	MM_BENCH_RUN( bitvector_bench );
+}
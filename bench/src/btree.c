@@ -0,0 +1,178 @@
+#include "mm/bench.h"
+#include "mm/btree.h"
+#include "mm/random.h"
+#include "mm/rbtree.h"
+#include "mm/vector.h"
+
+#define COUNT 4000000
+#define SCANS 100000
+#define SCAN_LENGTH 100
+
+struct entry {
+	struct mm_rbtree_node node;
+	mm_btree_key_t key;
+};
+
+static mm_btree_key_t *keys;
+static struct entry *entries;
+
+static int entry_cmp( const struct mm_rbtree_node *lhs, const struct mm_rbtree_node *rhs ) {
+	mm_btree_key_t a = MM_CONTAINER_OF( lhs, struct entry, node )->key;
+	mm_btree_key_t b = MM_CONTAINER_OF( rhs, struct entry, node )->key;
+
+	return ( a > b ) - ( a < b );
+}
+
+static int key_cmp( const void *key, const struct mm_rbtree_node *node ) {
+	mm_btree_key_t a = *( const mm_btree_key_t* ) key;
+	mm_btree_key_t b = MM_CONTAINER_OF( node, struct entry, node )->key;
+
+	return ( a > b ) - ( a < b );
+}
+
+// even keys in shuffled order, so odd keys can be used for range scan starts
+static bool setup( void ) {
+	struct mm_random r;
+
+	keys = MM_MALLOC( sizeof( *keys ) * COUNT );
+	entries = MM_MALLOC( sizeof( *entries ) * COUNT );
+
+	if ( !keys || !entries ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		keys[ i ] = i * 2;
+	}
+
+	for ( size_t i = COUNT - 1; i > 0; --i ) {
+		size_t j = mm_random_next( &r, 0, i + 1 );
+		mm_btree_key_t tmp = keys[ i ];
+
+		keys[ i ] = keys[ j ];
+		keys[ j ] = tmp;
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( keys );
+	MM_FREE( entries );
+}
+
+MM_BENCH_CASE( btree_bench, setup, teardown ) {
+	MM_BTREE_DECLARE( tree );
+	uint_least64_t start;
+	uintptr_t sum = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		mm_btree_insert( &tree, keys[ i ], &keys[ i ] );
+	}
+
+	mm_bench_report( "btree random insert", COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		sum += ( uintptr_t ) *mm_btree_find( &tree, keys[ COUNT - i - 1 ] );
+	}
+
+	mm_bench_report( "btree point lookup", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < SCANS; ++i ) {
+		struct mm_btree_iter it = mm_btree_lower_bound( &tree, keys[ i ] + 1 );
+
+		for ( size_t j = 0; j < SCAN_LENGTH && !mm_btree_iter_end( &it ); ++j, mm_btree_iter_next( &it ) ) {
+			sum += mm_btree_iter_key( &it );
+		}
+	}
+
+	mm_bench_report( "btree range scan ( keys )", SCANS * SCAN_LENGTH, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		mm_btree_erase( &tree, keys[ i ], NULL );
+	}
+
+	mm_bench_report( "btree random erase", COUNT, mm_bench_now() - start );
+
+	MM_VECTOR_DECLARE( sorted, struct mm_btree_entry, NULL );
+	mm_vector_resize( &sorted, COUNT );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		struct mm_btree_entry *entry = mm_vector_at( &sorted, i );
+
+		entry->key = i * 2;
+		entry->value = NULL;
+	}
+
+	start = mm_bench_now();
+	mm_btree_bulk_load( &tree, &sorted );
+	mm_bench_report( "btree bulk load", COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		sum += mm_btree_find( &tree, keys[ i ] ) != NULL;
+	}
+
+	mm_bench_report( "btree point lookup ( bulk loaded )", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+
+	mm_btree_destroy( &tree );
+	mm_vector_destroy( &sorted );
+}
+
+MM_BENCH_CASE( rbtree_compare_bench, setup, teardown ) {
+	MM_RBTREE_DECLARE( tree );
+	uint_least64_t start;
+	uintptr_t sum = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		entries[ i ].key = keys[ i ];
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	mm_bench_report( "rbtree random insert", COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		sum += ( uintptr_t ) mm_rbtree_find( &tree, &keys[ COUNT - i - 1 ], key_cmp );
+	}
+
+	mm_bench_report( "rbtree point lookup", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < SCANS; ++i ) {
+		mm_btree_key_t key = keys[ i ] + 1;
+		struct mm_rbtree_node *node = mm_rbtree_lower_bound( &tree, &key, key_cmp );
+
+		for ( size_t j = 0; j < SCAN_LENGTH && node; ++j, node = mm_rbtree_next( node ) ) {
+			sum += MM_CONTAINER_OF( node, struct entry, node )->key;
+		}
+	}
+
+	mm_bench_report( "rbtree range scan ( keys )", SCANS * SCAN_LENGTH, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		mm_rbtree_erase( &tree, &entries[ i ].node );
+	}
+
+	mm_bench_report( "rbtree random erase", COUNT, mm_bench_now() - start );
+}
+
+MM_BENCH_SUITE( btree_suite ) {
+	MM_BENCH_RUN( btree_bench );
+	MM_BENCH_RUN( rbtree_compare_bench );
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/cchan.h"
+#include "mm/chan.h"
+
+#define MESSAGES ( 1u << 21 )
+#define FAN_IN 64
+#define WORKERS 4
+
+static struct mm_sched sched;
+static struct mm_chan chans[ 2 ];
+
+struct peer {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_chan *in;
+	struct mm_chan *out;
+	enum mm_chan_status status;
+	size_t left;
+	size_t value;
+	size_t sum;
+};
+
+static struct peer peers[ FAN_IN + 1 ];
+
+static void peers_init( void ) {
+	mm_sched_init( &sched, NULL, NULL );
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( peers ); ++i ) {
+		MM_CO_INIT( &peers[ i ].co );
+		peers[ i ].sum = 0;
+	}
+}
+
+// serves first, every message goes there and back
+MM_COROUTINE( ping, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_SEND( &this->co, task, this->out, &this->value, this->status );
+		MM_CO_RECV( &this->co, task, this->in, &this->value, this->status );
+		++this->value;
+	}
+
+	mm_chan_close( this->out );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( pong, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_RECV( &this->co, task, this->in, &this->value, this->status );
+
+		if ( this->status == MM_CHAN_CLOSED ) {
+			break;
+		}
+
+		MM_CO_SEND( &this->co, task, this->out, &this->value, this->status );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static void ping_pong( const char *name, size_t capacity ) {
+	uint_least64_t start;
+
+	peers_init();
+
+	if ( !MM_CHAN_INIT( &chans[ 0 ], &sched, size_t, capacity ) ) {
+		return;
+	}
+
+	if ( !MM_CHAN_INIT( &chans[ 1 ], &sched, size_t, capacity ) ) {
+		mm_chan_destroy( &chans[ 0 ] );
+		return;
+	}
+
+	peers[ 0 ] = ( struct peer ) { .in = &chans[ 1 ], .out = &chans[ 0 ], .left = MESSAGES / 2, .value = 0 };
+	peers[ 1 ] = ( struct peer ) { .in = &chans[ 0 ], .out = &chans[ 1 ] };
+	start = mm_bench_now();
+	mm_sched_spawn( &sched, &peers[ 0 ].task, ping );
+	mm_sched_spawn( &sched, &peers[ 1 ].task, pong );
+	mm_sched_run( &sched );
+	mm_bench_report( name, MESSAGES, mm_bench_now() - start );
+	MM_BENCH_KEEP( peers[ 0 ].value );
+	mm_chan_destroy( &chans[ 0 ] );
+	mm_chan_destroy( &chans[ 1 ] );
+}
+
+MM_BENCH_CASE( chan_ping_pong_bench, NULL, NULL ) {
+	ping_pong( "mm_chan ping-pong, unbuffered", 0 );
+	ping_pong( "mm_chan ping-pong, capacity 1", 1 );
+}
+
+MM_COROUTINE( fan_producer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_SEND( &this->co, task, this->out, &this->left, this->status );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( fan_consumer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_RECV( &this->co, task, this->in, &this->value, this->status );
+		this->sum += this->value;
+	}
+
+	MM_CO_END( &this->co );
+}
+
+// many producers parked on one bounded channel, each receive wakes exactly one of them
+static void fan_in( const char *name, size_t capacity ) {
+	uint_least64_t start;
+
+	peers_init();
+
+	if ( !MM_CHAN_INIT( &chans[ 0 ], &sched, size_t, capacity ) ) {
+		return;
+	}
+
+	for ( size_t i = 0; i < FAN_IN; ++i ) {
+		peers[ i ].out = &chans[ 0 ];
+		peers[ i ].left = MESSAGES / FAN_IN;
+	}
+
+	peers[ FAN_IN ].in = &chans[ 0 ];
+	peers[ FAN_IN ].left = MESSAGES;
+	start = mm_bench_now();
+	mm_sched_spawn( &sched, &peers[ FAN_IN ].task, fan_consumer );
+
+	for ( size_t i = 0; i < FAN_IN; ++i ) {
+		mm_sched_spawn( &sched, &peers[ i ].task, fan_producer );
+	}
+
+	mm_sched_run( &sched );
+	mm_bench_report( name, MESSAGES, mm_bench_now() - start );
+	MM_BENCH_KEEP( peers[ FAN_IN ].sum );
+	mm_chan_destroy( &chans[ 0 ] );
+}
+
+MM_BENCH_CASE( chan_fan_in_bench, NULL, NULL ) {
+	fan_in( "mm_chan 64 to 1, unbuffered", 0 );
+	fan_in( "mm_chan 64 to 1, capacity 64", 64 );
+}
+
+static struct mm_executor executor;
+static struct mm_cchan cchans[ 2 ];
+
+struct cpeer {
+	struct mm_executor_task task;
+	struct mm_co co;
+	struct mm_cchan *in;
+	struct mm_cchan *out;
+	enum mm_chan_status status;
+	size_t left;
+	size_t value;
+};
+
+static struct cpeer cpeers[ WORKERS + 1 ];
+
+MM_COROUTINE( cping, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_CCHAN_SEND( &this->co, task, this->out, &this->value, this->status );
+		MM_CO_CCHAN_RECV( &this->co, task, this->in, &this->value, this->status );
+		++this->value;
+	}
+
+	mm_cchan_close( this->out );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( cpong, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_CCHAN_RECV( &this->co, task, this->in, &this->value, this->status );
+
+		if ( this->status == MM_CHAN_CLOSED ) {
+			break;
+		}
+
+		MM_CO_CCHAN_SEND( &this->co, task, this->out, &this->value, this->status );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( cfan_producer, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_CCHAN_SEND( &this->co, task, this->out, &this->left, this->status );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( cfan_consumer, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ; this->left; --this->left ) {
+		MM_CO_CCHAN_RECV( &this->co, task, this->in, &this->value, this->status );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static bool cchan_setup( void ) {
+	if ( !mm_executor_init( &executor, WORKERS, false, NULL, NULL ) ) {
+		return false;
+	}
+
+	if ( !MM_CCHAN_INIT( &cchans[ 0 ], &executor, size_t, 64 ) ) {
+		mm_executor_destroy( &executor );
+		return false;
+	}
+
+	if ( !MM_CCHAN_INIT( &cchans[ 1 ], &executor, size_t, 64 ) ) {
+		mm_cchan_destroy( &cchans[ 0 ] );
+		mm_executor_destroy( &executor );
+		return false;
+	}
+
+	return true;
+}
+
+static void cchan_teardown( void ) {
+	mm_executor_destroy( &executor );
+	mm_cchan_destroy( &cchans[ 0 ] );
+	mm_cchan_destroy( &cchans[ 1 ] );
+}
+
+// the same topologies with the peers spread over executor threads
+MM_BENCH_CASE( cchan_bench, cchan_setup, cchan_teardown ) {
+	uint_least64_t start;
+
+	cpeers[ 0 ] = ( struct cpeer ) { .in = &cchans[ 1 ], .out = &cchans[ 0 ], .left = MESSAGES / 16, .value = 0 };
+	cpeers[ 1 ] = ( struct cpeer ) { .in = &cchans[ 0 ], .out = &cchans[ 1 ] };
+	MM_CO_INIT( &cpeers[ 0 ].co );
+	MM_CO_INIT( &cpeers[ 1 ].co );
+	start = mm_bench_now();
+	mm_executor_spawn( &executor, &cpeers[ 0 ].task, cping );
+	mm_executor_spawn( &executor, &cpeers[ 1 ].task, cpong );
+	mm_executor_wait( &executor );
+	mm_bench_report( "mm_cchan ping-pong, capacity 64, 4 workers", MESSAGES / 8, mm_bench_now() - start );
+	MM_BENCH_KEEP( cpeers[ 0 ].value );
+
+	for ( size_t i = 0; i < WORKERS; ++i ) {
+		cpeers[ i ] = ( struct cpeer ) { .out = &cchans[ 1 ], .left = MESSAGES / WORKERS };
+		MM_CO_INIT( &cpeers[ i ].co );
+	}
+
+	cpeers[ WORKERS ] = ( struct cpeer ) { .in = &cchans[ 1 ], .left = MESSAGES };
+	MM_CO_INIT( &cpeers[ WORKERS ].co );
+	start = mm_bench_now();
+	mm_executor_spawn( &executor, &cpeers[ WORKERS ].task, cfan_consumer );
+
+	for ( size_t i = 0; i < WORKERS; ++i ) {
+		mm_executor_spawn( &executor, &cpeers[ i ].task, cfan_producer );
+	}
+
+	mm_executor_wait( &executor );
+	mm_bench_report( "mm_cchan 4 to 1, capacity 64, 4 workers", MESSAGES, mm_bench_now() - start );
+	MM_BENCH_KEEP( cpeers[ WORKERS ].value );
+}
+
+MM_BENCH_SUITE( chan_suite ) {
+	MM_BENCH_RUN( chan_ping_pong_bench );
+	MM_BENCH_RUN( chan_fan_in_bench );
+	MM_BENCH_RUN( cchan_bench );
+}
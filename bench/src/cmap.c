@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <threads.h>
+#include "mm/bench.h"
+#include "mm/cmap.h"
+#include "mm/hash.h"
+#include "mm/hashmap.h"
+#include "mm/random.h"
+
+// keys are drawn from twice the preloaded range, so half of the lookups miss
+#define KEYS ( 1u << 20 )
+#define OPS ( 1u << 22 )
+#define MAX_THREADS 64
+
+static inline uint_least64_t hash_key( uint_least64_t key ) {
+	return mm_hash_u64( key, 0 );
+}
+
+static inline bool eq_key( uint_least64_t lhs, uint_least64_t rhs ) {
+	return lhs == rhs;
+}
+
+MM_HASHMAP_DEFINE( locked_map, uint_least64_t, void*, hash_key, eq_key )
+
+struct worker {
+	thrd_t thread;
+	unsigned int write_percent;
+	size_t ops;
+	unsigned long seed;
+	uintptr_t sum;
+};
+
+static struct mm_cmap cmap;
+static struct locked_map hashmap;
+static mtx_t hashmap_lock;
+
+static int cmap_worker( void *arg ) {
+	struct worker *w = arg;
+	struct mm_random r;
+
+	mm_random_reset( &r, w->seed );
+
+	for ( size_t i = 0; i < w->ops; ++i ) {
+		uint_least64_t key = mm_random_next( &r, 0, KEYS * 2 );
+
+		if ( mm_random_next( &r, 0, 100 ) >= w->write_percent ) {
+			w->sum += ( uintptr_t ) mm_cmap_find( &cmap, key );
+		} else if ( key & 1 ) {
+			mm_cmap_insert( &cmap, key, ( void* ) ( uintptr_t ) ( key | 2 ) );
+		} else {
+			mm_cmap_erase( &cmap, key, NULL );
+		}
+	}
+
+	return 0;
+}
+
+// the baseline: one mutex around a mm_hashmap
+static int hashmap_worker( void *arg ) {
+	struct worker *w = arg;
+	struct mm_random r;
+
+	mm_random_reset( &r, w->seed );
+
+	for ( size_t i = 0; i < w->ops; ++i ) {
+		uint_least64_t key = mm_random_next( &r, 0, KEYS * 2 );
+		bool read = mm_random_next( &r, 0, 100 ) >= w->write_percent;
+
+		mtx_lock( &hashmap_lock );
+
+		if ( read ) {
+			void **value = locked_map_find( &hashmap, key );
+			w->sum += value ? ( uintptr_t ) *value : 0;
+		} else if ( key & 1 ) {
+			locked_map_put( &hashmap, key, ( void* ) ( uintptr_t ) ( key | 2 ) );
+		} else {
+			locked_map_erase( &hashmap, key, NULL );
+		}
+
+		mtx_unlock( &hashmap_lock );
+	}
+
+	return 0;
+}
+
+static void run( const char *label, thrd_start_t func, unsigned int threads, unsigned int write_percent ) {
+	struct worker workers[ MAX_THREADS ];
+	uint_least64_t start = mm_bench_now();
+	uintptr_t sum = 0;
+	char name[ 64 ];
+
+	for ( unsigned int i = 0; i < threads; ++i ) {
+		workers[ i ].write_percent = write_percent;
+		workers[ i ].ops = OPS / threads;
+		workers[ i ].seed = i + 1;
+		workers[ i ].sum = 0;
+		thrd_create( &workers[ i ].thread, func, &workers[ i ] );
+	}
+
+	for ( unsigned int i = 0; i < threads; ++i ) {
+		thrd_join( workers[ i ].thread, NULL );
+		sum += workers[ i ].sum;
+	}
+
+	snprintf( name, sizeof( name ), "%s %u/%u %2u threads", label, 100 - write_percent, write_percent, threads );
+	mm_bench_report( name, ( double ) OPS / threads * threads, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+static bool setup( void ) {
+	if ( !mm_cmap_init( &cmap, 0 ) || mtx_init( &hashmap_lock, mtx_plain ) != thrd_success ) {
+		return false;
+	}
+
+	locked_map_init( &hashmap );
+
+	for ( uint_least64_t key = 1; key < KEYS * 2; key += 2 ) {
+		if ( !mm_cmap_insert( &cmap, key, ( void* ) ( uintptr_t ) ( key | 2 ) )
+		  || !locked_map_put( &hashmap, key, ( void* ) ( uintptr_t ) ( key | 2 ) ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	mm_cmap_destroy( &cmap );
+	locked_map_destroy( &hashmap );
+	mtx_destroy( &hashmap_lock );
+}
+
+MM_BENCH_CASE( cmap_scaling_bench, setup, teardown ) {
+	static const unsigned int write_percents[] = { 1, 10, 50 };
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( write_percents ); ++i ) {
+		for ( unsigned int threads = 1; threads <= MAX_THREADS; threads *= 2 ) {
+			run( "cmap", cmap_worker, threads, write_percents[ i ] );
+		}
+
+		for ( unsigned int threads = 1; threads <= MAX_THREADS; threads *= 2 ) {
+			run( "mutex + hashmap", hashmap_worker, threads, write_percents[ i ] );
+		}
+	}
+}
+
+MM_BENCH_SUITE( cmap_suite ) {
+	MM_BENCH_RUN( cmap_scaling_bench );
+}
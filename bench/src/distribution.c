@@ -0,0 +1,132 @@
+#include "mm/bench.h"
+#include "mm/distribution.h"
+
+#define DRAWS ( 1u << 24 )
+#define BATCH 1024
+
+static double *reals;
+static uint_least64_t *ranks;
+static size_t *indices;
+
+static bool setup( void ) {
+	reals = MM_MALLOC( sizeof( *reals ) * BATCH );
+	ranks = MM_MALLOC( sizeof( *ranks ) * BATCH );
+	indices = MM_MALLOC( sizeof( *indices ) * BATCH );
+
+	return reals && ranks && indices;
+}
+
+static void teardown( void ) {
+	MM_FREE( reals );
+	MM_FREE( ranks );
+	MM_FREE( indices );
+}
+
+MM_BENCH_CASE( distribution_normal_bench, setup, teardown ) {
+	struct mm_random r;
+	uint_least64_t start;
+	double sum = 0.0;
+
+	mm_random_reset( &r, 42 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_random_normal( &r );
+	}
+
+	mm_bench_report( "mm_random_normal", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS / BATCH; ++i ) {
+		mm_random_normal_fill( &r, reals, BATCH );
+		MM_BENCH_KEEP( reals );
+	}
+
+	mm_bench_report( "mm_random_normal_fill", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_random_exponential( &r );
+	}
+
+	mm_bench_report( "mm_random_exponential", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS / BATCH; ++i ) {
+		mm_random_exponential_fill( &r, reals, BATCH );
+		MM_BENCH_KEEP( reals );
+	}
+
+	mm_bench_report( "mm_random_exponential_fill", DRAWS, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+// skew typical of cache keys, the sampler costs the same for any n
+MM_BENCH_CASE( distribution_zipf_bench, setup, teardown ) {
+	struct mm_zipf zipf;
+	struct mm_random r;
+	uint_least64_t start;
+	uint_least64_t sum = 0;
+
+	mm_random_reset( &r, 42 );
+	mm_zipf_init( &zipf, 1000000, 0.99 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_zipf_next( &zipf, &r );
+	}
+
+	mm_bench_report( "mm_zipf_next n = 1e6, s = 0.99", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS / BATCH; ++i ) {
+		mm_zipf_fill( &zipf, &r, ranks, BATCH );
+		MM_BENCH_KEEP( ranks );
+	}
+
+	mm_bench_report( "mm_zipf_fill n = 1e6, s = 0.99", DRAWS, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+#define WEIGHTS 4096
+
+MM_BENCH_CASE( distribution_alias_bench, setup, teardown ) {
+	static double weights[ WEIGHTS ];
+	struct mm_alias alias;
+	struct mm_random r;
+	uint_least64_t start;
+	size_t sum = 0;
+
+	for ( size_t i = 0; i < WEIGHTS; ++i ) {
+		weights[ i ] = 1.0 + ( double ) ( i % 17 );
+	}
+
+	if ( !mm_alias_init( &alias, weights, WEIGHTS ) ) {
+		return;
+	}
+
+	mm_random_reset( &r, 42 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_alias_next( &alias, &r );
+	}
+
+	mm_bench_report( "mm_alias_next 4096 weights", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS / BATCH; ++i ) {
+		mm_alias_fill( &alias, &r, indices, BATCH );
+		MM_BENCH_KEEP( indices );
+	}
+
+	mm_bench_report( "mm_alias_fill 4096 weights", DRAWS, mm_bench_now() - start );
+	mm_alias_destroy( &alias );
+	MM_BENCH_KEEP( sum );
+}
+
+MM_BENCH_SUITE( distribution_suite ) {
+	MM_BENCH_RUN( distribution_normal_bench );
+	MM_BENCH_RUN( distribution_zipf_bench );
+	MM_BENCH_RUN( distribution_alias_bench );
+}
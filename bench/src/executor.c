@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/executor.h"
+
+#define ELEMENTS ( 1u << 24 )
+#define CUTOFF ( 1u << 12 )
+#define MAX_WORKERS 64
+#define SHORT_TASKS ( 1u << 20 )
+
+static struct mm_executor executor;
+static unsigned int *elements;
+
+struct sum {
+	struct mm_executor_task task;
+	struct mm_co co;
+	struct sum *parent;
+	atomic_ullong total;
+	atomic_int pending;
+	size_t begin;
+	size_t end;
+	unsigned long long result;
+};
+
+static void sum_retire( struct mm_executor_task *task, void *ctx ) {
+	struct sum *this = MM_EXECUTOR_CONTAINER( task, struct sum, task );
+
+	( void ) ctx;
+
+	if ( this->parent ) {
+		MM_FREE( this );
+	}
+}
+
+static bool setup( void ) {
+	elements = MM_MALLOC( sizeof( *elements ) * ELEMENTS );
+
+	if ( !elements ) {
+		return false;
+	}
+
+	for ( size_t i = 0; i < ELEMENTS; ++i ) {
+		elements[ i ] = ( unsigned int ) i;
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( elements );
+}
+
+// splits the range in halves until it's small enough to add up in place
+MM_COROUTINE( sum_job, struct mm_executor_task *task ) {
+	struct sum *this = MM_EXECUTOR_CONTAINER( task, struct sum, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	if ( this->end - this->begin <= CUTOFF ) {
+		this->result = 0;
+
+		for ( size_t i = this->begin; i < this->end; ++i ) {
+			this->result += elements[ i ];
+		}
+	} else {
+		size_t middle = this->begin + ( this->end - this->begin ) / 2;
+
+		atomic_init( &this->total, 0 );
+		atomic_init( &this->pending, 2 );
+
+		for ( unsigned int i = 0; i < 2; ++i ) {
+			struct sum *child = MM_MALLOC( sizeof( *child ) );
+
+			// what the missing child would have added is added here
+			if ( !child ) {
+				size_t begin = i ? middle : this->begin;
+				size_t end = i ? this->end : middle;
+				unsigned long long total = 0;
+
+				for ( size_t j = begin; j < end; ++j ) {
+					total += elements[ j ];
+				}
+
+				atomic_fetch_add( &this->total, total );
+				atomic_fetch_sub( &this->pending, 1 );
+				continue;
+			}
+
+			child->parent = this;
+			child->begin = i ? middle : this->begin;
+			child->end = i ? this->end : middle;
+			MM_CO_INIT( &child->co );
+			mm_executor_spawn( &executor, &child->task, sum_job );
+		}
+
+		// a child that is still pending wakes this, even if it finishes before the wait
+		if ( atomic_load( &this->pending ) ) {
+			MM_CO_WAIT_WAKE( &this->co );
+		}
+
+		this->result = atomic_load( &this->total );
+	}
+
+	if ( this->parent ) {
+		atomic_fetch_add( &this->parent->total, this->result );
+
+		if ( atomic_fetch_sub( &this->parent->pending, 1 ) == 1 ) {
+			mm_executor_wake( &executor, &this->parent->task );
+		}
+	}
+
+	MM_CO_END( &this->co );
+}
+
+// fork-join tree sum, the scaling curve shows what stealing and parking cost as workers are added
+MM_BENCH_CASE( executor_fork_join_bench, setup, teardown ) {
+	char name[ 64 ];
+
+	for ( unsigned int workers = 1; workers <= MAX_WORKERS; workers *= 2 ) {
+		struct sum root = { .parent = NULL, .begin = 0, .end = ELEMENTS };
+		uint_least64_t start;
+
+		if ( !mm_executor_init( &executor, workers, false, sum_retire, NULL ) ) {
+			return;
+		}
+
+		MM_CO_INIT( &root.co );
+		start = mm_bench_now();
+		mm_executor_spawn( &executor, &root.task, sum_job );
+		mm_executor_wait( &executor );
+		snprintf( name, sizeof( name ), "fork-join sum, %u workers", workers );
+		mm_bench_report_bytes( name, sizeof( *elements ) * ELEMENTS, mm_bench_now() - start );
+		MM_BENCH_KEEP( root.result );
+		mm_executor_destroy( &executor );
+	}
+}
+
+struct tiny {
+	struct mm_executor_task task;
+	struct mm_co co;
+	size_t begin; //!< \brief index of this task, the tasks up to end are spawned below it
+	size_t end;
+};
+
+static struct tiny *tinies;
+static atomic_size_t tiny_count;
+
+static bool tiny_setup( void ) {
+	tinies = MM_MALLOC( sizeof( *tinies ) * SHORT_TASKS );
+
+	return tinies != NULL;
+}
+
+static void tiny_teardown( void ) {
+	MM_FREE( tinies );
+}
+
+MM_COROUTINE( tiny_job, struct mm_executor_task *task ) {
+	struct tiny *this = MM_EXECUTOR_CONTAINER( task, struct tiny, task );
+
+	MM_CO_BEGIN( &this->co );
+	atomic_fetch_add_explicit( &tiny_count, 1, memory_order_relaxed );
+
+	// the rest of the range is split between two children, so the deques stay as shallow as the tree
+	if ( this->end - this->begin > 1 ) {
+		size_t middle = this->begin + 1 + ( this->end - this->begin - 1 ) / 2;
+		size_t bounds[ 3 ] = { this->begin + 1, middle, this->end };
+
+		for ( unsigned int i = 0; i < 2; ++i ) {
+			if ( bounds[ i ] < bounds[ i + 1 ] ) {
+				struct tiny *child = &tinies[ bounds[ i ] ];
+
+				child->begin = bounds[ i ];
+				child->end = bounds[ i + 1 ];
+				MM_CO_INIT( &child->co );
+				mm_executor_spawn( &executor, &child->task, tiny_job );
+			}
+		}
+	}
+
+	MM_CO_END( &this->co );
+}
+
+// tasks fanned out from a root task inside the pool, so every spawn but the first goes through the worker deques
+MM_BENCH_CASE( executor_spawn_bench, tiny_setup, tiny_teardown ) {
+	char name[ 64 ];
+
+	for ( unsigned int workers = 1; workers <= MAX_WORKERS; workers *= 2 ) {
+		uint_least64_t start;
+
+		if ( !mm_executor_init( &executor, workers, false, NULL, NULL ) ) {
+			return;
+		}
+
+		start = mm_bench_now();
+		tinies[ 0 ].begin = 0;
+		tinies[ 0 ].end = SHORT_TASKS;
+		MM_CO_INIT( &tinies[ 0 ].co );
+		mm_executor_spawn( &executor, &tinies[ 0 ].task, tiny_job );
+		mm_executor_wait( &executor );
+		snprintf( name, sizeof( name ), "spawn + run short task, %u workers", workers );
+		mm_bench_report( name, SHORT_TASKS, mm_bench_now() - start );
+		mm_executor_destroy( &executor );
+	}
+
+	MM_BENCH_KEEP( tiny_count );
+}
+
+MM_BENCH_SUITE( executor_suite ) {
+	MM_BENCH_RUN( executor_fork_join_bench );
+	MM_BENCH_RUN( executor_spawn_bench );
+}
@@ -0,0 +1,110 @@
+#include <ucontext.h>
+#include "mm/bench.h"
+#include "mm/fiber.h"
+
+#define SWITCHES ( 1u << 22 )
+#define SPAWNS ( 1u << 18 )
+#define STACK_SIZE ( 64 * 1024 )
+
+static struct mm_fiber_pool pool;
+
+static bool setup( void ) {
+	return mm_fiber_pool_init( &pool, STACK_SIZE, 64 );
+}
+
+static void teardown( void ) {
+	mm_fiber_pool_destroy( &pool );
+}
+
+static void spin( struct mm_fiber *fiber, void *arg ) {
+	size_t *count = arg;
+
+	for ( ;; ) {
+		++*count;
+		MM_FIBER_YIELD( fiber );
+	}
+}
+
+static ucontext_t main_context;
+static ucontext_t spin_context;
+static size_t spin_count;
+
+static void spin_ucontext( void ) {
+	for ( ;; ) {
+		++spin_count;
+		swapcontext( &spin_context, &main_context );
+	}
+}
+
+// one op is a resume and the yield back, so two switches
+MM_BENCH_CASE( fiber_switch_bench, setup, teardown ) {
+	struct mm_fiber fiber;
+	uint_least64_t start;
+	size_t count = 0;
+	void *stack;
+
+	if ( !mm_fiber_init( &fiber, &pool, spin, &count ) ) {
+		return;
+	}
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < SWITCHES; ++i ) {
+		mm_fiber_resume( &fiber );
+	}
+
+	mm_bench_report( "mm_fiber resume + yield", SWITCHES, mm_bench_now() - start );
+	MM_BENCH_KEEP( count );
+	mm_fiber_destroy( &fiber );
+
+	// the same round trip through swapcontext, which also saves and restores the signal mask
+	stack = MM_MALLOC( STACK_SIZE );
+
+	if ( !stack ) {
+		return;
+	}
+
+	getcontext( &spin_context );
+	spin_context.uc_stack.ss_sp = stack;
+	spin_context.uc_stack.ss_size = STACK_SIZE;
+	spin_context.uc_link = NULL;
+	makecontext( &spin_context, spin_ucontext, 0 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < SWITCHES; ++i ) {
+		swapcontext( &main_context, &spin_context );
+	}
+
+	mm_bench_report( "swapcontext round trip", SWITCHES, mm_bench_now() - start );
+	MM_BENCH_KEEP( spin_count );
+	MM_FREE( stack );
+}
+
+static void finish( struct mm_fiber *fiber, void *arg ) {
+	( void ) fiber;
+	++*( size_t* ) arg;
+}
+
+// pooled stacks make creating a fiber about as cheap as the first switch into it
+MM_BENCH_CASE( fiber_spawn_bench, setup, teardown ) {
+	struct mm_fiber fiber;
+	uint_least64_t start;
+	size_t count = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < SPAWNS; ++i ) {
+		if ( mm_fiber_init( &fiber, &pool, finish, &count ) ) {
+			mm_fiber_resume( &fiber );
+			mm_fiber_destroy( &fiber );
+		}
+	}
+
+	mm_bench_report( "mm_fiber init + run + destroy", SPAWNS, mm_bench_now() - start );
+	MM_BENCH_KEEP( count );
+}
+
+MM_BENCH_SUITE( fiber_suite ) {
+	MM_BENCH_RUN( fiber_switch_bench );
+	MM_BENCH_RUN( fiber_spawn_bench );
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/hash.h"
+#include "mm/random.h"
+
+// bytes hashed per key size
+#define VOLUME ( 1u << 28 )
+#define BUFFER_SIZE ( 1u << 17 )
+#define BATCH 1024
+
+static unsigned char *buffer;
+
+static bool setup( void ) {
+	struct mm_random r;
+
+	buffer = MM_MALLOC( BUFFER_SIZE );
+
+	if ( !buffer ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < BUFFER_SIZE; ++i ) {
+		buffer[ i ] = ( unsigned char ) mm_random_next( &r, 0, 256 );
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( buffer );
+}
+
+MM_BENCH_CASE( hash_bytes_bench, setup, teardown ) {
+	uint_least64_t seed = mm_hash_seed();
+	char name[ 64 ];
+
+	for ( size_t len = 8; len <= 65536; len *= 2 ) {
+		size_t count = VOLUME / len;
+		uint_least64_t sum = 0;
+		uint_least64_t start = mm_bench_now();
+
+		// keys are independent, so this measures throughput rather than latency
+		for ( size_t i = 0; i < count; ++i ) {
+			sum += mm_hash_bytes( buffer + ( i * 8 ) % ( BUFFER_SIZE - len + 1 ), len, seed );
+		}
+
+		snprintf( name, sizeof( name ), "hash %zu bytes", len );
+		mm_bench_report_bytes( name, ( double ) count * len, mm_bench_now() - start );
+		MM_BENCH_KEEP( sum );
+	}
+}
+
+MM_BENCH_CASE( hash_stream_bench, setup, teardown ) {
+	uint_least64_t seed = mm_hash_seed();
+	struct mm_hash_state state;
+	uint_least64_t start = mm_bench_now();
+
+	// odd sized updates so most of them go through the buffer
+	mm_hash_init( &state, seed );
+
+	for ( size_t done = 0; done < VOLUME; done += 1000 ) {
+		mm_hash_update( &state, buffer + done % BUFFER_SIZE / 2, 1000 );
+	}
+
+	mm_bench_report_bytes( "hash stream ( 1000 byte updates )", VOLUME / 1000 * 1000, mm_bench_now() - start );
+	MM_BENCH_KEEP( mm_hash_final( &state ) );
+}
+
+MM_BENCH_CASE( hash_fixed_bench, setup, teardown ) {
+	uint_least64_t seed = mm_hash_seed();
+	const uint_least64_t *keys = ( const uint_least64_t* ) buffer;
+	size_t count = BUFFER_SIZE / sizeof( *keys ) / BATCH * BATCH;
+	size_t rounds = VOLUME / 8 / count;
+	uint_least64_t out[ BATCH ];
+	uint_least64_t sum = 0;
+	uint_least64_t start = mm_bench_now();
+
+	// a different seed per round, so the rounds can't be folded into one
+	for ( size_t round = 0; round < rounds; ++round ) {
+		for ( size_t i = 0; i < count; ++i ) {
+			sum += mm_hash_u64( keys[ i ], seed + round );
+		}
+	}
+
+	mm_bench_report( "hash u64", ( double ) rounds * count, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	// each hash feeds the next seed, the latency a lookup sees
+	for ( size_t round = 0; round < rounds; ++round ) {
+		for ( size_t i = 0; i < count; ++i ) {
+			sum = mm_hash_u64( keys[ i ], sum );
+		}
+	}
+
+	mm_bench_report( "hash u64 ( dependent chain )", ( double ) rounds * count, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t round = 0; round < rounds; ++round ) {
+		for ( size_t i = 0; i < count; i += BATCH ) {
+			mm_hash_u64_batch( keys + i, BATCH, seed + round, out );
+			sum += out[ BATCH - 1 ];
+		}
+	}
+
+	mm_bench_report( "hash u64 batch", ( double ) rounds * count, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+MM_BENCH_SUITE( hash_suite ) {
+	MM_BENCH_RUN( hash_bytes_bench );
+	MM_BENCH_RUN( hash_stream_bench );
+	MM_BENCH_RUN( hash_fixed_bench );
+}
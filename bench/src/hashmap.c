@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/hash.h"
+#include "mm/hashmap.h"
+#include "mm/random.h"
+
+// fixed table size, the load factor is set by the number of keys
+#define CAPACITY ( 1u << 20 )
+
+static uint_least64_t seed;
+
+static inline uint_least64_t hash_key( uint_least64_t key ) {
+	return mm_hash_u64( key, seed );
+}
+
+static inline bool eq_key( uint_least64_t lhs, uint_least64_t rhs ) {
+	return lhs == rhs;
+}
+
+MM_HASHMAP_DEFINE( bench_map, uint_least64_t, uint_least64_t, hash_key, eq_key )
+
+static uint_least64_t *keys;
+
+// even keys in shuffled order, odd keys are never inserted and used for misses
+static bool setup( void ) {
+	struct mm_random r;
+
+	keys = MM_MALLOC( sizeof( *keys ) * CAPACITY );
+
+	if ( !keys ) {
+		return false;
+	}
+
+	seed = mm_hash_seed();
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < CAPACITY; ++i ) {
+		keys[ i ] = i * 2;
+	}
+
+	for ( size_t i = CAPACITY - 1; i > 0; --i ) {
+		size_t j = mm_random_next( &r, 0, i + 1 );
+		uint_least64_t tmp = keys[ i ];
+
+		keys[ i ] = keys[ j ];
+		keys[ j ] = tmp;
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( keys );
+}
+
+static void run_load( unsigned int eighths ) {
+	struct bench_map map = MM_HASHMAP_INIT;
+	size_t count = CAPACITY / 8 * eighths;
+	uint_least64_t start;
+	uint_least64_t sum = 0;
+	char name[ 64 ];
+
+	bench_map_reserve( &map, CAPACITY / 8 * 7 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < count; ++i ) {
+		bench_map_put( &map, keys[ i ], i );
+	}
+
+	snprintf( name, sizeof( name ), "hashmap insert ( load %.3f )", eighths / 8.0 );
+	mm_bench_report( name, count, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < count; ++i ) {
+		sum += *bench_map_find( &map, keys[ count - i - 1 ] );
+	}
+
+	snprintf( name, sizeof( name ), "hashmap lookup hit ( load %.3f )", eighths / 8.0 );
+	mm_bench_report( name, count, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < count; ++i ) {
+		sum += bench_map_find( &map, keys[ i ] + 1 ) != NULL;
+	}
+
+	snprintf( name, sizeof( name ), "hashmap lookup miss ( load %.3f )", eighths / 8.0 );
+	mm_bench_report( name, count, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < count; ++i ) {
+		bench_map_erase( &map, keys[ i ], NULL );
+	}
+
+	snprintf( name, sizeof( name ), "hashmap erase ( load %.3f )", eighths / 8.0 );
+	mm_bench_report( name, count, mm_bench_now() - start );
+
+	bench_map_destroy( &map );
+}
+
+MM_BENCH_CASE( hashmap_bench, setup, teardown ) {
+	for ( unsigned int eighths = 4; eighths <= 7; ++eighths ) {
+		run_load( eighths );
+	}
+}
+
+MM_BENCH_SUITE( hashmap_suite ) {
+	MM_BENCH_RUN( hashmap_bench );
+}
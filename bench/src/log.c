@@ -0,0 +1,227 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+// MM_INFO through the macros is compiled out in this file
+#define MM_LOG_MIN_LEVEL MM_WARN
+#include "mm/bench.h"
+#include "mm/log.h"
+
+#define SAMPLES 200000
+
+static uint_least64_t *samples;
+static int devnull;
+static int saved;
+
+static bool setup( void ) {
+	samples = MM_MALLOC( sizeof( *samples ) * SAMPLES );
+	devnull = open( "/dev/null", O_WRONLY );
+
+	return samples && devnull >= 0;
+}
+
+static void teardown( void ) {
+	MM_FREE( samples );
+	close( devnull );
+}
+
+static int cmp_samples( const void *lhs, const void *rhs ) {
+	uint_least64_t a = *( const uint_least64_t* ) lhs;
+	uint_least64_t b = *( const uint_least64_t* ) rhs;
+
+	return ( a > b ) - ( a < b );
+}
+
+// messages go to /dev/null for the measurement, stdout comes back for the report
+static void redirect( void ) {
+	MM_FFLUSH( MM_STDOUT );
+	saved = dup( STDOUT_FILENO );
+	dup2( devnull, STDOUT_FILENO );
+}
+
+static void restore( void ) {
+	MM_FFLUSH( MM_STDOUT );
+	dup2( saved, STDOUT_FILENO );
+	close( saved );
+}
+
+static void measure( void ) {
+	for ( size_t i = 0; i < SAMPLES; ++i ) {
+		uint_least64_t start = mm_bench_now();
+
+		mm_log( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+		samples[ i ] = mm_bench_now() - start;
+	}
+}
+
+static void report( const char *name ) {
+	qsort( samples, SAMPLES, sizeof( *samples ), cmp_samples );
+	mm_log( MM_INFO, "  %-40s p50 %6llu ns  p99 %6llu ns  p99.9 %6llu ns", name,
+		( unsigned long long ) samples[ SAMPLES / 2 ],
+		( unsigned long long ) samples[ SAMPLES / 100 * 99 ],
+		( unsigned long long ) samples[ SAMPLES / 1000 * 999 ] );
+}
+
+// caller side latency of one call, formatting included, the write is what async moves away
+MM_BENCH_CASE( log_latency_bench, setup, teardown ) {
+	struct mm_log_async_config config = { .fd = devnull, .ring_size = 1 << 20, .overflow = MM_LOG_BLOCK };
+
+	redirect();
+	measure();
+	restore();
+	report( "mm_log sync" );
+
+	if ( !mm_log_async_start( &config ) ) {
+		return;
+	}
+
+	measure();
+	mm_log_async_stop();
+	report( "mm_log async, block on overflow" );
+
+	config.overflow = MM_LOG_DROP;
+
+	if ( !mm_log_async_start( &config ) ) {
+		return;
+	}
+
+	measure();
+	mm_log_async_stop();
+	report( "mm_log async, drop on overflow" );
+}
+
+#define RECORDS ( 1u << 20 )
+
+// the ring holds the whole run, so only the calling side is measured
+static void throughput( const char *name, bool deferred, bool binary ) {
+	struct mm_log_async_config config = { .fd = devnull, .ring_size = 1 << 26, .overflow = MM_LOG_BLOCK, .binary = binary };
+	uint_least64_t start;
+	uint_least64_t elapsed;
+
+	if ( !mm_log_async_start( &config ) ) {
+		return;
+	}
+
+	// warm the ring up, the first touch of every page is a fault
+	for ( size_t i = 0; i < RECORDS; ++i ) {
+		MM_LOG_DEFER( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	mm_log_flush();
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < RECORDS; ++i ) {
+		if ( deferred ) {
+			MM_LOG_DEFER( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+		} else {
+			mm_log( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+		}
+	}
+
+	elapsed = mm_bench_now() - start;
+	mm_log_async_stop();
+	mm_bench_report( name, RECORDS, elapsed );
+}
+
+MM_BENCH_CASE( log_defer_bench, setup, teardown ) {
+	throughput( "mm_log async", false, false );
+	throughput( "MM_LOG_DEFER, text", true, false );
+	throughput( "MM_LOG_DEFER, binary", true, true );
+}
+
+#define FILTERED ( 1u << 24 )
+
+// what a call costs when nothing comes out of it
+MM_BENCH_CASE( log_filtered_bench, setup, teardown ) {
+	uint_least64_t start = mm_bench_now();
+
+	for ( size_t i = 0; i < FILTERED; ++i ) {
+		MM_LOG( MM_INFO, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	mm_bench_report( "MM_LOG below MM_LOG_MIN_LEVEL", FILTERED, mm_bench_now() - start );
+	mm_log_set_level( MM_ERR );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < FILTERED; ++i ) {
+		MM_LOG( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	mm_log_set_level( MM_INFO );
+	mm_bench_report( "MM_LOG below the threshold", FILTERED, mm_bench_now() - start );
+	mm_log_set_level( MM_ERR );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < FILTERED; ++i ) {
+		mm_log( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	mm_log_set_level( MM_INFO );
+	mm_bench_report( "mm_log below the threshold", FILTERED, mm_bench_now() - start );
+	redirect();
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < FILTERED / 16; ++i ) {
+		MM_LOG_LIMITED( MM_WARN, 1, 1, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	start = mm_bench_now() - start;
+	restore();
+	mm_bench_report( "MM_LOG_LIMITED, suppressed", FILTERED / 16, start );
+}
+
+#define APPENDS ( 1u << 22 )
+
+// the price of leaving the recorder on, messages go to /dev/null either way
+MM_BENCH_CASE( log_recorder_bench, setup, teardown ) {
+	char path[] = "/tmp/mm-bench-recorder-XXXXXX";
+	int fd = mkstemp( path );
+	uint_least64_t elapsed[ 3 ];
+	uint_least64_t start;
+
+	if ( fd < 0 ) {
+		return;
+	}
+
+	close( fd );
+
+	if ( !mm_log_recorder_open( path, 1 << 20 ) ) {
+		remove( path );
+		return;
+	}
+
+	start = mm_bench_now();
+
+	for ( uint_least32_t i = 0; i < APPENDS; ++i ) {
+		mm_log_event( 1, &i, sizeof( i ) );
+	}
+
+	elapsed[ 0 ] = mm_bench_now() - start;
+	redirect();
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < APPENDS / 16; ++i ) {
+		mm_log( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	elapsed[ 1 ] = mm_bench_now() - start;
+	mm_log_recorder_close();
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < APPENDS / 16; ++i ) {
+		mm_log( MM_WARN, "request %zu took %d us on worker %s", i, 42, "main" );
+	}
+
+	elapsed[ 2 ] = mm_bench_now() - start;
+	restore();
+	remove( path );
+	mm_bench_report( "mm_log_event, 4 bytes", APPENDS, elapsed[ 0 ] );
+	mm_bench_report( "mm_log sync, recorder on", APPENDS / 16, elapsed[ 1 ] );
+	mm_bench_report( "mm_log sync, recorder off", APPENDS / 16, elapsed[ 2 ] );
+}
+
+MM_BENCH_SUITE( log_suite ) {
+	MM_BENCH_RUN( log_latency_bench );
+	MM_BENCH_RUN( log_defer_bench );
+	MM_BENCH_RUN( log_filtered_bench );
+	MM_BENCH_RUN( log_recorder_bench );
+}
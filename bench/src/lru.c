@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/lru.h"
+#include "mm/random.h"
+
+#define KEYS ( 1u << 20 )
+#define REQUESTS ( 1u << 22 )
+#define ZIPF_S 0.99
+
+static struct mm_lru_node *nodes;
+static uint_least32_t *requests;
+
+// zipf distributed ranks by binary search over the cumulative distribution
+static bool setup( void ) {
+	double *cdf = MM_MALLOC( sizeof( *cdf ) * KEYS );
+	double sum = 0;
+	struct mm_random r;
+
+	nodes = MM_MALLOC( sizeof( *nodes ) * KEYS );
+	requests = MM_MALLOC( sizeof( *requests ) * REQUESTS );
+
+	if ( !cdf || !nodes || !requests ) {
+		MM_FREE( cdf );
+		return false;
+	}
+
+	for ( size_t i = 0; i < KEYS; ++i ) {
+		sum += 1.0 / pow( ( double ) ( i + 1 ), ZIPF_S );
+		cdf[ i ] = sum;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < REQUESTS; ++i ) {
+		double u = ( double ) mm_random_next( &r, 0, 1ul << 30 ) / ( double ) ( 1ul << 30 ) * sum;
+		size_t lo = 0, hi = KEYS - 1;
+
+		while ( lo < hi ) {
+			size_t mid = ( lo + hi ) / 2;
+
+			if ( cdf[ mid ] < u ) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		requests[ i ] = ( uint_least32_t ) lo;
+	}
+
+	MM_FREE( cdf );
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( nodes );
+	MM_FREE( requests );
+}
+
+static void run( const char *label, enum mm_lru_policy policy, size_t capacity ) {
+	struct mm_lru lru;
+	size_t hits = 0;
+	uint_least64_t start, elapsed;
+	char name[ 64 ];
+
+	if ( !mm_lru_init( &lru, capacity, policy, NULL, NULL ) ) {
+		return;
+	}
+
+	start = mm_bench_now();
+
+	// every key has its own node, so a miss can always insert it
+	for ( size_t i = 0; i < REQUESTS; ++i ) {
+		uint_least32_t key = requests[ i ];
+
+		if ( mm_lru_find( &lru, key ) ) {
+			++hits;
+		} else {
+			mm_lru_insert( &lru, &nodes[ key ], key, 1 );
+		}
+	}
+
+	elapsed = mm_bench_now() - start;
+	snprintf( name, sizeof( name ), "%s %zu entries ( %.1f%% hits )", label, capacity, 100.0 * ( double ) hits / REQUESTS );
+	mm_bench_report( name, REQUESTS, elapsed );
+
+	mm_lru_destroy( &lru );
+}
+
+MM_BENCH_CASE( lru_zipf_bench, setup, teardown ) {
+	static const size_t capacities[] = { KEYS / 100, KEYS / 10 };
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( capacities ); ++i ) {
+		run( "lru", MM_LRU_LRU, capacities[ i ] );
+		run( "clock", MM_LRU_CLOCK, capacities[ i ] );
+		run( "slru", MM_LRU_SLRU, capacities[ i ] );
+	}
+}
+
+MM_BENCH_SUITE( lru_suite ) {
+	MM_BENCH_RUN( lru_zipf_bench );
+}
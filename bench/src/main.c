@@ -0,0 +1,62 @@
+#include <string.h>
+#include "mm/common.h"
+#include "mm/bench.h"
+
+MM_BENCH_IMPORT( bit_suite );
+MM_BENCH_IMPORT( bitset_suite );
+MM_BENCH_IMPORT( bitvector_suite );
+MM_BENCH_IMPORT( btree_suite );
+MM_BENCH_IMPORT( chan_suite );
+MM_BENCH_IMPORT( cmap_suite );
+MM_BENCH_IMPORT( distribution_suite );
+MM_BENCH_IMPORT( executor_suite );
+MM_BENCH_IMPORT( fiber_suite );
+MM_BENCH_IMPORT( hash_suite );
+MM_BENCH_IMPORT( hashmap_suite );
+MM_BENCH_IMPORT( log_suite );
+MM_BENCH_IMPORT( lru_suite );
+MM_BENCH_IMPORT( random_suite );
+MM_BENCH_IMPORT( rbtree_suite );
+MM_BENCH_IMPORT( reactor_suite );
+MM_BENCH_IMPORT( roaring_suite );
+MM_BENCH_IMPORT( sched_suite );
+MM_BENCH_IMPORT( timer_suite );
+
+static struct mm_bench *suites[] = {
+	&bit_suite,
+	&bitset_suite,
+	&bitvector_suite,
+	&btree_suite,
+	&chan_suite,
+	&cmap_suite,
+	&distribution_suite,
+	&executor_suite,
+	&fiber_suite,
+	&hash_suite,
+	&hashmap_suite,
+	&log_suite,
+	&lru_suite,
+	&random_suite,
+	&rbtree_suite,
+	&reactor_suite,
+	&roaring_suite,
+	&sched_suite,
+	&timer_suite
+};
+
+// run every suite, or only the suites named on the command line
+int main( int argc, const char *argv[] ) {
+	for ( size_t i = 0; i < MM_ARR_SIZE( suites ); ++i ) {
+		bool selected = argc < 2;
+
+		for ( int j = 1; j < argc && !selected; ++j ) {
+			selected = !strcmp( argv[ j ], suites[ i ]->name );
+		}
+
+		if ( selected ) {
+			MM_BENCH_RUN_SUITE( ( *suites[ i ] ) );
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
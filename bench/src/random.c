@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <threads.h>
+#include "mm/bench.h"
+#include "mm/random.h"
+
+#define VOLUME ( 1u << 30 )
+#define BUFFER_SIZE ( 1u << 16 )
+#define DRAWS ( 1u << 26 )
+
+static unsigned char *buffer;
+
+static bool setup( void ) {
+	buffer = MM_MALLOC( BUFFER_SIZE );
+
+	return buffer != NULL;
+}
+
+static void teardown( void ) {
+	MM_FREE( buffer );
+}
+
+// the buffer stays in L2, this is generation speed rather than memory bandwidth
+MM_BENCH_CASE( random_fill_bench, setup, teardown ) {
+	struct mm_random r;
+	uint_least64_t start;
+	uint_least64_t sum = 0;
+
+	mm_random_reset( &r, 42 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < VOLUME / BUFFER_SIZE; ++i ) {
+		mm_random_fill( &r, buffer, BUFFER_SIZE );
+		MM_BENCH_KEEP( buffer );
+	}
+
+	mm_bench_report_bytes( "mm_random_fill 64 KiB", VOLUME, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < VOLUME / 8; ++i ) {
+		sum += mm_random_u64( &r );
+	}
+
+	mm_bench_report_bytes( "mm_random_u64", VOLUME, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+}
+
+MM_BENCH_CASE( random_draw_bench, NULL, NULL ) {
+	struct mm_random r;
+	uint_least64_t start;
+	unsigned long sum = 0;
+	double total = 0.0;
+
+	mm_random_reset( &r, 42 );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_random_next( &r, 0, 1000 );
+	}
+
+	mm_bench_report( "mm_random_next [0, 1000)", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		sum += mm_random_next( &r, 0, i + 1 );
+	}
+
+	mm_bench_report( "mm_random_next, shuffle sized ranges", DRAWS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < DRAWS; ++i ) {
+		total += mm_random_double( &r );
+	}
+
+	mm_bench_report( "mm_random_double", DRAWS, mm_bench_now() - start );
+	MM_BENCH_KEEP( sum );
+	MM_BENCH_KEEP( total );
+}
+
+#define MAX_THREADS 8
+#define SAMPLES ( 1u << 24 )
+
+struct pi_job {
+	struct mm_random *r;
+	mtx_t *lock;
+	size_t samples;
+	size_t inside;
+};
+
+// monte carlo pi, the lock is what sharing one generator costs. a split stream is copied to the
+// worker's stack so neighbouring jobs don't share cache lines
+static int pi_worker( void *arg ) {
+	struct pi_job *job = arg;
+	struct mm_random *r = job->r;
+	struct mm_random copy;
+	size_t inside = 0;
+
+	// the shared generator is only read under the lock
+	if ( !job->lock ) {
+		copy = *job->r;
+		r = &copy;
+	}
+
+	for ( size_t i = 0; i < job->samples; ++i ) {
+		double x, y;
+
+		if ( job->lock ) {
+			mtx_lock( job->lock );
+		}
+
+		x = mm_random_double( r );
+		y = mm_random_double( r );
+
+		if ( job->lock ) {
+			mtx_unlock( job->lock );
+		}
+
+		inside += x * x + y * y < 1.0;
+	}
+
+	job->inside = inside;
+
+	return 0;
+}
+
+static void pi( size_t threads, bool shared ) {
+	struct mm_random streams[ MAX_THREADS ];
+	struct pi_job jobs[ MAX_THREADS ];
+	thrd_t ids[ MAX_THREADS ];
+	struct mm_random r;
+	mtx_t lock;
+	uint_least64_t start;
+	size_t inside = 0;
+	char name[ 64 ];
+
+	mm_random_reset( &r, 42 );
+	mm_random_split( &r, streams, threads );
+	mtx_init( &lock, mtx_plain );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < threads; ++i ) {
+		jobs[ i ] = ( struct pi_job ) { shared ? &r : &streams[ i ], shared ? &lock : NULL, SAMPLES / threads, 0 };
+		thrd_create( &ids[ i ], pi_worker, &jobs[ i ] );
+	}
+
+	for ( size_t i = 0; i < threads; ++i ) {
+		thrd_join( ids[ i ], NULL );
+		inside += jobs[ i ].inside;
+	}
+
+	snprintf( name, sizeof( name ), "pi, %zu threads, %s", threads, shared ? "shared under a lock" : "split streams" );
+	mm_bench_report( name, SAMPLES, mm_bench_now() - start );
+	MM_BENCH_KEEP( inside );
+	mtx_destroy( &lock );
+}
+
+// the same total work spread over more threads, split streams scale with the cores
+MM_BENCH_CASE( random_parallel_bench, NULL, NULL ) {
+	for ( size_t threads = 1; threads <= MAX_THREADS; threads *= 2 ) {
+		pi( threads, false );
+	}
+
+	for ( size_t threads = 1; threads <= MAX_THREADS; threads *= 2 ) {
+		pi( threads, true );
+	}
+}
+
+MM_BENCH_SUITE( random_suite ) {
+	MM_BENCH_RUN( random_fill_bench );
+	MM_BENCH_RUN( random_draw_bench );
+	MM_BENCH_RUN( random_parallel_bench );
+}
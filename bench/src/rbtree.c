@@ -0,0 +1,169 @@
+#include <string.h>
+#include "mm/bench.h"
+#include "mm/random.h"
+#include "mm/rbtree.h"
+#include "mm/vector.h"
+
+#define COUNT 1000000
+// ordered insertion into a vector is O( n ) per call, so it gets a smaller run
+#define VECTOR_COUNT 100000
+
+struct entry {
+	struct mm_rbtree_node node;
+	unsigned int key;
+};
+
+static unsigned int *keys;
+static struct entry *entries;
+
+static int entry_cmp( const struct mm_rbtree_node *lhs, const struct mm_rbtree_node *rhs ) {
+	unsigned int a = MM_CONTAINER_OF( lhs, struct entry, node )->key;
+	unsigned int b = MM_CONTAINER_OF( rhs, struct entry, node )->key;
+
+	return ( a > b ) - ( a < b );
+}
+
+static int key_cmp( const void *key, const struct mm_rbtree_node *node ) {
+	unsigned int a = *( const unsigned int* ) key;
+	unsigned int b = MM_CONTAINER_OF( node, struct entry, node )->key;
+
+	return ( a > b ) - ( a < b );
+}
+
+static int uint_cmp( const void *lhs, const void *rhs ) {
+	unsigned int a = *( const unsigned int* ) lhs;
+	unsigned int b = *( const unsigned int* ) rhs;
+
+	return ( a > b ) - ( a < b );
+}
+
+static unsigned int* vector_lower_bound( struct mm_vector *vec, unsigned int key ) {
+	unsigned int *begin = mm_vector_begin( vec );
+	size_t len = mm_vector_size( vec );
+
+	while ( len ) {
+		size_t half = len / 2;
+
+		if ( begin[ half ] < key ) {
+			begin += half + 1;
+			len -= half + 1;
+		} else {
+			len = half;
+		}
+	}
+
+	return begin;
+}
+
+// shuffled, unique keys
+static bool setup( void ) {
+	struct mm_random r;
+
+	keys = MM_MALLOC( sizeof( *keys ) * COUNT );
+	entries = MM_MALLOC( sizeof( *entries ) * COUNT );
+
+	if ( !keys || !entries ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( unsigned int i = 0; i < COUNT; ++i ) {
+		keys[ i ] = i * 2654435761u;
+	}
+
+	for ( unsigned int i = COUNT - 1; i > 0; --i ) {
+		unsigned int j = mm_random_next( &r, 0, i + 1 );
+		unsigned int tmp = keys[ i ];
+
+		keys[ i ] = keys[ j ];
+		keys[ j ] = tmp;
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( keys );
+	MM_FREE( entries );
+}
+
+MM_BENCH_CASE( rbtree_bench, setup, teardown ) {
+	MM_RBTREE_DECLARE( tree );
+	uint_least64_t start;
+	size_t found = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		entries[ i ].key = keys[ i ];
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	mm_bench_report( "rbtree insert", COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		found += mm_rbtree_find( &tree, &keys[ COUNT - i - 1 ], key_cmp ) != NULL;
+	}
+
+	mm_bench_report( "rbtree find", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( found );
+
+	struct mm_rbtree_node *pos;
+	start = mm_bench_now();
+
+	MM_RBTREE_FOREACH( &tree, pos ) {
+		++found;
+	}
+
+	mm_bench_report( "rbtree in-order walk", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( found );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		mm_rbtree_erase( &tree, &entries[ i ].node );
+	}
+
+	mm_bench_report( "rbtree erase", COUNT, mm_bench_now() - start );
+}
+
+MM_BENCH_CASE( sorted_vector_bench, setup, teardown ) {
+	MM_VECTOR_DECLARE( vec, unsigned int, uint_cmp );
+	uint_least64_t start;
+	size_t found = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < VECTOR_COUNT; ++i ) {
+		mm_vector_insert( &vec, vector_lower_bound( &vec, keys[ i ] ), &keys[ i ] );
+	}
+
+	mm_bench_report( "sorted mm_vector insert ( 100k )", VECTOR_COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < VECTOR_COUNT; ++i ) {
+		mm_vector_erase( &vec, vector_lower_bound( &vec, keys[ i ] ), NULL );
+	}
+
+	mm_bench_report( "sorted mm_vector erase ( 100k )", VECTOR_COUNT, mm_bench_now() - start );
+	mm_vector_resize( &vec, COUNT );
+	memcpy( mm_vector_begin( &vec ), keys, sizeof( *keys ) * COUNT );
+	start = mm_bench_now();
+	mm_vector_sort( &vec );
+	mm_bench_report( "mm_vector sort ( bulk build )", COUNT, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		found += mm_vector_search( &vec, &keys[ COUNT - i - 1 ] ) != NULL;
+	}
+
+	mm_bench_report( "mm_vector_search", COUNT, mm_bench_now() - start );
+	MM_BENCH_KEEP( found );
+	mm_vector_destroy( &vec );
+}
+
+MM_BENCH_SUITE( rbtree_suite ) {
+	MM_BENCH_RUN( rbtree_bench );
+	MM_BENCH_RUN( sorted_vector_bench );
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "mm/bench.h"
+#include "mm/random.h"
+#include "mm/reactor.h"
+
+#define MAX_CONNS 100000
+#define WAKES ( 1u << 18 )
+
+struct conn {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_reactor_fd io;
+	int peer;
+	size_t bytes;
+};
+
+static struct mm_reactor reactor;
+static struct conn *conns;
+static size_t count;
+
+MM_COROUTINE( idle_conn, struct mm_sched_task *task ) {
+	struct conn *this = MM_SCHED_CONTAINER( task, struct conn, task );
+	char buf[ 16 ];
+	ssize_t len;
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+		len = mm_reactor_read( &this->io, buf, sizeof( buf ) );
+
+		if ( len == 0 ) {
+			break;
+		}
+
+		if ( len > 0 ) {
+			this->bytes += ( size_t ) len;
+		}
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	MM_CO_END( &this->co );
+}
+
+// as many socketpairs as the fd limit allows, up to MAX_CONNS
+static bool setup( void ) {
+	struct rlimit limit;
+
+	if ( !getrlimit( RLIMIT_NOFILE, &limit ) && limit.rlim_cur < limit.rlim_max ) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit( RLIMIT_NOFILE, &limit );
+	}
+
+	if ( getrlimit( RLIMIT_NOFILE, &limit ) || !mm_reactor_init( &reactor, NULL, NULL ) ) {
+		return false;
+	}
+
+	count = limit.rlim_cur == RLIM_INFINITY ? MAX_CONNS : ( size_t ) ( limit.rlim_cur - 64 ) / 2;
+	count = count < MAX_CONNS ? count : MAX_CONNS;
+	conns = MM_CALLOC( count, sizeof( *conns ) );
+
+	return conns != NULL;
+}
+
+static void teardown( void ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		close( conns[ i ].io.fd );
+		close( conns[ i ].peer );
+	}
+
+	MM_FREE( conns );
+	mm_reactor_destroy( &reactor );
+}
+
+MM_BENCH_CASE( idle_bench, setup, teardown ) {
+	struct mm_random r;
+	uint_least64_t start, elapsed = 0;
+	size_t woken = 0, bytes = 0;
+	char name[ 64 ];
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < count; ++i ) {
+		int fds[ 2 ];
+
+		if ( socketpair( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds ) ) {
+			count = i;
+			break;
+		}
+
+		conns[ i ].peer = fds[ 1 ];
+		MM_CO_INIT( &conns[ i ].co );
+		mm_reactor_add( &reactor, &conns[ i ].io, fds[ 0 ] );
+		mm_sched_spawn( &reactor.sched, &conns[ i ].task, idle_conn );
+	}
+
+	// every connection parks on its first await
+	mm_sched_run( &reactor.sched );
+	snprintf( name, sizeof( name ), "register and park ( %zu conns )", count );
+	mm_bench_report( name, count, mm_bench_now() - start );
+
+	// wake a random batch of idle connections at a time, only the dispatch is timed
+	mm_random_reset( &r, 42 );
+
+	while ( woken < WAKES ) {
+		int handled;
+
+		for ( size_t i = 0; i < MM_REACTOR_BATCH; ++i ) {
+			ssize_t ret = write( conns[ mm_random_next( &r, 0, count ) ].peer, "x", 1 );
+			( void ) ret;
+		}
+
+		start = mm_bench_now();
+
+		do {
+			handled = mm_reactor_poll( &reactor, 0 );
+			mm_sched_run( &reactor.sched );
+			woken += handled > 0 ? ( size_t ) handled : 0;
+		} while ( handled == MM_REACTOR_BATCH );
+
+		elapsed += mm_bench_now() - start;
+	}
+
+	snprintf( name, sizeof( name ), "wake idle conn ( %zu conns )", count );
+	mm_bench_report( name, woken, elapsed );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		bytes += conns[ i ].bytes;
+	}
+
+	MM_BENCH_KEEP( bytes );
+}
+
+struct waiter {
+	struct mm_sched_task task;
+	struct mm_co co;
+	size_t seen;
+};
+
+MM_COROUTINE( notify_conn, struct mm_sched_task *task ) {
+	struct waiter *this = MM_SCHED_CONTAINER( task, struct waiter, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_SCHED_AWAIT( &this->co, task, &reactor.notified );
+		++this->seen;
+	}
+
+	MM_CO_END( &this->co );
+}
+
+// notify, epoll_wait on the eventfd, drain and resume the waiting task
+MM_BENCH_CASE( notify_bench, NULL, NULL ) {
+	struct waiter waiter = { .seen = 0 };
+	uint_least64_t start;
+
+	if ( !mm_reactor_init( &reactor, NULL, NULL ) ) {
+		return;
+	}
+
+	MM_CO_INIT( &waiter.co );
+	mm_sched_spawn( &reactor.sched, &waiter.task, notify_conn );
+	mm_sched_run( &reactor.sched );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < WAKES; ++i ) {
+		mm_reactor_notify( &reactor );
+		mm_reactor_poll( &reactor, -1 );
+		mm_sched_run( &reactor.sched );
+	}
+
+	mm_bench_report( "notify round trip", WAKES, mm_bench_now() - start );
+	MM_BENCH_KEEP( waiter.seen );
+	mm_reactor_destroy( &reactor );
+}
+
+MM_BENCH_SUITE( reactor_suite ) {
+	MM_BENCH_RUN( idle_bench );
+	MM_BENCH_RUN( notify_bench );
+}
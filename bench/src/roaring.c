@@ -0,0 +1,176 @@
+#include "mm/bench.h"
+#include "mm/bitset.h"
+#include "mm/random.h"
+#include "mm/roaring.h"
+
+// document ids of a 16M document index
+#define UNIVERSE ( 1u << 24 )
+#define REPS 64
+
+struct list {
+	const char *name;
+	size_t count;
+	bool clustered;
+	struct mm_bitset bits;
+	uint_least32_t *ids;
+	size_t size;
+	struct mm_roaring rb;
+};
+
+// posting lists from a rare term up to a quarter of the index, and one that follows document age
+static struct list lists[] = {
+	{ .name = "1k", .count = 1000 },
+	{ .name = "100k", .count = 100000 },
+	{ .name = "1M", .count = 1000000 },
+	{ .name = "4M", .count = 4000000 },
+	{ .name = "1M clustered", .count = 1000000, .clustered = true }
+};
+
+static const struct { size_t lhs, rhs; } pairs[] = {
+	{ 0, 2 }, { 1, 2 }, { 2, 3 }, { 4, 2 }
+};
+
+static bool setup( void ) {
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t l = 0; l < MM_ARR_SIZE( lists ); ++l ) {
+		struct list *list = &lists[ l ];
+		size_t id = 0;
+
+		if ( !mm_bitset_init( &list->bits, UNIVERSE ) ) {
+			return false;
+		}
+
+		// 64 blocks of consecutive ids, or ids anywhere with the odd repeat
+		for ( size_t i = 0; i < list->count; ++i ) {
+			if ( list->clustered && i % ( list->count / 64 ) == 0 ) {
+				id = mm_random_next( &r, 0, UNIVERSE - list->count / 64 );
+			} else {
+				id = list->clustered ? id + 1 : mm_random_next( &r, 0, UNIVERSE );
+			}
+
+			mm_bitset_set( &list->bits, id );
+		}
+
+		list->size = mm_bitset_count( &list->bits );
+		list->ids = MM_MALLOC( sizeof( *list->ids ) * list->size );
+		mm_roaring_init( &list->rb );
+
+		if ( !list->ids ) {
+			return false;
+		}
+
+		list->size = 0;
+
+		MM_BITSET_FOR_EACH( &list->bits, id ) {
+			list->ids[ list->size++ ] = ( uint_least32_t ) id;
+
+			if ( !mm_roaring_add( &list->rb, ( uint_least32_t ) id ) ) {
+				return false;
+			}
+		}
+
+		if ( !mm_roaring_optimize( &list->rb ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	for ( size_t l = 0; l < MM_ARR_SIZE( lists ); ++l ) {
+		mm_bitset_destroy( &lists[ l ].bits );
+		mm_roaring_destroy( &lists[ l ].rb );
+		MM_FREE( lists[ l ].ids );
+	}
+}
+
+// what the posting lists were before, sorted ids in a vector
+static size_t merge_count( const uint_least32_t *a, size_t na, const uint_least32_t *b, size_t nb ) {
+	size_t count = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	while ( i < na && j < nb ) {
+		if ( a[ i ] < b[ j ] ) {
+			++i;
+		} else if ( a[ i ] > b[ j ] ) {
+			++j;
+		} else {
+			++count;
+			++i;
+			++j;
+		}
+	}
+
+	return count;
+}
+
+MM_BENCH_CASE( roaring_memory_bench, setup, teardown ) {
+	for ( size_t l = 0; l < MM_ARR_SIZE( lists ); ++l ) {
+		char name[ 64 ];
+
+		snprintf( name, sizeof( name ), "%s roaring", lists[ l ].name );
+		mm_log( MM_INFO, "  %-40s %12.3f bytes/id", name, ( double ) mm_roaring_serialized_size( &lists[ l ].rb ) / ( double ) lists[ l ].size );
+		snprintf( name, sizeof( name ), "%s sorted ids", lists[ l ].name );
+		mm_log( MM_INFO, "  %-40s %12.3f bytes/id", name, ( double ) sizeof( *lists[ l ].ids ) );
+		snprintf( name, sizeof( name ), "%s bitset", lists[ l ].name );
+		mm_log( MM_INFO, "  %-40s %12.3f bytes/id", name, ( double ) UNIVERSE / 8 / ( double ) lists[ l ].size );
+	}
+}
+
+MM_BENCH_CASE( roaring_and_bench, setup, teardown ) {
+	size_t sum = 0;
+
+	for ( size_t p = 0; p < MM_ARR_SIZE( pairs ); ++p ) {
+		struct list *a = &lists[ pairs[ p ].lhs ];
+		struct list *b = &lists[ pairs[ p ].rhs ];
+		uint_least64_t start = mm_bench_now();
+		char name[ 64 ];
+
+		for ( size_t i = 0; i < REPS; ++i ) {
+			sum += merge_count( a->ids, a->size, b->ids, b->size );
+		}
+
+		snprintf( name, sizeof( name ), "%s & %s sorted ids merge", a->name, b->name );
+		mm_bench_report( name, REPS, mm_bench_now() - start );
+		start = mm_bench_now();
+
+		for ( size_t i = 0; i < REPS; ++i ) {
+			sum += mm_bitset_and_count( &a->bits, &b->bits );
+		}
+
+		snprintf( name, sizeof( name ), "%s & %s bitset count", a->name, b->name );
+		mm_bench_report( name, REPS, mm_bench_now() - start );
+		start = mm_bench_now();
+
+		for ( size_t i = 0; i < REPS; ++i ) {
+			sum += mm_roaring_and_cardinality( &a->rb, &b->rb );
+		}
+
+		snprintf( name, sizeof( name ), "%s & %s roaring count", a->name, b->name );
+		mm_bench_report( name, REPS, mm_bench_now() - start );
+		start = mm_bench_now();
+
+		for ( size_t i = 0; i < REPS; ++i ) {
+			struct mm_roaring result;
+
+			mm_roaring_and( &result, &a->rb, &b->rb );
+			sum += result.size;
+			mm_roaring_destroy( &result );
+		}
+
+		snprintf( name, sizeof( name ), "%s & %s roaring and", a->name, b->name );
+		mm_bench_report( name, REPS, mm_bench_now() - start );
+	}
+
+	MM_BENCH_KEEP( sum );
+}
+
+MM_BENCH_SUITE( roaring_suite ) {
+	MM_BENCH_RUN( roaring_memory_bench );
+	MM_BENCH_RUN( roaring_and_bench );
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include "mm/bench.h"
+#include "mm/sched.h"
+
+#define SWITCHES ( 1u << 23 )
+#define MAX_TASKS 100000
+#define PING_PONGS ( 1u << 21 )
+
+struct task {
+	struct mm_sched_task task;
+	struct mm_co co;
+	size_t left;
+	size_t sum;
+};
+
+static struct task *tasks;
+
+static bool setup( void ) {
+	tasks = MM_MALLOC( sizeof( *tasks ) * MAX_TASKS );
+
+	return tasks != NULL;
+}
+
+static void teardown( void ) {
+	MM_FREE( tasks );
+}
+
+MM_COROUTINE( spinner, struct mm_sched_task *task ) {
+	struct task *this = MM_SCHED_CONTAINER( task, struct task, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	while ( this->left-- ) {
+		this->sum += this->left;
+		MM_CO_YIELD( &this->co );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+// the same number of switches spread over more tasks, so the working set outgrows the caches
+MM_BENCH_CASE( switch_bench, setup, teardown ) {
+	static const size_t counts[] = { 1, 100, 10000, MAX_TASKS };
+
+	for ( size_t c = 0; c < MM_ARR_SIZE( counts ); ++c ) {
+		struct mm_sched sched;
+		uint_least64_t start;
+		size_t steps, sum = 0;
+		char name[ 64 ];
+
+		mm_sched_init( &sched, NULL, NULL );
+
+		for ( size_t i = 0; i < counts[ c ]; ++i ) {
+			tasks[ i ].left = SWITCHES / counts[ c ];
+			tasks[ i ].sum = i;
+			MM_CO_INIT( &tasks[ i ].co );
+			mm_sched_spawn( &sched, &tasks[ i ].task, spinner );
+		}
+
+		start = mm_bench_now();
+		steps = mm_sched_run( &sched );
+		snprintf( name, sizeof( name ), "mm_sched switch ( %zu tasks )", counts[ c ] );
+		mm_bench_report( name, steps, mm_bench_now() - start );
+
+		for ( size_t i = 0; i < counts[ c ]; ++i ) {
+			sum += tasks[ i ].sum;
+		}
+
+		MM_BENCH_KEEP( sum );
+	}
+}
+
+static struct mm_sched pong_sched;
+static struct mm_sched_event events[ 2 ];
+
+MM_COROUTINE( pinger, struct mm_sched_task *task ) {
+	struct task *this = MM_SCHED_CONTAINER( task, struct task, task );
+	size_t side = ( size_t ) ( this - tasks );
+
+	MM_CO_BEGIN( &this->co );
+
+	while ( this->left-- ) {
+		mm_sched_event_signal( &pong_sched, &events[ !side ] );
+		MM_SCHED_AWAIT( &this->co, task, &events[ side ] );
+	}
+
+	mm_sched_event_signal( &pong_sched, &events[ !side ] );
+	MM_CO_END( &this->co );
+}
+
+// every step parks one task on its event and wakes the other
+MM_BENCH_CASE( ping_pong_bench, setup, teardown ) {
+	uint_least64_t start;
+	size_t steps;
+
+	mm_sched_init( &pong_sched, NULL, NULL );
+
+	for ( size_t i = 0; i < 2; ++i ) {
+		mm_sched_event_init( &events[ i ] );
+		tasks[ i ].left = PING_PONGS;
+		MM_CO_INIT( &tasks[ i ].co );
+		mm_sched_spawn( &pong_sched, &tasks[ i ].task, pinger );
+	}
+
+	start = mm_bench_now();
+	steps = mm_sched_run( &pong_sched );
+	mm_bench_report( "mm_sched event ping-pong", steps, mm_bench_now() - start );
+	MM_BENCH_KEEP( pong_sched.count );
+}
+
+MM_BENCH_SUITE( sched_suite ) {
+	MM_BENCH_RUN( switch_bench );
+	MM_BENCH_RUN( ping_pong_bench );
+}
@@ -0,0 +1,161 @@
+#include "mm/bench.h"
+#include "mm/random.h"
+#include "mm/rbtree.h"
+#include "mm/timer.h"
+
+#define TIMERS 1000000
+#define CHURN ( 1u << 22 )
+// ten minutes of millisecond ticks
+#define HORIZON 600000
+
+struct entry {
+	struct mm_timer timer;
+	struct mm_rbtree_node node;
+	uint_least64_t expires;
+};
+
+static struct entry *entries;
+static uint_least32_t *picks;
+static uint_least32_t *delays;
+static size_t fired;
+
+static bool setup( void ) {
+	struct mm_random r;
+
+	entries = MM_MALLOC( sizeof( *entries ) * TIMERS );
+	picks = MM_MALLOC( sizeof( *picks ) * CHURN );
+	delays = MM_MALLOC( sizeof( *delays ) * ( TIMERS + CHURN ) );
+
+	if ( !entries || !picks || !delays ) {
+		return false;
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < CHURN; ++i ) {
+		picks[ i ] = ( uint_least32_t ) mm_random_next( &r, 0, TIMERS );
+	}
+
+	for ( size_t i = 0; i < TIMERS + CHURN; ++i ) {
+		delays[ i ] = ( uint_least32_t ) mm_random_next( &r, 1, HORIZON );
+	}
+
+	return true;
+}
+
+static void teardown( void ) {
+	MM_FREE( entries );
+	MM_FREE( picks );
+	MM_FREE( delays );
+}
+
+static void on_expire( struct mm_timer *timer ) {
+	( void ) timer;
+	++fired;
+}
+
+// schedule, then keep resetting random timeouts the way idle connections do, then let everything run out
+MM_BENCH_CASE( timer_wheel_bench, setup, teardown ) {
+	struct mm_timer_wheel *wheel = MM_MALLOC( sizeof( *wheel ) );
+	uint_least64_t start, now = 1000;
+
+	if ( !wheel ) {
+		return;
+	}
+
+	mm_timer_wheel_init( wheel, now );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < TIMERS; ++i ) {
+		mm_timer_init( &entries[ i ].timer, on_expire );
+		mm_timer_add( wheel, &entries[ i ].timer, now + delays[ i ] );
+	}
+
+	mm_bench_report( "mm_timer_add ( 1M )", TIMERS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < CHURN; ++i ) {
+		struct mm_timer *timer = &entries[ picks[ i ] ].timer;
+
+		mm_timer_cancel( wheel, timer );
+		mm_timer_add( wheel, timer, now + i / 1024 + delays[ TIMERS + i ] );
+
+		// time moves on a little between resets
+		if ( i % 1024 == 1023 ) {
+			mm_timer_wheel_advance( wheel, ++now );
+		}
+	}
+
+	mm_bench_report( "mm_timer cancel + add ( 1M pending )", CHURN, mm_bench_now() - start );
+	fired = 0;
+	start = mm_bench_now();
+
+	while ( mm_timer_wheel_size( wheel ) ) {
+		mm_timer_wheel_advance( wheel, ++now );
+	}
+
+	mm_bench_report( "mm_timer_wheel_advance per fired", ( double ) fired, mm_bench_now() - start );
+	MM_FREE( wheel );
+}
+
+static int entry_cmp( const struct mm_rbtree_node *lhs, const struct mm_rbtree_node *rhs ) {
+	const struct entry *a = MM_CONTAINER_OF( lhs, struct entry, node );
+	const struct entry *b = MM_CONTAINER_OF( rhs, struct entry, node );
+
+	// ties broken by address, so equal expiries can coexist
+	if ( a->expires != b->expires ) {
+		return ( a->expires > b->expires ) - ( a->expires < b->expires );
+	}
+
+	return ( a > b ) - ( a < b );
+}
+
+// the same workload on a sorted tree, the usual alternative
+MM_BENCH_CASE( timer_rbtree_bench, setup, teardown ) {
+	MM_RBTREE_DECLARE( tree );
+	uint_least64_t start, now = 1000;
+	size_t expired = 0;
+
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < TIMERS; ++i ) {
+		entries[ i ].expires = now + delays[ i ];
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	mm_bench_report( "mm_rbtree insert ( 1M )", TIMERS, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	for ( size_t i = 0; i < CHURN; ++i ) {
+		struct entry *entry = &entries[ picks[ i ] ];
+
+		if ( i % 1024 == 1023 ) {
+			++now;
+		}
+
+		mm_rbtree_erase( &tree, &entry->node );
+		entry->expires = now + i / 1024 + delays[ TIMERS + i ];
+		mm_rbtree_insert( &tree, &entry->node, entry_cmp );
+	}
+
+	mm_bench_report( "mm_rbtree erase + insert ( 1M pending )", CHURN, mm_bench_now() - start );
+	start = mm_bench_now();
+
+	while ( !mm_rbtree_empty( &tree ) ) {
+		struct mm_rbtree_node *first;
+
+		++now;
+
+		while ( ( first = mm_rbtree_first( &tree ) ) && MM_CONTAINER_OF( first, struct entry, node )->expires <= now ) {
+			mm_rbtree_erase( &tree, first );
+			++expired;
+		}
+	}
+
+	mm_bench_report( "mm_rbtree pop expired per fired", ( double ) expired, mm_bench_now() - start );
+}
+
+MM_BENCH_SUITE( timer_suite ) {
+	MM_BENCH_RUN( timer_wheel_bench );
+	MM_BENCH_RUN( timer_rbtree_bench );
+}
@@ -0,0 +1,125 @@
+#ifndef MM_BENCH_H
+#define MM_BENCH_H
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mm/common.h"
+#include "mm/log.h"
+
+/*! \file */
+
+/*!
+	\brief A single benchmark, laid out the same way as mm_unit.
+
+	Cases time themselves with mm_bench_now() and print results through mm_bench_report(),
+	so a single case can report several measurements.
+*/
+typedef struct mm_bench {
+	const char *name;
+	bool ( *setup )( void );
+	void ( *teardown )( void );
+	void ( *run )( void );
+} mm_bench_t;
+
+/*!
+	\return monotonic time in nanoseconds.
+*/
+static inline uint_least64_t mm_bench_now( void ) {
+	struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+#else
+	timespec_get( &ts, TIME_UTC );
+#endif
+	return ( uint_least64_t ) ts.tv_sec * 1000000000u + ( uint_least64_t ) ts.tv_nsec;
+}
+
+/*!
+	\brief Print operations per second and nanoseconds per operation.
+	\param name label for the measurement.
+	\param ops number of operations performed.
+	\param ns elapsed time in nanoseconds.
+*/
+static inline void mm_bench_report( const char *name, double ops, uint_least64_t ns ) {
+	double secs = ( double ) ns / 1e9;
+
+	mm_log( MM_INFO, "  %-40s %12.3f Mops/s %10.2f ns/op", name, ops / secs / 1e6, ( double ) ns / ops );
+}
+
+/*!
+	\brief Print throughput in gigabytes per second.
+	\param name label for the measurement.
+	\param bytes number of bytes processed.
+	\param ns elapsed time in nanoseconds.
+*/
+static inline void mm_bench_report_bytes( const char *name, double bytes, uint_least64_t ns ) {
+	mm_log( MM_INFO, "  %-40s %12.3f GB/s", name, bytes / ( double ) ns );
+}
+
+/*!
+	\brief Stop the compiler from optimizing away a computed value.
+*/
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define MM_BENCH_KEEP( value )\
+	__asm__ volatile( "" : : "r"( value ) : "memory" )
+#else
+#define MM_BENCH_KEEP( value )\
+	do {\
+		static volatile uintmax_t mm_bench_sink;\
+		mm_bench_sink = ( uintmax_t ) ( value );\
+	} while( 0 )
+#endif
+
+#define MM_BENCH_RUN_NAME( name )\
+	name##_run
+
+#define MM_BENCH_CASE( cname, csetup, cteardown )\
+	static void MM_BENCH_RUN_NAME( cname )( void );\
+	\
+	struct mm_bench cname = {\
+		.name = #cname,\
+		.setup = csetup,\
+		.teardown = cteardown,\
+		.run = MM_BENCH_RUN_NAME( cname )\
+	};\
+	\
+	static void MM_BENCH_RUN_NAME( cname )( void )
+
+#define MM_BENCH_IMPORT( name )\
+	extern struct mm_bench name
+
+#define MM_BENCH_SUITE( sname )\
+	void MM_BENCH_RUN_NAME( sname )( void );\
+	\
+	struct mm_bench sname = {\
+		.name = #sname,\
+		.setup = NULL,\
+		.teardown = NULL,\
+		.run = MM_BENCH_RUN_NAME( sname )\
+	};\
+	\
+	void MM_BENCH_RUN_NAME( sname )( void )
+
+#define MM_BENCH_RUN( bench )\
+	do {\
+		mm_log( MM_INFO, "running bench: '%s'", bench.name );\
+		\
+		if ( bench.setup && !bench.setup() ) {\
+			mm_log( MM_ERR, "%s:%d: '%s' setup failed", __FILE__, __LINE__, bench.name );\
+			exit( EXIT_FAILURE );\
+		}\
+		\
+		bench.run();\
+		\
+		if ( bench.teardown ) {\
+			bench.teardown();\
+		}\
+	} while( 0 )
+
+#define MM_BENCH_RUN_SUITE( suite )\
+	do {\
+		mm_log( MM_INFO, "running suite: '%s'", suite.name );\
+		suite.run();\
+	} while( 0 )
+
+#endif
@@ -1,31 +1,312 @@
 #ifndef MM_BIT_H
 #define MM_BIT_H
+#include <stdatomic.h>
+#include <stdint.h>
 #include "mm/common.h"
 
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
 
+#if defined( __BMI2__ ) && defined( __x86_64__ )
+#include <immintrin.h>
+#define MM_BIT_NATIVE_PDEP //!< \brief PDEP and PEXT are compiled in rather than picked at run time
+#endif
+
+/*
+	bit twiddling on 8, 16, 32 and 64 bit words, compiler intrinsics where there are some and
+	portable code where there aren't. the 8 and 16 bit versions are the 32 bit ones with the
+	width adjusted, the work is the same.
+*/
+
+// popcount, x86 without POPCNT turns the builtin into a library call that the inline version beats
+#ifdef _MSC_VER
+#define mm_popcount_u8( i ) ( ( unsigned int ) __popcnt16( ( uint_least8_t ) ( i ) ) )
+#define mm_popcount_u16( i ) ( ( unsigned int ) __popcnt16( i ) )
+#define mm_popcount_u32( i ) ( ( unsigned int ) __popcnt( i ) )
+#define mm_popcount_u64( i ) ( ( unsigned int ) __popcnt64( i ) )
+#elif ( ( __GNUC__ > 4 ) || MM_HAS_BUILTIN( __builtin_popcount ) )\
+   && ( defined( __POPCNT__ ) || !( defined( __x86_64__ ) || defined( __i386__ ) ) )
+#define mm_popcount_u8( i ) ( ( unsigned int ) __builtin_popcount( ( uint_least8_t ) ( i ) ) )
+#define mm_popcount_u16( i ) ( ( unsigned int ) __builtin_popcount( ( uint_least16_t ) ( i ) ) )
+#define mm_popcount_u32( i ) ( ( unsigned int ) __builtin_popcount( i ) )
+#define mm_popcount_u64( i ) ( ( unsigned int ) __builtin_popcountll( i ) )
+#else
+static inline unsigned int mm_popcount_u64( uint_least64_t i ) {
+	i = i - ( ( i >> 1 ) & 0x5555555555555555u );
+	i = ( i & 0x3333333333333333u ) + ( ( i >> 2 ) & 0x3333333333333333u );
+	i = ( i + ( i >> 4 ) ) & 0x0f0f0f0f0f0f0f0fu;
+
+	return ( unsigned int ) ( ( i * 0x0101010101010101u ) >> 56 );
+}
+
+static inline unsigned int mm_popcount_u32( uint_least32_t i ) {
+	i = i - ( ( i >> 1 ) & 0x55555555u );
+	i = ( i & 0x33333333u ) + ( ( i >> 2 ) & 0x33333333u );
+	i = ( i + ( i >> 4 ) ) & 0x0f0f0f0fu;
+
+	return ( unsigned int ) ( ( ( i * 0x01010101u ) & 0xffffffffu ) >> 24 );
+}
+
+#define mm_popcount_u8( i ) mm_popcount_u32( ( uint_least8_t ) ( i ) )
+#define mm_popcount_u16( i ) mm_popcount_u32( ( uint_least16_t ) ( i ) )
+#endif
+
+// parity, 1 for an odd number of set bits
+#if !defined( _MSC_VER )\
+ && ( ( __GNUC__ > 4 ) || MM_HAS_BUILTIN( __builtin_parity ) )
+#define mm_parity_u8( i ) ( ( unsigned int ) __builtin_parity( ( uint_least8_t ) ( i ) ) )
+#define mm_parity_u16( i ) ( ( unsigned int ) __builtin_parity( ( uint_least16_t ) ( i ) ) )
+#define mm_parity_u32( i ) ( ( unsigned int ) __builtin_parity( i ) )
+#define mm_parity_u64( i ) ( ( unsigned int ) __builtin_parityll( i ) )
+#else
+static inline unsigned int mm_parity_u64( uint_least64_t i ) {
+	i ^= i >> 32;
+	i ^= i >> 16;
+	i ^= i >> 8;
+	i ^= i >> 4;
+
+	// the low nibble indexes a 16 bit parity table held in a constant
+	return ( 0x6996u >> ( i & 0xf ) ) & 1;
+}
+
+#define mm_parity_u8( i ) mm_parity_u64( ( uint_least8_t ) ( i ) )
+#define mm_parity_u16( i ) mm_parity_u64( ( uint_least16_t ) ( i ) )
+#define mm_parity_u32( i ) mm_parity_u64( ( uint_least32_t ) ( i ) )
+#endif
+
+// count leading zeros, undefined for 0
+#ifdef _MSC_VER
+static inline unsigned int mm_clz_u32( uint_least32_t i ) {
+	unsigned long idx;
+	_BitScanReverse( &idx, i );
+	return 31 - idx;
+}
+
+static inline unsigned int mm_clz_u64( uint_least64_t i ) {
+	unsigned long idx;
+	_BitScanReverse64( &idx, i );
+	return 63 - idx;
+}
+#elif ( __GNUC__ > 4 )\
+   || MM_HAS_BUILTIN( __builtin_clz )
+#define mm_clz_u32( i ) ( ( unsigned int ) __builtin_clz( i ) )
+#define mm_clz_u64( i ) ( ( unsigned int ) __builtin_clzll( i ) )
+#else
+static inline unsigned int mm_clz_u32( uint_least32_t i ) {
+	unsigned int n = 0;
+
+	while ( !( i & 0x80000000 ) ) {
+		i <<= 1;
+		++n;
+	}
+
+	return n;
+}
+
+static inline unsigned int mm_clz_u64( uint_least64_t i ) {
+	return i >> 32 ? mm_clz_u32( ( uint_least32_t ) ( i >> 32 ) ) : 32 + mm_clz_u32( ( uint_least32_t ) i );
+}
+#endif
+
+#define mm_clz_u8( i ) ( mm_clz_u32( ( uint_least8_t ) ( i ) ) - 24 )
+#define mm_clz_u16( i ) ( mm_clz_u32( ( uint_least16_t ) ( i ) ) - 16 )
+
+// count trailing zeros, undefined for 0
 #ifdef _MSC_VER
-#define mm_popcount_u16 __popcnt16
-#define mm_popcount_u32 __popcnt
-#define mm_popcount_u64 __popcnt64
+static inline unsigned int mm_ctz_u32( uint_least32_t i ) {
+	unsigned long idx;
+	_BitScanForward( &idx, i );
+	return idx;
+}
+
+static inline unsigned int mm_ctz_u64( uint_least64_t i ) {
+	unsigned long idx;
+	_BitScanForward64( &idx, i );
+	return idx;
+}
 #elif ( __GNUC__ > 4 )\
-   || MM_HAS_BUILTIN( __builtin_popcount )
-#define mm_popcount_u16 __bultin_popcount
-#define mm_popcount_u32 __bultin_popcountl
-#define mm_popcount_u64 __bultin_popcountll
+   || MM_HAS_BUILTIN( __builtin_ctz )
+#define mm_ctz_u32( i ) ( ( unsigned int ) __builtin_ctz( i ) )
+#define mm_ctz_u64( i ) ( ( unsigned int ) __builtin_ctzll( i ) )
 #else
+static inline unsigned int mm_ctz_u32( uint_least32_t i ) {
+	unsigned int n = 0;
+
+	while ( !( i & 1 ) ) {
+		i >>= 1;
+		++n;
+	}
+
+	return n;
+}
+
+static inline unsigned int mm_ctz_u64( uint_least64_t i ) {
+	unsigned int n = 0;
+
+	while ( !( i & 1 ) ) {
+		i >>= 1;
+		++n;
+	}
+
+	return n;
+}
 #endif
 
-// parity
+#define mm_ctz_u8( i ) mm_ctz_u32( ( uint_least8_t ) ( i ) )
+#define mm_ctz_u16( i ) mm_ctz_u32( ( uint_least16_t ) ( i ) )
+
+// powers of two
+
+/*!
+	\return index of the highest set bit, undefined for 0.
+*/
+static inline unsigned int mm_bit_floor_log2_u32( uint_least32_t i ) {
+	return 31 - mm_clz_u32( i );
+}
 
-// count leading zeros
+static inline unsigned int mm_bit_floor_log2_u64( uint_least64_t i ) {
+	return 63 - mm_clz_u64( i );
+}
 
-// count trailing zeros
+/*!
+	\return smallest power of two not below i, 1 for 0 and 0 when it doesn't fit the word.
+*/
+static inline uint_least32_t mm_bit_ceil_pow2_u32( uint_least32_t i ) {
+	if ( i <= 1 ) {
+		return 1;
+	}
+
+	if ( i > ( uint_least32_t ) 1 << 31 ) {
+		return 0;
+	}
+
+	return ( uint_least32_t ) 1 << ( 32 - mm_clz_u32( i - 1 ) );
+}
+
+static inline uint_least64_t mm_bit_ceil_pow2_u64( uint_least64_t i ) {
+	if ( i <= 1 ) {
+		return 1;
+	}
+
+	if ( i > ( uint_least64_t ) 1 << 63 ) {
+		return 0;
+	}
+
+	return ( uint_least64_t ) 1 << ( 64 - mm_clz_u64( i - 1 ) );
+}
+
+// deposit and extract
+
+typedef uint_least64_t ( *mm_bit_scatter_fn )( uint_least64_t i, uint_least64_t mask );
+
+/*!
+	\brief PDEP and PEXT as picked on first use, BMI2 where the CPU has a fast one and mm_bit_*_soft
+	otherwise. the microcoded versions on AMD before Zen 3 are slower than the portable ones.
+*/
+MM_API _Atomic( mm_bit_scatter_fn ) mm_bit_pdep_fn;
+MM_API _Atomic( mm_bit_scatter_fn ) mm_bit_pext_fn;
+
+/*!
+	\brief Portable deposit, one round per set bit in mask.
+*/
+MM_API uint_least64_t mm_bit_pdep_soft( uint_least64_t i, uint_least64_t mask );
+
+/*!
+	\brief Portable extract, one round per set bit in mask.
+*/
+MM_API uint_least64_t mm_bit_pext_soft( uint_least64_t i, uint_least64_t mask );
+
+/*!
+	\return true if mm_bit_pdep_u64() and mm_bit_pext_u64() run on BMI2.
+*/
+MM_API bool mm_bit_native_pdep( void );
+
+/*!
+	\return the low bits of i moved to the positions of the set bits in mask, in order.
+*/
+static inline uint_least64_t mm_bit_pdep_u64( uint_least64_t i, uint_least64_t mask ) {
+#ifdef MM_BIT_NATIVE_PDEP
+	return _pdep_u64( i, mask );
+#else
+	return atomic_load_explicit( &mm_bit_pdep_fn, memory_order_relaxed )( i, mask );
+#endif
+}
+
+/*!
+	\return the bits of i at the set bits in mask, packed into the low bits in order.
+*/
+static inline uint_least64_t mm_bit_pext_u64( uint_least64_t i, uint_least64_t mask ) {
+#ifdef MM_BIT_NATIVE_PDEP
+	return _pext_u64( i, mask );
+#else
+	return atomic_load_explicit( &mm_bit_pext_fn, memory_order_relaxed )( i, mask );
+#endif
+}
+
+static inline uint_least32_t mm_bit_pdep_u32( uint_least32_t i, uint_least32_t mask ) {
+#ifdef MM_BIT_NATIVE_PDEP
+	return _pdep_u32( i, mask );
+#else
+	return ( uint_least32_t ) mm_bit_pdep_u64( i, mask );
+#endif
+}
+
+static inline uint_least32_t mm_bit_pext_u32( uint_least32_t i, uint_least32_t mask ) {
+#ifdef MM_BIT_NATIVE_PDEP
+	return _pext_u32( i, mask );
+#else
+	return ( uint_least32_t ) mm_bit_pext_u64( i, mask );
+#endif
+}
 
 // rank
 
+/*!
+	\return number of set bits below position pos, pos in [0, 64).
+*/
+static inline unsigned int mm_bit_rank_u64( uint_least64_t i, unsigned int pos ) {
+	return mm_popcount_u64( i & ( ( ( uint_least64_t ) 1 << pos ) - 1 ) );
+}
+
 // select
 
+/*!
+	\return position of the set bit with rank k, undefined unless k < mm_popcount_u64( i ).
+
+	without BMI2 compiled in this is broadword and branch free, an indirect call to PDEP costs about as
+	much. the byte holding the bit comes from prefix sums of byte popcounts, compared to k all at once.
+*/
+static inline unsigned int mm_bit_select_u64( uint_least64_t i, unsigned int k ) {
+#ifdef MM_BIT_NATIVE_PDEP
+	return mm_ctz_u64( _pdep_u64( ( uint_least64_t ) 1 << k, i ) );
+#else
+	const uint_least64_t ones = 0x0101010101010101u;
+	const uint_least64_t highs = 0x8080808080808080u;
+	uint_least64_t s = i - ( ( i >> 1 ) & 0x5555555555555555u );
+	unsigned int shift;
+	uint_least64_t bits;
+
+	s = ( s & 0x3333333333333333u ) + ( ( s >> 2 ) & 0x3333333333333333u );
+	s = ( ( s + ( s >> 4 ) ) & 0x0f0f0f0f0f0f0f0fu ) * ones;
+
+	// bytes whose prefix sum is at most k come before the one we want
+	shift = mm_popcount_u64( ( ( k * ones | highs ) - s ) & highs ) * 8;
+	k -= ( unsigned int ) ( ( s << 8 ) >> shift ) & 0xff;
+
+	// the same again inside that byte, with every bit spread out to a byte of its own
+	bits = ( ( i >> shift ) & 0xff ) * ones & 0x8040201008040201u;
+	bits = ( ( ( bits + 0x7f7f7f7f7f7f7f7fu ) & highs ) >> 7 ) * ones;
+
+	return shift + mm_popcount_u64( ( ( k * ones | highs ) - bits ) & highs );
+#endif
+}
+
+/*!
+	\return position of the set bit with rank k, undefined unless k < mm_popcount_u32( i ).
+*/
+static inline unsigned int mm_bit_select_u32( uint_least32_t i, unsigned int k ) {
+	return mm_bit_select_u64( i, k );
+}
+
 #endif
@@ -0,0 +1,93 @@
+#ifndef MM_BITSET_H
+#define MM_BITSET_H
+#include <stdint.h>
+#include "mm/common.h"
+
+/*! \file */
+
+/*!
+	\brief Resizable set of bits.
+
+	Bits past size in the last word are always clear, so counting and searching never mask them.
+	The bulk operations run on AVX-512 or AVX2 when the library is built for them
+	( LIBMM_NATIVE ), on SSE2 for a baseline x86-64 build and on a plain word loop otherwise.
+*/
+typedef struct mm_bitset {
+	uint_least64_t *words;
+	size_t size; //!< \brief number of bits
+	size_t capacity; //!< \brief number of words allocated
+} mm_bitset_t;
+
+/*!
+	\param this pointer to mm_bitset.
+	\param size number of bits, all clear.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitset_init( struct mm_bitset *this, size_t size );
+
+/*!
+	\brief Initialize this with the bits of other.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitset_copy( struct mm_bitset *this, const struct mm_bitset *other );
+MM_API void mm_bitset_destroy( struct mm_bitset *this );
+
+/*!
+	\brief Grow or shrink to size bits, bits added are clear.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitset_resize( struct mm_bitset *this, size_t size );
+
+/*!
+	\return first set bit at or after from, size if there is none.
+*/
+MM_API size_t mm_bitset_find_next( const struct mm_bitset *this, size_t from );
+
+/*!
+	\return number of set bits.
+*/
+MM_API size_t mm_bitset_count( const struct mm_bitset *this );
+
+/*!
+	\brief In place this = this op other, both of the same size.
+*/
+MM_API void mm_bitset_and( struct mm_bitset *this, const struct mm_bitset *other );
+MM_API void mm_bitset_or( struct mm_bitset *this, const struct mm_bitset *other );
+MM_API void mm_bitset_xor( struct mm_bitset *this, const struct mm_bitset *other );
+
+/*!
+	\brief In place this = this & ~other, both of the same size.
+*/
+MM_API void mm_bitset_andnot( struct mm_bitset *this, const struct mm_bitset *other );
+
+/*!
+	\return number of bits set in lhs op rhs, without storing it anywhere. Both of the same size.
+*/
+MM_API size_t mm_bitset_and_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs );
+MM_API size_t mm_bitset_or_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs );
+MM_API size_t mm_bitset_xor_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs );
+MM_API size_t mm_bitset_andnot_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs );
+
+static inline void mm_bitset_set( struct mm_bitset *this, size_t i ) {
+	this->words[ i >> 6 ] |= ( uint_least64_t ) 1 << ( i & 63 );
+}
+
+static inline void mm_bitset_clear( struct mm_bitset *this, size_t i ) {
+	this->words[ i >> 6 ] &= ~( ( uint_least64_t ) 1 << ( i & 63 ) );
+}
+
+static inline bool mm_bitset_test( const struct mm_bitset *this, size_t i ) {
+	return this->words[ i >> 6 ] >> ( i & 63 ) & 1;
+}
+
+/*!
+	\brief Visit every set bit in increasing order.
+	\param this pointer to mm_bitset.
+	\param i size_t to hold the position.
+*/
+#define MM_BITSET_FOR_EACH( this, i )\
+	for ( ( i ) = mm_bitset_find_next( ( this ), 0 );\
+	      ( i ) < ( this )->size;\
+	      ( i ) = mm_bitset_find_next( ( this ), ( i ) + 1 ) )
+
+#endif
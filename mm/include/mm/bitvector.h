@@ -0,0 +1,98 @@
+#ifndef MM_BITVECTOR_H
+#define MM_BITVECTOR_H
+#include <stdint.h>
+#include "mm/bit.h"
+#include "mm/common.h"
+#include "mm/vector.h"
+
+/*! \file */
+
+#define MM_BITVECTOR_BLOCK_BITS 2048 //!< \brief bits covered by one directory entry
+#define MM_BITVECTOR_SELECT_SAMPLE 8192 //!< \brief set bits between two select samples
+
+/*!
+	\brief Static bit array with constant time rank and select.
+
+	Bits are appended as a stream, then mm_bitvector_build() indexes them. The rank directory has two
+	levels, an absolute count every 2^32 bits and one 64 bit entry for every 2048 bit block holding
+	the count up to the block, relative to the level above, plus the counts of the first three of its
+	512 bit sub-blocks. that is 3.1% on top of the bits, and a rank reads one entry and at most one
+	cache line of bits.
+
+	select starts from the block of every 8192nd set bit and searches the directory between two
+	samples, which stays within a handful of entries unless the bits are very sparse.
+*/
+typedef struct mm_bitvector {
+	uint_least64_t *words;
+	uint_least64_t size; //!< \brief number of bits
+	uint_least64_t ones; //!< \brief number of set bits, valid once built
+	size_t capacity; //!< \brief number of words allocated
+	uint_least64_t *upper; //!< \brief set bits before every 2^32 bits
+	uint_least64_t *blocks; //!< \brief set bits before the block within its 2^32 bits, then 3 sub-block counts of 10 bits
+	uint_least64_t *samples; //!< \brief block holding every MM_BITVECTOR_SELECT_SAMPLE-th set bit, then the last block
+} mm_bitvector_t;
+
+/*!
+	\param this pointer to mm_bitvector.
+	\param capacity number of bits to reserve space for, can be 0.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitvector_init( struct mm_bitvector *this, uint_least64_t capacity );
+MM_API void mm_bitvector_destroy( struct mm_bitvector *this );
+
+/*!
+	\brief Append the low count bits of bits, the lowest first. The index has to be built again after.
+	\param count number of bits in [1, 64].
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitvector_append( struct mm_bitvector *this, uint_least64_t bits, unsigned int count );
+
+/*!
+	\brief Index the bits for rank and select, replacing an earlier index.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_bitvector_build( struct mm_bitvector *this );
+
+/*!
+	\brief Initialize and build a vector of size bits, set where positions says and clear elsewhere.
+	\param positions mm_vector of uint_least64_t, in any order.
+	\return false if memory cannot be allocated or a position isn't below size.
+*/
+MM_API bool mm_bitvector_from_positions( struct mm_bitvector *this, struct mm_vector *positions, uint_least64_t size );
+
+/*!
+	\return position of the set bit with rank k, size if k isn't below the number of set bits.
+*/
+MM_API uint_least64_t mm_bitvector_select1( const struct mm_bitvector *this, uint_least64_t k );
+
+static inline bool mm_bitvector_get( const struct mm_bitvector *this, uint_least64_t i ) {
+	return this->words[ i >> 6 ] >> ( i & 63 ) & 1;
+}
+
+/*!
+	\return number of set bits in [0, i), i in [0, size].
+*/
+static inline uint_least64_t mm_bitvector_rank1( const struct mm_bitvector *this, uint_least64_t i ) {
+	uint_least64_t entry = this->blocks[ i >> 11 ];
+	uint_least64_t rank = this->upper[ i >> 32 ] + ( entry & 0xffffffff );
+	const uint_least64_t *word = this->words + ( i >> 9 << 3 );
+	unsigned int sub = ( i >> 9 ) & 3;
+	unsigned int last = ( i >> 6 ) & 7;
+
+	rank += ( ( entry >> 32 ) & 0x3ff ) * ( sub > 0 ) + ( ( entry >> 42 ) & 0x3ff ) * ( sub > 1 ) + ( ( entry >> 52 ) & 0x3ff ) * ( sub > 2 );
+
+	for ( unsigned int j = 0; j < last; ++j ) {
+		rank += mm_popcount_u64( word[ j ] );
+	}
+
+	return rank + mm_bit_rank_u64( word[ last ], i & 63 );
+}
+
+/*!
+	\return number of clear bits in [0, i), i in [0, size].
+*/
+static inline uint_least64_t mm_bitvector_rank0( const struct mm_bitvector *this, uint_least64_t i ) {
+	return i - mm_bitvector_rank1( this, i );
+}
+
+#endif
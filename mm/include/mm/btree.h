@@ -0,0 +1,196 @@
+#ifndef MM_BTREE_H
+#define MM_BTREE_H
+#include "mm/common.h"
+#include "mm/vector.h"
+
+/*! \file */
+
+/*!
+	\brief Maximum number of keys in any mm_btree node.
+
+	32 keys of 64 bits fill four cache lines, which keeps the tree shallow ( five levels for 10M keys )
+	while a node search still only touches the keys.
+	Must be a multiple of 4 for the SIMD search.
+*/
+#define MM_BTREE_KEYS 32
+
+/*!
+	\brief Alignment of mm_btree nodes in bytes.
+*/
+#define MM_BTREE_ALIGN 64
+
+typedef uint_least64_t mm_btree_key_t;
+
+/*!
+	\brief Leaf node, holds the actual key/value pairs.
+
+	Leaves are doubly linked in key order for range scans.
+	Key slots past count always hold UINT_LEAST64_MAX so the node search can run over whole vectors.
+*/
+typedef struct mm_btree_leaf {
+	mm_btree_key_t keys[ MM_BTREE_KEYS ]; //!< \brief sorted keys
+	void *values[ MM_BTREE_KEYS ]; //!< \brief value for each key
+	struct mm_btree_leaf *prev; //!< \brief previous leaf in key order
+	struct mm_btree_leaf *next; //!< \brief next leaf in key order
+	unsigned int count; //!< \brief number of keys in use
+} mm_btree_leaf_t;
+
+/*!
+	\brief Inner node, keys[ i ] separates children[ i ] ( lesser ) from children[ i + 1 ] ( greater or equal ).
+*/
+typedef struct mm_btree_inner {
+	mm_btree_key_t keys[ MM_BTREE_KEYS ]; //!< \brief sorted separator keys
+	void *children[ MM_BTREE_KEYS + 1 ]; //!< \brief mm_btree_inner or mm_btree_leaf, depending on depth
+	unsigned int count; //!< \brief number of keys in use, there is always one more child
+} mm_btree_inner_t;
+
+/*!
+	\brief Cache-conscious in-memory B+tree mapping 64 bit keys to pointers.
+
+	Nodes are allocated with MM_ALIGNED_ALLOC and freed with MM_FREE.
+	Compared to mm_rbtree, each level checks up to MM_BTREE_KEYS keys that sit next to each other in memory,
+	so lookups take far fewer cache misses, and range scans walk arrays instead of pointers.
+*/
+typedef struct mm_btree {
+	void *root; //!< \brief root node, a leaf when height is 0, NULL when empty
+	unsigned int height; //!< \brief number of inner levels above the leaves
+	size_t size; //!< \brief number of keys
+} mm_btree_t;
+
+/*!
+	\brief Element type for mm_btree_bulk_load().
+*/
+typedef struct mm_btree_entry {
+	mm_btree_key_t key;
+	void *value;
+} mm_btree_entry_t;
+
+/*!
+	\brief Position inside of a mm_btree, invalidated by any insert or erase.
+*/
+typedef struct mm_btree_iter {
+	struct mm_btree_leaf *leaf; //!< \brief current leaf or NULL at the end
+	unsigned int idx; //!< \brief index inside of leaf
+} mm_btree_iter_t;
+
+#define MM_BTREE_INIT\
+	{ .root = NULL, .height = 0, .size = 0 }
+
+#define MM_BTREE_DECLARE( name )\
+	struct mm_btree name = MM_BTREE_INIT
+
+static inline void mm_btree_init( struct mm_btree *this ) {
+	this->root = NULL;
+	this->height = 0;
+	this->size = 0;
+}
+
+/*!
+	\brief Free every node and reset to an empty tree.
+	\param this pointer to mm_btree.
+*/
+MM_API void mm_btree_destroy( struct mm_btree *this );
+
+static inline size_t mm_btree_size( const struct mm_btree *this ) {
+	return this->size;
+}
+
+static inline bool mm_btree_empty( const struct mm_btree *this ) {
+	return !this->size;
+}
+
+/*!
+	\brief Insert a key, or replace the value if the key already exists.
+	\param this pointer to mm_btree.
+	\param key key to insert.
+	\param value value to store.
+	\return false if memory cannot be allocated, the tree is left unchanged.
+*/
+MM_API bool mm_btree_insert( struct mm_btree *this, mm_btree_key_t key, void *value );
+
+/*!
+	\brief Remove a key.
+	\param this pointer to mm_btree.
+	\param key key to remove.
+	\param value buffer to copy the removed value into. Can be NULL.
+	\return true if the key was found.
+*/
+MM_API bool mm_btree_erase( struct mm_btree *this, mm_btree_key_t key, void **value );
+
+/*!
+	\brief Find the value slot for a key.
+	\param this pointer to mm_btree.
+	\param key key to search for.
+	\return pointer to the stored value, or NULL if key doesn't exist.
+*/
+MM_API void** mm_btree_find( const struct mm_btree *this, mm_btree_key_t key );
+
+/*!
+	\brief Position at the first key that is not less than key.
+	\param this pointer to mm_btree.
+	\param key key to search for.
+	\return iterator, check with mm_btree_iter_end().
+*/
+MM_API struct mm_btree_iter mm_btree_lower_bound( const struct mm_btree *this, mm_btree_key_t key );
+
+/*!
+	\brief Replace the contents of a mm_btree with sorted entries in O( n ).
+
+	Leaves and inner nodes are packed close to full, which suits read mostly indexes.
+
+	\param this pointer to mm_btree.
+	\param entries mm_vector of mm_btree_entry, sorted by key without duplicates.
+	\return false if memory cannot be allocated, the tree is left empty.
+*/
+MM_API bool mm_btree_bulk_load( struct mm_btree *this, struct mm_vector *entries );
+
+/*!
+	\param this pointer to mm_btree.
+	\return iterator at the smallest key.
+*/
+static inline struct mm_btree_iter mm_btree_first( const struct mm_btree *this ) {
+	struct mm_btree_iter it = { .leaf = NULL, .idx = 0 };
+	void *node = this->root;
+
+	if ( node && this->size ) {
+		for ( unsigned int i = 0; i < this->height; ++i ) {
+			node = ( ( struct mm_btree_inner* ) node )->children[ 0 ];
+		}
+
+		it.leaf = node;
+	}
+
+	return it;
+}
+
+static inline bool mm_btree_iter_end( const struct mm_btree_iter *it ) {
+	return !it->leaf;
+}
+
+static inline mm_btree_key_t mm_btree_iter_key( const struct mm_btree_iter *it ) {
+	return it->leaf->keys[ it->idx ];
+}
+
+static inline void* mm_btree_iter_value( const struct mm_btree_iter *it ) {
+	return it->leaf->values[ it->idx ];
+}
+
+/*!
+	\brief Move to the next key, following the leaf links.
+	\param it iterator that isn't at the end.
+*/
+static inline void mm_btree_iter_next( struct mm_btree_iter *it ) {
+	if ( ++it->idx >= it->leaf->count ) {
+		it->leaf = it->leaf->next;
+		it->idx = 0;
+	}
+}
+
+/*!
+	\brief Iterate keys in ascending order from an iterator.
+	\param it mm_btree_iter to advance.
+*/
+#define MM_BTREE_FOREACH( it )\
+	for ( ; !mm_btree_iter_end( it ); mm_btree_iter_next( it ) )
+
+#endif
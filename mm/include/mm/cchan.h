@@ -0,0 +1,110 @@
+#ifndef MM_CCHAN_H
+#define MM_CCHAN_H
+#include <threads.h>
+#include "mm/assert.h"
+#include "mm/chan.h"
+#include "mm/common.h"
+#include "mm/executor.h"
+#include "mm/list.h"
+
+/*! \file */
+
+/*
+	channels between mm_executor tasks, which may run on different threads
+
+	example usage
+
+	MM_COROUTINE( consume, struct mm_executor_task *task ) {
+		struct consumer *this = MM_EXECUTOR_CONTAINER( task, struct consumer, task );
+
+		MM_CO_BEGIN( &this->co );
+
+		for ( ;; ) {
+			MM_CO_CCHAN_RECV( &this->co, task, this->in, &this->value, this->status );
+
+			if ( this->status == MM_CHAN_CLOSED ) {
+				break;
+			}
+			...
+		}
+
+		MM_CO_END( &this->co );
+	}
+*/
+
+/*!
+	\brief Bounded FIFO channel between tasks of one mm_executor, safe from any thread.
+
+	Same semantics as mm_chan, guarded by a mutex. A task that has to wait links its mm_executor_task
+	into the channel and parks, the task on the other side unlinks it and calls mm_executor_wake(),
+	so a parked task must not be woken by anything but the channel.
+*/
+typedef struct mm_cchan {
+	mtx_t lock;
+	struct mm_executor *executor;
+	unsigned char *buffer;
+	size_t size; //!< \brief element size in bytes
+	size_t capacity; //!< \brief 0 for unbuffered
+	size_t slots; //!< \brief room in buffer, 1 for unbuffered
+	size_t head;
+	size_t count;
+	bool closed;
+	struct mm_list senders; //!< \brief parked mm_executor_task
+	struct mm_list receivers; //!< \brief parked mm_executor_task
+} mm_cchan_t;
+
+/*!
+	\param this pointer to mm_cchan.
+	\param executor executor running every task using the channel.
+	\param size element size in bytes.
+	\param capacity values buffered, 0 for unbuffered.
+	\return false if the buffer or the mutex couldn't be created.
+*/
+MM_API bool mm_cchan_init( struct mm_cchan *this, struct mm_executor *executor, size_t size, size_t capacity );
+
+#define MM_CCHAN_INIT( this, executor, type, capacity )\
+	mm_cchan_init( this, executor, sizeof( type ), capacity )
+
+MM_API void mm_cchan_destroy( struct mm_cchan *this );
+
+/*!
+	\param this pointer to mm_cchan.
+	\param task task to park on the channel when MM_CHAN_AGAIN is returned, NULL to only try.
+	\param value pointer to the element to copy in.
+*/
+MM_API enum mm_chan_status mm_cchan_send( struct mm_cchan *this, struct mm_executor_task *task, const void *value );
+
+/*!
+	\param this pointer to mm_cchan.
+	\param task task to park on the channel when MM_CHAN_AGAIN is returned, NULL to only try.
+	\param value pointer to the element to copy out to.
+*/
+MM_API enum mm_chan_status mm_cchan_recv( struct mm_cchan *this, struct mm_executor_task *task, void *value );
+
+/*!
+	\brief Fail every further send and wake every parked task, values already sent can still be received.
+*/
+MM_API void mm_cchan_close( struct mm_cchan *this );
+
+#define _MM_CCHAN_AWAIT_( co, status, op )\
+	do {\
+		_MM_CO_JMP_;\
+		\
+		if ( ( ( status ) = ( op ) ) == MM_CHAN_AGAIN ) {\
+			_MM_CO_RET_( co, MM_CO_WAITING );\
+		}\
+	} while( 0 )
+
+#define MM_CO_CCHAN_SEND( co, task, chan, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( chan )->size );\
+		_MM_CCHAN_AWAIT_( co, status, mm_cchan_send( chan, task, value ) );\
+	} while( 0 )
+
+#define MM_CO_CCHAN_RECV( co, task, chan, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( chan )->size );\
+		_MM_CCHAN_AWAIT_( co, status, mm_cchan_recv( chan, task, value ) );\
+	} while( 0 )
+
+#endif
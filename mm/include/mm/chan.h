@@ -0,0 +1,296 @@
+#ifndef MM_CHAN_H
+#define MM_CHAN_H
+#include <stdint.h>
+#include "mm/assert.h"
+#include "mm/common.h"
+#include "mm/list.h"
+#include "mm/sched.h"
+
+/*! \file */
+
+/*
+	channels between mm_sched tasks
+
+	example usage
+
+	struct producer {
+		struct mm_sched_task task;
+		struct mm_co co;
+		struct mm_chan *out;
+		enum mm_chan_status status;
+		int i;
+	};
+
+	MM_COROUTINE( produce, struct mm_sched_task *task ) {
+		struct producer *this = MM_SCHED_CONTAINER( task, struct producer, task );
+
+		MM_CO_BEGIN( &this->co );
+
+		for ( this->i = 0; this->i < 10; ++this->i ) {
+			MM_CO_SEND( &this->co, task, this->out, &this->i, this->status );
+		}
+
+		mm_chan_close( this->out );
+		MM_CO_END( &this->co );
+	}
+
+	the consumer loops on MM_CO_RECV( &this->co, task, this->in, &this->value, this->status )
+	until status is MM_CHAN_CLOSED.
+
+	struct mm_chan chan;
+	MM_CHAN_INIT( &chan, &sched, int, 16 );
+*/
+
+typedef enum mm_chan_status {
+	MM_CHAN_OK,
+	MM_CHAN_AGAIN, //!< \brief the operation would have to wait
+	MM_CHAN_CLOSED //!< \brief closed, and for receives also drained
+} mm_chan_status_t;
+
+struct mm_chan;
+struct mm_chan_select;
+
+/*!
+	\brief One send or receive of a select, registered with its channel while the select waits.
+*/
+typedef struct mm_chan_case {
+	struct mm_list list; //!< \brief link in the selects waiting on the channel
+	struct mm_chan *chan;
+	void *value; //!< \brief sent from or received into
+	bool send;
+	struct mm_chan_select *select;
+} mm_chan_case_t;
+
+/*!
+	\brief Wait for the first of several channel operations that can complete.
+*/
+typedef struct mm_chan_select {
+	struct mm_sched_task *task;
+	struct mm_chan_case *cases;
+	size_t count;
+	size_t start; //!< \brief case tried first, rotated so no case starves the others
+	struct mm_chan_case *woken; //!< \brief case whose channel woke the select
+	enum mm_chan_status status; //!< \brief status of the completed case
+} mm_chan_select_t;
+
+/*!
+	\brief Bounded FIFO channel between tasks of one mm_sched.
+
+	A channel with a capacity of 0 is unbuffered, a send only goes through while a receiver is waiting
+	for it. Tasks that can't send or receive park on the channel, and every completed operation wakes
+	exactly one task on the other side, either a plain waiter or a select.
+*/
+typedef struct mm_chan {
+	struct mm_sched *sched;
+	unsigned char *buffer;
+	size_t size; //!< \brief element size in bytes
+	size_t capacity; //!< \brief 0 for unbuffered
+	size_t slots; //!< \brief room in buffer, 1 for unbuffered
+	size_t head;
+	size_t count;
+	bool closed;
+	struct mm_sched_event senders;
+	struct mm_sched_event receivers;
+	struct mm_list send_selects; //!< \brief send cases of waiting selects
+	struct mm_list recv_selects; //!< \brief receive cases of waiting selects
+} mm_chan_t;
+
+/*!
+	\brief Broadcast channel, every subscriber receives every value sent after it subscribed.
+
+	A slot is reused once every subscriber received it, so the slowest subscriber holds back senders.
+	Values sent while nobody is subscribed are dropped.
+*/
+typedef struct mm_chan_bcast {
+	struct mm_sched *sched;
+	unsigned char *buffer;
+	size_t *pending; //!< \brief subscribers that haven't received the value in a slot
+	size_t size;
+	size_t capacity;
+	uint_least64_t head; //!< \brief sequence of the oldest value still held
+	uint_least64_t tail; //!< \brief sequence of the next value sent
+	size_t subs;
+	bool closed;
+	struct mm_sched_event senders;
+	struct mm_sched_event receivers;
+} mm_chan_bcast_t;
+
+/*!
+	\brief Receiving end of a broadcast channel.
+*/
+typedef struct mm_chan_sub {
+	struct mm_chan_bcast *bcast;
+	uint_least64_t cursor; //!< \brief sequence of the next value to receive
+} mm_chan_sub_t;
+
+/*!
+	\param this pointer to mm_chan.
+	\param sched scheduler of every task using the channel.
+	\param size element size in bytes.
+	\param capacity values buffered, 0 for unbuffered.
+	\return false if the buffer couldn't be allocated.
+*/
+MM_API bool mm_chan_init( struct mm_chan *this, struct mm_sched *sched, size_t size, size_t capacity );
+
+#define MM_CHAN_INIT( this, sched, type, capacity )\
+	mm_chan_init( this, sched, sizeof( type ), capacity )
+
+/*!
+	\brief Free the buffer, no task may still wait on the channel.
+*/
+MM_API void mm_chan_destroy( struct mm_chan *this );
+
+/*!
+	\brief Send without waiting.
+	\param this pointer to mm_chan.
+	\param value pointer to the element to copy in.
+	\return MM_CHAN_AGAIN if the buffer is full, or for an unbuffered channel if no receiver waits.
+*/
+MM_API enum mm_chan_status mm_chan_try_send( struct mm_chan *this, const void *value );
+
+/*!
+	\brief Receive without waiting.
+	\param this pointer to mm_chan.
+	\param value pointer to the element to copy out to.
+	\return MM_CHAN_AGAIN if nothing was sent, MM_CHAN_CLOSED once the channel is closed and drained.
+*/
+MM_API enum mm_chan_status mm_chan_try_recv( struct mm_chan *this, void *value );
+
+/*!
+	\brief Fail every further send and wake every waiting task, values already sent can still be received.
+*/
+MM_API void mm_chan_close( struct mm_chan *this );
+
+static inline size_t mm_chan_size( struct mm_chan *this ) {
+	return this->count;
+}
+
+/*!
+	\param this pointer to mm_chan_select.
+	\param task task running the select.
+	\param cases cases set up with mm_chan_case_send() and mm_chan_case_recv().
+	\param count number of cases.
+*/
+static inline void mm_chan_select_init( struct mm_chan_select *this, struct mm_sched_task *task, struct mm_chan_case *cases, size_t count ) {
+	this->task = task;
+	this->cases = cases;
+	this->count = count;
+	this->start = 0;
+	this->woken = NULL;
+	this->status = MM_CHAN_OK;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		cases[ i ].select = this;
+	}
+}
+
+static inline void mm_chan_case_send( struct mm_chan_case *this, struct mm_chan *chan, const void *value ) {
+	mm_list_init( &this->list );
+	this->chan = chan;
+	this->value = ( void* ) value;
+	this->send = true;
+	this->select = NULL;
+}
+
+static inline void mm_chan_case_recv( struct mm_chan_case *this, struct mm_chan *chan, void *value ) {
+	mm_list_init( &this->list );
+	this->chan = chan;
+	this->value = value;
+	this->send = false;
+	this->select = NULL;
+}
+
+/*!
+	\brief Try every case once, starting after the case that completed last time.
+	\param this pointer to mm_chan_select.
+	\return index of the completed case, its status is left in this->status, or -1 if none could complete.
+*/
+MM_API long mm_chan_select_try( struct mm_chan_select *this );
+
+/*!
+	\brief Register every case with its channel, the task is woken by the first that becomes ready.
+*/
+MM_API void mm_chan_select_wait( struct mm_chan_select *this );
+
+/*!
+	\param this pointer to mm_chan_bcast.
+	\param sched scheduler of every task using the channel.
+	\param size element size in bytes.
+	\param capacity values buffered, at least 1.
+	\return false if the buffer couldn't be allocated.
+*/
+MM_API bool mm_chan_bcast_init( struct mm_chan_bcast *this, struct mm_sched *sched, size_t size, size_t capacity );
+
+#define MM_CHAN_BCAST_INIT( this, sched, type, capacity )\
+	mm_chan_bcast_init( this, sched, sizeof( type ), capacity )
+
+MM_API void mm_chan_bcast_destroy( struct mm_chan_bcast *this );
+
+/*!
+	\return MM_CHAN_AGAIN while the slowest subscriber is capacity values behind.
+*/
+MM_API enum mm_chan_status mm_chan_bcast_try_send( struct mm_chan_bcast *this, const void *value );
+
+MM_API void mm_chan_bcast_close( struct mm_chan_bcast *this );
+
+/*!
+	\brief Subscribe to every value sent from now on.
+*/
+MM_API void mm_chan_sub_init( struct mm_chan_sub *this, struct mm_chan_bcast *bcast );
+
+/*!
+	\brief Unsubscribe, the values it didn't receive yet no longer hold back senders.
+*/
+MM_API void mm_chan_sub_destroy( struct mm_chan_sub *this );
+
+MM_API enum mm_chan_status mm_chan_sub_try_recv( struct mm_chan_sub *this, void *value );
+
+// status has to outlive the wait, so keep it in the coroutine state like every other local
+#define _MM_CHAN_AWAIT_( co, task, event, status, op )\
+	MM_SCHED_AWAIT_UNTIL( co, task, event, ( ( status ) = ( op ) ) != MM_CHAN_AGAIN )
+
+/*!
+	\brief Send the value pointed to, suspending the coroutine until it goes through or the channel is closed.
+*/
+#define MM_CO_SEND( co, task, chan, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( chan )->size );\
+		_MM_CHAN_AWAIT_( co, task, &( chan )->senders, status, mm_chan_try_send( chan, value ) );\
+	} while( 0 )
+
+/*!
+	\brief Receive into the value pointed to, suspending the coroutine until something was sent or the channel is closed.
+*/
+#define MM_CO_RECV( co, task, chan, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( chan )->size );\
+		_MM_CHAN_AWAIT_( co, task, &( chan )->receivers, status, mm_chan_try_recv( chan, value ) );\
+	} while( 0 )
+
+/*!
+	\brief Complete exactly one case of the select, index is set to the case that did.
+*/
+#define MM_CO_SELECT( co, select, index )\
+	do {\
+		_MM_CO_JMP_;\
+		\
+		if ( ( ( index ) = mm_chan_select_try( select ) ) < 0 ) {\
+			mm_chan_select_wait( select );\
+			( select )->task->park = true;\
+			_MM_CO_RET_( co, MM_CO_WAITING );\
+		}\
+	} while( 0 )
+
+#define MM_CO_BCAST_SEND( co, task, bcast, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( bcast )->size );\
+		_MM_CHAN_AWAIT_( co, task, &( bcast )->senders, status, mm_chan_bcast_try_send( bcast, value ) );\
+	} while( 0 )
+
+#define MM_CO_SUB_RECV( co, task, sub, value, status )\
+	do {\
+		MM_ASSERT( sizeof( *( value ) ) == ( sub )->bcast->size );\
+		_MM_CHAN_AWAIT_( co, task, &( sub )->bcast->receivers, status, mm_chan_sub_try_recv( sub, value ) );\
+	} while( 0 )
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef MM_CMAP_H
+#define MM_CMAP_H
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include "mm/common.h"
+#include "mm/hash.h"
+
+/*! \file */
+
+/*!
+	\brief Value slot markers, neither can be stored as a value.
+*/
+#define MM_CMAP_EMPTY ( ( uintptr_t ) 0 )
+#define MM_CMAP_DELETED ( ( uintptr_t ) 1 )
+
+/*!
+	\brief Default number of segments for mm_cmap_init().
+*/
+#define MM_CMAP_SEGMENTS 64
+
+/*!
+	\brief Maximum load factor of a segment, tombstones included ( 3 / 4 ).
+*/
+#define MM_CMAP_LOAD_NUM 3
+#define MM_CMAP_LOAD_DEN 4
+
+typedef struct mm_cmap_slot {
+	atomic_uint_least64_t key;
+	atomic_uintptr_t value; //!< \brief MM_CMAP_EMPTY, MM_CMAP_DELETED or the stored pointer
+} mm_cmap_slot_t;
+
+/*!
+	\brief Linear probing table of one segment, never modified again once replaced by a resize.
+*/
+typedef struct mm_cmap_table {
+	size_t mask; //!< \brief number of slots - 1
+	struct mm_cmap_table *retired; //!< \brief older tables of the same segment
+	struct mm_cmap_slot slots[];
+} mm_cmap_table_t;
+
+/*!
+	\brief Independently locked and resized part of a mm_cmap, aligned to keep segments off each others cache lines.
+*/
+typedef struct mm_cmap_segment {
+	alignas( 64 ) _Atomic( struct mm_cmap_table* ) table;
+	mtx_t lock; //!< \brief serializes writers, readers never take it
+	size_t size; //!< \brief number of keys
+	size_t used; //!< \brief number of keys and tombstones
+} mm_cmap_segment_t;
+
+/*!
+	\brief Concurrent map from 64 bit keys to non NULL pointers with lock free reads.
+
+	Keys are spread over a power of two number of segments, each one an open addressing table with its own writer lock.
+	mm_cmap_find() never locks or writes shared memory: a slot's key is published before its value,
+	so a reader that sees a value also sees the matching key, and a second read of the value catches slots
+	that were erased and reused in between.
+
+	Resizing replaces the table of a single segment, so each step copies only a fraction of the map while the
+	other segments keep taking writes, and readers keep using the old table until the new one is published.
+	Old tables may still be in use by readers, so they are only freed by mm_cmap_reclaim() or mm_cmap_destroy().
+
+	Stored pointers are returned as is, the map doesn't manage the lifetime of what they point to.
+*/
+typedef struct mm_cmap {
+	struct mm_cmap_segment *segments;
+	unsigned int shift; //!< \brief 64 - log2( number of segments ), selects the segment from the hash
+	uint_least64_t seed;
+} mm_cmap_t;
+
+/*!
+	\param this pointer to mm_cmap.
+	\param segments number of segments, rounded up to a power of two. 0 for MM_CMAP_SEGMENTS.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_cmap_init( struct mm_cmap *this, size_t segments );
+
+/*!
+	\brief Free all memory, no other thread may use the map.
+	\param this pointer to mm_cmap.
+*/
+MM_API void mm_cmap_destroy( struct mm_cmap *this );
+
+/*!
+	\brief Insert a key, or replace the value if the key already exists.
+	\param this pointer to mm_cmap.
+	\param key key to insert.
+	\param value value to store, not NULL and not MM_CMAP_DELETED.
+	\return false if memory cannot be allocated, the map is left unchanged.
+*/
+MM_API bool mm_cmap_insert( struct mm_cmap *this, uint_least64_t key, void *value );
+
+/*!
+	\brief Remove a key.
+	\param this pointer to mm_cmap.
+	\param key key to remove.
+	\param value buffer to copy the removed value into. Can be NULL.
+	\return true if the key was found.
+*/
+MM_API bool mm_cmap_erase( struct mm_cmap *this, uint_least64_t key, void **value );
+
+/*!
+	\brief Number of keys, only exact while no writer is active.
+	\param this pointer to mm_cmap.
+*/
+MM_API size_t mm_cmap_size( struct mm_cmap *this );
+
+/*!
+	\brief Free tables replaced by resizes.
+
+	Must only be called while no thread is inside of mm_cmap_find(), for example between request batches.
+	\param this pointer to mm_cmap.
+*/
+MM_API void mm_cmap_reclaim( struct mm_cmap *this );
+
+static inline struct mm_cmap_segment* mm_cmap_segment( const struct mm_cmap *this, uint_least64_t hash ) {
+	return &this->segments[ this->shift < 64 ? hash >> this->shift : 0 ];
+}
+
+/*!
+	\brief Look up a key without locking, safe to call concurrently with any writer.
+	\param this pointer to mm_cmap.
+	\param key key to search for.
+	\return stored value or NULL if key doesn't exist.
+*/
+static inline void* mm_cmap_find( const struct mm_cmap *this, uint_least64_t key ) {
+	uint_least64_t hash = mm_hash_u64( key, this->seed );
+	const struct mm_cmap_table *table = atomic_load_explicit( &mm_cmap_segment( this, hash )->table, memory_order_acquire );
+	size_t idx = hash & table->mask;
+
+	for ( size_t probes = 0; probes <= table->mask; ) {
+		const struct mm_cmap_slot *slot = &table->slots[ idx ];
+		uintptr_t value = atomic_load_explicit( &slot->value, memory_order_acquire );
+
+		if ( value == MM_CMAP_EMPTY ) {
+			return NULL;
+		}
+
+		if ( value != MM_CMAP_DELETED && atomic_load_explicit( &slot->key, memory_order_acquire ) == key ) {
+			// the slot could have been erased and reused for key after value was read
+			if ( atomic_load_explicit( &slot->value, memory_order_relaxed ) == value ) {
+				return ( void* ) value;
+			}
+
+			continue;
+		}
+
+		idx = ( idx + 1 ) & table->mask;
+		++probes;
+	}
+
+	return NULL;
+}
+
+#endif
@@ -94,7 +94,7 @@ typedef struct mm_co {
 	} while( 0 )
 
 #define MM_CO_YIELD_WHILE( co, cond )\
-	_MM_CO_RET_WHILE( co, cond, MM_CO_SUSPENDED )
+	_MM_CO_RET_WHILE_( co, cond, MM_CO_SUSPENDED )
 
 #define MM_CO_YIELD_UNTIL( co, cond )\
 	MM_CO_YIELD_WHILE( co, !( cond ) )
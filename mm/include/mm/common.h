@@ -22,10 +22,10 @@
  || defined( __EMSCRIPTEN__ )\
  || defined( __MINGW32__ )\
  || defined( __MINGW64__ )
-#define MM_IMPORT
+#define MM_IMPORT extern
 #define MM_EXPORT __attribute__(( visibility( "default" ) )) extern
 #elif defined( _MSC_VER )
-#define MM_IMPORT __declspec( dllimport )
+#define MM_IMPORT __declspec( dllimport ) extern
 #define MM_EXPORT __declspec( dllexport ) extern
 #else
 #error "unsupported compiler"
@@ -5,6 +5,7 @@
 #define MM_MALLOC malloc
 #define MM_CALLOC calloc
 #define MM_REALLOC realloc
+#define MM_ALIGNED_ALLOC aligned_alloc
 #define MM_FREE free
 #define MM_STDIN stdin
 #define MM_STDOUT stdout
@@ -0,0 +1,71 @@
+#ifndef MM_DISTRIBUTION_H
+#define MM_DISTRIBUTION_H
+#include <stddef.h>
+#include <stdint.h>
+#include "mm/common.h"
+#include "mm/random.h"
+
+/*
+	non uniform samplers on top of mm_random, every one of them takes constant expected time per
+	sample and has a fill variant for batches. sampler state is read only once initialized, threads
+	can share one as long as each brings its own generator.
+*/
+
+/*!
+	\brief Zipf distribution over [0, n), rank k comes up with probability proportional to 1 / ( k + 1 )^s.
+
+	Sampled with Hormann and Derflinger's rejection-inversion, no table, any n.
+*/
+typedef struct mm_zipf {
+	uint_least64_t n;
+	double s;
+	double h_x1; //!< \brief H( 1.5 ) - 1
+	double h_n; //!< \brief H( n + 0.5 )
+	double cutoff; //!< \brief accept without evaluating the density when k - x is below it
+} mm_zipf_t;
+
+/*!
+	\param n number of ranks.
+	\param s exponent, larger is more skewed.
+	\return false unless n > 0 and s > 0.
+*/
+MM_API bool mm_zipf_init( struct mm_zipf *this, uint_least64_t n, double s );
+MM_API uint_least64_t mm_zipf_next( const struct mm_zipf *this, struct mm_random *r );
+MM_API void mm_zipf_fill( const struct mm_zipf *this, struct mm_random *r, uint_least64_t *out, size_t count );
+
+/*!
+	\return exponentially distributed value with rate 1, divide by the rate for any other.
+*/
+MM_API double mm_random_exponential( struct mm_random *r );
+MM_API void mm_random_exponential_fill( struct mm_random *r, double *out, size_t count );
+
+/*!
+	\return normally distributed value with mean 0 and standard deviation 1.
+*/
+MM_API double mm_random_normal( struct mm_random *r );
+MM_API void mm_random_normal_fill( struct mm_random *r, double *out, size_t count );
+
+/*!
+	\brief Arbitrary discrete distribution, Vose's alias method.
+*/
+typedef struct mm_alias {
+	size_t count;
+	uint_least64_t *threshold; //!< \brief the column keeps its own index below threshold, out of 2^64
+	size_t *alias;
+} mm_alias_t;
+
+/*!
+	\param weights relative probability of every index, need not sum to 1.
+	\param count number of weights.
+	\return false if allocation fails, count is 0, a weight is negative or not finite, or they sum to 0.
+*/
+MM_API bool mm_alias_init( struct mm_alias *this, const double *weights, size_t count );
+MM_API void mm_alias_destroy( struct mm_alias *this );
+
+/*!
+	\return index in [0, count) drawn with the probability of its weight.
+*/
+MM_API size_t mm_alias_next( const struct mm_alias *this, struct mm_random *r );
+MM_API void mm_alias_fill( const struct mm_alias *this, struct mm_random *r, size_t *out, size_t count );
+
+#endif
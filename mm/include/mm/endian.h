@@ -12,7 +12,7 @@
 #include <sys/isadefs.h>
 #endif
 
-#if ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )\
+#if ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ )\
  || ( defined( __BYTE_ORDER ) && __BYTE_ORDER == __BIG_ENDIAN )\
  || ( defined( _BYTE_ORDER ) && _BYTE_ORDER == _BIG_ENDIAN )\
  || ( defined( BYTE_ORDER ) && BYTE_ORDER == BIG_ENDIAN )\
@@ -20,15 +20,15 @@
  ||   defined( __ARMEB__ )\
  ||   defined( __THUMBEB__ )\
  ||   defined( __AARCH64EB__ )\
- ||   defined( _MIBSEB )\
- ||   defined( __MIBSEB )\
- ||   defined( __MIBSEB__ )\
+ ||   defined( _MIPSEB )\
+ ||   defined( __MIPSEB )\
+ ||   defined( __MIPSEB__ )\
  ||   defined( _M_PPC )
 
-#define MM_LITTLE_ENDIAN 1
-#define MM_BYTE_ORDER MM_LITTLE_ENDIAN
+#define MM_BIG_ENDIAN 1
+#define MM_BYTE_ORDER MM_BIG_ENDIAN
 
-#elif ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)\
+#elif ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )\
    || ( defined( __BYTE_ORDER ) && __BYTE_ORDER == __LITTLE_ENDIAN )\
    || ( defined( _BYTE_ORDER ) && _BYTE_ORDER == _LITTLE_ENDIAN )\
    || ( defined( BYTE_ORDER ) && BYTE_ORDER == LITTLE_ENDIAN )\
@@ -44,8 +44,8 @@
    ||   defined( _M_IA64 )\
    ||   defined( _M_ARM )
 
-#define MM_BIG_ENDIAN 1
-#define MM_BYTE_ORDER MM_BIG_ENDIAN
+#define MM_LITTLE_ENDIAN 1
+#define MM_BYTE_ORDER MM_LITTLE_ENDIAN
 #else
 #error "unsupported compiler"
 #endif
@@ -56,7 +56,7 @@
 #define mm_bswap_32( i ) _byteswap_ulong( i )
 #define mm_bswap_64( i ) _byteswap_uint64( i )
 #elif ( __GNUC__ > 4 )\
-   || ( __GNUC__ == 4 && __GNUC__MINOR__ >= 8 )\
+   || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 8 )\
    || MM_HAS_BUILTIN( __builtin_bswap16 )
 #define mm_bswap_16( i ) __builtin_bswap16( i )
 #define mm_bswap_32( i ) __builtin_bswap32( i )
@@ -86,19 +86,39 @@ static inline uint_least64_t mm_bswap_64( uint_least64_t i ) {
 }
 #endif
 
+// functions rather than macros, so the generic selections below can name them
 #ifdef MM_LITTLE_ENDIAN
-#define mm_host_to_net_16( i ) mm_bswap_16( i )
-#define mm_host_to_net_32( i ) mm_bswap_32( i )
-#define mm_host_to_net_64( i ) mm_bswap_64( i )
+#define MM_ENDIAN_NET( bits, i ) mm_bswap_##bits( i )
+#define MM_ENDIAN_LE( bits, i ) ( i )
+#else
+#define MM_ENDIAN_NET( bits, i ) ( i )
+#define MM_ENDIAN_LE( bits, i ) mm_bswap_##bits( i )
+#endif
+
+static inline uint_least16_t mm_host_to_net_16( uint_least16_t i ) {
+	return ( uint_least16_t ) MM_ENDIAN_NET( 16, i );
+}
+
+static inline uint_least32_t mm_host_to_net_32( uint_least32_t i ) {
+	return ( uint_least32_t ) MM_ENDIAN_NET( 32, i );
+}
+
+static inline uint_least64_t mm_host_to_net_64( uint_least64_t i ) {
+	return ( uint_least64_t ) MM_ENDIAN_NET( 64, i );
+}
 
 static inline float mm_host_to_net_float( float f ) {
-	uint_least32_t i = mm_host_to_net_32( *( uint_least32_t* ) &f );
-	return *( float* ) &i;
+	union { float f; uint_least32_t i; } u = { .f = f };
+
+	u.i = mm_host_to_net_32( u.i );
+	return u.f;
 }
 
-static inline float mm_host_to_net_double( double d ) {
-	uint_least64_t i = mm_host_to_net_64( *( uint_least64_t* ) &d );
-	return *( double* ) &i;
+static inline double mm_host_to_net_double( double d ) {
+	union { double d; uint_least64_t i; } u = { .d = d };
+
+	u.i = mm_host_to_net_64( u.i );
+	return u.d;
 }
 
 #define mm_net_to_host_16( i ) mm_host_to_net_16( i )
@@ -107,24 +127,36 @@ static inline float mm_host_to_net_double( double d ) {
 #define mm_net_to_host_float( f ) mm_host_to_net_float( f )
 #define mm_net_to_host_double( d ) mm_host_to_net_double( d )
 
+/*!
+	\brief Swap bytes from host order to little endian, the order of on disk formats meant to be mapped.
+*/
+static inline uint_least16_t mm_host_to_le_16( uint_least16_t i ) {
+	return ( uint_least16_t ) MM_ENDIAN_LE( 16, i );
+}
+
+static inline uint_least32_t mm_host_to_le_32( uint_least32_t i ) {
+	return ( uint_least32_t ) MM_ENDIAN_LE( 32, i );
+}
+
+static inline uint_least64_t mm_host_to_le_64( uint_least64_t i ) {
+	return ( uint_least64_t ) MM_ENDIAN_LE( 64, i );
+}
+
+#define mm_le_to_host_16( i ) mm_host_to_le_16( i )
+#define mm_le_to_host_32( i ) mm_host_to_le_32( i )
+#define mm_le_to_host_64( i ) mm_host_to_le_64( i )
+
+#if ULONG_MAX > 0xffffffff
+#define MM_ENDIAN_ULONG( prefix ) prefix##_64
 #else
-#define mm_host_to_net_16( i ) ( i )
-#define mm_host_to_net_32( i ) ( i )
-#define mm_host_to_net_64( i ) ( i )
-#define mm_host_to_net_float( f ) ( f )
-#define mm_host_to_net_double( d ) ( d )
-#define mm_net_to_host_16( i ) ( i )
-#define mm_net_to_host_32( i ) ( i )
-#define mm_net_to_host_64( i ) ( i )
-#define mm_net_to_host_float( f ) ( f )
-#define mm_net_to_host_double( d ) ( d )
+#define MM_ENDIAN_ULONG( prefix ) prefix##_32
 #endif
 
 /** \def Generically swap bytes from host order to network order ( big endian ) */
 #define mm_host_to_net( i ) _Generic( ( i ),\
 		unsigned short: mm_host_to_net_16,\
-		unsigned int: mm_host_to_net_16,\
-		unsigned long: mm_host_to_net_32,\
+		unsigned int: mm_host_to_net_32,\
+		unsigned long: MM_ENDIAN_ULONG( mm_host_to_net ),\
 		unsigned long long: mm_host_to_net_64,\
 		float: mm_host_to_net_float,\
 		double: mm_host_to_net_double\
@@ -132,12 +164,12 @@ static inline float mm_host_to_net_double( double d ) {
 
 /** \def Generically swap bytes from network order ( big endian ) to host order */
 #define mm_net_to_host( i ) _Generic( ( i ),\
-		unsigned short: mm_net_to_host_16,\
-		unsigned int: mm_net_to_host_16,\
-		unsigned long: mm_net_to_host_32,\
-		unsigned long long: mm_net_to_host_64\
-		float: mm_net_to_host_float,\
-		double: mm_net_to_host_double\
+		unsigned short: mm_host_to_net_16,\
+		unsigned int: mm_host_to_net_32,\
+		unsigned long: MM_ENDIAN_ULONG( mm_host_to_net ),\
+		unsigned long long: mm_host_to_net_64,\
+		float: mm_host_to_net_float,\
+		double: mm_host_to_net_double\
 	)( i )
 
 #endif
@@ -0,0 +1,164 @@
+#ifndef MM_EXECUTOR_H
+#define MM_EXECUTOR_H
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include "mm/common.h"
+#include "mm/co.h"
+#include "mm/list.h"
+
+/*! \file */
+
+/*
+	mm_co tasks spread over worker threads
+
+	example usage
+
+	struct job {
+		struct mm_executor_task task;
+		struct mm_co co;
+		...
+	};
+
+	MM_COROUTINE( job_run, struct mm_executor_task *task ) {
+		struct job *this = MM_EXECUTOR_CONTAINER( task, struct job, task );
+
+		MM_CO_BEGIN( &this->co );
+		...
+		// park until some thread calls mm_executor_wake( executor, task )
+		MM_CO_WAIT_WAKE( &this->co );
+		...
+		MM_CO_END( &this->co );
+	}
+
+	mm_executor_init( &executor, 8, false, NULL, NULL );
+	mm_executor_spawn( &executor, &job->task, job_run );
+	mm_executor_wait( &executor );
+	mm_executor_destroy( &executor );
+*/
+
+#define MM_EXECUTOR_DEQUE 4096 //!< \brief capacity of a worker's deque, further tasks go to the shared queue
+
+enum mm_executor_state {
+	MM_EXECUTOR_IDLE, //!< \brief parked, waiting for mm_executor_wake()
+	MM_EXECUTOR_SCHEDULED, //!< \brief in a queue
+	MM_EXECUTOR_RUNNING,
+	MM_EXECUTOR_NOTIFIED, //!< \brief running, and woken before it got to park
+	MM_EXECUTOR_DONE
+};
+
+struct mm_executor_task;
+
+typedef enum mm_co_state ( *mm_executor_func_t )( struct mm_executor_task *task );
+
+/*!
+	\brief Task embedded in the coroutine state, like struct mm_list.
+*/
+typedef struct mm_executor_task {
+	struct mm_list list; //!< \brief link in the shared queue, or in the waiters of a mm_cchan while parked
+	mm_executor_func_t func;
+	atomic_int state; //!< \brief enum mm_executor_state
+} mm_executor_task_t;
+
+typedef void ( *mm_executor_retire_t )( struct mm_executor_task *task, void *ctx );
+
+/*!
+	\brief Fixed size Chase-Lev deque, the owner pushes and pops at the bottom, thieves take from the top.
+*/
+typedef struct mm_executor_deque {
+	alignas( 64 ) atomic_llong top;
+	alignas( 64 ) atomic_llong bottom;
+	_Atomic( struct mm_executor_task* ) tasks[ MM_EXECUTOR_DEQUE ];
+} mm_executor_deque_t;
+
+struct mm_executor;
+
+typedef struct mm_executor_worker {
+	struct mm_executor_deque deque;
+	struct mm_executor *executor;
+	thrd_t thread;
+	uint_least64_t seed; //!< \brief victim selection
+	unsigned int index;
+} mm_executor_worker_t;
+
+/*!
+	\brief Work stealing thread pool running mm_co tasks.
+
+	Every worker runs tasks from its own deque newest first, which keeps forked work hot in its cache,
+	and steals the oldest task of a random other worker when it runs dry. Tasks spawned or woken from
+	outside the pool go through a shared FIFO queue. A task returning
+	- MM_CO_SUSPENDED goes to the back of the shared queue, so yielding lets every other task run first.
+	- MM_CO_WAITING is parked until mm_executor_wake(), a wake that arrives while it still runs isn't lost.
+	- MM_CO_DONE is retired, the executor no longer touches it.
+
+	Idle workers sleep on a condition variable and are woken one at a time when work shows up.
+*/
+typedef struct mm_executor {
+	struct mm_executor_worker *workers;
+	unsigned int count;
+	bool pin; //!< \brief worker i runs on cpu i modulo the cpu count
+	mm_executor_retire_t retire;
+	void *ctx;
+
+	alignas( 64 ) mtx_t shared_lock;
+	struct mm_list shared; //!< \brief tasks from outside the pool, yielded tasks and deque overflow
+	atomic_size_t shared_size;
+
+	alignas( 64 ) mtx_t park_lock;
+	cnd_t park;
+	atomic_uint sleeping;
+	atomic_bool stop;
+
+	alignas( 64 ) atomic_size_t live; //!< \brief spawned tasks that aren't done
+	cnd_t idle; //!< \brief signaled under park_lock when live drops to 0
+} mm_executor_t;
+
+#define MM_EXECUTOR_CONTAINER( task, type, member )\
+	MM_CONTAINER_OF( task, type, member )
+
+/*!
+	\brief Park the task until mm_executor_wake() is called on it.
+*/
+#define MM_CO_WAIT_WAKE( co )\
+	do {\
+		_MM_CO_RET_( co, MM_CO_WAITING );\
+		_MM_CO_JMP_;\
+	} while( 0 )
+
+/*!
+	\param this pointer to mm_executor.
+	\param workers number of worker threads, 0 for one per cpu.
+	\param pin keep worker i on cpu i modulo the cpu count, where supported.
+	\param retire called on the worker that finished a task. Can be NULL.
+	\param ctx passed to retire.
+	\return false if a thread or synchronization primitive couldn't be created.
+*/
+MM_API bool mm_executor_init( struct mm_executor *this, unsigned int workers, bool pin, mm_executor_retire_t retire, void *ctx );
+
+/*!
+	\brief Stop and join the workers, tasks that are still queued or parked are dropped.
+*/
+MM_API void mm_executor_destroy( struct mm_executor *this );
+
+/*!
+	\brief Schedule a new task, safe from any thread.
+	\param this pointer to mm_executor.
+	\param task task that isn't scheduled, its coroutine state must already be initialized.
+	\param func coroutine to resume.
+*/
+MM_API void mm_executor_spawn( struct mm_executor *this, struct mm_executor_task *task, mm_executor_func_t func );
+
+/*!
+	\brief Schedule a parked task again, safe from any thread, does nothing if it's already scheduled.
+
+	The next run of the task sees whatever the caller stored before the call, so a task may check a
+	condition before MM_CO_WAIT_WAKE() without locking.
+*/
+MM_API void mm_executor_wake( struct mm_executor *this, struct mm_executor_task *task );
+
+/*!
+	\brief Block until every spawned task is done, must not be called from a worker.
+*/
+MM_API void mm_executor_wait( struct mm_executor *this );
+
+#endif
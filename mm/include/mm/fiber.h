@@ -0,0 +1,137 @@
+#ifndef MM_FIBER_H
+#define MM_FIBER_H
+#include <threads.h>
+#include "mm/common.h"
+#include "mm/co.h"
+
+/*! \file */
+
+/*
+	stackful coroutines, the counterpart of mm_co for code that has to yield
+	from deep inside nested calls or keeps its state in locals
+
+	example usage
+
+	static void walk( struct node *node ) {
+		if ( node ) {
+			walk( node->left );
+			mm_fiber_yield( mm_fiber_self() );
+			walk( node->right );
+		}
+	}
+
+	static void run( struct mm_fiber *fiber, void *arg ) {
+		walk( arg );
+	}
+
+	mm_fiber_pool_init( &pool, 64 * 1024, 16 );
+	mm_fiber_init( &fiber, &pool, run, root );
+
+	while( MM_FIBER_RESUME( &fiber ) ) {
+		...
+	}
+
+	mm_fiber_destroy( &fiber );
+*/
+
+// the assembly switch covers the SysV x86-64 and AAPCS64 ABIs, everything else goes through ucontext
+#if !defined( MM_FIBER_UCONTEXT )\
+ && !( defined( __x86_64__ ) && !defined( _WIN32 ) )\
+ && !defined( __aarch64__ )
+#define MM_FIBER_UCONTEXT
+#endif
+
+#ifdef MM_FIBER_UCONTEXT
+#include <ucontext.h>
+#endif
+
+struct mm_fiber;
+
+typedef void ( *mm_fiber_func_t )( struct mm_fiber *fiber, void *arg );
+
+/*!
+	\brief Cache of mmap'ed stacks, each with a PROT_NONE guard page below it.
+
+	Mapping a stack costs a few syscalls and page faults, so released stacks are kept
+	for the next fiber up to max_cached. The pool may be shared between threads.
+*/
+typedef struct mm_fiber_pool {
+	size_t stack_size; //!< \brief usable bytes per stack, a multiple of the page size
+	size_t guard_size;
+	size_t max_cached;
+	size_t cached;
+	void *free; //!< \brief released stacks, linked through their lowest word
+	mtx_t lock;
+} mm_fiber_pool_t;
+
+/*!
+	\brief Coroutine with its own stack.
+*/
+typedef struct mm_fiber {
+#ifdef MM_FIBER_UCONTEXT
+	ucontext_t context;
+	ucontext_t caller;
+#else
+	void *sp; //!< \brief saved stack pointer of the fiber while it's suspended
+	void *caller_sp; //!< \brief saved stack pointer of the resumer while the fiber runs
+#endif
+	struct mm_fiber_pool *pool;
+	void *stack; //!< \brief lowest usable address of the stack
+	mm_fiber_func_t func;
+	void *arg;
+	struct mm_fiber *prev; //!< \brief fiber that resumed this one, NULL for the thread itself
+	enum mm_co_state state;
+} mm_fiber_t;
+
+/*!
+	\param this pointer to mm_fiber_pool.
+	\param stack_size usable bytes per stack, rounded up to whole pages.
+	\param max_cached released stacks kept mapped.
+	\return false if the lock couldn't be created.
+*/
+MM_API bool mm_fiber_pool_init( struct mm_fiber_pool *this, size_t stack_size, size_t max_cached );
+
+/*!
+	\brief Unmap every cached stack, stacks of live fibers are unmapped when they're destroyed.
+*/
+MM_API void mm_fiber_pool_destroy( struct mm_fiber_pool *this );
+
+/*!
+	\param this pointer to mm_fiber.
+	\param pool pool to take the stack from.
+	\param func entry point, the fiber is done once it returns.
+	\param arg passed to func.
+	\return false if no stack could be mapped.
+*/
+MM_API bool mm_fiber_init( struct mm_fiber *this, struct mm_fiber_pool *pool, mm_fiber_func_t func, void *arg );
+
+/*!
+	\brief Give the stack back to the pool, a fiber that didn't finish is dropped without unwinding.
+*/
+MM_API void mm_fiber_destroy( struct mm_fiber *this );
+
+/*!
+	\brief Run the fiber until it yields or returns.
+	\param this pointer to mm_fiber.
+	\return MM_CO_SUSPENDED after a yield, MM_CO_DONE once func returned.
+*/
+MM_API enum mm_co_state mm_fiber_resume( struct mm_fiber *this );
+
+/*!
+	\brief Switch back to whoever resumed the fiber, from any call depth.
+	\param this the running fiber.
+*/
+MM_API void mm_fiber_yield( struct mm_fiber *this );
+
+/*!
+	\return fiber running on the calling thread, NULL outside of any fiber.
+*/
+MM_API struct mm_fiber* mm_fiber_self( void );
+
+#define MM_FIBER_YIELD( fiber )\
+	mm_fiber_yield( fiber )
+
+#define MM_FIBER_RESUME( fiber )\
+	( mm_fiber_resume( fiber ) != MM_CO_DONE )
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef MM_HASH_H
+#define MM_HASH_H
+#include <string.h>
+#include "mm/common.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*! \file */
+
+/*!
+	\brief Fast non-cryptographic 64 bit hashing in the style of wyhash.
+
+	Every function takes a seed. Hash containers should use mm_hash_seed(), which is random per process,
+	so inputs can't be precomputed to collide ( hash flooding ).
+	Keys are read in native byte order, so hashes aren't portable between machines and must not be persisted.
+*/
+
+#define MM_HASH_SECRET_0 0xA0761D6478BD642FULL
+#define MM_HASH_SECRET_1 0xE7037ED1A0B428DBULL
+#define MM_HASH_SECRET_2 0x8EBC6AF09C88C6E3ULL
+#define MM_HASH_SECRET_3 0x589965CC75374CC3ULL
+
+/*!
+	\brief Bytes consumed per iteration by the long input loop.
+*/
+#define MM_HASH_BLOCK 48
+
+/*!
+	\brief Streaming hash state, see mm_hash_init().
+
+	Holds the last 16 processed bytes in front of the pending bytes,
+	since the final step may read back into data that was already processed.
+*/
+typedef struct mm_hash_state {
+	uint_least64_t seed[ 3 ];
+	uint_least64_t total; //!< \brief number of bytes hashed so far
+	size_t pending; //!< \brief number of bytes in buffer after the 16 byte history
+	unsigned char buffer[ 16 + MM_HASH_BLOCK ];
+} mm_hash_state_t;
+
+// 64x64 -> 128 bit multiply, low half in a, high half in b
+static inline void mm_hash_mum( uint_least64_t *a, uint_least64_t *b ) {
+#if defined( __SIZEOF_INT128__ )
+	__extension__ typedef unsigned __int128 mm_hash_u128_t;
+	mm_hash_u128_t r = ( mm_hash_u128_t ) *a * *b;
+
+	*a = ( uint_least64_t ) r;
+	*b = ( uint_least64_t ) ( r >> 64 );
+#elif defined( _MSC_VER ) && defined( _M_X64 )
+	*a = _umul128( *a, *b, b );
+#else
+	uint_least64_t ha = *a >> 32, hb = *b >> 32, la = *a & 0xFFFFFFFF, lb = *b & 0xFFFFFFFF;
+	uint_least64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint_least64_t t = rl + ( rm0 << 32 );
+	uint_least64_t c = t < rl;
+	uint_least64_t lo = t + ( rm1 << 32 );
+
+	c += lo < t;
+	*a = lo;
+	*b = rh + ( rm0 >> 32 ) + ( rm1 >> 32 ) + c;
+#endif
+}
+
+static inline uint_least64_t mm_hash_mix( uint_least64_t a, uint_least64_t b ) {
+	mm_hash_mum( &a, &b );
+	return a ^ b;
+}
+
+static inline uint_least64_t mm_hash_read64( const unsigned char *p ) {
+	uint_least64_t v;
+	memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+static inline uint_least64_t mm_hash_read32( const unsigned char *p ) {
+	uint_least32_t v;
+	memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+// 1 to 3 bytes
+static inline uint_least64_t mm_hash_read3( const unsigned char *p, size_t len ) {
+	return ( ( uint_least64_t ) p[ 0 ] << 16 ) | ( ( uint_least64_t ) p[ len >> 1 ] << 8 ) | p[ len - 1 ];
+}
+
+// seed as used internally, derived once per hash
+static inline uint_least64_t mm_hash_seed_mix( uint_least64_t seed ) {
+	return seed ^ mm_hash_mix( seed ^ MM_HASH_SECRET_0, MM_HASH_SECRET_1 );
+}
+
+static inline uint_least64_t mm_hash_finish( uint_least64_t a, uint_least64_t b, uint_least64_t seed, uint_least64_t len ) {
+	a ^= MM_HASH_SECRET_1;
+	b ^= seed;
+	mm_hash_mum( &a, &b );
+
+	return mm_hash_mix( a ^ MM_HASH_SECRET_0 ^ len, b ^ MM_HASH_SECRET_1 );
+}
+
+// up to 16 bytes with a mixed seed, branches fold away when len is a constant
+static inline uint_least64_t mm_hash_short( const unsigned char *p, size_t len, uint_least64_t seed ) {
+	uint_least64_t a = 0, b = 0;
+
+	if ( len >= 4 ) {
+		size_t off = ( len >> 3 ) << 2;
+
+		a = ( mm_hash_read32( p ) << 32 ) | mm_hash_read32( p + off );
+		b = ( mm_hash_read32( p + len - 4 ) << 32 ) | mm_hash_read32( p + len - 4 - off );
+	} else if ( len ) {
+		a = mm_hash_read3( p, len );
+	}
+
+	return mm_hash_finish( a, b, seed, len );
+}
+
+/*!
+	\brief Hash more than 16 bytes, used by mm_hash_bytes().
+	\param data bytes to hash.
+	\param len length of data, greater than 16.
+	\param seed seed already passed through mm_hash_seed_mix().
+*/
+MM_API uint_least64_t mm_hash_long( const void *data, size_t len, uint_least64_t seed );
+
+/*!
+	\brief Hash a byte string.
+	\param data bytes to hash. Can be NULL if len is 0.
+	\param len length of data in bytes.
+	\param seed seed, usually mm_hash_seed().
+	\return 64 bit hash.
+*/
+static inline uint_least64_t mm_hash_bytes( const void *data, size_t len, uint_least64_t seed ) {
+	seed = mm_hash_seed_mix( seed );
+
+	if ( len <= 16 ) {
+		return mm_hash_short( data, len, seed );
+	}
+
+	return mm_hash_long( data, len, seed );
+}
+
+/*!
+	\brief Hash a 4 byte key, same result as mm_hash_bytes() over its bytes.
+*/
+static inline uint_least64_t mm_hash_u32( uint_least32_t key, uint_least64_t seed ) {
+	unsigned char bytes[ 4 ];
+
+	memcpy( bytes, &key, sizeof( bytes ) );
+	return mm_hash_short( bytes, sizeof( bytes ), mm_hash_seed_mix( seed ) );
+}
+
+/*!
+	\brief Hash an 8 byte key, same result as mm_hash_bytes() over its bytes.
+*/
+static inline uint_least64_t mm_hash_u64( uint_least64_t key, uint_least64_t seed ) {
+	unsigned char bytes[ 8 ];
+
+	memcpy( bytes, &key, sizeof( bytes ) );
+	return mm_hash_short( bytes, sizeof( bytes ), mm_hash_seed_mix( seed ) );
+}
+
+/*!
+	\brief Hash a 16 byte key, same result as mm_hash_bytes() over lo followed by hi.
+*/
+static inline uint_least64_t mm_hash_u128( uint_least64_t lo, uint_least64_t hi, uint_least64_t seed ) {
+	unsigned char bytes[ 16 ];
+
+	memcpy( bytes, &lo, 8 );
+	memcpy( bytes + 8, &hi, 8 );
+	return mm_hash_short( bytes, sizeof( bytes ), mm_hash_seed_mix( seed ) );
+}
+
+/*!
+	\brief Random seed chosen once per process.
+
+	Drawn from mm_random on first use, seeded with the time and stack/code addresses.
+	\return non zero seed, the same for every call.
+*/
+MM_API uint_least64_t mm_hash_seed( void );
+
+/*!
+	\brief Hash an array of 8 byte keys.
+
+	The keys are independent, so several hashes are in flight at once instead of one after the other.
+	\param keys keys to hash.
+	\param count number of keys.
+	\param seed seed, usually mm_hash_seed().
+	\param out receives mm_hash_u64() of every key. Can alias keys.
+*/
+MM_API void mm_hash_u64_batch( const uint_least64_t *keys, size_t count, uint_least64_t seed, uint_least64_t *out );
+
+/*!
+	\brief Hash an array of byte strings.
+	\param data pointer to every string.
+	\param lens length of every string.
+	\param count number of strings.
+	\param seed seed, usually mm_hash_seed().
+	\param out receives mm_hash_bytes() of every string.
+*/
+MM_API void mm_hash_bytes_batch( const void *const *data, const size_t *lens, size_t count, uint_least64_t seed, uint_least64_t *out );
+
+/*!
+	\brief Start a streaming hash.
+
+	Feeding data through any number of mm_hash_update() calls
+	gives the same result as one mm_hash_bytes() call over the concatenation.
+	\param this pointer to mm_hash_state.
+	\param seed seed, usually mm_hash_seed().
+*/
+MM_API void mm_hash_init( struct mm_hash_state *this, uint_least64_t seed );
+
+/*!
+	\param this pointer to mm_hash_state.
+	\param data bytes to append. Can be NULL if len is 0.
+	\param len length of data in bytes.
+*/
+MM_API void mm_hash_update( struct mm_hash_state *this, const void *data, size_t len );
+
+/*!
+	\brief Hash of everything passed to mm_hash_update() so far, the state isn't modified.
+	\param this pointer to mm_hash_state.
+	\return 64 bit hash.
+*/
+MM_API uint_least64_t mm_hash_final( const struct mm_hash_state *this );
+
+#endif
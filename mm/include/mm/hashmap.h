@@ -0,0 +1,401 @@
+#ifndef MM_HASHMAP_H
+#define MM_HASHMAP_H
+#include <stdlib.h>
+#include <string.h>
+#include "mm/common.h"
+#include "mm/bit.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define MM_HASHMAP_SSE2
+#endif
+
+/*! \file */
+
+/*!
+	\brief Open addressing hash map in the style of Swiss tables.
+
+	Every slot has a control byte in a separate array. A full slot stores the low 7 bits of its hash,
+	empty and deleted slots have the high bit set. Lookups compare 16 control bytes at once
+	( with SSE2 when available ) and only touch slots whose 7 bit fragment matches.
+
+	Maps are instantiated per key/value type with MM_HASHMAP_DEFINE(), so the hash and equality functions
+	are inlined into the probe loop. For example
+
+	static inline uint_least64_t hash_int( int key ) { return mm_hash_u32( key, seed ); }
+	static inline bool eq_int( int lhs, int rhs ) { return lhs == rhs; }
+
+	MM_HASHMAP_DEFINE( int_map, int, const char*, hash_int, eq_int )
+
+	struct int_map map = MM_HASHMAP_INIT;
+	int_map_put( &map, 1, "one" );
+	const char **value = int_map_find( &map, 1 );
+	int_map_destroy( &map );
+*/
+
+/*!
+	\brief Number of control bytes probed at once.
+*/
+#define MM_HASHMAP_GROUP 16
+
+#define MM_HASHMAP_EMPTY ( ( unsigned char ) 0x80 )
+#define MM_HASHMAP_DELETED ( ( unsigned char ) 0xFE )
+
+/*!
+	\brief Maximum load factor is MM_HASHMAP_LOAD_NUM / MM_HASHMAP_LOAD_DEN ( 7 / 8 ).
+*/
+#define MM_HASHMAP_LOAD_NUM 7
+#define MM_HASHMAP_LOAD_DEN 8
+
+#define MM_HASHMAP_INIT\
+	{ .ctrl = NULL, .slots = NULL, .capacity = 0, .size = 0, .growth_left = 0 }
+
+static inline bool mm_hashmap_is_full( unsigned char ctrl ) {
+	return !( ctrl & 0x80 );
+}
+
+// position within the table
+static inline size_t mm_hashmap_h1( uint_least64_t hash ) {
+	return ( size_t ) ( hash >> 7 );
+}
+
+// 7 bit fragment stored in the control byte
+static inline unsigned char mm_hashmap_h2( uint_least64_t hash ) {
+	return ( unsigned char ) ( hash & 0x7F );
+}
+
+// bit i is set when ctrl[ i ] == byte
+static inline uint_least32_t mm_hashmap_match( const unsigned char *ctrl, unsigned char byte ) {
+#ifdef MM_HASHMAP_SSE2
+	__m128i group = _mm_loadu_si128( ( const __m128i* ) ctrl );
+	return ( uint_least32_t ) _mm_movemask_epi8( _mm_cmpeq_epi8( group, _mm_set1_epi8( ( char ) byte ) ) );
+#else
+	uint_least32_t mask = 0;
+
+	for ( unsigned int i = 0; i < MM_HASHMAP_GROUP; ++i ) {
+		mask |= ( uint_least32_t ) ( ctrl[ i ] == byte ) << i;
+	}
+
+	return mask;
+#endif
+}
+
+static inline uint_least32_t mm_hashmap_match_empty( const unsigned char *ctrl ) {
+	return mm_hashmap_match( ctrl, MM_HASHMAP_EMPTY );
+}
+
+// empty and deleted are the only control bytes with the high bit set
+static inline uint_least32_t mm_hashmap_match_free( const unsigned char *ctrl ) {
+#ifdef MM_HASHMAP_SSE2
+	return ( uint_least32_t ) _mm_movemask_epi8( _mm_loadu_si128( ( const __m128i* ) ctrl ) );
+#else
+	uint_least32_t mask = 0;
+
+	for ( unsigned int i = 0; i < MM_HASHMAP_GROUP; ++i ) {
+		mask |= ( uint_least32_t ) !mm_hashmap_is_full( ctrl[ i ] ) << i;
+	}
+
+	return mask;
+#endif
+}
+
+/*!
+	\brief Write a control byte, keeping the copy of the first group after the end in sync.
+
+	The copy lets a group load starting anywhere in the table read 16 bytes without wrapping.
+*/
+static inline void mm_hashmap_set_ctrl( unsigned char *ctrl, size_t capacity, size_t idx, unsigned char byte ) {
+	ctrl[ idx ] = byte;
+	ctrl[ ( ( idx - MM_HASHMAP_GROUP ) & ( capacity - 1 ) ) + MM_HASHMAP_GROUP ] = byte;
+}
+
+/*!
+	\brief Smallest power of two capacity that holds count elements under the maximum load factor.
+*/
+static inline size_t mm_hashmap_capacity_for( size_t count ) {
+	size_t needed = ( count * MM_HASHMAP_LOAD_DEN + MM_HASHMAP_LOAD_NUM - 1 ) / MM_HASHMAP_LOAD_NUM;
+	size_t capacity = MM_HASHMAP_GROUP;
+
+	while ( capacity < needed ) {
+		capacity *= 2;
+	}
+
+	return capacity;
+}
+
+static inline size_t mm_hashmap_max_load( size_t capacity ) {
+	return capacity / MM_HASHMAP_LOAD_DEN * MM_HASHMAP_LOAD_NUM;
+}
+
+/*!
+	\brief First empty or deleted slot on the probe sequence of a hash.
+*/
+static inline size_t mm_hashmap_find_free( const unsigned char *ctrl, size_t capacity, uint_least64_t hash ) {
+	size_t mask = capacity - 1;
+	size_t pos = mm_hashmap_h1( hash ) & mask;
+	size_t step = 0;
+
+	for ( ;; ) {
+		uint_least32_t match = mm_hashmap_match_free( ctrl + pos );
+
+		if ( match ) {
+			return ( pos + mm_ctz_u32( match ) ) & mask;
+		}
+
+		step += MM_HASHMAP_GROUP;
+		pos = ( pos + step ) & mask;
+	}
+}
+
+/*!
+	\brief Pick the control byte for an erased slot.
+
+	If the slot sits in a run of fewer than 16 full slots, no probe sequence can have
+	skipped past it while looking for an empty slot, so it can become empty again instead of a tombstone.
+*/
+static inline unsigned char mm_hashmap_erased_ctrl( const unsigned char *ctrl, size_t capacity, size_t idx ) {
+	size_t before = ( idx - MM_HASHMAP_GROUP ) & ( capacity - 1 );
+	uint_least32_t empty_before = mm_hashmap_match_empty( ctrl + before );
+	uint_least32_t empty_after = mm_hashmap_match_empty( ctrl + idx );
+
+	if ( empty_before && empty_after
+	  && mm_ctz_u32( empty_after ) + ( mm_clz_u32( empty_before ) - ( 32 - MM_HASHMAP_GROUP ) ) < MM_HASHMAP_GROUP ) {
+		return MM_HASHMAP_EMPTY;
+	}
+
+	return MM_HASHMAP_DELETED;
+}
+
+/*!
+	\brief Iterate every slot of a map instantiated with MM_HASHMAP_DEFINE().
+	\param name name the map was defined with.
+	\param map pointer to the map.
+	\param pos pointer to name##_slot holding the current slot.
+*/
+#define MM_HASHMAP_FOREACH( name, map, pos )\
+	for ( ( pos ) = name##_next( map, NULL );\
+	      ( pos );\
+	      ( pos ) = name##_next( map, pos ) )
+
+/*!
+	\brief Instantiate a hash map type and its functions.
+
+	Generates struct name, struct name##_slot and static inline functions prefixed with name.
+	Memory is allocated with MM_MALLOC and released with MM_FREE.
+
+	\param name name of the generated struct and function prefix.
+	\param key_type key type, stored and passed by value.
+	\param value_type value type.
+	\param hash function or macro taking a key_type and returning a well mixed uint_least64_t.
+	\param eq function or macro taking two key_types and returning true when they are equal.
+*/
+#define MM_HASHMAP_DEFINE( name, key_type, value_type, hash, eq )\
+	struct name##_slot {\
+		key_type key;\
+		value_type value;\
+	};\
+	\
+	struct name {\
+		unsigned char *ctrl; /* capacity + MM_HASHMAP_GROUP control bytes */\
+		struct name##_slot *slots;\
+		size_t capacity; /* 0 or a power of two of at least MM_HASHMAP_GROUP */\
+		size_t size;\
+		size_t growth_left; /* empty slots that may still be filled before a rehash */\
+	};\
+	\
+	static inline void name##_init( struct name *this ) {\
+		this->ctrl = NULL;\
+		this->slots = NULL;\
+		this->capacity = 0;\
+		this->size = 0;\
+		this->growth_left = 0;\
+	}\
+	\
+	static inline void name##_destroy( struct name *this ) {\
+		MM_FREE( this->ctrl );\
+		MM_FREE( this->slots );\
+		name##_init( this );\
+	}\
+	\
+	static inline size_t name##_size( const struct name *this ) {\
+		return this->size;\
+	}\
+	\
+	static inline void name##_clear( struct name *this ) {\
+		if ( this->capacity ) {\
+			memset( this->ctrl, MM_HASHMAP_EMPTY, this->capacity + MM_HASHMAP_GROUP );\
+		}\
+		\
+		this->size = 0;\
+		this->growth_left = mm_hashmap_max_load( this->capacity );\
+	}\
+	\
+	/* index of the slot holding key or SIZE_MAX */\
+	static inline size_t name##_find_index( const struct name *this, key_type key, uint_least64_t h ) {\
+		size_t mask = this->capacity - 1;\
+		size_t pos = mm_hashmap_h1( h ) & mask;\
+		size_t step = 0;\
+		\
+		if ( !this->capacity ) {\
+			return SIZE_MAX;\
+		}\
+		\
+		for ( ;; ) {\
+			uint_least32_t match = mm_hashmap_match( this->ctrl + pos, mm_hashmap_h2( h ) );\
+			\
+			while ( match ) {\
+				size_t idx = ( pos + mm_ctz_u32( match ) ) & mask;\
+				\
+				if ( eq( this->slots[ idx ].key, key ) ) {\
+					return idx;\
+				}\
+				\
+				match &= match - 1;\
+			}\
+			\
+			if ( mm_hashmap_match_empty( this->ctrl + pos ) ) {\
+				return SIZE_MAX;\
+			}\
+			\
+			step += MM_HASHMAP_GROUP;\
+			pos = ( pos + step ) & mask;\
+		}\
+	}\
+	\
+	/* move every element into a table of new_capacity, dropping tombstones */\
+	static inline bool name##_rehash( struct name *this, size_t new_capacity ) {\
+		unsigned char *ctrl = MM_MALLOC( new_capacity + MM_HASHMAP_GROUP );\
+		struct name##_slot *slots = MM_MALLOC( sizeof( *slots ) * new_capacity );\
+		\
+		if ( !ctrl || !slots ) {\
+			MM_FREE( ctrl );\
+			MM_FREE( slots );\
+			return false;\
+		}\
+		\
+		memset( ctrl, MM_HASHMAP_EMPTY, new_capacity + MM_HASHMAP_GROUP );\
+		\
+		for ( size_t i = 0; i < this->capacity; ++i ) {\
+			if ( mm_hashmap_is_full( this->ctrl[ i ] ) ) {\
+				uint_least64_t h = hash( this->slots[ i ].key );\
+				size_t idx = mm_hashmap_find_free( ctrl, new_capacity, h );\
+				\
+				mm_hashmap_set_ctrl( ctrl, new_capacity, idx, mm_hashmap_h2( h ) );\
+				slots[ idx ] = this->slots[ i ];\
+			}\
+		}\
+		\
+		MM_FREE( this->ctrl );\
+		MM_FREE( this->slots );\
+		this->ctrl = ctrl;\
+		this->slots = slots;\
+		this->capacity = new_capacity;\
+		this->growth_left = mm_hashmap_max_load( new_capacity ) - this->size;\
+		\
+		return true;\
+	}\
+	\
+	/* make room for count elements in total without further rehashing */\
+	static inline bool name##_reserve( struct name *this, size_t count ) {\
+		size_t capacity = mm_hashmap_capacity_for( count );\
+		\
+		if ( capacity <= this->capacity ) {\
+			return true;\
+		}\
+		\
+		return name##_rehash( this, capacity );\
+	}\
+	\
+	static inline value_type* name##_find( const struct name *this, key_type key ) {\
+		size_t idx = name##_find_index( this, key, hash( key ) );\
+		return idx == SIZE_MAX ? NULL : &this->slots[ idx ].value;\
+	}\
+	\
+	/* find or add key, a new value is left uninitialized, NULL on allocation failure */\
+	static inline value_type* name##_emplace( struct name *this, key_type key, bool *inserted ) {\
+		uint_least64_t h = hash( key );\
+		size_t idx = name##_find_index( this, key, h );\
+		\
+		if ( idx != SIZE_MAX ) {\
+			if ( inserted ) {\
+				*inserted = false;\
+			}\
+			\
+			return &this->slots[ idx ].value;\
+		}\
+		\
+		if ( this->capacity ) {\
+			idx = mm_hashmap_find_free( this->ctrl, this->capacity, h );\
+		}\
+		\
+		if ( !this->capacity || ( !this->growth_left && this->ctrl[ idx ] == MM_HASHMAP_EMPTY ) ) {\
+			/* grow, unless at least half of the used slots are tombstones */\
+			size_t capacity = this->capacity && this->size * 2 < mm_hashmap_max_load( this->capacity )\
+				? this->capacity\
+				: mm_hashmap_capacity_for( this->size + 1 );\
+			\
+			if ( !name##_rehash( this, capacity ) ) {\
+				return NULL;\
+			}\
+			\
+			idx = mm_hashmap_find_free( this->ctrl, this->capacity, h );\
+		}\
+		\
+		this->growth_left -= this->ctrl[ idx ] == MM_HASHMAP_EMPTY;\
+		mm_hashmap_set_ctrl( this->ctrl, this->capacity, idx, mm_hashmap_h2( h ) );\
+		this->slots[ idx ].key = key;\
+		++this->size;\
+		\
+		if ( inserted ) {\
+			*inserted = true;\
+		}\
+		\
+		return &this->slots[ idx ].value;\
+	}\
+	\
+	/* insert or overwrite a value, false on allocation failure */\
+	static inline bool name##_put( struct name *this, key_type key, value_type value ) {\
+		value_type *pos = name##_emplace( this, key, NULL );\
+		\
+		if ( !pos ) {\
+			return false;\
+		}\
+		\
+		*pos = value;\
+		return true;\
+	}\
+	\
+	static inline bool name##_erase( struct name *this, key_type key, value_type *value ) {\
+		size_t idx = name##_find_index( this, key, hash( key ) );\
+		\
+		if ( idx == SIZE_MAX ) {\
+			return false;\
+		}\
+		\
+		if ( value ) {\
+			*value = this->slots[ idx ].value;\
+		}\
+		\
+		unsigned char ctrl = mm_hashmap_erased_ctrl( this->ctrl, this->capacity, idx );\
+		\
+		this->growth_left += ctrl == MM_HASHMAP_EMPTY;\
+		mm_hashmap_set_ctrl( this->ctrl, this->capacity, idx, ctrl );\
+		--this->size;\
+		\
+		return true;\
+	}\
+	\
+	/* next full slot after pos, or the first one when pos is NULL */\
+	static inline struct name##_slot* name##_next( const struct name *this, const struct name##_slot *pos ) {\
+		size_t idx = pos ? ( size_t ) ( pos - this->slots ) + 1 : 0;\
+		\
+		for ( ; idx < this->capacity; ++idx ) {\
+			if ( mm_hashmap_is_full( this->ctrl[ idx ] ) ) {\
+				return &this->slots[ idx ];\
+			}\
+		}\
+		\
+		return NULL;\
+	}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef MM_ITREE_H
+#define MM_ITREE_H
+#include "mm/rbtree.h"
+
+/*! \file */
+
+/*!
+	\brief Interval tree node, a closed interval [ start, end ] augmented with the largest end in its subtree.
+
+	start and end must be set before insertion and not changed while inside of a tree.
+*/
+typedef struct mm_itree_node {
+	struct mm_rbtree_node node; //!< \brief underlying red-black tree node, ordered by start
+	uint_least64_t start; //!< \brief first point of the interval
+	uint_least64_t end; //!< \brief last point of the interval, inclusive
+	uint_least64_t max_end; //!< \brief largest end within the subtree rooted here
+} mm_itree_node_t;
+
+/*!
+	\brief Intrusive interval tree.
+
+	Multiple intervals may share the same start or be identical.
+	Finding every interval overlapping a point or range costs O( log n + m ) for m results.
+*/
+typedef struct mm_itree {
+	struct mm_rbtree tree; //!< \brief underlying red-black tree
+} mm_itree_t;
+
+#define MM_ITREE_INIT\
+	{ .tree = MM_RBTREE_INIT }
+
+#define MM_ITREE_DECLARE( name )\
+	struct mm_itree name = MM_ITREE_INIT
+
+#define MM_ITREE_NODE( ptr )\
+	( ( ptr ) ? MM_CONTAINER_OF( ptr, struct mm_itree_node, node ) : NULL )
+
+static inline void mm_itree_init( struct mm_itree *this ) {
+	mm_rbtree_init( &this->tree );
+}
+
+static inline bool mm_itree_empty( const struct mm_itree *this ) {
+	return mm_rbtree_empty( &this->tree );
+}
+
+/*!
+	\brief Insert an interval.
+	\param this pointer to mm_itree.
+	\param node node with start and end set, start must not be greater than end.
+*/
+MM_API void mm_itree_insert( struct mm_itree *this, struct mm_itree_node *node );
+
+/*!
+	\brief Remove an interval.
+	\param this pointer to mm_itree.
+	\param node node to remove, must be inside of the tree.
+*/
+MM_API void mm_itree_erase( struct mm_itree *this, struct mm_itree_node *node );
+
+/*!
+	\brief Find the first interval, ordered by start, that overlaps [ start, end ].
+	\param this pointer to mm_itree.
+	\param start first point of the query.
+	\param end last point of the query, inclusive.
+	\return overlapping node or NULL.
+*/
+MM_API struct mm_itree_node* mm_itree_first_overlap( const struct mm_itree *this, uint_least64_t start, uint_least64_t end );
+
+/*!
+	\brief Find the next interval that overlaps [ start, end ].
+	\param node previous result of mm_itree_first_overlap() or mm_itree_next_overlap().
+	\param start first point of the query.
+	\param end last point of the query, inclusive.
+	\return overlapping node or NULL.
+*/
+MM_API struct mm_itree_node* mm_itree_next_overlap( const struct mm_itree_node *node, uint_least64_t start, uint_least64_t end );
+
+/*!
+	\brief Iterate every interval overlapping [ start, end ], use start == end for a point query.
+	\param tree pointer to mm_itree.
+	\param pos pointer to mm_itree_node to hold the current result.
+	\param start first point of the query.
+	\param end last point of the query, inclusive.
+*/
+#define MM_ITREE_FOREACH_OVERLAP( tree, pos, start, end )\
+	for ( ( pos ) = mm_itree_first_overlap( tree, start, end );\
+	      ( pos );\
+	      ( pos ) = mm_itree_next_overlap( pos, start, end ) )
+
+#endif
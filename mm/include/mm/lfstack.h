@@ -0,0 +1,105 @@
+#ifndef MM_LFSTACK_H
+#define MM_LFSTACK_H
+#include <stdatomic.h>
+#include "mm/common.h"
+
+/*! \file */
+
+/*!
+	\brief Link embedded in objects kept on a mm_lfstack, like struct mm_list.
+*/
+typedef struct mm_lfstack_node {
+	_Atomic( struct mm_lfstack_node* ) next;
+} mm_lfstack_node_t;
+
+/*!
+	\brief Top of stack paired with a counter that changes on every pop.
+*/
+typedef struct mm_lfstack_head {
+	struct mm_lfstack_node *top;
+	uintptr_t tag;
+} mm_lfstack_head_t;
+
+/*!
+	\brief Intrusive LIFO stack ( Treiber ), safe for any number of pushing and popping threads.
+
+	The top pointer is swapped together with a tag using a double width compare and swap,
+	so a pop can't succeed with a stale next pointer after the same node was popped and pushed again ( ABA ).
+	The stack is only lock free where that compare and swap is: GCC on x86-64 sends the 16 byte head through
+	libatomic, which may fall back to a lock, and atomic_is_lock_free() on head returns false there.
+	The tag doesn't protect against reading freed memory: a popping thread may still read the next field of a node
+	another thread just popped, so nodes must stay mapped ( pooled or reused ) while the stack is shared.
+*/
+typedef struct mm_lfstack {
+	_Atomic( struct mm_lfstack_head ) head;
+} mm_lfstack_t;
+
+static inline void mm_lfstack_init( struct mm_lfstack *this ) {
+	struct mm_lfstack_head head = { .top = NULL, .tag = 0 };
+	atomic_init( &this->head, head );
+}
+
+/*!
+	\param this pointer to mm_lfstack.
+	\param node node that isn't part of any stack.
+*/
+static inline void mm_lfstack_push( struct mm_lfstack *this, struct mm_lfstack_node *node ) {
+	struct mm_lfstack_head old = atomic_load_explicit( &this->head, memory_order_relaxed );
+	struct mm_lfstack_head desired;
+
+	do {
+		atomic_store_explicit( &node->next, old.top, memory_order_relaxed );
+		desired.top = node;
+		desired.tag = old.tag;
+	} while ( !atomic_compare_exchange_weak_explicit( &this->head, &old, desired, memory_order_release, memory_order_relaxed ) );
+}
+
+/*!
+	\param this pointer to mm_lfstack.
+	\return most recently pushed node, or NULL if the stack is empty.
+*/
+static inline struct mm_lfstack_node* mm_lfstack_pop( struct mm_lfstack *this ) {
+	struct mm_lfstack_head old = atomic_load_explicit( &this->head, memory_order_acquire );
+	struct mm_lfstack_head desired;
+
+	do {
+		if ( !old.top ) {
+			return NULL;
+		}
+
+		desired.top = atomic_load_explicit( &old.top->next, memory_order_relaxed );
+		desired.tag = old.tag + 1;
+	} while ( !atomic_compare_exchange_weak_explicit( &this->head, &old, desired, memory_order_acquire, memory_order_acquire ) );
+
+	return old.top;
+}
+
+/*!
+	\brief Take every node at once.
+	\param this pointer to mm_lfstack.
+	\return former top of the stack, follow next to walk the rest in LIFO order.
+*/
+static inline struct mm_lfstack_node* mm_lfstack_pop_all( struct mm_lfstack *this ) {
+	struct mm_lfstack_head old = atomic_load_explicit( &this->head, memory_order_acquire );
+	struct mm_lfstack_head desired;
+
+	do {
+		desired.top = NULL;
+		desired.tag = old.tag + 1;
+	} while ( !atomic_compare_exchange_weak_explicit( &this->head, &old, desired, memory_order_acquire, memory_order_acquire ) );
+
+	return old.top;
+}
+
+/*!
+	\param this pointer to mm_lfstack.
+	\return true if the stack was empty at the time of the call.
+*/
+static inline bool mm_lfstack_empty( struct mm_lfstack *this ) {
+	return !atomic_load_explicit( &this->head, memory_order_relaxed ).top;
+}
+
+#define MM_LFSTACK_CONTAINER( node, type, member )\
+	MM_CONTAINER_OF( node, type, member )
+
+#endif
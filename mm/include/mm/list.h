@@ -9,7 +9,7 @@ typedef struct mm_list {
 
 static inline void mm_list_init( struct mm_list *head ) {
 	head->prev = head;
-	head->next = next;
+	head->next = head;
 }
 
 static inline bool mm_list_empty( struct mm_list *head ) {
@@ -78,7 +78,7 @@ static inline void mm_list_replace( struct mm_list *old_pos, struct mm_list *new
 static inline void mm_list_swap( struct mm_list *pos_1, struct mm_list *pos_2 ) {
 	struct mm_list *tmp = pos_2->prev;
 
-	mm_list_do_del( pos_2 );
+	mm_list_del( pos_2 );
 	mm_list_replace( pos_1, pos_2 );
 
 	if ( tmp == pos_1 ) {
@@ -105,7 +105,7 @@ static inline void mm_list_rotate_to( struct mm_list *head, struct mm_list *pos
 }
 
 static inline void mm_list_do_cut( struct mm_list *head, struct mm_list *other, struct mm_list *pos ) {
-	struct end = pos->next;
+	struct mm_list *end = pos->next;
 
 	other->next = head->next;
 	other->next->prev = other;
@@ -176,16 +176,16 @@ static inline void mm_list_splice_tail( struct mm_list *head, struct mm_list *ot
 	      ( pos ) = ( tmp ), ( tmp ) = ( pos )->prev )
 
 #define MM_LIST_FIRST_CONTAINER( head, type, member )\
-	MM_CONTAINER_OF( head->next, type, member )
+	MM_CONTAINER_OF( ( head )->next, type, member )
 
 #define MM_LIST_LAST_CONTAINER( head, type, member )\
-	MM_CONTAINER_OF( head->prev, type, member )
+	MM_CONTAINER_OF( ( head )->prev, type, member )
 
 #define MM_LIST_NEXT_CONTAINER( pos, type, member )\
-	MM_CONTAINER_OF( ( pos )->member->next, type, member )
+	MM_CONTAINER_OF( ( pos )->member.next, type, member )
 
 #define MM_LIST_PREV_CONTAINER( pos, type, member )\
-	MM_CONTAINER_OF( ( pos )->member->prev, type, member )
+	MM_CONTAINER_OF( ( pos )->member.prev, type, member )
 
 #define MM_LIST_FOREACH_CONTAINER( head, pos, type, member )\
 	for ( ( pos ) = MM_LIST_FIRST_CONTAINER( head, type, member );\
@@ -1,6 +1,11 @@
 #ifndef MM_LOG_H
 #define MM_LOG_H
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
 #include "mm/common.h"
 
 #if MM_HAS_INCLUDE( <syslog.h> )
@@ -21,6 +26,9 @@ typedef enum mm_log_level {
 	MM_ERR = LOG_ERR,
 	MM_CRIT = LOG_CRIT
 } mm_log_level_t;
+
+// syslog counts down towards the more severe levels
+#define MM_LOG_SEVERITY( level ) ( LOG_DEBUG - ( int ) ( level ) )
 #else
 typedef enum mm_log_facility {
 	MM_DAEMON = 1,
@@ -33,13 +41,399 @@ typedef enum mm_log_level {
 	MM_ERR,
 	MM_CRIT
 } mm_log_level_t;
+
+#define MM_LOG_SEVERITY( level ) ( ( int ) ( level ) )
+#endif
+
+/*!
+	\brief Least severe level that is compiled in, MM_LOG(), MM_LOG_LIMITED() and MM_LOG_DEFER() below it are removed.
+*/
+#ifndef MM_LOG_MIN_LEVEL
+#define MM_LOG_MIN_LEVEL MM_INFO
 #endif
 
+#define MM_LOG_COMPILED( level )\
+	( MM_LOG_SEVERITY( level ) >= MM_LOG_SEVERITY( MM_LOG_MIN_LEVEL ) )
+
+#define MM_LOG_RING_SIZE ( 64 * 1024 ) //!< \brief default bytes buffered per thread in async mode
+#define MM_LOG_MAX_MESSAGE 1024 //!< \brief longer messages are truncated in async mode
+#define MM_LOG_RECORDER_SIZE ( 1024 * 1024 ) //!< \brief default bytes kept by the flight recorder
+
+/*!
+	\brief What a thread logging in async mode does when its ring is full.
+*/
+typedef enum mm_log_overflow {
+	MM_LOG_DROP, //!< \brief discard the message
+	MM_LOG_BLOCK, //!< \brief wait for the writer thread to make room
+	MM_LOG_COUNT //!< \brief discard the message, the writer thread reports how many were lost
+} mm_log_overflow_t;
+
+typedef struct mm_log_async_config {
+	int fd; //!< \brief where messages are written, -1 for MM_STDOUT
+	size_t ring_size; //!< \brief bytes per thread, 0 for MM_LOG_RING_SIZE, rounded up to a power of 2
+	enum mm_log_overflow overflow;
+	bool binary; //!< \brief write records as they are, for mm_log_decode(), instead of formatting them
+} mm_log_async_config_t;
+
+/*!
+	\brief Only calls to syslog once opened.
+*/
 MM_API void mm_openlog( const char *name, enum mm_log_facility facility );
 MM_API void mm_closelog( void );
 MM_API void mm_vlog( enum mm_log_level level, const char *format, va_list args );
 MM_API void mm_log( enum mm_log_level level, const char *format, ... );
 
+/*!
+	\brief MM_LOG_SEVERITY() of the least severe level that is logged, use mm_log_set_level().
+*/
+MM_API atomic_int mm_log_threshold;
+
+/*!
+	\brief Discard messages less severe than level from now on, MM_INFO at startup.
+*/
+MM_API void mm_log_set_level( enum mm_log_level level );
+
+/*!
+	\return whether a message of the level would be logged, one relaxed load when compiled in.
+*/
+static inline bool mm_log_enabled( enum mm_log_level level ) {
+	return MM_LOG_COMPILED( level ) && MM_LOG_SEVERITY( level ) >= atomic_load_explicit( &mm_log_threshold, memory_order_relaxed );
+}
+
+/*!
+	\brief mm_log() that doesn't evaluate its arguments when the level is filtered.
+*/
+#define MM_LOG( level, ... )\
+	do {\
+		if ( MM_LOG_COMPILED( level ) && mm_log_enabled( level ) ) {\
+			mm_log( level, __VA_ARGS__ );\
+		}\
+	} while( 0 )
+
+/*!
+	\brief Token bucket of one MM_LOG_LIMITED() call.
+*/
+typedef struct mm_log_limit {
+	const char *file;
+	int line;
+	enum mm_log_level level;
+	uint_least32_t rate; //!< \brief messages per second in the long run
+	uint_least32_t burst; //!< \brief messages that may go out at once
+	atomic_uint_least64_t next; //!< \brief when the bucket is full again, in ns
+	atomic_uint_least64_t suppressed; //!< \brief since the last message that went out
+} mm_log_limit_t;
+
+/*!
+	\brief Take a token, the first message after some were suppressed is preceded by their count.
+	\return false if the message has to be suppressed.
+*/
+MM_API bool mm_log_limit_take( struct mm_log_limit *this );
+
+/*!
+	\brief MM_LOG() that lets at most burst messages through at once and rate per second after that.
+*/
+#define MM_LOG_LIMITED( level, rate, burst, ... )\
+	do {\
+		static struct mm_log_limit _mm_log_limit = { MM_LOG_COMPILED( level ) ? __FILE__ : NULL, __LINE__, level, rate, burst, 0, 0 };\
+		\
+		if ( MM_LOG_COMPILED( level ) && mm_log_enabled( level ) && mm_log_limit_take( &_mm_log_limit ) ) {\
+			mm_log( level, __VA_ARGS__ );\
+		}\
+	} while( 0 )
+
+/*!
+	\brief Move writing off the calling threads.
+
+	Every thread formats its messages into its own lock free ring, a writer thread collects them and
+	writes them out in batches with writev. Callers never make a system call unless their ring is more
+	than half full, or full under MM_LOG_BLOCK. Messages of one thread keep their order, messages of
+	different threads may interleave differently than they were logged. The ring of a thread that
+	exits is kept for the next thread that logs.
+
+	Whatever was logged is written out by mm_log_async_stop(), which is also registered with atexit.
+	\param config NULL for the defaults, MM_STDOUT with MM_LOG_BLOCK.
+	\return false if async mode is already on, or its lock or the writer thread couldn't be created.
+*/
+MM_API bool mm_log_async_start( const struct mm_log_async_config *config );
+
+/*!
+	\brief Write out everything logged so far and go back to logging on the calling thread.
+*/
+MM_API void mm_log_async_stop( void );
+
+/*!
+	\brief Block until everything logged so far has been written.
+*/
+MM_API void mm_log_flush( void );
+
+/*!
+	\return messages lost to MM_LOG_COUNT since async mode was started.
+*/
+MM_API uint_least64_t mm_log_dropped( void );
+
+/*!
+	\brief Keep the last messages in a file backed ring that outlives a crash.
+
+	Every message that is logged is also appended to a ring in a shared mapping of path, the oldest
+	messages are overwritten. Threads reserve room with a single atomic add and seal a record once it
+	is complete, so a thread that dies halfway through only loses its own record. The pages belong to
+	the kernel, whatever was appended before the process died is in the file, mm_log_decode() and
+	mm-logdump read it back. Deferred messages are formatted before they are appended.
+	\param path file to create or overwrite.
+	\param size bytes in the ring, 0 for MM_LOG_RECORDER_SIZE, rounded up to a power of 2.
+	\return false if the file can't be created or mapped, or the recorder is already open.
+*/
+MM_API bool mm_log_recorder_open( const char *path, size_t size );
+
+/*!
+	\brief Stop recording and unmap the ring, no other thread may be logging at the same time.
+*/
+MM_API void mm_log_recorder_close( void );
+
+/*!
+	\brief Append a binary event to the flight recorder, nothing happens if it isn't open.
+	\param type for whoever reads the recording.
+	\param data event, at most MM_LOG_MAX_MESSAGE bytes are kept.
+	\param size bytes in data.
+*/
+MM_API void mm_log_event( uint_least32_t type, const void *data, size_t size );
+
+/*
+	deferred formatting
+
+	MM_LOG_DEFER( MM_INFO, "request %d took %f ms from %s", id, ms, peer );
+
+	stores a pointer to the call site, a timestamp and the raw arguments, formatting happens on the
+	writer thread or, with binary set in mm_log_async_config, offline in mm_log_decode(). strings are
+	copied, every other pointer is logged as its address. up to MM_LOG_MAX_ARGS arguments, and the
+	format must not use * for a width or precision.
+*/
+
+#define MM_LOG_MAX_ARGS 8
+
+typedef enum mm_log_arg_type {
+	MM_LOG_ARG_I64 = 1,
+	MM_LOG_ARG_U64,
+	MM_LOG_ARG_F64,
+	MM_LOG_ARG_PTR,
+	MM_LOG_ARG_STR
+} mm_log_arg_type_t;
+
+typedef union mm_log_arg {
+	int_least64_t i;
+	uint_least64_t u;
+	double f;
+	const void *p;
+	const char *s;
+} mm_log_arg_t;
+
+/*!
+	\brief Everything about a MM_LOG_DEFER() call that is known at compile time, one static instance per call.
+*/
+typedef struct mm_log_site {
+	const char *format;
+	const char *file;
+	int line;
+	unsigned char level;
+	unsigned char count;
+	unsigned char types[ MM_LOG_MAX_ARGS ]; //!< \brief enum mm_log_arg_type
+	atomic_uint epoch; //!< \brief async run the site was last described in
+} mm_log_site_t;
+
+/*!
+	\return timestamp counter, cycles on x86 and aarch64, nanoseconds elsewhere.
+*/
+static inline uint_least64_t mm_log_tsc( void ) {
+#if defined( __GNUC__ ) && defined( __x86_64__ )
+	unsigned int lo, hi;
+
+	__asm__ volatile( "rdtsc" : "=a"( lo ), "=d"( hi ) );
+	return ( uint_least64_t ) hi << 32 | lo;
+#elif defined( __GNUC__ ) && defined( __aarch64__ )
+	uint_least64_t value;
+
+	__asm__ volatile( "mrs %0, cntvct_el0" : "=r"( value ) );
+	return value;
+#else
+	struct timespec ts;
+
+	timespec_get( &ts, TIME_UTC );
+	return ( uint_least64_t ) ts.tv_sec * 1000000000u + ( uint_least64_t ) ts.tv_nsec;
+#endif
+}
+
+/*!
+	\brief Record one deferred message, used by MM_LOG_DEFER().
+	\param site call site.
+	\param args site->count arguments.
+*/
+MM_API void mm_log_defer( struct mm_log_site *site, const union mm_log_arg *args );
+
+/*!
+	\brief printf with arguments that were captured by MM_LOG_DEFER().
+	\param buf output, always terminated when size isn't 0.
+	\param size bytes in buf.
+	\param format printf format.
+	\param types type of every argument.
+	\param args arguments.
+	\param count number of arguments.
+	\return length of the output, not counting what was truncated.
+*/
+MM_API size_t mm_log_format( char *buf, size_t size, const char *format, const unsigned char *types, const union mm_log_arg *args, size_t count );
+
+/*!
+	\brief Turn the output of a binary async run, or a flight recorder file, back into text.
+	\param in binary log or recording.
+	\param out text.
+	\return false if in isn't a binary log or is cut short.
+*/
+MM_API bool mm_log_decode( FILE *in, FILE *out );
+
+static inline union mm_log_arg mm_log_arg_i64( long long value ) {
+	union mm_log_arg arg;
+
+	arg.i = value;
+	return arg;
+}
+
+static inline union mm_log_arg mm_log_arg_u64( unsigned long long value ) {
+	union mm_log_arg arg;
+
+	arg.u = value;
+	return arg;
+}
+
+static inline union mm_log_arg mm_log_arg_f64( double value ) {
+	union mm_log_arg arg;
+
+	arg.f = value;
+	return arg;
+}
+
+static inline union mm_log_arg mm_log_arg_ptr( const volatile void *value ) {
+	union mm_log_arg arg;
+
+	arg.p = ( const void* ) value;
+	return arg;
+}
+
+static inline union mm_log_arg mm_log_arg_str( const char *value ) {
+	union mm_log_arg arg;
+
+	arg.s = value;
+	return arg;
+}
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+__attribute__(( format( printf, 1, 2 ) ))
+#endif
+static inline void mm_log_format_check( const char *format, ... ) {
+	( void ) format;
+}
+
+#define _MM_LOG_TYPE_( x )\
+	_Generic( ( x ),\
+		_Bool: MM_LOG_ARG_U64,\
+		char: MM_LOG_ARG_I64,\
+		signed char: MM_LOG_ARG_I64,\
+		unsigned char: MM_LOG_ARG_U64,\
+		short: MM_LOG_ARG_I64,\
+		unsigned short: MM_LOG_ARG_U64,\
+		int: MM_LOG_ARG_I64,\
+		unsigned int: MM_LOG_ARG_U64,\
+		long: MM_LOG_ARG_I64,\
+		unsigned long: MM_LOG_ARG_U64,\
+		long long: MM_LOG_ARG_I64,\
+		unsigned long long: MM_LOG_ARG_U64,\
+		float: MM_LOG_ARG_F64,\
+		double: MM_LOG_ARG_F64,\
+		long double: MM_LOG_ARG_F64,\
+		char*: MM_LOG_ARG_STR,\
+		const char*: MM_LOG_ARG_STR,\
+		default: MM_LOG_ARG_PTR )
+
+#define _MM_LOG_ARG_( x )\
+	_Generic( ( x ),\
+		_Bool: mm_log_arg_u64,\
+		char: mm_log_arg_i64,\
+		signed char: mm_log_arg_i64,\
+		unsigned char: mm_log_arg_u64,\
+		short: mm_log_arg_i64,\
+		unsigned short: mm_log_arg_u64,\
+		int: mm_log_arg_i64,\
+		unsigned int: mm_log_arg_u64,\
+		long: mm_log_arg_i64,\
+		unsigned long: mm_log_arg_u64,\
+		long long: mm_log_arg_i64,\
+		unsigned long long: mm_log_arg_u64,\
+		float: mm_log_arg_f64,\
+		double: mm_log_arg_f64,\
+		long double: mm_log_arg_f64,\
+		char*: mm_log_arg_str,\
+		const char*: mm_log_arg_str,\
+		default: mm_log_arg_ptr )( x )
+
+#define _MM_LOG_NARGS_( _1, _2, _3, _4, _5, _6, _7, _8, _9, n, ... ) n
+#define _MM_LOG_NARGS( ... )\
+	_MM_LOG_NARGS_( __VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, _ )
+
+// apply m to every argument, separated by commas
+#define _MM_LOG_MAP_0( m )
+#define _MM_LOG_MAP_1( m, a ) m( a )
+#define _MM_LOG_MAP_2( m, a, ... ) m( a ), _MM_LOG_MAP_1( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_3( m, a, ... ) m( a ), _MM_LOG_MAP_2( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_4( m, a, ... ) m( a ), _MM_LOG_MAP_3( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_5( m, a, ... ) m( a ), _MM_LOG_MAP_4( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_6( m, a, ... ) m( a ), _MM_LOG_MAP_5( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_7( m, a, ... ) m( a ), _MM_LOG_MAP_6( m, __VA_ARGS__ )
+#define _MM_LOG_MAP_8( m, a, ... ) m( a ), _MM_LOG_MAP_7( m, __VA_ARGS__ )
+
+#define _MM_LOG_DEFER_0( level, format )\
+	do {\
+		static struct mm_log_site _mm_log_site = {\
+			MM_LOG_COMPILED( level ) ? format : NULL, MM_LOG_COMPILED( level ) ? __FILE__ : NULL, __LINE__, level, 0, { 0 }, 0\
+		};\
+		\
+		if ( 0 ) {\
+			mm_log_format_check( format );\
+		}\
+		\
+		mm_log_defer( &_mm_log_site, NULL );\
+	} while( 0 )
+
+#define _MM_LOG_DEFER_N( n, level, format, ... )\
+	do {\
+		static struct mm_log_site _mm_log_site = {\
+			MM_LOG_COMPILED( level ) ? format : NULL, MM_LOG_COMPILED( level ) ? __FILE__ : NULL, __LINE__, level, n, { MM_CAT( _MM_LOG_MAP_, n )( _MM_LOG_TYPE_, __VA_ARGS__ ) }, 0\
+		};\
+		union mm_log_arg _mm_log_args[] = { MM_CAT( _MM_LOG_MAP_, n )( _MM_LOG_ARG_, __VA_ARGS__ ) };\
+		\
+		if ( 0 ) {\
+			mm_log_format_check( format, __VA_ARGS__ );\
+		}\
+		\
+		mm_log_defer( &_mm_log_site, _mm_log_args );\
+	} while( 0 )
+
+#define _MM_LOG_DEFER_1( level, format, ... ) _MM_LOG_DEFER_N( 1, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_2( level, format, ... ) _MM_LOG_DEFER_N( 2, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_3( level, format, ... ) _MM_LOG_DEFER_N( 3, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_4( level, format, ... ) _MM_LOG_DEFER_N( 4, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_5( level, format, ... ) _MM_LOG_DEFER_N( 5, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_6( level, format, ... ) _MM_LOG_DEFER_N( 6, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_7( level, format, ... ) _MM_LOG_DEFER_N( 7, level, format, __VA_ARGS__ )
+#define _MM_LOG_DEFER_8( level, format, ... ) _MM_LOG_DEFER_N( 8, level, format, __VA_ARGS__ )
+
+/*!
+	\brief Log without formatting on the calling thread, the format has to be a string literal.
+*/
+#define MM_LOG_DEFER( level, ... )\
+	do {\
+		if ( MM_LOG_COMPILED( level ) && mm_log_enabled( level ) ) {\
+			MM_CAT( _MM_LOG_DEFER_, _MM_LOG_NARGS( __VA_ARGS__ ) )( level, __VA_ARGS__ );\
+		}\
+	} while( 0 )
+
 #ifdef MM_DEBUG
 #define MM_DEBUG_VLOG( level, format, args) mm_vlog( level, format, args )
 #define MM_DEBUG_LOG( level, ... ) mm_log( level, __VA_ARGS__ )
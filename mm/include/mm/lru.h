@@ -0,0 +1,131 @@
+#ifndef MM_LRU_H
+#define MM_LRU_H
+#include <stdatomic.h>
+#include "mm/common.h"
+#include "mm/list.h"
+
+/*! \file */
+
+/*!
+	\brief Share of the capacity reserved for the protected segment in MM_LRU_SLRU mode ( 4 / 5 ).
+*/
+#define MM_LRU_PROTECTED_NUM 4
+#define MM_LRU_PROTECTED_DEN 5
+
+/*!
+	\brief Replacement policy of a mm_lru.
+*/
+typedef enum mm_lru_policy {
+	MM_LRU_LRU, //!< \brief a hit moves the entry to the front, evict from the back
+	MM_LRU_CLOCK, //!< \brief a hit only sets a reference bit, eviction gives referenced entries a second chance
+	MM_LRU_SLRU //!< \brief new entries start on probation, a second hit promotes them to a protected segment
+} mm_lru_policy_t;
+
+/*!
+	\brief Intrusive cache entry, embed it in the cached object.
+*/
+typedef struct mm_lru_node {
+	struct mm_list list; //!< \brief position in the recency list
+	struct mm_lru_node *chain; //!< \brief next node in the same hash bucket
+	uint_least64_t key;
+	size_t charge; //!< \brief share of the capacity used by this entry
+	atomic_bool referenced; //!< \brief set by hits in MM_LRU_CLOCK mode
+	bool protected; //!< \brief in the protected segment in MM_LRU_SLRU mode
+} mm_lru_node_t;
+
+/*!
+	\brief Called for every entry the cache drops because the capacity is exceeded.
+
+	The node is already unlinked, so the callback may free it.
+*/
+typedef void ( *mm_lru_evict_t )( struct mm_lru_node *node, void *ctx );
+
+/*!
+	\brief Cache of intrusive nodes with a fixed budget and O( 1 ) lookup, insert and eviction.
+
+	Recency is kept in mm_list order, the most recently used entry first, and keys are indexed by an
+	embedded chained hash table, so the cache never allocates per entry.
+	Every entry has a charge, so the capacity can count entries ( charge 1 ) or bytes ( charge = size ).
+
+	The cache isn't thread safe. In MM_LRU_CLOCK mode mm_lru_find() only sets an atomic flag on the node,
+	so lookups may run concurrently under the read side of a reader/writer lock,
+	while insert, erase and the other policies need exclusive access.
+*/
+typedef struct mm_lru {
+	struct mm_list main; //!< \brief all entries, or the probation segment in MM_LRU_SLRU mode
+	struct mm_list protected; //!< \brief protected segment in MM_LRU_SLRU mode
+	struct mm_lru_node **buckets;
+	size_t mask; //!< \brief number of buckets - 1
+	size_t size; //!< \brief number of entries
+	size_t charge; //!< \brief sum of all entry charges
+	size_t protected_charge; //!< \brief sum of protected entry charges
+	size_t capacity;
+	enum mm_lru_policy policy;
+	mm_lru_evict_t evict;
+	void *ctx;
+	uint_least64_t seed;
+} mm_lru_t;
+
+/*!
+	\param this pointer to mm_lru.
+	\param capacity maximum sum of entry charges.
+	\param policy replacement policy.
+	\param evict called for entries dropped to stay within capacity. Can be NULL.
+	\param ctx passed to evict.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_lru_init( struct mm_lru *this, size_t capacity, enum mm_lru_policy policy, mm_lru_evict_t evict, void *ctx );
+
+/*!
+	\brief Pass every entry to the eviction callback and free the index.
+	\param this pointer to mm_lru.
+*/
+MM_API void mm_lru_destroy( struct mm_lru *this );
+
+/*!
+	\brief Find an entry and mark it as used.
+	\param this pointer to mm_lru.
+	\param key key to search for.
+	\return node or NULL on a miss.
+*/
+MM_API struct mm_lru_node* mm_lru_find( struct mm_lru *this, uint_least64_t key );
+
+/*!
+	\brief Find an entry without changing its position.
+	\param this pointer to mm_lru.
+	\param key key to search for.
+	\return node or NULL if key isn't cached.
+*/
+MM_API struct mm_lru_node* mm_lru_peek( const struct mm_lru *this, uint_least64_t key );
+
+/*!
+	\brief Add an entry as the most recently used one, then evict until the charge fits the capacity.
+
+	An existing entry with the same key is evicted first. An entry larger than the whole capacity is evicted
+	right away.
+	\param this pointer to mm_lru.
+	\param node node that isn't part of any mm_lru.
+	\param key key of the entry.
+	\param charge share of the capacity used by this entry.
+*/
+MM_API void mm_lru_insert( struct mm_lru *this, struct mm_lru_node *node, uint_least64_t key, size_t charge );
+
+/*!
+	\brief Remove an entry without calling the eviction callback.
+	\param this pointer to mm_lru.
+	\param node node that is part of this mm_lru.
+*/
+MM_API void mm_lru_erase( struct mm_lru *this, struct mm_lru_node *node );
+
+static inline size_t mm_lru_size( const struct mm_lru *this ) {
+	return this->size;
+}
+
+static inline size_t mm_lru_charge( const struct mm_lru *this ) {
+	return this->charge;
+}
+
+#define MM_LRU_CONTAINER( node, type, member )\
+	MM_CONTAINER_OF( node, type, member )
+
+#endif
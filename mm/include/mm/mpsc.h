@@ -0,0 +1,104 @@
+#ifndef MM_MPSC_H
+#define MM_MPSC_H
+#include <stdalign.h>
+#include <stdatomic.h>
+#include "mm/common.h"
+
+/*! \file */
+
+/*!
+	\brief Link embedded in objects passed through a mm_mpsc, like struct mm_list.
+*/
+typedef struct mm_mpsc_node {
+	_Atomic( struct mm_mpsc_node* ) next;
+} mm_mpsc_node_t;
+
+/*!
+	\brief Intrusive multi producer, single consumer queue ( Vyukov ).
+
+	Any thread may push, only one thread at a time may pop. A push is one atomic exchange and never waits on
+	other producers or the consumer, a pop touches no shared cache line unless the queue is nearly empty.
+	Nothing is allocated, the queue links the embedded nodes directly.
+
+	A producer that was preempted between its exchange and linking its node hides every later node for a moment,
+	so mm_mpsc_pop() can return NULL while the queue isn't empty. Consumers that need every node must retry.
+*/
+typedef struct mm_mpsc {
+	_Atomic( struct mm_mpsc_node* ) head; //!< \brief last pushed node, written by producers
+	alignas( 64 ) struct mm_mpsc_node *tail; //!< \brief next node to pop, owned by the consumer
+	struct mm_mpsc_node stub; //!< \brief placeholder that keeps the list non empty
+} mm_mpsc_t;
+
+static inline void mm_mpsc_init( struct mm_mpsc *this ) {
+	atomic_init( &this->stub.next, NULL );
+	atomic_init( &this->head, &this->stub );
+	this->tail = &this->stub;
+}
+
+/*!
+	\brief Append a node, safe to call from any number of threads.
+	\param this pointer to mm_mpsc.
+	\param node node that isn't part of any queue.
+*/
+static inline void mm_mpsc_push( struct mm_mpsc *this, struct mm_mpsc_node *node ) {
+	struct mm_mpsc_node *prev;
+
+	atomic_store_explicit( &node->next, NULL, memory_order_relaxed );
+	prev = atomic_exchange_explicit( &this->head, node, memory_order_acq_rel );
+	atomic_store_explicit( &prev->next, node, memory_order_release );
+}
+
+/*!
+	\brief Remove the oldest node, only one thread may pop at a time.
+	\param this pointer to mm_mpsc.
+	\return node, or NULL if the queue is empty or a push is halfway done.
+*/
+static inline struct mm_mpsc_node* mm_mpsc_pop( struct mm_mpsc *this ) {
+	struct mm_mpsc_node *tail = this->tail;
+	struct mm_mpsc_node *next = atomic_load_explicit( &tail->next, memory_order_acquire );
+
+	if ( tail == &this->stub ) {
+		if ( !next ) {
+			return NULL;
+		}
+
+		this->tail = next;
+		tail = next;
+		next = atomic_load_explicit( &next->next, memory_order_acquire );
+	}
+
+	if ( next ) {
+		this->tail = next;
+		return tail;
+	}
+
+	// tail is the last linked node, unless a producer already swapped head
+	if ( tail != atomic_load_explicit( &this->head, memory_order_acquire ) ) {
+		return NULL;
+	}
+
+	// tail can only be handed out once something follows it, so push the stub behind it
+	mm_mpsc_push( this, &this->stub );
+	next = atomic_load_explicit( &tail->next, memory_order_acquire );
+
+	if ( next ) {
+		this->tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+/*!
+	\param this pointer to mm_mpsc.
+	\return true if no node is queued, only reliable on the consumer thread.
+*/
+static inline bool mm_mpsc_empty( struct mm_mpsc *this ) {
+	return this->tail == &this->stub
+	    && !atomic_load_explicit( &this->stub.next, memory_order_acquire );
+}
+
+#define MM_MPSC_CONTAINER( node, type, member )\
+	MM_CONTAINER_OF( node, type, member )
+
+#endif
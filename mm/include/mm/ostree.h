@@ -0,0 +1,180 @@
+#ifndef MM_OSTREE_H
+#define MM_OSTREE_H
+#include "mm/rbtree.h"
+
+/*! \file */
+
+/*!
+	\brief Order-statistic tree node, a mm_rbtree_node augmented with its subtree size.
+*/
+typedef struct mm_ostree_node {
+	struct mm_rbtree_node node; //!< \brief underlying red-black tree node
+	size_t size; //!< \brief number of nodes in the subtree rooted here, including itself
+} mm_ostree_node_t;
+
+/*!
+	\brief Intrusive order-statistic tree.
+
+	Supports selecting the Nth smallest node and ranking a key in O( log n ).
+*/
+typedef struct mm_ostree {
+	struct mm_rbtree tree; //!< \brief underlying red-black tree
+} mm_ostree_t;
+
+typedef int ( *mm_ostree_cmp_t )( const struct mm_ostree_node *lhs, const struct mm_ostree_node *rhs );
+typedef int ( *mm_ostree_key_cmp_t )( const void *key, const struct mm_ostree_node *node );
+
+#define MM_OSTREE_INIT\
+	{ .tree = MM_RBTREE_INIT }
+
+#define MM_OSTREE_DECLARE( name )\
+	struct mm_ostree name = MM_OSTREE_INIT
+
+#define MM_OSTREE_NODE( ptr )\
+	( ( ptr ) ? MM_CONTAINER_OF( ptr, struct mm_ostree_node, node ) : NULL )
+
+static inline void mm_ostree_init( struct mm_ostree *this ) {
+	mm_rbtree_init( &this->tree );
+}
+
+/*!
+	\param this pointer to mm_ostree.
+	\return number of nodes in the tree.
+*/
+static inline size_t mm_ostree_size( const struct mm_ostree *this ) {
+	return this->tree.root ? MM_OSTREE_NODE( this->tree.root )->size : 0;
+}
+
+static inline size_t mm_ostree_node_size( const struct mm_rbtree_node *node ) {
+	return node ? MM_CONTAINER_OF( node, struct mm_ostree_node, node )->size : 0;
+}
+
+/*!
+	\brief Rebalance after mm_rbtree_link() and update subtree sizes.
+	\param this pointer to mm_ostree.
+	\param node newly linked node.
+*/
+MM_API void mm_ostree_insert_colour( struct mm_ostree *this, struct mm_ostree_node *node );
+
+/*!
+	\brief Remove a node from the tree.
+	\param this pointer to mm_ostree.
+	\param node node to remove, must be inside of the tree.
+*/
+MM_API void mm_ostree_erase( struct mm_ostree *this, struct mm_ostree_node *node );
+
+/*!
+	\brief Insert a node if no equal node exists.
+	\param this pointer to mm_ostree.
+	\param node node to insert.
+	\param cmp node comparator, pass a static function so it can be inlined.
+	\return NULL on success, otherwise the already inserted node that compares equal.
+*/
+static inline struct mm_ostree_node* mm_ostree_insert( struct mm_ostree *this, struct mm_ostree_node *node, mm_ostree_cmp_t cmp ) {
+	struct mm_rbtree_node **link = &this->tree.root;
+	struct mm_rbtree_node *parent = NULL;
+
+	while ( *link ) {
+		int res = cmp( node, MM_OSTREE_NODE( *link ) );
+		parent = *link;
+
+		if ( res < 0 ) {
+			link = &parent->lhs;
+		} else if ( res > 0 ) {
+			link = &parent->rhs;
+		} else {
+			return MM_OSTREE_NODE( parent );
+		}
+	}
+
+	mm_rbtree_link( &node->node, parent, link );
+	mm_ostree_insert_colour( this, node );
+
+	return NULL;
+}
+
+/*!
+	\brief Find a node equal to key.
+	\param this pointer to mm_ostree.
+	\param key key to search for.
+	\param cmp key comparator, pass a static function so it can be inlined.
+	\return matching node or NULL.
+*/
+static inline struct mm_ostree_node* mm_ostree_find( const struct mm_ostree *this, const void *key, mm_ostree_key_cmp_t cmp ) {
+	struct mm_rbtree_node *node = this->tree.root;
+
+	while ( node ) {
+		int res = cmp( key, MM_OSTREE_NODE( node ) );
+
+		if ( res < 0 ) {
+			node = node->lhs;
+		} else if ( res > 0 ) {
+			node = node->rhs;
+		} else {
+			return MM_OSTREE_NODE( node );
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+	\brief Find the node at a given position in sorted order.
+	\param this pointer to mm_ostree.
+	\param idx zero based position.
+	\return node or NULL if idx is out of range.
+*/
+MM_API struct mm_ostree_node* mm_ostree_select( const struct mm_ostree *this, size_t idx );
+
+/*!
+	\brief Get the position of a node in sorted order.
+	\param node node inside of a mm_ostree.
+	\return zero based position, the number of nodes that are smaller.
+*/
+MM_API size_t mm_ostree_rank( const struct mm_ostree_node *node );
+
+/*!
+	\brief Count the nodes less than key, key doesn't need to be inside of the tree.
+	\param this pointer to mm_ostree.
+	\param key key to rank.
+	\param cmp key comparator, pass a static function so it can be inlined.
+	\return number of nodes that compare less than key.
+*/
+static inline size_t mm_ostree_rank_key( const struct mm_ostree *this, const void *key, mm_ostree_key_cmp_t cmp ) {
+	struct mm_rbtree_node *node = this->tree.root;
+	size_t rank = 0;
+
+	while ( node ) {
+		if ( cmp( key, MM_OSTREE_NODE( node ) ) <= 0 ) {
+			node = node->lhs;
+		} else {
+			rank += mm_ostree_node_size( node->lhs ) + 1;
+			node = node->rhs;
+		}
+	}
+
+	return rank;
+}
+
+static inline struct mm_ostree_node* mm_ostree_first( const struct mm_ostree *this ) {
+	return MM_OSTREE_NODE( mm_rbtree_first( &this->tree ) );
+}
+
+static inline struct mm_ostree_node* mm_ostree_last( const struct mm_ostree *this ) {
+	return MM_OSTREE_NODE( mm_rbtree_last( &this->tree ) );
+}
+
+static inline struct mm_ostree_node* mm_ostree_next( const struct mm_ostree_node *node ) {
+	return MM_OSTREE_NODE( mm_rbtree_next( &node->node ) );
+}
+
+static inline struct mm_ostree_node* mm_ostree_prev( const struct mm_ostree_node *node ) {
+	return MM_OSTREE_NODE( mm_rbtree_prev( &node->node ) );
+}
+
+#define MM_OSTREE_FOREACH( tree, pos )\
+	for ( ( pos ) = mm_ostree_first( tree );\
+	      ( pos );\
+	      ( pos ) = mm_ostree_next( pos ) )
+
+#endif
@@ -1,16 +1,82 @@
 #ifndef MM_RANDOM_H
 #define MM_RANDOM_H
+#include <stddef.h>
+#include <stdint.h>
 #include "mm/common.h"
 
-struct mm_random {
-	unsigned long counter;
-	unsigned long a;
-	unsigned long b;
-	unsigned long c;
-	unsigned long d;
+#define MM_RANDOM_LANES 4 //!< \brief independent generators behind mm_random_fill()
+
+/*!
+	\brief xoshiro256** generator, not suitable for cryptography.
+
+	lanes are separate generators that mm_random_fill() steps together, with AVX2 in one vector each
+	word. they are seeded along with the main state, the output of a seed is the same with or without
+	AVX2.
+*/
+typedef struct mm_random {
+	uint_least64_t s[ 4 ];
+	uint_least64_t lanes[ 4 ][ MM_RANDOM_LANES ]; //!< \brief word, then lane
 } mm_random_t;
 
+/*!
+	\return uniformly distributed value in [min, max), min if the range is empty.
+*/
 MM_API unsigned long mm_random_next( struct mm_random *this, unsigned long min, unsigned long max );
 MM_API void mm_random_reset( struct mm_random *this, unsigned long seed );
 
+/*!
+	\brief Fill buf with random bytes, the lanes are advanced by one step per 32 bytes started.
+*/
+MM_API void mm_random_fill( struct mm_random *this, void *buf, size_t size );
+
+/*!
+	\brief Advance the generator and every lane by 2^128 steps.
+*/
+MM_API void mm_random_jump( struct mm_random *this );
+
+/*!
+	\brief Derive streams that don't overlap for 2^128 draws, one per thread or job.
+
+	stream i starts where this was after i jumps, this is left count jumps ahead so it doesn't run
+	into any of them either.
+	\param streams count generators to initialize.
+*/
+MM_API void mm_random_split( struct mm_random *this, struct mm_random *streams, size_t count );
+
+/*!
+	\brief Generator of the calling thread, split off a process wide one seeded by mm_hash_seed(), or seeded
+	from it directly if the lock around the process wide one couldn't be created.
+	\return valid for as long as the thread runs.
+*/
+MM_API struct mm_random* mm_random_local( void );
+
+static inline uint_least64_t mm_random_rotl( uint_least64_t x, int k ) {
+	return ( x << k ) | ( x >> ( 64 - k ) );
+}
+
+/*!
+	\return 64 random bits.
+*/
+static inline uint_least64_t mm_random_u64( struct mm_random *this ) {
+	uint_least64_t *s = this->s;
+	uint_least64_t result = mm_random_rotl( s[ 1 ] * 5, 7 ) * 9;
+	uint_least64_t t = s[ 1 ] << 17;
+
+	s[ 2 ] ^= s[ 0 ];
+	s[ 3 ] ^= s[ 1 ];
+	s[ 1 ] ^= s[ 2 ];
+	s[ 0 ] ^= s[ 3 ];
+	s[ 2 ] ^= t;
+	s[ 3 ] = mm_random_rotl( s[ 3 ], 45 );
+
+	return result;
+}
+
+/*!
+	\return uniformly distributed value in [0, 1) with 53 bits of precision.
+*/
+static inline double mm_random_double( struct mm_random *this ) {
+	return ( double ) ( mm_random_u64( this ) >> 11 ) * 0x1.0p-53;
+}
+
 #endif
@@ -1,30 +1,445 @@
 #ifndef MM_RBTREE_H
 #define MM_RBTREE_H
-#include "mm/list.h"
+#include "mm/common.h"
 
+/*! \file */
+
+/*!
+	\brief Node colours, stored in the lowest bit of mm_rbtree_node::parent.
+*/
 typedef enum mm_rbtree_colour {
 	MM_RB_RED,
 	MM_RB_BLACK
 } mm_rbtree_colour_t;
 
+/*!
+	\brief Intrusive red-black tree node.
+
+	Embed this inside of a struct and use MM_CONTAINER_OF() to get back to it.
+	The colour is packed into the parent pointer, nodes are always at least pointer aligned
+	so the lowest bit is never used by the address.
+*/
 typedef struct mm_rbtree_node {
-	struct mm_list_node list_node; // used for traversal, non reentrant but requires no additional memory
-	struct mm_rbtree_node *parent;
-	struct mm_rbtree_node *lhs;
-	struct mm_rbtree_node *rhs;
-	enum mm_rbtree_colour colour;
-	void *key;
+	uintptr_t parent; //!< \brief parent node address ORed with its mm_rbtree_colour
+	struct mm_rbtree_node *lhs; //!< \brief left child, all keys are lesser
+	struct mm_rbtree_node *rhs; //!< \brief right child, all keys are greater
 } mm_rbtree_node_t;
 
+/*!
+	\brief Intrusive red-black tree.
+
+	The tree itself doesn't know how to order nodes, instead the search functions take a comparator.
+	The search functions are static inline, so passing a static function as the comparator allows
+	the compiler to inline the comparison into the search loop.
+*/
 typedef struct mm_rbtree {
-	struct mm_rbtree_node *root;
-	int ( *cmp )( void*, void* );
+	struct mm_rbtree_node *root; //!< \brief root node or NULL if empty
 } mm_rbtree_t;
 
-#define RBTREE_INIT( name, cmp_f )\
-	{ .root = NULL, .cmp = cmp_f }
+/*!
+	\brief Compare two nodes, must return < 0, 0 or > 0 like strcmp().
+*/
+typedef int ( *mm_rbtree_cmp_t )( const struct mm_rbtree_node *lhs, const struct mm_rbtree_node *rhs );
+
+/*!
+	\brief Compare a key to a node, must return < 0, 0 or > 0 like strcmp().
+*/
+typedef int ( *mm_rbtree_key_cmp_t )( const void *key, const struct mm_rbtree_node *node );
+
+/*!
+	\brief Initialize an empty mm_rbtree.
+*/
+#define MM_RBTREE_INIT\
+	{ .root = NULL }
+
+/*!
+	\brief Declare an empty mm_rbtree variable.
+	\param name name of the variable.
+*/
+#define MM_RBTREE_DECLARE( name )\
+	struct mm_rbtree name = MM_RBTREE_INIT
+
+/*!
+	\brief Get a pointer to the struct containing a mm_rbtree_node.
+	\param ptr pointer to a mm_rbtree_node, can be NULL.
+	\param type type of the containing struct.
+	\param member name of the mm_rbtree_node within type.
+*/
+#define MM_RBTREE_CONTAINER( ptr, type, member )\
+	( ( ptr ) ? MM_CONTAINER_OF( ptr, type, member ) : NULL )
+
+static inline void mm_rbtree_init( struct mm_rbtree *this ) {
+	this->root = NULL;
+}
+
+static inline bool mm_rbtree_empty( const struct mm_rbtree *this ) {
+	return !this->root;
+}
+
+static inline struct mm_rbtree_node* mm_rbtree_parent( const struct mm_rbtree_node *node ) {
+	return ( struct mm_rbtree_node* ) ( node->parent & ~( uintptr_t ) 1 );
+}
+
+static inline enum mm_rbtree_colour mm_rbtree_colour( const struct mm_rbtree_node *node ) {
+	return ( enum mm_rbtree_colour ) ( node->parent & 1 );
+}
+
+/*!
+	\brief Link a new node into the tree as a red leaf.
+
+	Should be followed by mm_rbtree_insert_colour() to rebalance.
+	Only needed when writing a custom insertion loop, otherwise use mm_rbtree_insert().
+
+	\param node node to insert.
+	\param parent parent of the new node or NULL if the tree is empty.
+	\param link address of the parent's child pointer ( or mm_rbtree::root ) to store node in.
+*/
+static inline void mm_rbtree_link( struct mm_rbtree_node *node, struct mm_rbtree_node *parent, struct mm_rbtree_node **link ) {
+	node->parent = ( uintptr_t ) parent;
+	node->lhs = NULL;
+	node->rhs = NULL;
+	*link = node;
+}
+
+/*!
+	\brief Rebalance the tree after a node has been linked with mm_rbtree_link().
+	\param this pointer to mm_rbtree.
+	\param node newly linked node.
+*/
+MM_API void mm_rbtree_insert_colour( struct mm_rbtree *this, struct mm_rbtree_node *node );
+
+/*!
+	\brief Remove a node from the tree and rebalance.
+	\param this pointer to mm_rbtree.
+	\param node node to remove, must be inside of the tree.
+*/
+MM_API void mm_rbtree_erase( struct mm_rbtree *this, struct mm_rbtree_node *node );
+
+/*!
+	\brief Put new_node into the exact position of old_node without rebalancing.
+
+	Both nodes must compare equal, otherwise the tree ordering is broken.
+
+	\param this pointer to mm_rbtree.
+	\param old_node node currently inside of the tree.
+	\param new_node node to take its place.
+*/
+MM_API void mm_rbtree_replace( struct mm_rbtree *this, struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node );
+
+/*!
+	\brief Callbacks that keep per-node subtree data ( sizes, maximums, ... ) valid while the tree changes shape.
+
+	Usually generated with MM_RBTREE_AUGMENT_CALLBACKS().
+*/
+typedef struct mm_rbtree_augment {
+	void ( *propagate )( struct mm_rbtree_node *node, struct mm_rbtree_node *stop ); //!< \brief recompute node and its ancestors up to, but not including, stop
+	void ( *copy )( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ); //!< \brief new_node takes over the position of old_node
+	void ( *rotate )( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ); //!< \brief new_node was rotated above old_node
+} mm_rbtree_augment_t;
+
+/*!
+	\brief Rebalance after mm_rbtree_link() while keeping augmented data valid.
+
+	Unlike mm_rbtree_insert_colour(), the augmented data of node and all of its ancestors are computed here.
+
+	\param this pointer to mm_rbtree.
+	\param node newly linked node.
+	\param augment callbacks.
+*/
+MM_API void mm_rbtree_insert_augmented( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment );
+
+/*!
+	\brief Remove a node and rebalance while keeping augmented data valid.
+	\param this pointer to mm_rbtree.
+	\param node node to remove, must be inside of the tree.
+	\param augment callbacks.
+*/
+MM_API void mm_rbtree_erase_augmented( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment );
+
+/*!
+	\brief Define a const mm_rbtree_augment and its callbacks, in the style of Linux's RB_DECLARE_CALLBACKS.
+
+	compute is called as compute( type *pos ) and must recalculate pos->field from pos and its children,
+	returning true if the stored value changed. Propagation stops at the first unchanged node.
+
+	\param storage storage class of the generated mm_rbtree_augment, e.g. static or empty.
+	\param name name of the generated mm_rbtree_augment.
+	\param type type containing the mm_rbtree_node.
+	\param member name of the mm_rbtree_node within type.
+	\param field name of the augmented field within type.
+	\param compute function or macro that updates field.
+*/
+#define MM_RBTREE_AUGMENT_CALLBACKS( storage, name, type, member, field, compute )\
+	static void name##_propagate( struct mm_rbtree_node *node, struct mm_rbtree_node *stop ) {\
+		while ( node != stop && compute( MM_CONTAINER_OF( node, type, member ) ) ) {\
+			node = mm_rbtree_parent( node );\
+		}\
+	}\
+	\
+	static void name##_copy( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ) {\
+		MM_CONTAINER_OF( new_node, type, member )->field = MM_CONTAINER_OF( old_node, type, member )->field;\
+	}\
+	\
+	static void name##_rotate( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ) {\
+		MM_CONTAINER_OF( new_node, type, member )->field = MM_CONTAINER_OF( old_node, type, member )->field;\
+		compute( MM_CONTAINER_OF( old_node, type, member ) );\
+	}\
+	\
+	storage const struct mm_rbtree_augment name = {\
+		.propagate = name##_propagate,\
+		.copy = name##_copy,\
+		.rotate = name##_rotate\
+	}
+
+/*!
+	\param this pointer to mm_rbtree.
+	\return left most ( smallest ) node or NULL if empty.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_first( const struct mm_rbtree *this ) {
+	struct mm_rbtree_node *node = this->root;
+
+	if ( node ) {
+		while ( node->lhs ) {
+			node = node->lhs;
+		}
+	}
+
+	return node;
+}
+
+/*!
+	\param this pointer to mm_rbtree.
+	\return right most ( largest ) node or NULL if empty.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_last( const struct mm_rbtree *this ) {
+	struct mm_rbtree_node *node = this->root;
+
+	if ( node ) {
+		while ( node->rhs ) {
+			node = node->rhs;
+		}
+	}
+
+	return node;
+}
+
+/*!
+	\brief In-order successor, walks parent pointers so no stack is required.
+	\param node pointer to a node inside of a tree.
+	\return next node or NULL if node is the last.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_next( const struct mm_rbtree_node *node ) {
+	struct mm_rbtree_node *parent;
+
+	if ( node->rhs ) {
+		node = node->rhs;
+
+		while ( node->lhs ) {
+			node = node->lhs;
+		}
+
+		return ( struct mm_rbtree_node* ) node;
+	}
+
+	while ( ( parent = mm_rbtree_parent( node ) ) && node == parent->rhs ) {
+		node = parent;
+	}
+
+	return parent;
+}
+
+/*!
+	\brief In-order predecessor, walks parent pointers so no stack is required.
+	\param node pointer to a node inside of a tree.
+	\return previous node or NULL if node is the first.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_prev( const struct mm_rbtree_node *node ) {
+	struct mm_rbtree_node *parent;
+
+	if ( node->lhs ) {
+		node = node->lhs;
+
+		while ( node->rhs ) {
+			node = node->rhs;
+		}
+
+		return ( struct mm_rbtree_node* ) node;
+	}
+
+	while ( ( parent = mm_rbtree_parent( node ) ) && node == parent->lhs ) {
+		node = parent;
+	}
+
+	return parent;
+}
+
+static inline struct mm_rbtree_node* mm_rbtree_deepest_left( const struct mm_rbtree_node *node ) {
+	for ( ;; ) {
+		if ( node->lhs ) {
+			node = node->lhs;
+		} else if ( node->rhs ) {
+			node = node->rhs;
+		} else {
+			return ( struct mm_rbtree_node* ) node;
+		}
+	}
+}
+
+/*!
+	\brief First node of a post-order traversal.
+
+	Post-order visits children before their parent, so it can be used to free every node
+	without rebalancing. The tree is invalid afterwards and must be reinitialized.
+
+	\param this pointer to mm_rbtree.
+	\return first node or NULL if empty.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_first_postorder( const struct mm_rbtree *this ) {
+	return this->root ? mm_rbtree_deepest_left( this->root ) : NULL;
+}
+
+/*!
+	\brief Next node of a post-order traversal.
+	\param node current node, can be freed after this call.
+	\return next node or NULL when done.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_next_postorder( const struct mm_rbtree_node *node ) {
+	struct mm_rbtree_node *parent = mm_rbtree_parent( node );
+
+	if ( parent && node == parent->lhs && parent->rhs ) {
+		return mm_rbtree_deepest_left( parent->rhs );
+	}
+
+	return parent;
+}
+
+/*!
+	\brief Insert a node if no equal node exists.
+	\param this pointer to mm_rbtree.
+	\param node node to insert.
+	\param cmp node comparator, pass a static function so it can be inlined.
+	\return NULL on success, otherwise the already inserted node that compares equal.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_insert( struct mm_rbtree *this, struct mm_rbtree_node *node, mm_rbtree_cmp_t cmp ) {
+	struct mm_rbtree_node **link = &this->root;
+	struct mm_rbtree_node *parent = NULL;
+
+	while ( *link ) {
+		int res = cmp( node, *link );
+		parent = *link;
+
+		if ( res < 0 ) {
+			link = &parent->lhs;
+		} else if ( res > 0 ) {
+			link = &parent->rhs;
+		} else {
+			return parent;
+		}
+	}
+
+	mm_rbtree_link( node, parent, link );
+	mm_rbtree_insert_colour( this, node );
+
+	return NULL;
+}
+
+/*!
+	\brief Find a node equal to key.
+	\param this pointer to mm_rbtree.
+	\param key key to search for.
+	\param cmp key comparator, pass a static function so it can be inlined.
+	\return matching node or NULL.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_find( const struct mm_rbtree *this, const void *key, mm_rbtree_key_cmp_t cmp ) {
+	struct mm_rbtree_node *node = this->root;
+
+	while ( node ) {
+		int res = cmp( key, node );
+
+		if ( res < 0 ) {
+			node = node->lhs;
+		} else if ( res > 0 ) {
+			node = node->rhs;
+		} else {
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+	\brief Find the first node that is not less than key.
+	\param this pointer to mm_rbtree.
+	\param key key to search for.
+	\param cmp key comparator, pass a static function so it can be inlined.
+	\return matching node or NULL.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_lower_bound( const struct mm_rbtree *this, const void *key, mm_rbtree_key_cmp_t cmp ) {
+	struct mm_rbtree_node *node = this->root;
+	struct mm_rbtree_node *match = NULL;
+
+	while ( node ) {
+		if ( cmp( key, node ) <= 0 ) {
+			match = node;
+			node = node->lhs;
+		} else {
+			node = node->rhs;
+		}
+	}
+
+	return match;
+}
+
+/*!
+	\brief Find the first node that is greater than key.
+	\param this pointer to mm_rbtree.
+	\param key key to search for.
+	\param cmp key comparator, pass a static function so it can be inlined.
+	\return matching node or NULL.
+*/
+static inline struct mm_rbtree_node* mm_rbtree_upper_bound( const struct mm_rbtree *this, const void *key, mm_rbtree_key_cmp_t cmp ) {
+	struct mm_rbtree_node *node = this->root;
+	struct mm_rbtree_node *match = NULL;
+
+	while ( node ) {
+		if ( cmp( key, node ) < 0 ) {
+			match = node;
+			node = node->lhs;
+		} else {
+			node = node->rhs;
+		}
+	}
+
+	return match;
+}
+
+#define MM_RBTREE_FOREACH( tree, pos )\
+	for ( ( pos ) = mm_rbtree_first( tree );\
+	      ( pos );\
+	      ( pos ) = mm_rbtree_next( pos ) )
+
+#define MM_RBTREE_FOREACH_REVERSE( tree, pos )\
+	for ( ( pos ) = mm_rbtree_last( tree );\
+	      ( pos );\
+	      ( pos ) = mm_rbtree_prev( pos ) )
+
+/*!
+	\brief Iterate every node in post-order, pos may be freed inside of the loop body.
+*/
+#define MM_RBTREE_FOREACH_POSTORDER_SAFE( tree, pos, tmp )\
+	for ( ( pos ) = mm_rbtree_first_postorder( tree ), ( tmp ) = ( pos ) ? mm_rbtree_next_postorder( pos ) : NULL;\
+	      ( pos );\
+	      ( pos ) = ( tmp ), ( tmp ) = ( pos ) ? mm_rbtree_next_postorder( pos ) : NULL )
+
+#define MM_RBTREE_FOREACH_CONTAINER( tree, pos, type, member )\
+	for ( ( pos ) = MM_RBTREE_CONTAINER( mm_rbtree_first( tree ), type, member );\
+	      ( pos );\
+	      ( pos ) = MM_RBTREE_CONTAINER( mm_rbtree_next( &( pos )->member ), type, member ) )
 
-#define RBTREE_HEAD( name, cmp_f )\
-	struct rbtree name = RBTREE_INIT( name, cmp_f )
+#define MM_RBTREE_FOREACH_CONTAINER_REVERSE( tree, pos, type, member )\
+	for ( ( pos ) = MM_RBTREE_CONTAINER( mm_rbtree_last( tree ), type, member );\
+	      ( pos );\
+	      ( pos ) = MM_RBTREE_CONTAINER( mm_rbtree_prev( &( pos )->member ), type, member ) )
 
 #endif
@@ -0,0 +1,252 @@
+#ifndef MM_REACTOR_H
+#define MM_REACTOR_H
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "mm/common.h"
+#include "mm/sched.h"
+#include "mm/timer.h"
+
+/*! \file */
+
+/*
+	epoll based readiness for mm_sched tasks ( linux only )
+
+	example usage
+
+	struct conn {
+		struct mm_sched_task task;
+		struct mm_co co;
+		struct mm_reactor_fd io;
+		char buf[ 4096 ];
+		ssize_t len;
+	};
+
+	MM_COROUTINE( conn_run, struct mm_sched_task *task ) {
+		struct conn *this = MM_SCHED_CONTAINER( task, struct conn, task );
+
+		MM_CO_BEGIN( &this->co );
+
+		for ( ;; ) {
+			MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+			this->len = mm_reactor_read( &this->io, this->buf, sizeof( this->buf ) );
+
+			if ( this->len == 0 || ( this->len < 0 && errno != EAGAIN ) ) {
+				break;
+			}
+			...
+		}
+
+		mm_reactor_del( reactor, &this->io );
+		close( this->io.fd );
+		MM_CO_END( &this->co );
+	}
+
+	mm_reactor_add( &reactor, &conn->io, fd );
+	mm_sched_spawn( &reactor.sched, &conn->task, conn_run );
+	mm_reactor_run( &reactor );
+*/
+
+#define MM_REACTOR_BATCH 256 //!< \brief epoll events handled per epoll_wait
+
+#define MM_REACTOR_READABLE 0x1
+#define MM_REACTOR_WRITABLE 0x2
+
+/*!
+	\brief Registration of one non blocking fd, embedded in the connection state.
+
+	Fds are registered edge triggered, so readiness is latched in ready until an operation
+	reports EAGAIN. mm_reactor_read() and mm_reactor_write() clear it, code doing its own
+	syscalls calls mm_reactor_again() instead. Hangups and errors set both bits, so waiters
+	run and see the error from their next syscall.
+*/
+typedef struct mm_reactor_fd {
+	int fd;
+	unsigned int ready; //!< \brief MM_REACTOR_READABLE and MM_REACTOR_WRITABLE bits
+	struct mm_sched_event readable;
+	struct mm_sched_event writable;
+} mm_reactor_fd_t;
+
+/*!
+	\brief Single threaded event loop, resumes tasks of its mm_sched when their fds become ready.
+
+	Timers bound the epoll_wait timeout and fire after it returns, their waiters run in the same pass as the fds.
+	Registering a fd is one epoll_ctl for its whole lifetime and the reactor allocates nothing per fd,
+	so idle connections only cost their own state. Other threads wake the loop with mm_reactor_notify(),
+	which writes an eventfd at most once until the loop picked it up.
+*/
+typedef struct mm_reactor {
+	struct mm_sched sched; //!< \brief tasks run by mm_reactor_run()
+	struct mm_sched_event notified; //!< \brief broadcast on the loop thread after mm_reactor_notify()
+	struct mm_timer_wheel timers; //!< \brief ticks are mm_reactor_now() milliseconds, fired by mm_reactor_poll()
+	int epfd;
+	int wakefd;
+	atomic_bool pending; //!< \brief eventfd was written and not drained yet
+	atomic_bool stop;
+	struct epoll_event events[ MM_REACTOR_BATCH ];
+} mm_reactor_t;
+
+/*!
+	\brief Timeout of a task waiting through a mm_reactor.
+*/
+typedef struct mm_reactor_timer {
+	struct mm_timer timer;
+	struct mm_reactor *reactor;
+	struct mm_sched_task *task; //!< \brief made ready when the timer fires
+	bool expired; //!< \brief the last wait ended because of the timeout
+} mm_reactor_timer_t;
+
+/*!
+	\param this pointer to mm_reactor.
+	\param retire passed to mm_sched_init().
+	\param ctx passed to mm_sched_init().
+	\return false if the epoll instance or the eventfd couldn't be created, errno is set.
+*/
+MM_API bool mm_reactor_init( struct mm_reactor *this, mm_sched_retire_t retire, void *ctx );
+
+/*!
+	\brief Close the epoll instance and the eventfd, registered fds stay open.
+*/
+MM_API void mm_reactor_destroy( struct mm_reactor *this );
+
+/*!
+	\brief Watch a fd for both directions.
+	\param this pointer to mm_reactor.
+	\param io registration that isn't in use.
+	\param fd non blocking fd.
+	\return false if epoll_ctl failed, errno is set.
+*/
+MM_API bool mm_reactor_add( struct mm_reactor *this, struct mm_reactor_fd *io, int fd );
+
+/*!
+	\brief Stop watching a fd before it's closed, tasks still waiting on it are made ready.
+	\param this pointer to mm_reactor.
+	\param io registered fd.
+	\return false if epoll_ctl failed, errno is set.
+*/
+MM_API bool mm_reactor_del( struct mm_reactor *this, struct mm_reactor_fd *io );
+
+/*!
+	\brief Wait for one batch of epoll events, fire expired timers and make their waiters ready.
+	\param this pointer to mm_reactor.
+	\param timeout milliseconds to block, -1 for no limit, 0 to only poll. The next timer shortens it.
+	\return number of events and timers handled, -1 on error with errno set.
+*/
+MM_API int mm_reactor_poll( struct mm_reactor *this, int timeout );
+
+/*!
+	\brief Alternate between running ready tasks and polling until every task finished or mm_reactor_stop() was called.
+	\param this pointer to mm_reactor.
+	\return false on a poll error, errno is set.
+*/
+MM_API bool mm_reactor_run( struct mm_reactor *this );
+
+/*!
+	\brief Wake the loop from any thread, tasks waiting on notified run on the loop thread afterwards.
+*/
+MM_API void mm_reactor_notify( struct mm_reactor *this );
+
+/*!
+	\brief Make mm_reactor_run() return, safe from any thread.
+*/
+MM_API void mm_reactor_stop( struct mm_reactor *this );
+
+/*!
+	\return CLOCK_MONOTONIC in milliseconds, the clock of the timers.
+*/
+MM_API uint_least64_t mm_reactor_now( void );
+
+/*!
+	\param this pointer to mm_reactor_timer.
+	\param reactor reactor the timer fires on.
+	\param task task woken when the timer fires.
+*/
+MM_API void mm_reactor_timer_init( struct mm_reactor_timer *this, struct mm_reactor *reactor, struct mm_sched_task *task );
+
+/*!
+	\brief Fire the timer ms milliseconds from now, replacing a pending expiry.
+*/
+static inline void mm_reactor_timer_arm( struct mm_reactor_timer *this, uint_least64_t ms ) {
+	this->expired = false;
+	mm_timer_add( &this->reactor->timers, &this->timer, mm_reactor_now() + ms );
+}
+
+static inline void mm_reactor_timer_cancel( struct mm_reactor_timer *this ) {
+	mm_timer_cancel( &this->reactor->timers, &this->timer );
+}
+
+/*!
+	\brief Forget readiness after an operation reported EAGAIN.
+	\param io registered fd.
+	\param mask MM_REACTOR_READABLE and / or MM_REACTOR_WRITABLE.
+*/
+static inline void mm_reactor_again( struct mm_reactor_fd *io, unsigned int mask ) {
+	io->ready &= ~mask;
+}
+
+/*!
+	\brief read( 2 ) that keeps the readiness of io up to date.
+*/
+static inline ssize_t mm_reactor_read( struct mm_reactor_fd *io, void *buf, size_t len ) {
+	ssize_t ret = read( io->fd, buf, len );
+
+	if ( ret < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+		mm_reactor_again( io, MM_REACTOR_READABLE );
+	}
+
+	return ret;
+}
+
+/*!
+	\brief write( 2 ) that keeps the readiness of io up to date.
+*/
+static inline ssize_t mm_reactor_write( struct mm_reactor_fd *io, const void *buf, size_t len ) {
+	ssize_t ret = write( io->fd, buf, len );
+
+	if ( ret < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+		mm_reactor_again( io, MM_REACTOR_WRITABLE );
+	}
+
+	return ret;
+}
+
+/*!
+	\brief Suspend the task until io is readable, returns immediately if it still is.
+*/
+#define MM_CO_AWAIT_READABLE( co, task, io )\
+	MM_SCHED_AWAIT_UNTIL( co, task, &( io )->readable, ( io )->ready & MM_REACTOR_READABLE )
+
+/*!
+	\brief Suspend the task until io is writable, returns immediately if it still is.
+*/
+#define MM_CO_AWAIT_WRITABLE( co, task, io )\
+	MM_SCHED_AWAIT_UNTIL( co, task, &( io )->writable, ( io )->ready & MM_REACTOR_WRITABLE )
+
+/*!
+	\brief Suspend the task of timer for ms milliseconds.
+*/
+#define MM_CO_SLEEP( co, timer, ms )\
+	do {\
+		mm_reactor_timer_arm( timer, ms );\
+		MM_SCHED_AWAIT_UNTIL( co, ( timer )->task, NULL, ( timer )->expired );\
+	} while( 0 )
+
+/*!
+	\brief Wait on event until cond holds or ms milliseconds passed, ( timer )->expired tells which one happened.
+*/
+#define MM_CO_AWAIT_TIMEOUT( co, timer, ms, event, cond )\
+	do {\
+		mm_reactor_timer_arm( timer, ms );\
+		MM_SCHED_AWAIT_UNTIL( co, ( timer )->task, event, ( cond ) || ( timer )->expired );\
+		mm_reactor_timer_cancel( timer );\
+	} while( 0 )
+
+#define MM_CO_AWAIT_READABLE_TIMEOUT( co, timer, io, ms )\
+	MM_CO_AWAIT_TIMEOUT( co, timer, ms, &( io )->readable, ( io )->ready & MM_REACTOR_READABLE )
+
+#define MM_CO_AWAIT_WRITABLE_TIMEOUT( co, timer, io, ms )\
+	MM_CO_AWAIT_TIMEOUT( co, timer, ms, &( io )->writable, ( io )->ready & MM_REACTOR_WRITABLE )
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef MM_ROARING_H
+#define MM_ROARING_H
+#include <stdint.h>
+#include "mm/common.h"
+
+/*! \file */
+
+#define MM_ROARING_ARRAY_MAX 4096 //!< \brief containers with more values than this are bitmaps
+
+enum mm_roaring_type {
+	MM_ROARING_ARRAY, //!< \brief sorted 16 bit values
+	MM_ROARING_BITMAP, //!< \brief 1024 words, one bit per value
+	MM_ROARING_RUN //!< \brief sorted ( first, last ) pairs of 16 bit values
+};
+
+/*!
+	\brief The low 16 bits of every value sharing the high 16 bits in key.
+*/
+typedef struct mm_roaring_container {
+	void *data;
+	uint_least32_t cardinality;
+	uint_least32_t size; //!< \brief number of values, words or runs in data
+	uint_least32_t capacity; //!< \brief number of values, words or runs allocated, 0 if data is not owned
+	uint_least16_t key;
+	uint_least8_t type;
+} mm_roaring_container_t;
+
+/*!
+	\brief Compressed set of 32 bit values.
+
+	Values are split on their high 16 bits into containers sorted by key. A container is an array
+	while it holds at most MM_ROARING_ARRAY_MAX values and a bitmap past that, mm_roaring_optimize()
+	turns the ones that are cheaper as runs into runs.
+
+	A set made with mm_roaring_view() reads straight from a serialized buffer and cannot be modified.
+*/
+typedef struct mm_roaring {
+	struct mm_roaring_container *containers;
+	size_t size;
+	size_t capacity;
+	bool frozen; //!< \brief containers point into a buffer owned by someone else
+} mm_roaring_t;
+
+/*!
+	\param this pointer to mm_roaring, empty afterwards.
+*/
+MM_API void mm_roaring_init( struct mm_roaring *this );
+
+/*!
+	\brief Initialize this with the values of other, other may be a view.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_roaring_copy( struct mm_roaring *this, const struct mm_roaring *other );
+MM_API void mm_roaring_destroy( struct mm_roaring *this );
+
+/*!
+	\brief Adding in increasing order is the fast path.
+	\return false if memory cannot be allocated.
+*/
+MM_API bool mm_roaring_add( struct mm_roaring *this, uint_least32_t value );
+
+/*!
+	\return false if memory cannot be allocated, a run container may have to expand.
+*/
+MM_API bool mm_roaring_remove( struct mm_roaring *this, uint_least32_t value );
+MM_API bool mm_roaring_contains( const struct mm_roaring *this, uint_least32_t value );
+
+/*!
+	\return number of values.
+*/
+MM_API uint_least64_t mm_roaring_cardinality( const struct mm_roaring *this );
+
+/*!
+	\brief Convert every container to whichever of array, bitmap or runs takes the least memory.
+	\return false if memory cannot be allocated, this is still valid.
+*/
+MM_API bool mm_roaring_optimize( struct mm_roaring *this );
+
+/*!
+	\brief Write the values in increasing order.
+	\param out room for mm_roaring_cardinality() values.
+	\return number of values written.
+*/
+MM_API size_t mm_roaring_to_array( const struct mm_roaring *this, uint_least32_t *out );
+
+/*!
+	\brief Initialize result with lhs op rhs, result must be neither of them.
+	\return false if memory cannot be allocated, result is empty.
+*/
+MM_API bool mm_roaring_and( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+MM_API bool mm_roaring_or( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+MM_API bool mm_roaring_andnot( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+
+/*!
+	\return number of values in lhs op rhs, without building it.
+*/
+MM_API uint_least64_t mm_roaring_and_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+MM_API uint_least64_t mm_roaring_or_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+MM_API uint_least64_t mm_roaring_andnot_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs );
+
+/*!
+	\brief Bytes needed by mm_roaring_serialize().
+*/
+MM_API size_t mm_roaring_serialized_size( const struct mm_roaring *this );
+
+/*!
+	\brief Write this in a little endian layout with every container 8 byte aligned, so it can be mapped.
+	\param buf room for mm_roaring_serialized_size() bytes.
+	\return number of bytes written.
+*/
+MM_API size_t mm_roaring_serialize( const struct mm_roaring *this, void *buf );
+
+/*!
+	\brief Initialize this with a copy of serialized values.
+	\return false if buf is malformed or memory cannot be allocated.
+*/
+MM_API bool mm_roaring_deserialize( struct mm_roaring *this, const void *buf, size_t size );
+
+/*!
+	\brief Initialize this to read serialized values in place, only the container list is allocated.
+	\param buf 8 byte aligned, must outlive this.
+	\return false if buf is malformed or misaligned, on big endian hosts, or if memory cannot be allocated.
+*/
+MM_API bool mm_roaring_view( struct mm_roaring *this, const void *buf, size_t size );
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef MM_SCHED_H
+#define MM_SCHED_H
+#include "mm/common.h"
+#include "mm/co.h"
+#include "mm/list.h"
+
+/*! \file */
+
+/*
+	run queue for mm_co coroutines
+
+	example usage
+
+	struct conn {
+		struct mm_sched_task task;
+		struct mm_co co;
+		struct mm_sched_event *readable;
+	};
+
+	MM_COROUTINE( conn_run, struct mm_sched_task *task ) {
+		struct conn *this = MM_SCHED_CONTAINER( task, struct conn, task );
+
+		MM_CO_BEGIN( &this->co );
+
+		for ( ;; ) {
+			MM_SCHED_AWAIT( &this->co, task, this->readable );
+			...
+			MM_CO_YIELD( &this->co );
+		}
+
+		MM_CO_END( &this->co );
+	}
+
+	mm_sched_spawn( &sched, &conn->task, conn_run );
+	mm_sched_run( &sched );
+*/
+
+struct mm_sched_task;
+
+typedef enum mm_co_state ( *mm_sched_func_t )( struct mm_sched_task *task );
+
+/*!
+	\brief Unit of work embedded in the coroutine state, like struct mm_list.
+*/
+typedef struct mm_sched_task {
+	struct mm_list list; //!< \brief link in the ready queue or in the waiters of an event
+	mm_sched_func_t func; //!< \brief coroutine resumed for every step
+	struct mm_sched_event *event; //!< \brief event to wait on after the current step
+	bool park; //!< \brief leave the ready queue after the current step
+} mm_sched_task_t;
+
+/*!
+	\brief Parked tasks waiting for something to happen.
+*/
+typedef struct mm_sched_event {
+	struct mm_list waiters;
+} mm_sched_event_t;
+
+/*!
+	\brief Called for every task that finished, the scheduler no longer references it.
+*/
+typedef void ( *mm_sched_retire_t )( struct mm_sched_task *task, void *ctx );
+
+/*!
+	\brief Single threaded round robin scheduler for mm_co coroutines.
+
+	Every step resumes the task at the front of the ready queue and acts on the returned state:
+	- MM_CO_SUSPENDED moves the task to the back of the queue.
+	- MM_CO_WAITING parks the task if it used MM_SCHED_AWAIT() or MM_SCHED_PARK(),
+	  otherwise ( MM_CO_WAIT() on a nested coroutine ) it is treated like MM_CO_SUSPENDED.
+	- MM_CO_DONE retires the task.
+
+	Tasks are intrusive, so scheduling never allocates.
+*/
+typedef struct mm_sched {
+	struct mm_list ready;
+	size_t count; //!< \brief number of tasks that haven't finished yet, parked ones included
+	mm_sched_retire_t retire;
+	void *ctx;
+} mm_sched_t;
+
+#define MM_SCHED_EVENT_INIT( name )\
+	{ .waiters = MM_LIST_INIT( ( name ).waiters ) }
+
+#define MM_SCHED_EVENT_DECLARE( name )\
+	struct mm_sched_event name = MM_SCHED_EVENT_INIT( name )
+
+#define MM_SCHED_CONTAINER( task, type, member )\
+	MM_CONTAINER_OF( task, type, member )
+
+/*!
+	\param this pointer to mm_sched.
+	\param retire called for every finished task. Can be NULL.
+	\param ctx passed to retire.
+*/
+static inline void mm_sched_init( struct mm_sched *this, mm_sched_retire_t retire, void *ctx ) {
+	mm_list_init( &this->ready );
+	this->count = 0;
+	this->retire = retire;
+	this->ctx = ctx;
+}
+
+static inline void mm_sched_event_init( struct mm_sched_event *this ) {
+	mm_list_init( &this->waiters );
+}
+
+/*!
+	\brief Add a task to the back of the ready queue.
+	\param this pointer to mm_sched.
+	\param task task that isn't scheduled, its coroutine state must already be initialized.
+	\param func coroutine to resume.
+*/
+static inline void mm_sched_spawn( struct mm_sched *this, struct mm_sched_task *task, mm_sched_func_t func ) {
+	task->func = func;
+	task->event = NULL;
+	task->park = false;
+	mm_list_add_tail( &this->ready, &task->list );
+	++this->count;
+}
+
+/*!
+	\brief Make a parked task ready again, removing it from the event it waits on.
+	\param this pointer to mm_sched.
+	\param task parked task.
+*/
+static inline void mm_sched_wake( struct mm_sched *this, struct mm_sched_task *task ) {
+	mm_list_move_tail( &this->ready, &task->list );
+}
+
+/*!
+	\brief Wake the task that waited longest on an event.
+	\return false if no task was waiting.
+*/
+static inline bool mm_sched_event_signal( struct mm_sched *this, struct mm_sched_event *event ) {
+	if ( mm_list_empty( &event->waiters ) ) {
+		return false;
+	}
+
+	mm_list_move_tail( &this->ready, event->waiters.next );
+	return true;
+}
+
+/*!
+	\brief Wake every task waiting on an event, in the order they started waiting.
+*/
+static inline void mm_sched_event_broadcast( struct mm_sched *this, struct mm_sched_event *event ) {
+	mm_list_splice_tail( &this->ready, &event->waiters );
+}
+
+static inline bool mm_sched_event_has_waiters( struct mm_sched_event *event ) {
+	return !mm_list_empty( &event->waiters );
+}
+
+/*!
+	\brief Resume the task at the front of the ready queue once.
+	\param this pointer to mm_sched.
+	\return false if no task was ready.
+*/
+MM_API bool mm_sched_step( struct mm_sched *this );
+
+/*!
+	\brief Step until no task is ready, that is every task finished or is parked.
+	\param this pointer to mm_sched.
+	\return number of steps taken.
+*/
+MM_API size_t mm_sched_run( struct mm_sched *this );
+
+/*!
+	\brief Suspend the coroutine and leave the ready queue until mm_sched_wake() is called on task.
+*/
+#define MM_SCHED_PARK( co, task )\
+	do {\
+		( task )->park = true;\
+		_MM_CO_RET_( co, MM_CO_WAITING );\
+		_MM_CO_JMP_;\
+	} while( 0 )
+
+/*!
+	\brief Suspend the coroutine until event is signaled.
+*/
+#define MM_SCHED_AWAIT( co, task, _event )\
+	do {\
+		( task )->event = ( _event );\
+		MM_SCHED_PARK( co, task );\
+	} while( 0 )
+
+/*!
+	\brief Wait on event until cond holds, cond is checked before every wait.
+*/
+#define MM_SCHED_AWAIT_UNTIL( co, task, _event, cond )\
+	do {\
+		_MM_CO_JMP_;\
+		\
+		if ( !( cond ) ) {\
+			( task )->event = ( _event );\
+			( task )->park = true;\
+			_MM_CO_RET_( co, MM_CO_WAITING );\
+		}\
+	} while( 0 )
+
+#endif
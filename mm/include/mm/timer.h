@@ -0,0 +1,107 @@
+#ifndef MM_TIMER_H
+#define MM_TIMER_H
+#include <stdint.h>
+#include "mm/common.h"
+#include "mm/list.h"
+
+/*! \file */
+
+#define MM_TIMER_BITS 6 //!< \brief log2 of the slots per level
+#define MM_TIMER_SLOTS ( 1u << MM_TIMER_BITS )
+#define MM_TIMER_LEVELS 6 //!< \brief levels cover 2^36 ticks, later timers are parked in the top level and placed again
+
+struct mm_timer;
+
+typedef void ( *mm_timer_func_t )( struct mm_timer *timer );
+
+/*!
+	\brief Timer embedded in the object that owns it, like struct mm_list.
+*/
+typedef struct mm_timer {
+	struct mm_list list; //!< \brief link in a slot of the wheel, empty when not pending
+	uint_least64_t expires; //!< \brief tick the timer fires at
+	mm_timer_func_t func; //!< \brief called once the wheel advanced to expires
+	unsigned short slot; //!< \brief level * MM_TIMER_SLOTS + slot the timer is linked into
+} mm_timer_t;
+
+/*!
+	\brief Hierarchical hashed timer wheel ( Varghese & Lauck ).
+
+	Level n has MM_TIMER_SLOTS slots of MM_TIMER_SLOTS^n ticks each. A timer goes into the lowest level
+	whose span still separates its expiry from now, so adding and cancelling are O( 1 ) list operations.
+	When now enters the range of a higher level slot, its timers are placed again on lower levels, every timer
+	moves at most MM_TIMER_LEVELS times before it fires. Timers that fire on the same tick are taken off
+	the wheel as one batch.
+
+	Ticks have no unit, mm_reactor uses milliseconds.
+*/
+typedef struct mm_timer_wheel {
+	uint_least64_t now; //!< \brief last tick advanced to
+	size_t count; //!< \brief pending timers
+	uint_least64_t occupied[ MM_TIMER_LEVELS ]; //!< \brief bit per non empty slot
+	struct mm_list due; //!< \brief timers added with an expiry that already passed
+	struct mm_list slots[ MM_TIMER_LEVELS ][ MM_TIMER_SLOTS ];
+} mm_timer_wheel_t;
+
+#define MM_TIMER_CONTAINER( timer, type, member )\
+	MM_CONTAINER_OF( timer, type, member )
+
+/*!
+	\param this pointer to mm_timer.
+	\param func called when the timer fires, the timer is no longer pending at that point.
+*/
+static inline void mm_timer_init( struct mm_timer *this, mm_timer_func_t func ) {
+	mm_list_init( &this->list );
+	this->expires = 0;
+	this->func = func;
+	this->slot = 0;
+}
+
+/*!
+	\return true if the timer was added and hasn't fired or been cancelled since.
+*/
+static inline bool mm_timer_pending( struct mm_timer *this ) {
+	return !mm_list_empty( &this->list );
+}
+
+/*!
+	\param this pointer to mm_timer_wheel.
+	\param now current tick.
+*/
+MM_API void mm_timer_wheel_init( struct mm_timer_wheel *this, uint_least64_t now );
+
+/*!
+	\brief Arm a timer, a pending timer is moved to the new expiry.
+	\param this pointer to mm_timer_wheel.
+	\param timer initialized timer.
+	\param expires absolute tick, ticks that already passed fire on the next advance.
+*/
+MM_API void mm_timer_add( struct mm_timer_wheel *this, struct mm_timer *timer, uint_least64_t expires );
+
+/*!
+	\brief Disarm a timer, does nothing if it isn't pending.
+*/
+MM_API void mm_timer_cancel( struct mm_timer_wheel *this, struct mm_timer *timer );
+
+/*!
+	\brief Move the wheel forward and fire every timer that expired, in order of expiry.
+
+	Callbacks may add and cancel timers, timers added for a tick up to now fire within the same call.
+	\param this pointer to mm_timer_wheel.
+	\param now current tick, going backwards is ignored.
+	\return number of timers fired.
+*/
+MM_API size_t mm_timer_wheel_advance( struct mm_timer_wheel *this, uint_least64_t now );
+
+/*!
+	\brief Earliest tick the wheel has work at, either firing a timer or placing timers on a lower level.
+	\param this pointer to mm_timer_wheel.
+	\return tick, UINT_LEAST64_MAX if no timer is pending.
+*/
+MM_API uint_least64_t mm_timer_wheel_next( struct mm_timer_wheel *this );
+
+static inline size_t mm_timer_wheel_size( const struct mm_timer_wheel *this ) {
+	return this->count;
+}
+
+#endif
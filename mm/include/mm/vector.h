@@ -224,7 +224,7 @@ static inline void* mm_vector_search( struct mm_vector *this, void *buf ) {
 	return bsearch(
 		buf,
 		mm_vector_begin( this ),
-		mm_vector_bsize( this ),
+		mm_vector_size( this ),
 		this->type_size,
 		this->type_cmp
 	);
@@ -240,7 +240,7 @@ static inline void* mm_vector_search( struct mm_vector *this, void *buf ) {
 static inline void mm_vector_sort( struct mm_vector *this ) {
 	qsort(
 		mm_vector_begin( this ),
-		mm_vector_bsize( this ),
+		mm_vector_size( this ),
 		this->type_size,
 		this->type_cmp
 	);
@@ -0,0 +1,90 @@
+#include "mm/bit.h"
+
+#if ( defined( __x86_64__ ) && defined( __GNUC__ ) ) && !defined( MM_BIT_NATIVE_PDEP )
+#include <immintrin.h>
+#define DISPATCH
+#endif
+
+uint_least64_t mm_bit_pdep_soft( uint_least64_t i, uint_least64_t mask ) {
+	uint_least64_t result = 0;
+
+	// without a branch on the bits of i, they are as good as random
+	for ( ; mask; mask &= mask - 1, i >>= 1 ) {
+		result |= mask & -mask & -( i & 1 );
+	}
+
+	return result;
+}
+
+uint_least64_t mm_bit_pext_soft( uint_least64_t i, uint_least64_t mask ) {
+	uint_least64_t result = 0;
+
+	for ( unsigned int bit = 0; mask; mask &= mask - 1, ++bit ) {
+		result |= ( uint_least64_t ) !!( i & mask & -mask ) << bit;
+	}
+
+	return result;
+}
+
+#if defined( MM_BIT_NATIVE_PDEP ) || defined( DISPATCH )
+#ifdef DISPATCH
+__attribute__(( target( "bmi2" ) ))
+#endif
+static uint_least64_t pdep_bmi2( uint_least64_t i, uint_least64_t mask ) {
+	return _pdep_u64( i, mask );
+}
+
+#ifdef DISPATCH
+__attribute__(( target( "bmi2" ) ))
+#endif
+static uint_least64_t pext_bmi2( uint_least64_t i, uint_least64_t mask ) {
+	return _pext_u64( i, mask );
+}
+#endif
+
+bool mm_bit_native_pdep( void ) {
+#if defined( MM_BIT_NATIVE_PDEP )
+	return true;
+#elif defined( DISPATCH )
+	__builtin_cpu_init();
+
+	// Zen 1 and 2 microcode PDEP and PEXT at hundreds of cycles for dense masks
+	return __builtin_cpu_supports( "bmi2" )
+	    && !__builtin_cpu_is( "znver1" )
+	    && !__builtin_cpu_is( "znver2" );
+#else
+	return false;
+#endif
+}
+
+// the first call through a pointer lands here and swaps in the right version, racing threads agree on it
+static uint_least64_t pdep_resolve( uint_least64_t i, uint_least64_t mask ) {
+	mm_bit_scatter_fn fn = mm_bit_pdep_soft;
+
+#if defined( MM_BIT_NATIVE_PDEP ) || defined( DISPATCH )
+	if ( mm_bit_native_pdep() ) {
+		fn = pdep_bmi2;
+	}
+#endif
+
+	atomic_store_explicit( &mm_bit_pdep_fn, fn, memory_order_relaxed );
+
+	return fn( i, mask );
+}
+
+static uint_least64_t pext_resolve( uint_least64_t i, uint_least64_t mask ) {
+	mm_bit_scatter_fn fn = mm_bit_pext_soft;
+
+#if defined( MM_BIT_NATIVE_PDEP ) || defined( DISPATCH )
+	if ( mm_bit_native_pdep() ) {
+		fn = pext_bmi2;
+	}
+#endif
+
+	atomic_store_explicit( &mm_bit_pext_fn, fn, memory_order_relaxed );
+
+	return fn( i, mask );
+}
+
+_Atomic( mm_bit_scatter_fn ) mm_bit_pdep_fn = pdep_resolve;
+_Atomic( mm_bit_scatter_fn ) mm_bit_pext_fn = pext_resolve;
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mm/assert.h"
+#include "mm/bit.h"
+#include "mm/bitset.h"
+
+#if defined( __AVX512F__ ) || defined( __AVX2__ ) || defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+/*
+	the kernels are written once against a vector type of VEC_WORDS words, with the words left over
+	at the end done one at a time. counting adds per vector counts into 64 bit lanes and sums the
+	lanes once at the end.
+*/
+#if defined( __AVX512F__ ) && defined( __AVX512BW__ )
+#define VEC_WORDS 8
+typedef __m512i vec;
+#define LOAD( p ) _mm512_loadu_si512( ( const void* ) ( p ) )
+#define STORE( p, v ) _mm512_storeu_si512( ( void* ) ( p ), v )
+#define VEC_AND( a, b ) _mm512_and_si512( a, b )
+#define VEC_OR( a, b ) _mm512_or_si512( a, b )
+#define VEC_XOR( a, b ) _mm512_xor_si512( a, b )
+#define VEC_ANDNOT( a, b ) _mm512_andnot_si512( b, a )
+#define VEC_ZERO() _mm512_setzero_si512()
+#define VEC_ADD( a, b ) _mm512_add_epi64( a, b )
+#define VEC_SUM( v ) ( ( size_t ) _mm512_reduce_add_epi64( v ) )
+
+#ifdef __AVX512VPOPCNTDQ__
+#define VEC_COUNT( v ) _mm512_popcnt_epi64( v )
+#else
+// nibble lookup, byte counts summed into the 64 bit lanes
+static inline vec VEC_COUNT( vec v ) {
+	const vec lut = _mm512_broadcast_i32x4( _mm_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 ) );
+	const vec low = _mm512_set1_epi8( 0x0f );
+	vec lo = _mm512_shuffle_epi8( lut, _mm512_and_si512( v, low ) );
+	vec hi = _mm512_shuffle_epi8( lut, _mm512_and_si512( _mm512_srli_epi16( v, 4 ), low ) );
+
+	return _mm512_sad_epu8( _mm512_add_epi8( lo, hi ), _mm512_setzero_si512() );
+}
+#endif
+#elif defined( __AVX2__ )
+#define VEC_WORDS 4
+typedef __m256i vec;
+#define LOAD( p ) _mm256_loadu_si256( ( const __m256i* ) ( p ) )
+#define STORE( p, v ) _mm256_storeu_si256( ( __m256i* ) ( p ), v )
+#define VEC_AND( a, b ) _mm256_and_si256( a, b )
+#define VEC_OR( a, b ) _mm256_or_si256( a, b )
+#define VEC_XOR( a, b ) _mm256_xor_si256( a, b )
+#define VEC_ANDNOT( a, b ) _mm256_andnot_si256( b, a )
+#define VEC_ZERO() _mm256_setzero_si256()
+#define VEC_ADD( a, b ) _mm256_add_epi64( a, b )
+
+static inline size_t VEC_SUM( vec v ) {
+	__m128i half = _mm_add_epi64( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) );
+
+	return ( size_t ) ( _mm_cvtsi128_si64( half ) + _mm_extract_epi64( half, 1 ) );
+}
+
+// Mula's nibble lookup, byte counts summed into the 64 bit lanes
+static inline vec VEC_COUNT( vec v ) {
+	const vec lut = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+					  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+	const vec low = _mm256_set1_epi8( 0x0f );
+	vec lo = _mm256_shuffle_epi8( lut, _mm256_and_si256( v, low ) );
+	vec hi = _mm256_shuffle_epi8( lut, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), low ) );
+
+	return _mm256_sad_epu8( _mm256_add_epi8( lo, hi ), _mm256_setzero_si256() );
+}
+#elif defined( __SSE2__ )
+// every x86-64 has this much, the baseline build still gets vectors
+#define VEC_WORDS 2
+typedef __m128i vec;
+#define LOAD( p ) _mm_loadu_si128( ( const __m128i* ) ( p ) )
+#define STORE( p, v ) _mm_storeu_si128( ( __m128i* ) ( p ), v )
+#define VEC_AND( a, b ) _mm_and_si128( a, b )
+#define VEC_OR( a, b ) _mm_or_si128( a, b )
+#define VEC_XOR( a, b ) _mm_xor_si128( a, b )
+#define VEC_ANDNOT( a, b ) _mm_andnot_si128( b, a )
+#define VEC_ZERO() _mm_setzero_si128()
+#define VEC_ADD( a, b ) _mm_add_epi64( a, b )
+
+static inline size_t VEC_SUM( vec v ) {
+	return ( size_t ) ( _mm_cvtsi128_si64( v ) + _mm_cvtsi128_si64( _mm_unpackhi_epi64( v, v ) ) );
+}
+
+// SWAR down to byte counts, no byte shuffle without SSSE3
+static inline vec VEC_COUNT( vec v ) {
+	const vec m1 = _mm_set1_epi8( 0x55 );
+	const vec m2 = _mm_set1_epi8( 0x33 );
+	const vec m4 = _mm_set1_epi8( 0x0f );
+
+	v = _mm_sub_epi8( v, _mm_and_si128( _mm_srli_epi16( v, 1 ), m1 ) );
+	v = _mm_add_epi8( _mm_and_si128( v, m2 ), _mm_and_si128( _mm_srli_epi16( v, 2 ), m2 ) );
+	v = _mm_and_si128( _mm_add_epi8( v, _mm_srli_epi16( v, 4 ) ), m4 );
+
+	return _mm_sad_epu8( v, _mm_setzero_si128() );
+}
+#endif
+
+#define AND( a, b ) ( ( a ) & ( b ) )
+#define OR( a, b ) ( ( a ) | ( b ) )
+#define XOR( a, b ) ( ( a ) ^ ( b ) )
+#define ANDNOT( a, b ) ( ( a ) & ~( b ) )
+
+#ifdef VEC_WORDS
+#define APPLY_VEC( vop )\
+	for ( ; i + VEC_WORDS <= count; i += VEC_WORDS ) {\
+		STORE( dst + i, vop( LOAD( dst + i ), LOAD( src + i ) ) );\
+	}
+
+#define COUNT_VEC( vop )\
+	{\
+		vec acc = VEC_ZERO();\
+		\
+		for ( ; i + VEC_WORDS <= count; i += VEC_WORDS ) {\
+			acc = VEC_ADD( acc, VEC_COUNT( vop( LOAD( lhs + i ), LOAD( rhs + i ) ) ) );\
+		}\
+		\
+		total = VEC_SUM( acc );\
+	}
+#else
+#define APPLY_VEC( vop )
+#define COUNT_VEC( vop )
+#endif
+
+#define APPLY( name, vop, op )\
+	static void name( uint_least64_t *dst, const uint_least64_t *src, size_t count ) {\
+		size_t i = 0;\
+		\
+		APPLY_VEC( vop )\
+		\
+		for ( ; i < count; ++i ) {\
+			dst[ i ] = op( dst[ i ], src[ i ] );\
+		}\
+	}
+
+#define COUNT( name, vop, op )\
+	static size_t name( const uint_least64_t *lhs, const uint_least64_t *rhs, size_t count ) {\
+		size_t total = 0;\
+		size_t i = 0;\
+		\
+		COUNT_VEC( vop )\
+		\
+		for ( ; i < count; ++i ) {\
+			total += mm_popcount_u64( op( lhs[ i ], rhs[ i ] ) );\
+		}\
+		\
+		return total;\
+	}
+
+APPLY( apply_and, VEC_AND, AND )
+APPLY( apply_or, VEC_OR, OR )
+APPLY( apply_xor, VEC_XOR, XOR )
+APPLY( apply_andnot, VEC_ANDNOT, ANDNOT )
+COUNT( count_and, VEC_AND, AND )
+COUNT( count_or, VEC_OR, OR )
+COUNT( count_xor, VEC_XOR, XOR )
+COUNT( count_andnot, VEC_ANDNOT, ANDNOT )
+
+static inline size_t words_for( size_t size ) {
+	return ( size + 63 ) / 64;
+}
+
+bool mm_bitset_init( struct mm_bitset *this, size_t size ) {
+	this->size = size;
+	this->capacity = words_for( size );
+	this->words = this->capacity ? MM_CALLOC( this->capacity, sizeof( *this->words ) ) : NULL;
+
+	return this->words || !this->capacity;
+}
+
+bool mm_bitset_copy( struct mm_bitset *this, const struct mm_bitset *other ) {
+	if ( !mm_bitset_init( this, other->size ) ) {
+		return false;
+	}
+
+	if ( this->capacity ) {
+		memcpy( this->words, other->words, sizeof( *this->words ) * this->capacity );
+	}
+
+	return true;
+}
+
+void mm_bitset_destroy( struct mm_bitset *this ) {
+	MM_FREE( this->words );
+	this->words = NULL;
+	this->size = 0;
+	this->capacity = 0;
+}
+
+bool mm_bitset_resize( struct mm_bitset *this, size_t size ) {
+	size_t used = words_for( this->size );
+	size_t need = words_for( size );
+
+	if ( need > this->capacity ) {
+		size_t capacity = this->capacity * 2 > need ? this->capacity * 2 : need;
+		uint_least64_t *words = MM_REALLOC( this->words, sizeof( *words ) * capacity );
+
+		if ( !words ) {
+			return false;
+		}
+
+		this->words = words;
+		this->capacity = capacity;
+	}
+
+	if ( need > used ) {
+		memset( this->words + used, 0, sizeof( *this->words ) * ( need - used ) );
+	} else if ( need < used ) {
+		memset( this->words + need, 0, sizeof( *this->words ) * ( used - need ) );
+	}
+
+	// keep the bits past the end clear
+	if ( size < this->size && size & 63 ) {
+		this->words[ size >> 6 ] &= ( ( uint_least64_t ) 1 << ( size & 63 ) ) - 1;
+	}
+
+	this->size = size;
+
+	return true;
+}
+
+size_t mm_bitset_find_next( const struct mm_bitset *this, size_t from ) {
+	size_t count = words_for( this->size );
+	size_t at = from >> 6;
+	uint_least64_t word;
+
+	if ( from >= this->size ) {
+		return this->size;
+	}
+
+	word = this->words[ at ] & ( UINT64_MAX << ( from & 63 ) );
+
+	while ( !word ) {
+		if ( ++at == count ) {
+			return this->size;
+		}
+
+		word = this->words[ at ];
+	}
+
+	return at * 64 + mm_ctz_u64( word );
+}
+
+size_t mm_bitset_count( const struct mm_bitset *this ) {
+	return count_and( this->words, this->words, words_for( this->size ) );
+}
+
+void mm_bitset_and( struct mm_bitset *this, const struct mm_bitset *other ) {
+	MM_ASSERT( this->size == other->size );
+	apply_and( this->words, other->words, words_for( this->size ) );
+}
+
+void mm_bitset_or( struct mm_bitset *this, const struct mm_bitset *other ) {
+	MM_ASSERT( this->size == other->size );
+	apply_or( this->words, other->words, words_for( this->size ) );
+}
+
+void mm_bitset_xor( struct mm_bitset *this, const struct mm_bitset *other ) {
+	MM_ASSERT( this->size == other->size );
+	apply_xor( this->words, other->words, words_for( this->size ) );
+}
+
+void mm_bitset_andnot( struct mm_bitset *this, const struct mm_bitset *other ) {
+	MM_ASSERT( this->size == other->size );
+	apply_andnot( this->words, other->words, words_for( this->size ) );
+}
+
+size_t mm_bitset_and_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs ) {
+	MM_ASSERT( lhs->size == rhs->size );
+	return count_and( lhs->words, rhs->words, words_for( lhs->size ) );
+}
+
+size_t mm_bitset_or_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs ) {
+	MM_ASSERT( lhs->size == rhs->size );
+	return count_or( lhs->words, rhs->words, words_for( lhs->size ) );
+}
+
+size_t mm_bitset_xor_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs ) {
+	MM_ASSERT( lhs->size == rhs->size );
+	return count_xor( lhs->words, rhs->words, words_for( lhs->size ) );
+}
+
+size_t mm_bitset_andnot_count( const struct mm_bitset *lhs, const struct mm_bitset *rhs ) {
+	MM_ASSERT( lhs->size == rhs->size );
+	return count_andnot( lhs->words, rhs->words, words_for( lhs->size ) );
+}
@@ -0,0 +1,233 @@
+#include <string.h>
+#include "mm/bitvector.h"
+
+#define BLOCK_WORDS ( MM_BITVECTOR_BLOCK_BITS / 64 )
+#define SUB_WORDS 8
+// blocks under one upper entry
+#define UPPER_SHIFT 21
+
+static void free_index( struct mm_bitvector *this ) {
+	MM_FREE( this->upper );
+	MM_FREE( this->blocks );
+	MM_FREE( this->samples );
+	this->upper = NULL;
+	this->blocks = NULL;
+	this->samples = NULL;
+}
+
+// the word holding bit size is always there, so rank( size ) doesn't need a bounds check
+static bool reserve( struct mm_bitvector *this, uint_least64_t bits ) {
+	size_t need = ( size_t ) ( bits >> 6 ) + 1;
+	size_t capacity = this->capacity ? this->capacity : 1;
+	uint_least64_t *words;
+
+	if ( need <= this->capacity ) {
+		return true;
+	}
+
+	while ( capacity < need ) {
+		capacity *= 2;
+	}
+
+	words = MM_REALLOC( this->words, sizeof( *words ) * capacity );
+
+	if ( !words ) {
+		return false;
+	}
+
+	memset( words + this->capacity, 0, sizeof( *words ) * ( capacity - this->capacity ) );
+	this->words = words;
+	this->capacity = capacity;
+
+	return true;
+}
+
+bool mm_bitvector_init( struct mm_bitvector *this, uint_least64_t capacity ) {
+	memset( this, 0, sizeof( *this ) );
+
+	return reserve( this, capacity );
+}
+
+void mm_bitvector_destroy( struct mm_bitvector *this ) {
+	free_index( this );
+	MM_FREE( this->words );
+	memset( this, 0, sizeof( *this ) );
+}
+
+bool mm_bitvector_append( struct mm_bitvector *this, uint_least64_t bits, unsigned int count ) {
+	unsigned int offset = this->size & 63;
+	size_t at = ( size_t ) ( this->size >> 6 );
+
+	if ( !reserve( this, this->size + count ) ) {
+		return false;
+	}
+
+	if ( count < 64 ) {
+		bits &= ( ( uint_least64_t ) 1 << count ) - 1;
+	}
+
+	this->words[ at ] |= bits << offset;
+
+	if ( offset && offset + count > 64 ) {
+		this->words[ at + 1 ] = bits >> ( 64 - offset );
+	}
+
+	this->size += count;
+
+	return true;
+}
+
+static unsigned int count_words( const uint_least64_t *words, size_t from, size_t to ) {
+	unsigned int count = 0;
+
+	for ( size_t i = from; i < to; ++i ) {
+		count += mm_popcount_u64( words[ i ] );
+	}
+
+	return count;
+}
+
+bool mm_bitvector_build( struct mm_bitvector *this ) {
+	size_t block_count = ( size_t ) ( this->size / MM_BITVECTOR_BLOCK_BITS ) + 1;
+	size_t word_count = ( size_t ) ( this->size >> 6 ) + 1;
+	size_t sample_count;
+	size_t next = 0;
+	uint_least64_t total = 0;
+
+	free_index( this );
+	this->upper = MM_MALLOC( sizeof( *this->upper ) * ( ( block_count >> UPPER_SHIFT ) + 1 ) );
+	this->blocks = MM_MALLOC( sizeof( *this->blocks ) * block_count );
+
+	if ( !this->upper || !this->blocks ) {
+		free_index( this );
+		return false;
+	}
+
+	for ( size_t b = 0; b < block_count; ++b ) {
+		size_t word = b * BLOCK_WORDS;
+		uint_least64_t entry;
+
+		if ( !( b & ( ( ( size_t ) 1 << UPPER_SHIFT ) - 1 ) ) ) {
+			this->upper[ b >> UPPER_SHIFT ] = total;
+		}
+
+		entry = total - this->upper[ b >> UPPER_SHIFT ];
+
+		for ( unsigned int sub = 0; sub < BLOCK_WORDS / SUB_WORDS; ++sub, word += SUB_WORDS ) {
+			size_t from = word < word_count ? word : word_count;
+			size_t to = word + SUB_WORDS < word_count ? word + SUB_WORDS : word_count;
+			uint_least64_t count = count_words( this->words, from, to );
+
+			if ( sub < 3 ) {
+				entry |= count << ( 32 + 10 * sub );
+			}
+
+			total += count;
+		}
+
+		this->blocks[ b ] = entry;
+	}
+
+	this->ones = total;
+	sample_count = ( size_t ) ( total / MM_BITVECTOR_SELECT_SAMPLE ) + 2;
+	this->samples = MM_MALLOC( sizeof( *this->samples ) * sample_count );
+
+	if ( !this->samples ) {
+		free_index( this );
+		return false;
+	}
+
+	// the block of a set bit is the last one that starts with fewer set bits before it
+	for ( size_t b = 0; b < block_count; ++b ) {
+		uint_least64_t after = b + 1 < block_count ? this->upper[ ( b + 1 ) >> UPPER_SHIFT ] + ( this->blocks[ b + 1 ] & 0xffffffff ) : total;
+
+		while ( next < sample_count - 1 && ( uint_least64_t ) next * MM_BITVECTOR_SELECT_SAMPLE < after ) {
+			this->samples[ next++ ] = b;
+		}
+	}
+
+	while ( next < sample_count ) {
+		this->samples[ next++ ] = block_count - 1;
+	}
+
+	return true;
+}
+
+bool mm_bitvector_from_positions( struct mm_bitvector *this, struct mm_vector *positions, uint_least64_t size ) {
+	const uint_least64_t *pos = mm_vector_begin( positions );
+	size_t count = mm_vector_size( positions );
+
+	if ( !mm_bitvector_init( this, size ) ) {
+		return false;
+	}
+
+	this->size = size;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		if ( pos[ i ] >= size ) {
+			mm_bitvector_destroy( this );
+			return false;
+		}
+
+		this->words[ pos[ i ] >> 6 ] |= ( uint_least64_t ) 1 << ( pos[ i ] & 63 );
+	}
+
+	if ( !mm_bitvector_build( this ) ) {
+		mm_bitvector_destroy( this );
+		return false;
+	}
+
+	return true;
+}
+
+static inline uint_least64_t block_rank( const struct mm_bitvector *this, size_t b ) {
+	return this->upper[ b >> UPPER_SHIFT ] + ( this->blocks[ b ] & 0xffffffff );
+}
+
+uint_least64_t mm_bitvector_select1( const struct mm_bitvector *this, uint_least64_t k ) {
+	size_t sample = ( size_t ) ( k / MM_BITVECTOR_SELECT_SAMPLE );
+	size_t lo;
+	size_t hi;
+	size_t word;
+	uint_least64_t entry;
+	unsigned int count;
+
+	if ( k >= this->ones ) {
+		return this->size;
+	}
+
+	lo = ( size_t ) this->samples[ sample ];
+	hi = ( size_t ) this->samples[ sample + 1 ];
+
+	// last block in the range with at most k set bits before it
+	while ( lo < hi ) {
+		size_t mid = lo + ( hi - lo + 1 ) / 2;
+
+		if ( block_rank( this, mid ) <= k ) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	k -= block_rank( this, lo );
+	entry = this->blocks[ lo ];
+	word = lo * BLOCK_WORDS;
+
+	for ( unsigned int sub = 0; sub < 3; ++sub, word += SUB_WORDS ) {
+		count = ( entry >> ( 32 + 10 * sub ) ) & 0x3ff;
+
+		if ( k < count ) {
+			break;
+		}
+
+		k -= count;
+	}
+
+	while ( k >= ( count = mm_popcount_u64( this->words[ word ] ) ) ) {
+		k -= count;
+		++word;
+	}
+
+	return ( uint_least64_t ) word * 64 + mm_bit_select_u64( this->words[ word ], ( unsigned int ) k );
+}
@@ -0,0 +1,607 @@
+#include "mm/btree.h"
+#include "mm/assert.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define KEY_MAX UINT_LEAST64_MAX
+#define MIN_KEYS ( MM_BTREE_KEYS / 2 )
+// a tree of height 32 would hold more than 16^32 keys
+#define MAX_HEIGHT 32
+
+#define ROUND_UP( size )\
+	( ( ( size ) + MM_BTREE_ALIGN - 1 ) / MM_BTREE_ALIGN * MM_BTREE_ALIGN )
+
+static void pad( mm_btree_key_t *keys, unsigned int from ) {
+	for ( unsigned int i = from; i < MM_BTREE_KEYS; ++i ) {
+		keys[ i ] = KEY_MAX;
+	}
+}
+
+static struct mm_btree_leaf* new_leaf( void ) {
+	struct mm_btree_leaf *leaf = MM_ALIGNED_ALLOC( MM_BTREE_ALIGN, ROUND_UP( sizeof( *leaf ) ) );
+
+	if ( leaf ) {
+		pad( leaf->keys, 0 );
+		leaf->prev = NULL;
+		leaf->next = NULL;
+		leaf->count = 0;
+	}
+
+	return leaf;
+}
+
+static struct mm_btree_inner* new_inner( void ) {
+	struct mm_btree_inner *inner = MM_ALIGNED_ALLOC( MM_BTREE_ALIGN, ROUND_UP( sizeof( *inner ) ) );
+
+	if ( inner ) {
+		pad( inner->keys, 0 );
+		inner->count = 0;
+	}
+
+	return inner;
+}
+
+// number of keys less than key, slots past count are padded with KEY_MAX
+static inline unsigned int search( const mm_btree_key_t *keys, unsigned int count, mm_btree_key_t key ) {
+#ifdef __AVX2__
+	// there's no unsigned 64 bit compare, flip the sign bits and compare signed
+	const __m256i sign = _mm256_set1_epi64x( INT64_MIN );
+	const __m256i needle = _mm256_xor_si256( _mm256_set1_epi64x( ( long long ) key ), sign );
+	unsigned int n = 0;
+
+	for ( unsigned int i = 0; i < count; i += 4 ) {
+		__m256i v = _mm256_xor_si256( _mm256_loadu_si256( ( const __m256i* ) ( keys + i ) ), sign );
+		__m256i lt = _mm256_cmpgt_epi64( needle, v );
+
+		n += __builtin_popcount( _mm256_movemask_pd( _mm256_castsi256_pd( lt ) ) );
+	}
+
+	return n;
+#else
+	// branchless binary search, compiles down to conditional moves
+	const mm_btree_key_t *base = keys;
+
+	if ( !count ) {
+		return 0;
+	}
+
+	while ( count > 1 ) {
+		unsigned int half = count / 2;
+
+		base = base[ half ] < key ? base + half : base;
+		count -= half;
+	}
+
+	return ( unsigned int ) ( base - keys ) + ( *base < key );
+#endif
+}
+
+// child to descend into, equal keys live in the right hand child
+static inline unsigned int child_index( const struct mm_btree_inner *inner, mm_btree_key_t key ) {
+	unsigned int idx = search( inner->keys, inner->count, key );
+
+	return idx + ( idx < inner->count && inner->keys[ idx ] == key );
+}
+
+static inline struct mm_btree_leaf* find_leaf( const struct mm_btree *this, mm_btree_key_t key ) {
+	void *node = this->root;
+
+	for ( unsigned int i = 0; i < this->height; ++i ) {
+		struct mm_btree_inner *inner = node;
+		node = inner->children[ child_index( inner, key ) ];
+	}
+
+	return node;
+}
+
+static void destroy( void *node, unsigned int height ) {
+	if ( height ) {
+		struct mm_btree_inner *inner = node;
+
+		for ( unsigned int i = 0; i <= inner->count; ++i ) {
+			destroy( inner->children[ i ], height - 1 );
+		}
+	}
+
+	MM_FREE( node );
+}
+
+void mm_btree_destroy( struct mm_btree *this ) {
+	if ( this->root ) {
+		destroy( this->root, this->height );
+	}
+
+	mm_btree_init( this );
+}
+
+void** mm_btree_find( const struct mm_btree *this, mm_btree_key_t key ) {
+	if ( !this->root ) {
+		return NULL;
+	}
+
+	struct mm_btree_leaf *leaf = find_leaf( this, key );
+	unsigned int idx = search( leaf->keys, leaf->count, key );
+
+	if ( idx < leaf->count && leaf->keys[ idx ] == key ) {
+		return &leaf->values[ idx ];
+	}
+
+	return NULL;
+}
+
+struct mm_btree_iter mm_btree_lower_bound( const struct mm_btree *this, mm_btree_key_t key ) {
+	struct mm_btree_iter it = { .leaf = NULL, .idx = 0 };
+
+	if ( !this->root ) {
+		return it;
+	}
+
+	it.leaf = find_leaf( this, key );
+	it.idx = search( it.leaf->keys, it.leaf->count, key );
+
+	// every key in this leaf was smaller, the answer is the start of the next one
+	if ( it.idx >= it.leaf->count ) {
+		it.leaf = it.leaf->next;
+		it.idx = 0;
+	}
+
+	return it;
+}
+
+static void leaf_insert_at( struct mm_btree_leaf *leaf, unsigned int idx, mm_btree_key_t key, void *value ) {
+	unsigned int tail = leaf->count - idx;
+
+	memmove( &leaf->keys[ idx + 1 ], &leaf->keys[ idx ], sizeof( *leaf->keys ) * tail );
+	memmove( &leaf->values[ idx + 1 ], &leaf->values[ idx ], sizeof( *leaf->values ) * tail );
+	leaf->keys[ idx ] = key;
+	leaf->values[ idx ] = value;
+	++leaf->count;
+}
+
+static void leaf_erase_at( struct mm_btree_leaf *leaf, unsigned int idx ) {
+	unsigned int tail = leaf->count - idx - 1;
+
+	memmove( &leaf->keys[ idx ], &leaf->keys[ idx + 1 ], sizeof( *leaf->keys ) * tail );
+	memmove( &leaf->values[ idx ], &leaf->values[ idx + 1 ], sizeof( *leaf->values ) * tail );
+	leaf->keys[ --leaf->count ] = KEY_MAX;
+}
+
+// insert key at idx and child at idx + 1
+static void inner_insert_at( struct mm_btree_inner *inner, unsigned int idx, mm_btree_key_t key, void *child ) {
+	unsigned int tail = inner->count - idx;
+
+	memmove( &inner->keys[ idx + 1 ], &inner->keys[ idx ], sizeof( *inner->keys ) * tail );
+	memmove( &inner->children[ idx + 2 ], &inner->children[ idx + 1 ], sizeof( *inner->children ) * tail );
+	inner->keys[ idx ] = key;
+	inner->children[ idx + 1 ] = child;
+	++inner->count;
+}
+
+// erase key at idx and child at idx + 1
+static void inner_erase_at( struct mm_btree_inner *inner, unsigned int idx ) {
+	unsigned int tail = inner->count - idx - 1;
+
+	memmove( &inner->keys[ idx ], &inner->keys[ idx + 1 ], sizeof( *inner->keys ) * tail );
+	memmove( &inner->children[ idx + 1 ], &inner->children[ idx + 2 ], sizeof( *inner->children ) * tail );
+	inner->keys[ --inner->count ] = KEY_MAX;
+}
+
+// split a full leaf while inserting, right is the new empty leaf, returns the separator
+static mm_btree_key_t split_leaf( struct mm_btree_leaf *leaf, struct mm_btree_leaf *right, unsigned int idx, mm_btree_key_t key, void *value ) {
+	unsigned int half = ( MM_BTREE_KEYS + 1 ) / 2;
+
+	// move the upper half over, then insert into whichever side the key belongs to
+	if ( idx < half ) {
+		--half;
+	}
+
+	right->count = MM_BTREE_KEYS - half;
+	memcpy( right->keys, &leaf->keys[ half ], sizeof( *leaf->keys ) * right->count );
+	memcpy( right->values, &leaf->values[ half ], sizeof( *leaf->values ) * right->count );
+	leaf->count = half;
+	pad( leaf->keys, half );
+
+	if ( idx <= half ) {
+		leaf_insert_at( leaf, idx, key, value );
+	} else {
+		leaf_insert_at( right, idx - half, key, value );
+	}
+
+	right->next = leaf->next;
+	right->prev = leaf;
+
+	if ( leaf->next ) {
+		leaf->next->prev = right;
+	}
+
+	leaf->next = right;
+
+	return right->keys[ 0 ];
+}
+
+// split a full inner node while inserting key/child at idx, returns the key moving up
+static mm_btree_key_t split_inner( struct mm_btree_inner *inner, struct mm_btree_inner *right, unsigned int idx, mm_btree_key_t key, void *child ) {
+	mm_btree_key_t keys[ MM_BTREE_KEYS + 1 ];
+	void *children[ MM_BTREE_KEYS + 2 ];
+	unsigned int mid = ( MM_BTREE_KEYS + 1 ) / 2;
+
+	memcpy( keys, inner->keys, sizeof( *keys ) * idx );
+	keys[ idx ] = key;
+	memcpy( &keys[ idx + 1 ], &inner->keys[ idx ], sizeof( *keys ) * ( MM_BTREE_KEYS - idx ) );
+
+	memcpy( children, inner->children, sizeof( *children ) * ( idx + 1 ) );
+	children[ idx + 1 ] = child;
+	memcpy( &children[ idx + 2 ], &inner->children[ idx + 1 ], sizeof( *children ) * ( MM_BTREE_KEYS - idx ) );
+
+	inner->count = mid;
+	memcpy( inner->keys, keys, sizeof( *keys ) * mid );
+	memcpy( inner->children, children, sizeof( *children ) * ( mid + 1 ) );
+	pad( inner->keys, mid );
+
+	right->count = MM_BTREE_KEYS - mid;
+	memcpy( right->keys, &keys[ mid + 1 ], sizeof( *keys ) * right->count );
+	memcpy( right->children, &children[ mid + 1 ], sizeof( *children ) * ( right->count + 1 ) );
+
+	return keys[ mid ];
+}
+
+bool mm_btree_insert( struct mm_btree *this, mm_btree_key_t key, void *value ) {
+	struct mm_btree_inner *path[ MAX_HEIGHT ];
+	unsigned int slots[ MAX_HEIGHT ];
+	void *spare[ MAX_HEIGHT + 2 ];
+	unsigned int needed = 0;
+	void *node = this->root;
+
+	if ( !node ) {
+		struct mm_btree_leaf *leaf = new_leaf();
+
+		if ( !leaf ) {
+			return false;
+		}
+
+		leaf_insert_at( leaf, 0, key, value );
+		this->root = leaf;
+		this->height = 0;
+		this->size = 1;
+
+		return true;
+	}
+
+	for ( unsigned int i = 0; i < this->height; ++i ) {
+		path[ i ] = node;
+		slots[ i ] = child_index( path[ i ], key );
+		node = path[ i ]->children[ slots[ i ] ];
+	}
+
+	struct mm_btree_leaf *leaf = node;
+	unsigned int idx = search( leaf->keys, leaf->count, key );
+
+	if ( idx < leaf->count && leaf->keys[ idx ] == key ) {
+		leaf->values[ idx ] = value;
+		return true;
+	}
+
+	if ( leaf->count < MM_BTREE_KEYS ) {
+		leaf_insert_at( leaf, idx, key, value );
+		++this->size;
+		return true;
+	}
+
+	// allocate every node the splits will need up front so failure leaves the tree untouched
+	spare[ needed++ ] = new_leaf();
+
+	for ( unsigned int i = this->height; i-- > 0 && path[ i ]->count == MM_BTREE_KEYS; ) {
+		spare[ needed++ ] = new_inner();
+	}
+
+	if ( needed == this->height + 1 ) {
+		spare[ needed++ ] = new_inner();
+	}
+
+	for ( unsigned int i = 0; i < needed; ++i ) {
+		if ( !spare[ i ] ) {
+			for ( unsigned int j = 0; j < needed; ++j ) {
+				MM_FREE( spare[ j ] );
+			}
+
+			return false;
+		}
+	}
+
+	unsigned int used = 0;
+	void *child = spare[ used++ ];
+	mm_btree_key_t sep = split_leaf( leaf, child, idx, key, value );
+
+	++this->size;
+
+	for ( unsigned int i = this->height; i-- > 0; ) {
+		if ( path[ i ]->count < MM_BTREE_KEYS ) {
+			inner_insert_at( path[ i ], slots[ i ], sep, child );
+			return true;
+		}
+
+		struct mm_btree_inner *right = spare[ used++ ];
+
+		sep = split_inner( path[ i ], right, slots[ i ], sep, child );
+		child = right;
+	}
+
+	// the root was split, grow the tree by one level
+	struct mm_btree_inner *root = spare[ used ];
+
+	root->keys[ 0 ] = sep;
+	root->children[ 0 ] = this->root;
+	root->children[ 1 ] = child;
+	root->count = 1;
+	this->root = root;
+	++this->height;
+
+	return true;
+}
+
+static void merge_leaves( struct mm_btree_leaf *left, struct mm_btree_leaf *right ) {
+	memcpy( &left->keys[ left->count ], right->keys, sizeof( *right->keys ) * right->count );
+	memcpy( &left->values[ left->count ], right->values, sizeof( *right->values ) * right->count );
+	left->count += right->count;
+	left->next = right->next;
+
+	if ( right->next ) {
+		right->next->prev = left;
+	}
+
+	MM_FREE( right );
+}
+
+// fix an underfull leaf by borrowing from or merging with a sibling, returns true if parent lost a key
+static bool rebalance_leaf( struct mm_btree_inner *parent, unsigned int slot, struct mm_btree_leaf *leaf ) {
+	struct mm_btree_leaf *left = slot > 0 ? parent->children[ slot - 1 ] : NULL;
+	struct mm_btree_leaf *right = slot < parent->count ? parent->children[ slot + 1 ] : NULL;
+
+	if ( left && left->count > MIN_KEYS ) {
+		leaf_insert_at( leaf, 0, left->keys[ left->count - 1 ], left->values[ left->count - 1 ] );
+		leaf_erase_at( left, left->count - 1 );
+		parent->keys[ slot - 1 ] = leaf->keys[ 0 ];
+		return false;
+	}
+
+	if ( right && right->count > MIN_KEYS ) {
+		leaf_insert_at( leaf, leaf->count, right->keys[ 0 ], right->values[ 0 ] );
+		leaf_erase_at( right, 0 );
+		parent->keys[ slot ] = right->keys[ 0 ];
+		return false;
+	}
+
+	if ( left ) {
+		merge_leaves( left, leaf );
+		inner_erase_at( parent, slot - 1 );
+	} else {
+		merge_leaves( leaf, right );
+		inner_erase_at( parent, slot );
+	}
+
+	return true;
+}
+
+static void merge_inners( struct mm_btree_inner *left, mm_btree_key_t sep, struct mm_btree_inner *right ) {
+	left->keys[ left->count ] = sep;
+	memcpy( &left->keys[ left->count + 1 ], right->keys, sizeof( *right->keys ) * right->count );
+	memcpy( &left->children[ left->count + 1 ], right->children, sizeof( *right->children ) * ( right->count + 1 ) );
+	left->count += right->count + 1;
+
+	MM_FREE( right );
+}
+
+static bool rebalance_inner( struct mm_btree_inner *parent, unsigned int slot, struct mm_btree_inner *inner ) {
+	struct mm_btree_inner *left = slot > 0 ? parent->children[ slot - 1 ] : NULL;
+	struct mm_btree_inner *right = slot < parent->count ? parent->children[ slot + 1 ] : NULL;
+
+	if ( left && left->count > MIN_KEYS ) {
+		// rotate right through the parent separator
+		memmove( &inner->keys[ 1 ], inner->keys, sizeof( *inner->keys ) * inner->count );
+		memmove( &inner->children[ 1 ], inner->children, sizeof( *inner->children ) * ( inner->count + 1 ) );
+		inner->keys[ 0 ] = parent->keys[ slot - 1 ];
+		inner->children[ 0 ] = left->children[ left->count ];
+		++inner->count;
+		parent->keys[ slot - 1 ] = left->keys[ left->count - 1 ];
+		left->keys[ --left->count ] = KEY_MAX;
+		return false;
+	}
+
+	if ( right && right->count > MIN_KEYS ) {
+		// rotate left through the parent separator
+		inner->keys[ inner->count ] = parent->keys[ slot ];
+		inner->children[ inner->count + 1 ] = right->children[ 0 ];
+		++inner->count;
+		parent->keys[ slot ] = right->keys[ 0 ];
+		memmove( right->keys, &right->keys[ 1 ], sizeof( *right->keys ) * ( right->count - 1 ) );
+		memmove( right->children, &right->children[ 1 ], sizeof( *right->children ) * right->count );
+		right->keys[ --right->count ] = KEY_MAX;
+		return false;
+	}
+
+	if ( left ) {
+		merge_inners( left, parent->keys[ slot - 1 ], inner );
+		inner_erase_at( parent, slot - 1 );
+	} else {
+		merge_inners( inner, parent->keys[ slot ], right );
+		inner_erase_at( parent, slot );
+	}
+
+	return true;
+}
+
+bool mm_btree_erase( struct mm_btree *this, mm_btree_key_t key, void **value ) {
+	struct mm_btree_inner *path[ MAX_HEIGHT ];
+	unsigned int slots[ MAX_HEIGHT ];
+	void *node = this->root;
+
+	if ( !node ) {
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < this->height; ++i ) {
+		path[ i ] = node;
+		slots[ i ] = child_index( path[ i ], key );
+		node = path[ i ]->children[ slots[ i ] ];
+	}
+
+	struct mm_btree_leaf *leaf = node;
+	unsigned int idx = search( leaf->keys, leaf->count, key );
+
+	if ( idx >= leaf->count || leaf->keys[ idx ] != key ) {
+		return false;
+	}
+
+	if ( value ) {
+		*value = leaf->values[ idx ];
+	}
+
+	leaf_erase_at( leaf, idx );
+	--this->size;
+
+	if ( !this->height ) {
+		if ( !leaf->count ) {
+			MM_FREE( leaf );
+			this->root = NULL;
+		}
+
+		return true;
+	}
+
+	if ( leaf->count >= MIN_KEYS || !rebalance_leaf( path[ this->height - 1 ], slots[ this->height - 1 ], leaf ) ) {
+		return true;
+	}
+
+	// a merge removed a separator, walk up while inner nodes underflow
+	for ( unsigned int i = this->height - 1; i > 0; --i ) {
+		if ( path[ i ]->count >= MIN_KEYS || !rebalance_inner( path[ i - 1 ], slots[ i - 1 ], path[ i ] ) ) {
+			return true;
+		}
+	}
+
+	struct mm_btree_inner *root = this->root;
+
+	if ( !root->count ) {
+		this->root = root->children[ 0 ];
+		--this->height;
+		MM_FREE( root );
+	}
+
+	return true;
+}
+
+bool mm_btree_bulk_load( struct mm_btree *this, struct mm_vector *entries ) {
+	struct mm_btree_entry *src = mm_vector_begin( entries );
+	size_t n = mm_vector_size( entries );
+
+	mm_btree_destroy( this );
+
+	if ( !n ) {
+		return true;
+	}
+
+	size_t count = ( n + MM_BTREE_KEYS - 1 ) / MM_BTREE_KEYS;
+	void **nodes = MM_MALLOC( sizeof( *nodes ) * count );
+	mm_btree_key_t *mins = MM_MALLOC( sizeof( *mins ) * count );
+	struct mm_btree_leaf *prev = NULL;
+	unsigned int height = 0;
+
+	if ( !nodes || !mins ) {
+		goto fail;
+	}
+
+	// spread the keys evenly so every leaf is at least half full
+	for ( size_t i = 0, pos = 0; i < count; ++i ) {
+		struct mm_btree_leaf *leaf = new_leaf();
+		size_t take = n / count + ( i < n % count );
+
+		if ( !leaf ) {
+			count = i;
+			goto fail;
+		}
+
+		for ( size_t j = 0; j < take; ++j, ++pos ) {
+			MM_ASSERT( !pos || src[ pos - 1 ].key < src[ pos ].key );
+			leaf->keys[ j ] = src[ pos ].key;
+			leaf->values[ j ] = src[ pos ].value;
+		}
+
+		leaf->count = ( unsigned int ) take;
+		leaf->prev = prev;
+
+		if ( prev ) {
+			prev->next = leaf;
+		}
+
+		prev = leaf;
+		nodes[ i ] = leaf;
+		mins[ i ] = leaf->keys[ 0 ];
+	}
+
+	// build each inner level from the one below, in place
+	while ( count > 1 ) {
+		size_t parents = ( count + MM_BTREE_KEYS ) / ( MM_BTREE_KEYS + 1 );
+		size_t pos = 0;
+
+		for ( size_t i = 0; i < parents; ++i ) {
+			struct mm_btree_inner *inner = new_inner();
+			size_t take = count / parents + ( i < count % parents );
+
+			if ( !inner ) {
+				// nodes[ 0, i ) are finished parents, nodes[ pos, count ) still need one
+				for ( size_t j = 0; j < i; ++j ) {
+					destroy( nodes[ j ], height + 1 );
+				}
+
+				for ( ; pos < count; ++pos ) {
+					destroy( nodes[ pos ], height );
+				}
+
+				count = 0;
+				goto fail;
+			}
+
+			mm_btree_key_t min = mins[ pos ];
+
+			for ( size_t j = 0; j < take; ++j, ++pos ) {
+				inner->children[ j ] = nodes[ pos ];
+
+				if ( j ) {
+					inner->keys[ j - 1 ] = mins[ pos ];
+				}
+			}
+
+			inner->count = ( unsigned int ) take - 1;
+			nodes[ i ] = inner;
+			mins[ i ] = min;
+		}
+
+		count = parents;
+		++height;
+	}
+
+	this->root = nodes[ 0 ];
+	this->height = height;
+	this->size = n;
+
+	MM_FREE( nodes );
+	MM_FREE( mins );
+
+	return true;
+
+fail:
+	if ( nodes ) {
+		for ( size_t i = 0; i < count; ++i ) {
+			destroy( nodes[ i ], height );
+		}
+	}
+
+	MM_FREE( nodes );
+	MM_FREE( mins );
+
+	return false;
+}
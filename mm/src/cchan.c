@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mm/cchan.h"
+
+#define TASK_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_executor_task, list )
+
+// unlinks the longest waiting task, it is woken once the lock is dropped
+static struct mm_executor_task* pop_waiter( struct mm_list *waiters ) {
+	struct mm_executor_task *task;
+
+	if ( mm_list_empty( waiters ) ) {
+		return NULL;
+	}
+
+	task = TASK_OF( waiters->next );
+	mm_list_del( &task->list );
+
+	return task;
+}
+
+// a task resumed again before anyone woke it is still linked, it must not be added twice
+static void add_waiter( struct mm_list *waiters, struct mm_executor_task *task ) {
+	if ( task && mm_list_empty( &task->list ) ) {
+		mm_list_add_tail( waiters, &task->list );
+	}
+}
+
+static void wake( struct mm_cchan *this, struct mm_executor_task *task ) {
+	if ( task ) {
+		mm_executor_wake( this->executor, task );
+	}
+}
+
+bool mm_cchan_init( struct mm_cchan *this, struct mm_executor *executor, size_t size, size_t capacity ) {
+	this->slots = capacity ? capacity : 1;
+	this->buffer = MM_MALLOC( size * this->slots );
+
+	if ( !this->buffer ) {
+		return false;
+	}
+
+	if ( mtx_init( &this->lock, mtx_plain ) != thrd_success ) {
+		MM_FREE( this->buffer );
+		return false;
+	}
+
+	this->executor = executor;
+	this->size = size;
+	this->capacity = capacity;
+	this->head = 0;
+	this->count = 0;
+	this->closed = false;
+	mm_list_init( &this->senders );
+	mm_list_init( &this->receivers );
+
+	return true;
+}
+
+void mm_cchan_destroy( struct mm_cchan *this ) {
+	mtx_destroy( &this->lock );
+	MM_FREE( this->buffer );
+	this->buffer = NULL;
+}
+
+enum mm_chan_status mm_cchan_send( struct mm_cchan *this, struct mm_executor_task *task, const void *value ) {
+	struct mm_executor_task *receiver = NULL;
+	enum mm_chan_status status = MM_CHAN_OK;
+
+	mtx_lock( &this->lock );
+
+	if ( this->closed ) {
+		status = MM_CHAN_CLOSED;
+	} else if ( this->count == this->slots || ( !this->capacity && mm_list_empty( &this->receivers ) ) ) {
+		add_waiter( &this->senders, task );
+		status = MM_CHAN_AGAIN;
+	} else {
+		size_t tail = this->head + this->count;
+
+		if ( tail >= this->slots ) {
+			tail -= this->slots;
+		}
+
+		memcpy( this->buffer + tail * this->size, value, this->size );
+		++this->count;
+		receiver = pop_waiter( &this->receivers );
+	}
+
+	mtx_unlock( &this->lock );
+	wake( this, receiver );
+
+	return status;
+}
+
+enum mm_chan_status mm_cchan_recv( struct mm_cchan *this, struct mm_executor_task *task, void *value ) {
+	struct mm_executor_task *sender = NULL;
+	enum mm_chan_status status = MM_CHAN_OK;
+
+	mtx_lock( &this->lock );
+
+	if ( this->count ) {
+		memcpy( value, this->buffer + this->head * this->size, this->size );
+
+		if ( ++this->head == this->slots ) {
+			this->head = 0;
+		}
+
+		--this->count;
+		sender = pop_waiter( &this->senders );
+	} else if ( this->closed ) {
+		status = MM_CHAN_CLOSED;
+	} else {
+		add_waiter( &this->receivers, task );
+		status = MM_CHAN_AGAIN;
+
+		// a receiver is waiting now, which is what an unbuffered sender waits for
+		if ( !this->capacity ) {
+			sender = pop_waiter( &this->senders );
+		}
+	}
+
+	mtx_unlock( &this->lock );
+	wake( this, sender );
+
+	return status;
+}
+
+void mm_cchan_close( struct mm_cchan *this ) {
+	struct mm_list waiters;
+
+	mm_list_init( &waiters );
+	mtx_lock( &this->lock );
+	this->closed = true;
+	mm_list_splice_tail( &waiters, &this->senders );
+	mm_list_splice_tail( &waiters, &this->receivers );
+	mtx_unlock( &this->lock );
+
+	while ( !mm_list_empty( &waiters ) ) {
+		wake( this, pop_waiter( &waiters ) );
+	}
+}
@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mm/chan.h"
+
+#define CASE_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_chan_case, list )
+
+static void select_unregister( struct mm_chan_select *this ) {
+	for ( size_t i = 0; i < this->count; ++i ) {
+		mm_list_del( &this->cases[ i ].list );
+	}
+}
+
+// a select waits on all of its channels at once, the first to fire takes it off every one of them
+static void select_wake( struct mm_chan_case *pos ) {
+	struct mm_chan_select *this = pos->select;
+
+	select_unregister( this );
+	this->woken = pos;
+	mm_sched_wake( pos->chan->sched, this->task );
+}
+
+static void wake_receiver( struct mm_chan *this ) {
+	if ( !mm_sched_event_signal( this->sched, &this->receivers ) && !mm_list_empty( &this->recv_selects ) ) {
+		select_wake( CASE_OF( this->recv_selects.next ) );
+	}
+}
+
+static void wake_sender( struct mm_chan *this ) {
+	if ( !mm_sched_event_signal( this->sched, &this->senders ) && !mm_list_empty( &this->send_selects ) ) {
+		select_wake( CASE_OF( this->send_selects.next ) );
+	}
+}
+
+static bool receiver_waiting( struct mm_chan *this ) {
+	return mm_sched_event_has_waiters( &this->receivers ) || !mm_list_empty( &this->recv_selects );
+}
+
+bool mm_chan_init( struct mm_chan *this, struct mm_sched *sched, size_t size, size_t capacity ) {
+	this->slots = capacity ? capacity : 1;
+	this->buffer = MM_MALLOC( size * this->slots );
+
+	if ( !this->buffer ) {
+		return false;
+	}
+
+	this->sched = sched;
+	this->size = size;
+	this->capacity = capacity;
+	this->head = 0;
+	this->count = 0;
+	this->closed = false;
+	mm_sched_event_init( &this->senders );
+	mm_sched_event_init( &this->receivers );
+	mm_list_init( &this->send_selects );
+	mm_list_init( &this->recv_selects );
+
+	return true;
+}
+
+void mm_chan_destroy( struct mm_chan *this ) {
+	MM_FREE( this->buffer );
+	this->buffer = NULL;
+}
+
+enum mm_chan_status mm_chan_try_send( struct mm_chan *this, const void *value ) {
+	size_t tail;
+
+	if ( this->closed ) {
+		return MM_CHAN_CLOSED;
+	}
+
+	// unbuffered values are only handed over to a receiver that is already there
+	if ( this->count == this->slots || ( !this->capacity && !receiver_waiting( this ) ) ) {
+		return MM_CHAN_AGAIN;
+	}
+
+	tail = this->head + this->count;
+
+	if ( tail >= this->slots ) {
+		tail -= this->slots;
+	}
+
+	memcpy( this->buffer + tail * this->size, value, this->size );
+	++this->count;
+	wake_receiver( this );
+
+	return MM_CHAN_OK;
+}
+
+enum mm_chan_status mm_chan_try_recv( struct mm_chan *this, void *value ) {
+	if ( !this->count ) {
+		if ( this->closed ) {
+			return MM_CHAN_CLOSED;
+		}
+
+		// let a sender know a receiver is about to wait
+		if ( !this->capacity ) {
+			wake_sender( this );
+		}
+
+		return MM_CHAN_AGAIN;
+	}
+
+	memcpy( value, this->buffer + this->head * this->size, this->size );
+
+	if ( ++this->head == this->slots ) {
+		this->head = 0;
+	}
+
+	--this->count;
+	wake_sender( this );
+
+	return MM_CHAN_OK;
+}
+
+void mm_chan_close( struct mm_chan *this ) {
+	this->closed = true;
+	mm_sched_event_broadcast( this->sched, &this->senders );
+	mm_sched_event_broadcast( this->sched, &this->receivers );
+
+	while ( !mm_list_empty( &this->send_selects ) ) {
+		select_wake( CASE_OF( this->send_selects.next ) );
+	}
+
+	while ( !mm_list_empty( &this->recv_selects ) ) {
+		select_wake( CASE_OF( this->recv_selects.next ) );
+	}
+}
+
+long mm_chan_select_try( struct mm_chan_select *this ) {
+	struct mm_chan_case *woken = this->woken;
+
+	// also covers a select resumed by something other than its channels
+	select_unregister( this );
+	this->woken = NULL;
+
+	for ( size_t i = 0; i < this->count; ++i ) {
+		size_t index = ( this->start + i ) % this->count;
+		struct mm_chan_case *pos = &this->cases[ index ];
+
+		if ( pos->send ) {
+			this->status = mm_chan_try_send( pos->chan, pos->value );
+		} else {
+			this->status = mm_chan_try_recv( pos->chan, pos->value );
+		}
+
+		if ( this->status == MM_CHAN_AGAIN ) {
+			continue;
+		}
+
+		// the wake that brought the select here went unused, pass it on to the next waiter
+		if ( woken && woken != pos && !woken->chan->closed ) {
+			if ( woken->send ) {
+				if ( woken->chan->count < woken->chan->slots ) {
+					wake_sender( woken->chan );
+				}
+			} else if ( woken->chan->count ) {
+				wake_receiver( woken->chan );
+			}
+		}
+
+		this->start = index + 1;
+
+		return ( long ) index;
+	}
+
+	return -1;
+}
+
+void mm_chan_select_wait( struct mm_chan_select *this ) {
+	for ( size_t i = 0; i < this->count; ++i ) {
+		struct mm_chan_case *pos = &this->cases[ i ];
+
+		mm_list_add_tail( pos->send ? &pos->chan->send_selects : &pos->chan->recv_selects, &pos->list );
+	}
+}
+
+bool mm_chan_bcast_init( struct mm_chan_bcast *this, struct mm_sched *sched, size_t size, size_t capacity ) {
+	this->buffer = MM_MALLOC( size * capacity );
+	this->pending = MM_CALLOC( capacity, sizeof( *this->pending ) );
+
+	if ( !this->buffer || !this->pending ) {
+		MM_FREE( this->buffer );
+		MM_FREE( this->pending );
+		return false;
+	}
+
+	this->sched = sched;
+	this->size = size;
+	this->capacity = capacity;
+	this->head = 0;
+	this->tail = 0;
+	this->subs = 0;
+	this->closed = false;
+	mm_sched_event_init( &this->senders );
+	mm_sched_event_init( &this->receivers );
+
+	return true;
+}
+
+void mm_chan_bcast_destroy( struct mm_chan_bcast *this ) {
+	MM_FREE( this->buffer );
+	MM_FREE( this->pending );
+	this->buffer = NULL;
+	this->pending = NULL;
+}
+
+enum mm_chan_status mm_chan_bcast_try_send( struct mm_chan_bcast *this, const void *value ) {
+	size_t slot;
+
+	if ( this->closed ) {
+		return MM_CHAN_CLOSED;
+	}
+
+	if ( this->tail - this->head == this->capacity ) {
+		return MM_CHAN_AGAIN;
+	}
+
+	if ( !this->subs ) {
+		return MM_CHAN_OK;
+	}
+
+	slot = this->tail++ % this->capacity;
+	memcpy( this->buffer + slot * this->size, value, this->size );
+	this->pending[ slot ] = this->subs;
+	mm_sched_event_broadcast( this->sched, &this->receivers );
+
+	// room for more, hand it to the next sender in line
+	if ( this->tail - this->head < this->capacity ) {
+		mm_sched_event_signal( this->sched, &this->senders );
+	}
+
+	return MM_CHAN_OK;
+}
+
+void mm_chan_bcast_close( struct mm_chan_bcast *this ) {
+	this->closed = true;
+	mm_sched_event_broadcast( this->sched, &this->senders );
+	mm_sched_event_broadcast( this->sched, &this->receivers );
+}
+
+// subscribers receive in order, so slots are released in order too
+static void bcast_release( struct mm_chan_bcast *this, uint_least64_t seq ) {
+	if ( --this->pending[ seq % this->capacity ] || seq != this->head ) {
+		return;
+	}
+
+	while ( this->head != this->tail && !this->pending[ this->head % this->capacity ] ) {
+		++this->head;
+	}
+
+	mm_sched_event_signal( this->sched, &this->senders );
+}
+
+void mm_chan_sub_init( struct mm_chan_sub *this, struct mm_chan_bcast *bcast ) {
+	this->bcast = bcast;
+	this->cursor = bcast->tail;
+	++bcast->subs;
+}
+
+void mm_chan_sub_destroy( struct mm_chan_sub *this ) {
+	struct mm_chan_bcast *bcast = this->bcast;
+
+	for ( ; this->cursor != bcast->tail; ++this->cursor ) {
+		bcast_release( bcast, this->cursor );
+	}
+
+	--bcast->subs;
+}
+
+enum mm_chan_status mm_chan_sub_try_recv( struct mm_chan_sub *this, void *value ) {
+	struct mm_chan_bcast *bcast = this->bcast;
+
+	if ( this->cursor == bcast->tail ) {
+		return bcast->closed ? MM_CHAN_CLOSED : MM_CHAN_AGAIN;
+	}
+
+	memcpy( value, bcast->buffer + this->cursor % bcast->capacity * bcast->size, bcast->size );
+	bcast_release( bcast, this->cursor++ );
+
+	return MM_CHAN_OK;
+}
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include "mm/assert.h"
+#include "mm/cmap.h"
+
+#define MIN_SLOTS 16
+
+static struct mm_cmap_table* table_new( size_t slots ) {
+	struct mm_cmap_table *table = MM_MALLOC( sizeof( *table ) + sizeof( table->slots[ 0 ] ) * slots );
+
+	if ( !table ) {
+		return NULL;
+	}
+
+	table->mask = slots - 1;
+	table->retired = NULL;
+
+	for ( size_t i = 0; i < slots; ++i ) {
+		atomic_init( &table->slots[ i ].key, 0 );
+		atomic_init( &table->slots[ i ].value, MM_CMAP_EMPTY );
+	}
+
+	return table;
+}
+
+static void table_free( struct mm_cmap_table *table ) {
+	while ( table ) {
+		struct mm_cmap_table *retired = table->retired;
+
+		MM_FREE( table );
+		table = retired;
+	}
+}
+
+static inline size_t segment_count( const struct mm_cmap *this ) {
+	return this->shift < 64 ? ( size_t ) 1 << ( 64 - this->shift ) : 1;
+}
+
+static inline size_t max_load( size_t slots ) {
+	return slots / MM_CMAP_LOAD_DEN * MM_CMAP_LOAD_NUM;
+}
+
+// replace the segment table with one sized for size + 1 keys and no tombstones, caller holds the lock
+static bool segment_rehash( struct mm_cmap *this, struct mm_cmap_segment *segment ) {
+	struct mm_cmap_table *old = atomic_load_explicit( &segment->table, memory_order_relaxed );
+	struct mm_cmap_table *table;
+	size_t slots = MIN_SLOTS;
+
+	while ( max_load( slots ) < ( segment->size + 1 ) * 2 ) {
+		slots *= 2;
+	}
+
+	if ( !( table = table_new( slots ) ) ) {
+		return false;
+	}
+
+	// the new table is private until published, so plain relaxed copies suffice
+	for ( size_t i = 0; i <= old->mask; ++i ) {
+		uintptr_t value = atomic_load_explicit( &old->slots[ i ].value, memory_order_relaxed );
+
+		if ( value != MM_CMAP_EMPTY && value != MM_CMAP_DELETED ) {
+			uint_least64_t key = atomic_load_explicit( &old->slots[ i ].key, memory_order_relaxed );
+			size_t idx = mm_hash_u64( key, this->seed ) & table->mask;
+
+			while ( atomic_load_explicit( &table->slots[ idx ].value, memory_order_relaxed ) != MM_CMAP_EMPTY ) {
+				idx = ( idx + 1 ) & table->mask;
+			}
+
+			atomic_store_explicit( &table->slots[ idx ].key, key, memory_order_relaxed );
+			atomic_store_explicit( &table->slots[ idx ].value, value, memory_order_relaxed );
+		}
+	}
+
+	// readers may still be probing the old table, keep it until mm_cmap_reclaim()
+	table->retired = old;
+	segment->used = segment->size;
+	atomic_store_explicit( &segment->table, table, memory_order_release );
+
+	return true;
+}
+
+bool mm_cmap_init( struct mm_cmap *this, size_t segments ) {
+	size_t count = 1;
+	unsigned int bits = 0;
+
+	segments = segments ? segments : MM_CMAP_SEGMENTS;
+
+	while ( count < segments ) {
+		count *= 2;
+		++bits;
+	}
+
+	this->segments = MM_ALIGNED_ALLOC( alignof( struct mm_cmap_segment ), sizeof( *this->segments ) * count );
+	this->shift = 64 - bits;
+	this->seed = mm_hash_seed();
+
+	if ( !this->segments ) {
+		return false;
+	}
+
+	for ( size_t i = 0; i < count; ++i ) {
+		struct mm_cmap_table *table = table_new( MIN_SLOTS );
+
+		if ( !table || mtx_init( &this->segments[ i ].lock, mtx_plain ) != thrd_success ) {
+			MM_FREE( table );
+
+			while ( i-- ) {
+				table_free( atomic_load_explicit( &this->segments[ i ].table, memory_order_relaxed ) );
+				mtx_destroy( &this->segments[ i ].lock );
+			}
+
+			MM_FREE( this->segments );
+			this->segments = NULL;
+
+			return false;
+		}
+
+		atomic_init( &this->segments[ i ].table, table );
+		this->segments[ i ].size = 0;
+		this->segments[ i ].used = 0;
+	}
+
+	return true;
+}
+
+void mm_cmap_destroy( struct mm_cmap *this ) {
+	size_t count = segment_count( this );
+
+	if ( !this->segments ) {
+		return;
+	}
+
+	for ( size_t i = 0; i < count; ++i ) {
+		table_free( atomic_load_explicit( &this->segments[ i ].table, memory_order_relaxed ) );
+		mtx_destroy( &this->segments[ i ].lock );
+	}
+
+	MM_FREE( this->segments );
+	this->segments = NULL;
+}
+
+bool mm_cmap_insert( struct mm_cmap *this, uint_least64_t key, void *value ) {
+	uint_least64_t hash = mm_hash_u64( key, this->seed );
+	struct mm_cmap_segment *segment = mm_cmap_segment( this, hash );
+	struct mm_cmap_table *table;
+	size_t reuse = SIZE_MAX;
+	size_t idx;
+
+	MM_ASSERT( ( uintptr_t ) value != MM_CMAP_EMPTY && ( uintptr_t ) value != MM_CMAP_DELETED );
+	mtx_lock( &segment->lock );
+	table = atomic_load_explicit( &segment->table, memory_order_relaxed );
+
+	for ( idx = hash & table->mask;; idx = ( idx + 1 ) & table->mask ) {
+		uintptr_t current = atomic_load_explicit( &table->slots[ idx ].value, memory_order_relaxed );
+
+		if ( current == MM_CMAP_EMPTY ) {
+			break;
+		}
+
+		if ( current == MM_CMAP_DELETED ) {
+			reuse = reuse == SIZE_MAX ? idx : reuse;
+		} else if ( atomic_load_explicit( &table->slots[ idx ].key, memory_order_relaxed ) == key ) {
+			atomic_store_explicit( &table->slots[ idx ].value, ( uintptr_t ) value, memory_order_release );
+			mtx_unlock( &segment->lock );
+
+			return true;
+		}
+	}
+
+	// only taking an empty slot raises the load, reusing a tombstone doesn't
+	if ( reuse == SIZE_MAX ) {
+		if ( segment->used + 1 > max_load( table->mask + 1 ) ) {
+			if ( !segment_rehash( this, segment ) ) {
+				mtx_unlock( &segment->lock );
+				return false;
+			}
+
+			table = atomic_load_explicit( &segment->table, memory_order_relaxed );
+			idx = hash & table->mask;
+
+			while ( atomic_load_explicit( &table->slots[ idx ].value, memory_order_relaxed ) != MM_CMAP_EMPTY ) {
+				idx = ( idx + 1 ) & table->mask;
+			}
+		}
+
+		reuse = idx;
+		++segment->used;
+	}
+
+	// key first, a reader that sees the value is guaranteed to see the key
+	atomic_store_explicit( &table->slots[ reuse ].key, key, memory_order_release );
+	atomic_store_explicit( &table->slots[ reuse ].value, ( uintptr_t ) value, memory_order_release );
+	++segment->size;
+	mtx_unlock( &segment->lock );
+
+	return true;
+}
+
+bool mm_cmap_erase( struct mm_cmap *this, uint_least64_t key, void **value ) {
+	uint_least64_t hash = mm_hash_u64( key, this->seed );
+	struct mm_cmap_segment *segment = mm_cmap_segment( this, hash );
+	struct mm_cmap_table *table;
+
+	mtx_lock( &segment->lock );
+	table = atomic_load_explicit( &segment->table, memory_order_relaxed );
+
+	for ( size_t idx = hash & table->mask;; idx = ( idx + 1 ) & table->mask ) {
+		uintptr_t current = atomic_load_explicit( &table->slots[ idx ].value, memory_order_relaxed );
+
+		if ( current == MM_CMAP_EMPTY ) {
+			break;
+		}
+
+		if ( current != MM_CMAP_DELETED && atomic_load_explicit( &table->slots[ idx ].key, memory_order_relaxed ) == key ) {
+			if ( value ) {
+				*value = ( void* ) current;
+			}
+
+			atomic_store_explicit( &table->slots[ idx ].value, MM_CMAP_DELETED, memory_order_release );
+			--segment->size;
+			mtx_unlock( &segment->lock );
+
+			return true;
+		}
+	}
+
+	mtx_unlock( &segment->lock );
+
+	return false;
+}
+
+size_t mm_cmap_size( struct mm_cmap *this ) {
+	size_t count = segment_count( this );
+	size_t size = 0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		mtx_lock( &this->segments[ i ].lock );
+		size += this->segments[ i ].size;
+		mtx_unlock( &this->segments[ i ].lock );
+	}
+
+	return size;
+}
+
+void mm_cmap_reclaim( struct mm_cmap *this ) {
+	size_t count = segment_count( this );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		struct mm_cmap_table *table;
+
+		mtx_lock( &this->segments[ i ].lock );
+		table = atomic_load_explicit( &this->segments[ i ].table, memory_order_relaxed );
+		table_free( table->retired );
+		table->retired = NULL;
+		mtx_unlock( &this->segments[ i ].lock );
+	}
+}
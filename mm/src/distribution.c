@@ -0,0 +1,331 @@
+#include <math.h>
+#include <stdlib.h>
+#include <threads.h>
+#include "mm/distribution.h"
+#include "mm/hash.h"
+
+/*
+	zipf, rejection-inversion
+
+	H is an integral of the density h( x ) = x^-s, the sampler inverts H at a uniform point and rounds
+	to the nearest rank, rejecting the few points where the rounded rank overshoots the histogram.
+	the helpers keep H and its inverse accurate for s close to 1, where ( 1 - s ) log x vanishes.
+*/
+static double helper1( double x ) {
+	return fabs( x ) > 1e-8 ? log1p( x ) / x : 1.0 - x * ( 0.5 - x * ( 1.0 / 3.0 - 0.25 * x ) );
+}
+
+static double helper2( double x ) {
+	return fabs( x ) > 1e-8 ? expm1( x ) / x : 1.0 + x * 0.5 * ( 1.0 + x * ( 1.0 / 3.0 ) * ( 1.0 + 0.25 * x ) );
+}
+
+static double zipf_h( double s, double x ) {
+	return exp( -s * log( x ) );
+}
+
+static double zipf_integral( double s, double x ) {
+	double l = log( x );
+
+	return helper2( ( 1.0 - s ) * l ) * l;
+}
+
+static double zipf_inverse( double s, double x ) {
+	double t = x * ( 1.0 - s );
+
+	return exp( helper1( t < -1.0 ? -1.0 : t ) * x );
+}
+
+bool mm_zipf_init( struct mm_zipf *this, uint_least64_t n, double s ) {
+	if ( !n || !( s > 0.0 ) || !isfinite( s ) ) {
+		return false;
+	}
+
+	this->n = n;
+	this->s = s;
+	this->h_x1 = zipf_integral( s, 1.5 ) - 1.0;
+	this->h_n = zipf_integral( s, ( double ) n + 0.5 );
+	this->cutoff = 2.0 - zipf_inverse( s, zipf_integral( s, 2.5 ) - zipf_h( s, 2.0 ) );
+
+	return true;
+}
+
+uint_least64_t mm_zipf_next( const struct mm_zipf *this, struct mm_random *r ) {
+	for ( ;; ) {
+		double u = this->h_n + mm_random_double( r ) * ( this->h_x1 - this->h_n );
+		double x = zipf_inverse( this->s, u );
+		double k = floor( x + 0.5 );
+
+		if ( !( k >= 1.0 ) ) {
+			k = 1.0;
+		} else if ( k > ( double ) this->n ) {
+			k = ( double ) this->n;
+		}
+
+		if ( k - x <= this->cutoff || u >= zipf_integral( this->s, k + 0.5 ) - zipf_h( this->s, k ) ) {
+			return ( uint_least64_t ) k - 1;
+		}
+	}
+}
+
+void mm_zipf_fill( const struct mm_zipf *this, struct mm_random *r, uint_least64_t *out, size_t count ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		out[ i ] = mm_zipf_next( this, r );
+	}
+}
+
+/*
+	ziggurat, Marsaglia and Tsang with 256 layers
+
+	x[ i ] is the right edge of layer i, layer 0 is the base strip with the tail folded into its width.
+	one 64 bit draw gives the layer from its low 8 bits and the position from its high 53, most samples
+	land inside the part of their layer that is under the curve and cost a multiply and a compare.
+*/
+#define LAYERS 256
+
+struct ziggurat {
+	double x[ LAYERS + 1 ];
+	double ratio[ LAYERS ]; //!< \brief x[ i + 1 ] / x[ i ], samples below it are accepted at once
+	double r;
+};
+
+static struct ziggurat normal;
+static struct ziggurat exponential;
+static once_flag tables = ONCE_FLAG_INIT;
+
+static void ziggurat_init( struct ziggurat *this, double r, double v, double ( *f )( double ), double ( *f_inv )( double ) ) {
+	this->r = r;
+	this->x[ 0 ] = v / f( r );
+	this->x[ 1 ] = r;
+
+	for ( size_t i = 1; i < LAYERS - 1; ++i ) {
+		this->x[ i + 1 ] = f_inv( v / this->x[ i ] + f( this->x[ i ] ) );
+	}
+
+	this->x[ LAYERS ] = 0.0;
+
+	for ( size_t i = 0; i < LAYERS; ++i ) {
+		this->ratio[ i ] = this->x[ i + 1 ] / this->x[ i ];
+	}
+}
+
+static double normal_f( double x ) {
+	return exp( -0.5 * x * x );
+}
+
+static double normal_f_inv( double y ) {
+	return sqrt( -2.0 * log( y ) );
+}
+
+static double exponential_f( double x ) {
+	return exp( -x );
+}
+
+static double exponential_f_inv( double y ) {
+	return -log( y );
+}
+
+static void tables_init( void ) {
+	ziggurat_init( &normal, 3.6541528853610088, 0.00492867323399, normal_f, normal_f_inv );
+	ziggurat_init( &exponential, 7.69711747013104972, 0.0039496598225815571993, exponential_f, exponential_f_inv );
+}
+
+// uniform in ( 0, 1 ], safe to take the log of
+static double open_unit( struct mm_random *r ) {
+	return 1.0 - mm_random_double( r );
+}
+
+static double exponential_next( struct mm_random *r ) {
+	const struct ziggurat *z = &exponential;
+
+	for ( ;; ) {
+		uint_least64_t bits = mm_random_u64( r );
+		size_t i = bits & ( LAYERS - 1 );
+		double u = ( double ) ( bits >> 11 ) * 0x1.0p-53;
+		double x = u * z->x[ i ];
+
+		if ( u < z->ratio[ i ] ) {
+			return x;
+		}
+
+		// the tail is an exponential again, shifted by r
+		if ( i == 0 ) {
+			return z->r - log( open_unit( r ) );
+		}
+
+		// between the curve at the two edges of the layer, relative to the curve at x
+		if ( exp( x - z->x[ i ] ) + mm_random_double( r ) * ( exp( x - z->x[ i + 1 ] ) - exp( x - z->x[ i ] ) ) < 1.0 ) {
+			return x;
+		}
+	}
+}
+
+static double normal_next( struct mm_random *r ) {
+	const struct ziggurat *z = &normal;
+
+	for ( ;; ) {
+		uint_least64_t bits = mm_random_u64( r );
+		size_t i = bits & ( LAYERS - 1 );
+		double u = ( double ) ( bits >> 11 ) * 0x1.0p-52 - 1.0;
+		double x = u * z->x[ i ];
+
+		if ( fabs( u ) < z->ratio[ i ] ) {
+			return x;
+		}
+
+		// Marsaglia's tail, beyond r
+		if ( i == 0 ) {
+			double a, b;
+
+			do {
+				a = -log( open_unit( r ) ) / z->r;
+				b = -log( open_unit( r ) );
+			} while ( b + b < a * a );
+
+			return u < 0.0 ? -z->r - a : z->r + a;
+		}
+
+		if ( exp( -0.5 * ( z->x[ i + 1 ] * z->x[ i + 1 ] - x * x ) )
+			+ mm_random_double( r ) * ( exp( -0.5 * ( z->x[ i ] * z->x[ i ] - x * x ) ) - exp( -0.5 * ( z->x[ i + 1 ] * z->x[ i + 1 ] - x * x ) ) ) < 1.0 ) {
+			return x;
+		}
+	}
+}
+
+double mm_random_exponential( struct mm_random *r ) {
+	call_once( &tables, tables_init );
+
+	return exponential_next( r );
+}
+
+void mm_random_exponential_fill( struct mm_random *r, double *out, size_t count ) {
+	call_once( &tables, tables_init );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		out[ i ] = exponential_next( r );
+	}
+}
+
+double mm_random_normal( struct mm_random *r ) {
+	call_once( &tables, tables_init );
+
+	return normal_next( r );
+}
+
+void mm_random_normal_fill( struct mm_random *r, double *out, size_t count ) {
+	call_once( &tables, tables_init );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		out[ i ] = normal_next( r );
+	}
+}
+
+/*
+	alias method
+
+	every column holds its own index up to threshold and the alias above it, a draw picks the column
+	with the high half of u * count and flips the biased coin with the low half.
+*/
+bool mm_alias_init( struct mm_alias *this, const double *weights, size_t count ) {
+	double *scaled;
+	size_t *small;
+	size_t *large;
+	size_t smalls = 0;
+	size_t larges = 0;
+	double sum = 0.0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		if ( !( weights[ i ] >= 0.0 ) || !isfinite( weights[ i ] ) ) {
+			return false;
+		}
+
+		sum += weights[ i ];
+	}
+
+	if ( !count || !( sum > 0.0 ) || !isfinite( sum ) ) {
+		return false;
+	}
+
+	this->count = count;
+	this->threshold = MM_MALLOC( sizeof( *this->threshold ) * count );
+	this->alias = MM_MALLOC( sizeof( *this->alias ) * count );
+	scaled = MM_MALLOC( sizeof( *scaled ) * count );
+	small = MM_MALLOC( sizeof( *small ) * count );
+	large = MM_MALLOC( sizeof( *large ) * count );
+
+	if ( !this->threshold || !this->alias || !scaled || !small || !large ) {
+		MM_FREE( large );
+		MM_FREE( small );
+		MM_FREE( scaled );
+		mm_alias_destroy( this );
+		return false;
+	}
+
+	for ( size_t i = 0; i < count; ++i ) {
+		scaled[ i ] = weights[ i ] * ( double ) count / sum;
+		this->alias[ i ] = i;
+
+		if ( scaled[ i ] < 1.0 ) {
+			small[ smalls++ ] = i;
+		} else {
+			large[ larges++ ] = i;
+		}
+	}
+
+	// Vose: every short column is topped up by a tall one, which may become short in turn
+	while ( smalls && larges ) {
+		size_t less = small[ --smalls ];
+		size_t more = large[ --larges ];
+
+		this->threshold[ less ] = ( uint_least64_t ) ( scaled[ less ] * 0x1.0p64 );
+		this->alias[ less ] = more;
+		scaled[ more ] = ( scaled[ more ] + scaled[ less ] ) - 1.0;
+
+		if ( scaled[ more ] < 1.0 ) {
+			small[ smalls++ ] = more;
+		} else {
+			large[ larges++ ] = more;
+		}
+	}
+
+	// whatever is left is full up to rounding
+	while ( larges ) {
+		this->threshold[ large[ --larges ] ] = UINT64_MAX;
+	}
+
+	while ( smalls ) {
+		this->threshold[ small[ --smalls ] ] = UINT64_MAX;
+	}
+
+	MM_FREE( large );
+	MM_FREE( small );
+	MM_FREE( scaled );
+
+	return true;
+}
+
+void mm_alias_destroy( struct mm_alias *this ) {
+	MM_FREE( this->threshold );
+	MM_FREE( this->alias );
+	this->threshold = NULL;
+	this->alias = NULL;
+	this->count = 0;
+}
+
+static inline size_t alias_next( const struct mm_alias *this, struct mm_random *r ) {
+	uint_least64_t lo = mm_random_u64( r );
+	uint_least64_t hi = this->count;
+
+	mm_hash_mum( &lo, &hi );
+
+	return lo < this->threshold[ hi ] ? ( size_t ) hi : this->alias[ hi ];
+}
+
+size_t mm_alias_next( const struct mm_alias *this, struct mm_random *r ) {
+	return alias_next( this, r );
+}
+
+void mm_alias_fill( const struct mm_alias *this, struct mm_random *r, size_t *out, size_t count ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		out[ i ] = alias_next( this, r );
+	}
+}
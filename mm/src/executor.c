@@ -0,0 +1,421 @@
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+#define _GNU_SOURCE
+#endif
+#include <stdlib.h>
+#include <unistd.h>
+#include "mm/executor.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// rounds of stealing before a worker goes to sleep
+#define SPINS 64
+
+#define TASK_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_executor_task, list )
+
+static _Thread_local struct mm_executor_worker *self;
+
+static void deque_init( struct mm_executor_deque *this ) {
+	atomic_init( &this->top, 0 );
+	atomic_init( &this->bottom, 0 );
+
+	for ( size_t i = 0; i < MM_EXECUTOR_DEQUE; ++i ) {
+		atomic_init( &this->tasks[ i ], NULL );
+	}
+}
+
+// owner only, false when full
+static bool deque_push( struct mm_executor_deque *this, struct mm_executor_task *task ) {
+	long long bottom = atomic_load_explicit( &this->bottom, memory_order_relaxed );
+	long long top = atomic_load_explicit( &this->top, memory_order_acquire );
+
+	if ( bottom - top >= MM_EXECUTOR_DEQUE ) {
+		return false;
+	}
+
+	atomic_store_explicit( &this->tasks[ bottom & ( MM_EXECUTOR_DEQUE - 1 ) ], task, memory_order_relaxed );
+	atomic_thread_fence( memory_order_release );
+	atomic_store_explicit( &this->bottom, bottom + 1, memory_order_relaxed );
+
+	return true;
+}
+
+// owner only, newest first
+static struct mm_executor_task* deque_pop( struct mm_executor_deque *this ) {
+	long long bottom = atomic_load_explicit( &this->bottom, memory_order_relaxed ) - 1;
+	struct mm_executor_task *task = NULL;
+	long long top;
+
+	atomic_store_explicit( &this->bottom, bottom, memory_order_relaxed );
+	atomic_thread_fence( memory_order_seq_cst );
+	top = atomic_load_explicit( &this->top, memory_order_relaxed );
+
+	if ( top <= bottom ) {
+		task = atomic_load_explicit( &this->tasks[ bottom & ( MM_EXECUTOR_DEQUE - 1 ) ], memory_order_relaxed );
+
+		if ( top == bottom ) {
+			// the last task, race the thieves for it
+			if ( !atomic_compare_exchange_strong_explicit( &this->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed ) ) {
+				task = NULL;
+			}
+
+			atomic_store_explicit( &this->bottom, bottom + 1, memory_order_relaxed );
+		}
+	} else {
+		atomic_store_explicit( &this->bottom, bottom + 1, memory_order_relaxed );
+	}
+
+	return task;
+}
+
+// any thread, oldest first, NULL if empty or another thread won the race
+static struct mm_executor_task* deque_steal( struct mm_executor_deque *this ) {
+	long long top = atomic_load_explicit( &this->top, memory_order_acquire );
+	long long bottom;
+	struct mm_executor_task *task;
+
+	atomic_thread_fence( memory_order_seq_cst );
+	bottom = atomic_load_explicit( &this->bottom, memory_order_acquire );
+
+	if ( top >= bottom ) {
+		return NULL;
+	}
+
+	task = atomic_load_explicit( &this->tasks[ top & ( MM_EXECUTOR_DEQUE - 1 ) ], memory_order_relaxed );
+
+	if ( !atomic_compare_exchange_strong_explicit( &this->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed ) ) {
+		return NULL;
+	}
+
+	return task;
+}
+
+static bool deque_empty( struct mm_executor_deque *this ) {
+	return atomic_load_explicit( &this->bottom, memory_order_acquire ) <= atomic_load_explicit( &this->top, memory_order_acquire );
+}
+
+static void shared_push( struct mm_executor *this, struct mm_executor_task *task ) {
+	mtx_lock( &this->shared_lock );
+	mm_list_add_tail( &this->shared, &task->list );
+	atomic_fetch_add_explicit( &this->shared_size, 1, memory_order_relaxed );
+	mtx_unlock( &this->shared_lock );
+}
+
+static struct mm_executor_task* shared_pop( struct mm_executor *this ) {
+	struct mm_executor_task *task = NULL;
+
+	if ( !atomic_load_explicit( &this->shared_size, memory_order_relaxed ) ) {
+		return NULL;
+	}
+
+	mtx_lock( &this->shared_lock );
+
+	if ( !mm_list_empty( &this->shared ) ) {
+		task = TASK_OF( this->shared.next );
+		mm_list_del( &task->list );
+		atomic_fetch_sub_explicit( &this->shared_size, 1, memory_order_relaxed );
+	}
+
+	mtx_unlock( &this->shared_lock );
+
+	return task;
+}
+
+// pairs with the sleeping increment in park(), one of the two sides always sees the other
+static void notify( struct mm_executor *this ) {
+	atomic_thread_fence( memory_order_seq_cst );
+
+	if ( atomic_load_explicit( &this->sleeping, memory_order_relaxed ) ) {
+		mtx_lock( &this->park_lock );
+		cnd_signal( &this->park );
+		mtx_unlock( &this->park_lock );
+	}
+}
+
+static void enqueue( struct mm_executor *this, struct mm_executor_task *task ) {
+	if ( !self || self->executor != this || !deque_push( &self->deque, task ) ) {
+		shared_push( this, task );
+	}
+
+	notify( this );
+}
+
+static bool has_work( struct mm_executor *this ) {
+	if ( atomic_load_explicit( &this->shared_size, memory_order_relaxed ) ) {
+		return true;
+	}
+
+	for ( unsigned int i = 0; i < this->count; ++i ) {
+		if ( !deque_empty( &this->workers[ i ].deque ) ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static struct mm_executor_task* steal( struct mm_executor_worker *worker ) {
+	struct mm_executor *this = worker->executor;
+	unsigned int start;
+
+	// xorshift, only used to spread the thieves
+	worker->seed ^= worker->seed << 13;
+	worker->seed ^= worker->seed >> 7;
+	worker->seed ^= worker->seed << 17;
+	start = ( unsigned int ) ( worker->seed % this->count );
+
+	for ( unsigned int i = 0; i < this->count; ++i ) {
+		struct mm_executor_worker *victim = &this->workers[ ( start + i ) % this->count ];
+		struct mm_executor_task *task;
+
+		if ( victim != worker && ( task = deque_steal( &victim->deque ) ) ) {
+			return task;
+		}
+	}
+
+	return shared_pop( this );
+}
+
+static void park( struct mm_executor *this ) {
+	mtx_lock( &this->park_lock );
+	atomic_fetch_add_explicit( &this->sleeping, 1, memory_order_seq_cst );
+	atomic_thread_fence( memory_order_seq_cst );
+
+	if ( !has_work( this ) && !atomic_load_explicit( &this->stop, memory_order_acquire ) ) {
+		cnd_wait( &this->park, &this->park_lock );
+	}
+
+	atomic_fetch_sub_explicit( &this->sleeping, 1, memory_order_relaxed );
+	mtx_unlock( &this->park_lock );
+}
+
+static void retire( struct mm_executor *this, struct mm_executor_task *task ) {
+	if ( this->retire ) {
+		this->retire( task, this->ctx );
+	}
+
+	if ( atomic_fetch_sub_explicit( &this->live, 1, memory_order_acq_rel ) == 1 ) {
+		mtx_lock( &this->park_lock );
+		cnd_broadcast( &this->idle );
+		mtx_unlock( &this->park_lock );
+	}
+}
+
+static void run( struct mm_executor_worker *worker, struct mm_executor_task *task ) {
+	struct mm_executor *this = worker->executor;
+	int state = MM_EXECUTOR_RUNNING;
+
+	// seq_cst, so the task can't read its wake condition before a waker can see it running
+	atomic_exchange( &task->state, MM_EXECUTOR_RUNNING );
+
+	switch ( task->func( task ) ) {
+		case MM_CO_SUSPENDED:
+			atomic_store_explicit( &task->state, MM_EXECUTOR_SCHEDULED, memory_order_relaxed );
+			shared_push( this, task );
+			break;
+
+		case MM_CO_WAITING:
+			if ( atomic_compare_exchange_strong_explicit( &task->state, &state, MM_EXECUTOR_IDLE, memory_order_acq_rel, memory_order_acquire ) ) {
+				break;
+			}
+
+			// woken while it ran, so it goes straight back into the queue
+			atomic_store_explicit( &task->state, MM_EXECUTOR_SCHEDULED, memory_order_relaxed );
+			enqueue( this, task );
+			break;
+
+		case MM_CO_DONE:
+			atomic_store_explicit( &task->state, MM_EXECUTOR_DONE, memory_order_release );
+			retire( this, task );
+			break;
+	}
+}
+
+#ifdef __linux__
+static void pin( struct mm_executor_worker *worker ) {
+	long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+	cpu_set_t set;
+
+	if ( cpus > 0 ) {
+		CPU_ZERO( &set );
+		CPU_SET( worker->index % ( unsigned long ) cpus, &set );
+		pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+	}
+}
+#else
+static void pin( struct mm_executor_worker *worker ) {
+	( void ) worker;
+}
+#endif
+
+static int worker_main( void *arg ) {
+	struct mm_executor_worker *worker = arg;
+	struct mm_executor *this = worker->executor;
+	unsigned int spins = 0;
+
+	self = worker;
+
+	if ( this->pin ) {
+		pin( worker );
+	}
+
+	while ( !atomic_load_explicit( &this->stop, memory_order_acquire ) ) {
+		struct mm_executor_task *task = deque_pop( &worker->deque );
+
+		if ( !task ) {
+			task = steal( worker );
+		}
+
+		if ( task ) {
+			run( worker, task );
+			spins = 0;
+		} else if ( ++spins < SPINS ) {
+			thrd_yield();
+		} else {
+			park( this );
+			spins = 0;
+		}
+	}
+
+	return 0;
+}
+
+bool mm_executor_init( struct mm_executor *this, unsigned int workers, bool pin, mm_executor_retire_t retire, void *ctx ) {
+	unsigned int started = 0;
+
+	if ( !workers ) {
+		long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+		workers = cpus > 0 ? ( unsigned int ) cpus : 1;
+	}
+
+	this->workers = MM_ALIGNED_ALLOC( alignof( struct mm_executor_worker ), sizeof( *this->workers ) * workers );
+
+	if ( !this->workers ) {
+		return false;
+	}
+
+	this->count = workers;
+	this->pin = pin;
+	this->retire = retire;
+	this->ctx = ctx;
+	mm_list_init( &this->shared );
+	atomic_init( &this->shared_size, 0 );
+	atomic_init( &this->sleeping, 0 );
+	atomic_init( &this->stop, false );
+	atomic_init( &this->live, 0 );
+
+	if ( mtx_init( &this->shared_lock, mtx_plain ) != thrd_success ) {
+		goto err_shared;
+	}
+
+	if ( mtx_init( &this->park_lock, mtx_plain ) != thrd_success ) {
+		goto err_park_lock;
+	}
+
+	if ( cnd_init( &this->park ) != thrd_success ) {
+		goto err_park;
+	}
+
+	if ( cnd_init( &this->idle ) != thrd_success ) {
+		goto err_idle;
+	}
+
+	for ( unsigned int i = 0; i < workers; ++i ) {
+		deque_init( &this->workers[ i ].deque );
+		this->workers[ i ].executor = this;
+		this->workers[ i ].index = i;
+		this->workers[ i ].seed = 0x9E3779B97F4A7C15ull * ( i + 1 );
+	}
+
+	for ( ; started < workers; ++started ) {
+		if ( thrd_create( &this->workers[ started ].thread, worker_main, &this->workers[ started ] ) != thrd_success ) {
+			goto err_threads;
+		}
+	}
+
+	return true;
+
+err_threads:
+	atomic_store( &this->stop, true );
+	mtx_lock( &this->park_lock );
+	cnd_broadcast( &this->park );
+	mtx_unlock( &this->park_lock );
+
+	while ( started-- ) {
+		thrd_join( this->workers[ started ].thread, NULL );
+	}
+
+	cnd_destroy( &this->idle );
+err_idle:
+	cnd_destroy( &this->park );
+err_park:
+	mtx_destroy( &this->park_lock );
+err_park_lock:
+	mtx_destroy( &this->shared_lock );
+err_shared:
+	MM_FREE( this->workers );
+
+	return false;
+}
+
+void mm_executor_destroy( struct mm_executor *this ) {
+	atomic_store( &this->stop, true );
+	mtx_lock( &this->park_lock );
+	cnd_broadcast( &this->park );
+	mtx_unlock( &this->park_lock );
+
+	for ( unsigned int i = 0; i < this->count; ++i ) {
+		thrd_join( this->workers[ i ].thread, NULL );
+	}
+
+	cnd_destroy( &this->idle );
+	cnd_destroy( &this->park );
+	mtx_destroy( &this->park_lock );
+	mtx_destroy( &this->shared_lock );
+	MM_FREE( this->workers );
+}
+
+void mm_executor_spawn( struct mm_executor *this, struct mm_executor_task *task, mm_executor_func_t func ) {
+	task->func = func;
+	mm_list_init( &task->list );
+	atomic_store_explicit( &task->state, MM_EXECUTOR_SCHEDULED, memory_order_relaxed );
+	atomic_fetch_add_explicit( &this->live, 1, memory_order_relaxed );
+	enqueue( this, task );
+}
+
+void mm_executor_wake( struct mm_executor *this, struct mm_executor_task *task ) {
+	int state;
+
+	// pairs with the exchange in run(), scheduled then means the task hasn't looked at what the caller published
+	atomic_thread_fence( memory_order_seq_cst );
+	state = atomic_load( &task->state );
+
+	for ( ;; ) {
+		if ( state == MM_EXECUTOR_IDLE ) {
+			if ( atomic_compare_exchange_weak_explicit( &task->state, &state, MM_EXECUTOR_SCHEDULED, memory_order_acq_rel, memory_order_acquire ) ) {
+				enqueue( this, task );
+				return;
+			}
+		} else if ( state == MM_EXECUTOR_RUNNING ) {
+			if ( atomic_compare_exchange_weak_explicit( &task->state, &state, MM_EXECUTOR_NOTIFIED, memory_order_acq_rel, memory_order_acquire ) ) {
+				return;
+			}
+		} else {
+			return;
+		}
+	}
+}
+
+void mm_executor_wait( struct mm_executor *this ) {
+	mtx_lock( &this->park_lock );
+
+	while ( atomic_load_explicit( &this->live, memory_order_acquire ) ) {
+		cnd_wait( &this->idle, &this->park_lock );
+	}
+
+	mtx_unlock( &this->park_lock );
+}
@@ -0,0 +1,297 @@
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mm/fiber.h"
+
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+static _Thread_local struct mm_fiber *current;
+
+// fibers start here on their own stack, never returns
+static void fiber_main( struct mm_fiber *this );
+
+#ifndef MM_FIBER_UCONTEXT
+
+#if defined( __APPLE__ )
+#define SYM( name ) "_" #name
+#define LOCAL( name ) ".private_extern " SYM( name ) "\n"
+#elif defined( __ELF__ )
+#define SYM( name ) #name
+#define LOCAL( name ) ".hidden " SYM( name ) "\n.type " SYM( name ) ", %function\n"
+#else
+#define SYM( name ) #name
+#define LOCAL( name )
+#endif
+
+#define ENTRY( name )\
+	".globl " SYM( name ) "\n"\
+	LOCAL( name )\
+	".p2align 4\n"\
+	SYM( name ) ":\n"
+
+/*
+	mm_fiber_switch( save, load ) pushes the callee saved registers, stores the stack pointer to *save,
+	continues on the stack load points to and pops what was pushed there. Caller saved registers are
+	already spilled by the compiler around the call, so nothing else has to be kept.
+
+	mm_fiber_start is where the return address of a new stack points, it calls the entry point kept
+	in a callee saved register with the fiber as its argument.
+*/
+#if defined( __x86_64__ )
+// rbp, rbx, r12 - r15, then the sse and x87 control words
+#define FRAME_WORDS 8
+#define FRAME_RET 7
+#define FRAME_ARG 4
+#define FRAME_FUNC 3
+
+__asm__(
+	".text\n"
+	ENTRY( mm_fiber_switch )
+	"pushq %rbp\n"
+	"pushq %rbx\n"
+	"pushq %r12\n"
+	"pushq %r13\n"
+	"pushq %r14\n"
+	"pushq %r15\n"
+	"subq $8, %rsp\n"
+	"stmxcsr (%rsp)\n"
+	"fnstcw 4(%rsp)\n"
+	"movq %rsp, (%rdi)\n"
+	"movq %rsi, %rsp\n"
+	"ldmxcsr (%rsp)\n"
+	"fldcw 4(%rsp)\n"
+	"addq $8, %rsp\n"
+	"popq %r15\n"
+	"popq %r14\n"
+	"popq %r13\n"
+	"popq %r12\n"
+	"popq %rbx\n"
+	"popq %rbp\n"
+	"ret\n"
+	ENTRY( mm_fiber_start )
+	"movq %r12, %rdi\n"
+	"callq *%r13\n"
+	"ud2\n"
+);
+#elif defined( __aarch64__ )
+// x19 - x30, then d8 - d15
+#define FRAME_WORDS 20
+#define FRAME_RET 11
+#define FRAME_ARG 0
+#define FRAME_FUNC 1
+
+__asm__(
+	".text\n"
+	ENTRY( mm_fiber_switch )
+	"sub sp, sp, #160\n"
+	"stp x19, x20, [sp, #0]\n"
+	"stp x21, x22, [sp, #16]\n"
+	"stp x23, x24, [sp, #32]\n"
+	"stp x25, x26, [sp, #48]\n"
+	"stp x27, x28, [sp, #64]\n"
+	"stp x29, x30, [sp, #80]\n"
+	"stp d8, d9, [sp, #96]\n"
+	"stp d10, d11, [sp, #112]\n"
+	"stp d12, d13, [sp, #128]\n"
+	"stp d14, d15, [sp, #144]\n"
+	"mov x9, sp\n"
+	"str x9, [x0]\n"
+	"mov sp, x1\n"
+	"ldp x19, x20, [sp, #0]\n"
+	"ldp x21, x22, [sp, #16]\n"
+	"ldp x23, x24, [sp, #32]\n"
+	"ldp x25, x26, [sp, #48]\n"
+	"ldp x27, x28, [sp, #64]\n"
+	"ldp x29, x30, [sp, #80]\n"
+	"ldp d8, d9, [sp, #96]\n"
+	"ldp d10, d11, [sp, #112]\n"
+	"ldp d12, d13, [sp, #128]\n"
+	"ldp d14, d15, [sp, #144]\n"
+	"add sp, sp, #160\n"
+	"ret\n"
+	ENTRY( mm_fiber_start )
+	"mov x0, x19\n"
+	"blr x20\n"
+	"brk #0\n"
+);
+#endif
+
+void mm_fiber_switch( void **save, void *load );
+void mm_fiber_start( void );
+
+static void context_init( struct mm_fiber *this ) {
+	// the top of the stack is page aligned, so the frame lands 16 byte aligned as both ABIs want
+	uint_least64_t *frame = ( uint_least64_t* ) ( ( unsigned char* ) this->stack + this->pool->stack_size ) - FRAME_WORDS;
+
+	memset( frame, 0, sizeof( *frame ) * FRAME_WORDS );
+	frame[ FRAME_RET ] = ( uint_least64_t ) ( uintptr_t ) mm_fiber_start;
+	frame[ FRAME_ARG ] = ( uint_least64_t ) ( uintptr_t ) this;
+	frame[ FRAME_FUNC ] = ( uint_least64_t ) ( uintptr_t ) fiber_main;
+#if defined( __x86_64__ )
+	// default mxcsr and x87 control word
+	frame[ 0 ] = ( uint_least64_t ) 0x037F << 32 | 0x1F80;
+#endif
+	this->sp = frame;
+}
+
+static inline void context_switch_in( struct mm_fiber *this ) {
+	mm_fiber_switch( &this->caller_sp, this->sp );
+}
+
+static inline void context_switch_out( struct mm_fiber *this ) {
+	mm_fiber_switch( &this->sp, this->caller_sp );
+}
+
+#else
+
+// makecontext only passes int arguments, so the pointer is split in two halves
+static void context_entry( unsigned int hi, unsigned int lo ) {
+	fiber_main( ( struct mm_fiber* ) ( uintptr_t ) ( ( uint_least64_t ) hi << 32 | lo ) );
+}
+
+static void context_init( struct mm_fiber *this ) {
+	uint_least64_t ptr = ( uintptr_t ) this;
+
+	getcontext( &this->context );
+	this->context.uc_stack.ss_sp = this->stack;
+	this->context.uc_stack.ss_size = this->pool->stack_size;
+	this->context.uc_link = NULL;
+	makecontext( &this->context, ( void ( * )( void ) ) context_entry, 2, ( unsigned int ) ( ptr >> 32 ), ( unsigned int ) ptr );
+}
+
+static inline void context_switch_in( struct mm_fiber *this ) {
+	swapcontext( &this->caller, &this->context );
+}
+
+static inline void context_switch_out( struct mm_fiber *this ) {
+	swapcontext( &this->context, &this->caller );
+}
+
+#endif
+
+static void fiber_main( struct mm_fiber *this ) {
+	this->func( this, this->arg );
+	this->state = MM_CO_DONE;
+
+	// nothing resumes a finished fiber, so this never comes back
+	context_switch_out( this );
+}
+
+bool mm_fiber_pool_init( struct mm_fiber_pool *this, size_t stack_size, size_t max_cached ) {
+	size_t page = ( size_t ) sysconf( _SC_PAGESIZE );
+
+	this->stack_size = ( stack_size + page - 1 ) / page * page;
+	this->guard_size = page;
+	this->max_cached = max_cached;
+	this->cached = 0;
+	this->free = NULL;
+
+	return mtx_init( &this->lock, mtx_plain ) == thrd_success;
+}
+
+void mm_fiber_pool_destroy( struct mm_fiber_pool *this ) {
+	while ( this->free ) {
+		void *stack = this->free;
+
+		this->free = *( void** ) stack;
+		munmap( ( unsigned char* ) stack - this->guard_size, this->guard_size + this->stack_size );
+	}
+
+	this->cached = 0;
+	mtx_destroy( &this->lock );
+}
+
+static void* stack_acquire( struct mm_fiber_pool *this ) {
+	unsigned char *map;
+	void *stack;
+
+	mtx_lock( &this->lock );
+	stack = this->free;
+
+	if ( stack ) {
+		this->free = *( void** ) stack;
+		--this->cached;
+	}
+
+	mtx_unlock( &this->lock );
+
+	if ( stack ) {
+		return stack;
+	}
+
+	map = mmap( NULL, this->guard_size + this->stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0 );
+
+	if ( map == MAP_FAILED ) {
+		return NULL;
+	}
+
+	// stacks grow down, an overflow runs into the guard page and faults instead of corrupting memory
+	if ( mprotect( map, this->guard_size, PROT_NONE ) ) {
+		munmap( map, this->guard_size + this->stack_size );
+		return NULL;
+	}
+
+	return map + this->guard_size;
+}
+
+static void stack_release( struct mm_fiber_pool *this, void *stack ) {
+	mtx_lock( &this->lock );
+
+	if ( this->cached < this->max_cached ) {
+		*( void** ) stack = this->free;
+		this->free = stack;
+		++this->cached;
+		stack = NULL;
+	}
+
+	mtx_unlock( &this->lock );
+
+	if ( stack ) {
+		munmap( ( unsigned char* ) stack - this->guard_size, this->guard_size + this->stack_size );
+	}
+}
+
+bool mm_fiber_init( struct mm_fiber *this, struct mm_fiber_pool *pool, mm_fiber_func_t func, void *arg ) {
+	this->pool = pool;
+	this->stack = stack_acquire( pool );
+
+	if ( !this->stack ) {
+		return false;
+	}
+
+	this->func = func;
+	this->arg = arg;
+	this->prev = NULL;
+	this->state = MM_CO_SUSPENDED;
+	context_init( this );
+
+	return true;
+}
+
+void mm_fiber_destroy( struct mm_fiber *this ) {
+	stack_release( this->pool, this->stack );
+	this->stack = NULL;
+}
+
+enum mm_co_state mm_fiber_resume( struct mm_fiber *this ) {
+	if ( this->state == MM_CO_DONE ) {
+		return MM_CO_DONE;
+	}
+
+	this->prev = current;
+	current = this;
+	context_switch_in( this );
+	current = this->prev;
+
+	return this->state;
+}
+
+void mm_fiber_yield( struct mm_fiber *this ) {
+	context_switch_out( this );
+}
+
+struct mm_fiber* mm_fiber_self( void ) {
+	return current;
+}
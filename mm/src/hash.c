@@ -0,0 +1,156 @@
+#include <stdatomic.h>
+#include <time.h>
+#include "mm/hash.h"
+#include "mm/random.h"
+
+static atomic_uint_least64_t process_seed;
+
+static inline void hash_block( const unsigned char *p, uint_least64_t seed[ 3 ] ) {
+	seed[ 0 ] = mm_hash_mix( mm_hash_read64( p ) ^ MM_HASH_SECRET_1, mm_hash_read64( p + 8 ) ^ seed[ 0 ] );
+	seed[ 1 ] = mm_hash_mix( mm_hash_read64( p + 16 ) ^ MM_HASH_SECRET_2, mm_hash_read64( p + 24 ) ^ seed[ 1 ] );
+	seed[ 2 ] = mm_hash_mix( mm_hash_read64( p + 32 ) ^ MM_HASH_SECRET_3, mm_hash_read64( p + 40 ) ^ seed[ 2 ] );
+}
+
+// last 1 to MM_HASH_BLOCK bytes, the 16 bytes before p must be readable when len is less than 16
+static inline uint_least64_t hash_tail( const unsigned char *p, size_t len, uint_least64_t seed, uint_least64_t total ) {
+	while ( len > 16 ) {
+		seed = mm_hash_mix( mm_hash_read64( p ) ^ MM_HASH_SECRET_1, mm_hash_read64( p + 8 ) ^ seed );
+		p += 16;
+		len -= 16;
+	}
+
+	return mm_hash_finish( mm_hash_read64( p + len - 16 ), mm_hash_read64( p + len - 8 ), seed, total );
+}
+
+uint_least64_t mm_hash_long( const void *data, size_t len, uint_least64_t seed ) {
+	const unsigned char *p = data;
+	size_t left = len;
+
+	if ( left > MM_HASH_BLOCK ) {
+		uint_least64_t seeds[ 3 ] = { seed, seed, seed };
+
+		do {
+			hash_block( p, seeds );
+			p += MM_HASH_BLOCK;
+			left -= MM_HASH_BLOCK;
+		} while ( left > MM_HASH_BLOCK );
+
+		seed = seeds[ 0 ] ^ seeds[ 1 ] ^ seeds[ 2 ];
+	}
+
+	return hash_tail( p, left, seed, len );
+}
+
+uint_least64_t mm_hash_seed( void ) {
+	uint_least64_t seed = atomic_load_explicit( &process_seed, memory_order_relaxed );
+	uint_least64_t expected = 0;
+	uint_least64_t entropy;
+	struct mm_random r;
+	struct timespec ts;
+
+	if ( seed ) {
+		return seed;
+	}
+
+	// stack and library addresses differ between runs with ASLR
+	timespec_get( &ts, TIME_UTC );
+	entropy = mm_hash_mix( ( uint_least64_t ) ts.tv_sec ^ ( uintptr_t ) &ts,
+	                       ( uint_least64_t ) ts.tv_nsec ^ ( uintptr_t ) &process_seed );
+
+	mm_random_reset( &r, ( unsigned long ) entropy );
+	seed = ( uint_least64_t ) mm_random_next( &r, 0, 0xFFFFFFFF ) << 32;
+	seed |= mm_random_next( &r, 0, 0xFFFFFFFF );
+	seed = mm_hash_mix( seed ^ entropy, MM_HASH_SECRET_2 ) | 1;
+
+	// threads racing on the first call all end up with the winner's seed
+	if ( !atomic_compare_exchange_strong_explicit( &process_seed, &expected, seed, memory_order_relaxed, memory_order_relaxed ) ) {
+		seed = expected;
+	}
+
+	return seed;
+}
+
+void mm_hash_u64_batch( const uint_least64_t *keys, size_t count, uint_least64_t seed, uint_least64_t *out ) {
+	seed = mm_hash_seed_mix( seed );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		unsigned char bytes[ 8 ];
+
+		memcpy( bytes, &keys[ i ], sizeof( bytes ) );
+		out[ i ] = mm_hash_short( bytes, sizeof( bytes ), seed );
+	}
+}
+
+void mm_hash_bytes_batch( const void *const *data, const size_t *lens, size_t count, uint_least64_t seed, uint_least64_t *out ) {
+	seed = mm_hash_seed_mix( seed );
+
+	for ( size_t i = 0; i < count; ++i ) {
+		out[ i ] = lens[ i ] <= 16 ? mm_hash_short( data[ i ], lens[ i ], seed ) : mm_hash_long( data[ i ], lens[ i ], seed );
+	}
+}
+
+void mm_hash_init( struct mm_hash_state *this, uint_least64_t seed ) {
+	seed = mm_hash_seed_mix( seed );
+
+	this->seed[ 0 ] = seed;
+	this->seed[ 1 ] = seed;
+	this->seed[ 2 ] = seed;
+	this->total = 0;
+	this->pending = 0;
+}
+
+// a block is only consumed once more data follows it, so the final step always has pending bytes
+void mm_hash_update( struct mm_hash_state *this, const void *data, size_t len ) {
+	const unsigned char *p = data;
+	unsigned char *pending = this->buffer + 16;
+
+	this->total += len;
+
+	if ( this->pending + len <= MM_HASH_BLOCK ) {
+		if ( len ) {
+			memcpy( pending + this->pending, p, len );
+			this->pending += len;
+		}
+
+		return;
+	}
+
+	if ( this->pending ) {
+		size_t fill = MM_HASH_BLOCK - this->pending;
+
+		memcpy( pending + this->pending, p, fill );
+		p += fill;
+		len -= fill;
+
+		hash_block( pending, this->seed );
+		memcpy( this->buffer, pending + MM_HASH_BLOCK - 16, 16 );
+		this->pending = 0;
+	}
+
+	if ( len > MM_HASH_BLOCK ) {
+		do {
+			hash_block( p, this->seed );
+			p += MM_HASH_BLOCK;
+			len -= MM_HASH_BLOCK;
+		} while ( len > MM_HASH_BLOCK );
+
+		memcpy( this->buffer, p - 16, 16 );
+	}
+
+	memcpy( pending, p, len );
+	this->pending = len;
+}
+
+uint_least64_t mm_hash_final( const struct mm_hash_state *this ) {
+	uint_least64_t seed = this->seed[ 0 ];
+
+	if ( this->total <= 16 ) {
+		return mm_hash_short( this->buffer + 16, this->pending, seed );
+	}
+
+	if ( this->total > MM_HASH_BLOCK ) {
+		seed ^= this->seed[ 1 ] ^ this->seed[ 2 ];
+	}
+
+	return hash_tail( this->buffer + 16, this->pending, seed, this->total );
+}
@@ -0,0 +1,116 @@
+#include "mm/itree.h"
+
+static inline uint_least64_t max_end( const struct mm_rbtree_node *node ) {
+	return MM_CONTAINER_OF( node, struct mm_itree_node, node )->max_end;
+}
+
+static inline bool compute_max_end( struct mm_itree_node *this ) {
+	uint_least64_t max = this->end;
+
+	if ( this->node.lhs && max_end( this->node.lhs ) > max ) {
+		max = max_end( this->node.lhs );
+	}
+
+	if ( this->node.rhs && max_end( this->node.rhs ) > max ) {
+		max = max_end( this->node.rhs );
+	}
+
+	if ( this->max_end == max ) {
+		return false;
+	}
+
+	this->max_end = max;
+	return true;
+}
+
+MM_RBTREE_AUGMENT_CALLBACKS( static, augment, struct mm_itree_node, node, max_end, compute_max_end );
+
+void mm_itree_insert( struct mm_itree *this, struct mm_itree_node *node ) {
+	struct mm_rbtree_node **link = &this->tree.root;
+	struct mm_rbtree_node *parent = NULL;
+
+	// equal starts go right, so equal intervals keep insertion order
+	while ( *link ) {
+		parent = *link;
+
+		if ( node->start < MM_ITREE_NODE( parent )->start ) {
+			link = &parent->lhs;
+		} else {
+			link = &parent->rhs;
+		}
+	}
+
+	node->max_end = node->end;
+	mm_rbtree_link( &node->node, parent, link );
+	mm_rbtree_insert_augmented( &this->tree, &node->node, &augment );
+}
+
+void mm_itree_erase( struct mm_itree *this, struct mm_itree_node *node ) {
+	mm_rbtree_erase_augmented( &this->tree, &node->node, &augment );
+}
+
+// left most node in the subtree overlapping [ start, end ]
+static struct mm_itree_node* subtree_search( struct mm_itree_node *node, uint_least64_t start, uint_least64_t end ) {
+	for ( ;; ) {
+		// anything on the left starts earlier, so prefer it if it reaches start
+		if ( node->node.lhs && start <= max_end( node->node.lhs ) ) {
+			node = MM_ITREE_NODE( node->node.lhs );
+			continue;
+		}
+
+		if ( node->start > end ) {
+			return NULL;
+		}
+
+		if ( start <= node->end ) {
+			return node;
+		}
+
+		if ( node->node.rhs && start <= max_end( node->node.rhs ) ) {
+			node = MM_ITREE_NODE( node->node.rhs );
+			continue;
+		}
+
+		return NULL;
+	}
+}
+
+struct mm_itree_node* mm_itree_first_overlap( const struct mm_itree *this, uint_least64_t start, uint_least64_t end ) {
+	if ( !this->tree.root || max_end( this->tree.root ) < start ) {
+		return NULL;
+	}
+
+	return subtree_search( MM_ITREE_NODE( this->tree.root ), start, end );
+}
+
+struct mm_itree_node* mm_itree_next_overlap( const struct mm_itree_node *this, uint_least64_t start, uint_least64_t end ) {
+	struct mm_rbtree_node *node = ( struct mm_rbtree_node* ) &this->node;
+	struct mm_rbtree_node *rhs = node->rhs;
+	struct mm_rbtree_node *prev;
+
+	for ( ;; ) {
+		if ( rhs && start <= max_end( rhs ) ) {
+			return subtree_search( MM_ITREE_NODE( rhs ), start, end );
+		}
+
+		// climb until we come up from a left child, that parent is the next in order
+		do {
+			prev = node;
+			node = mm_rbtree_parent( node );
+
+			if ( !node ) {
+				return NULL;
+			}
+
+			rhs = node->rhs;
+		} while ( prev == rhs );
+
+		if ( MM_ITREE_NODE( node )->start > end ) {
+			return NULL;
+		}
+
+		if ( start <= MM_ITREE_NODE( node )->end ) {
+			return MM_ITREE_NODE( node );
+		}
+	}
+}
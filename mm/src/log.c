@@ -1,6 +1,44 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include "mm/log.h"
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+#define BATCH ( IOV_MAX < 1024 ? IOV_MAX : 1024 )
+
+// the writer checks the rings this often while nothing asks it to hurry
+#define IDLE_NS 1000000
+
+#define RECORD_PAD 0x1
+#define RECORD_DEFER 0x2 //!< \brief tsc, site and the packed arguments of a MM_LOG_DEFER()
+#define RECORD_DEFINE 0x4 //!< \brief site description, binary mode only
+
+#define ALIGN8( x ) ( ( ( x ) + 7 ) & ~( size_t ) 7 )
+
+// largest record, a deferred one with every string sharing MM_LOG_MAX_MESSAGE bytes
+#define RECORD_MAX ALIGN8( sizeof( struct record ) + 16 + 16 * MM_LOG_MAX_ARGS + MM_LOG_MAX_MESSAGE + 1 )
+
+#define BINARY_MAGIC "MMLOGB1"
+#define RECORDER_MAGIC "MMLOGFR"
+#define CALIBRATE_NS 10000000
+
+static bool syslog_open;
+
+atomic_int mm_log_threshold = MM_LOG_SEVERITY( MM_INFO );
+
 void mm_openlog( const char *name, enum mm_log_facility facility ) {
 #ifdef MM_USING_SYSLOG
 	if ( !facility ) {
@@ -8,39 +46,1313 @@ void mm_openlog( const char *name, enum mm_log_facility facility ) {
 	}
 
 	openlog( name, 0, facility );
+	syslog_open = true;
+#else
+	( void ) name;
+	( void ) facility;
 #endif
 }
 
 void mm_closelog( void ) {
 #ifdef MM_USING_SYSLOG
+	syslog_open = false;
 	closelog();
 #endif
 }
 
-static inline void vlog( FILE *f, enum mm_log_level level, const char *prefix, const char *format, va_list args ) {
+static const char* prefix( enum mm_log_level level ) {
+	switch( level ) {
+		case MM_INFO: return "";
+		case MM_WARN: return "\033[34mWARNING\033[0m: ";
+		case MM_ERR: return "\033[31mERROR\033[0m: ";
+		case MM_CRIT: return "\033[31mCRITICAL\033[0m: ";
+	}
+
+	return "";
+}
+
+/*
+	async mode
+
+	every thread owns a single producer single consumer byte ring, records never wrap, a pad record
+	fills the end of the ring instead. rings are pushed onto a list the first time a thread logs and
+	stay there until the thread exits and the writer drained them.
+
+	a deferred record is the tsc, the site pointer and one 8 byte slot per argument, a string slot
+	holds the length and is followed by the bytes, terminated and padded to 8. in binary mode records
+	go out as they are, behind a header and a RECORD_DEFINE the first time a site shows up in the run.
+*/
+struct record {
+	uint_least32_t size; //!< \brief bytes up to the next record, a multiple of 8
+	uint_least16_t len;
+	unsigned char level;
+	unsigned char flags;
+};
+
+struct ring {
+	alignas( 64 ) atomic_size_t head; //!< \brief written by the writer thread
+	alignas( 64 ) atomic_size_t tail; //!< \brief written by the owner
+	size_t cached_head; //!< \brief owner's last look at head
+	atomic_bool busy; //!< \brief owner is between checking the mode and publishing
+	atomic_bool orphaned; //!< \brief owner exited, the next thread to log takes the ring over
+	atomic_uint_least64_t dropped; //!< \brief since the writer last reported
+	unsigned char *data;
+	size_t size;
+	struct ring *next;
+};
+
+static struct {
+	atomic_bool enabled;
+	_Atomic( struct ring* ) rings;
+	atomic_uint_least64_t dropped;
+	int fd;
+	size_t ring_size;
+	enum mm_log_overflow overflow;
+	thrd_t writer;
+	mtx_t lock;
+	cnd_t wake;
+	atomic_bool hurry; //!< \brief a ring is more than half full, or a caller waits on flush
+	atomic_bool stop;
+	bool binary;
+	atomic_uint epoch; //!< \brief bumped by every start, sites describe themselves once per run
+} async;
+
+static _Thread_local struct ring *local;
+static once_flag once = ONCE_FLAG_INIT;
+static bool ready; //!< \brief init_once succeeded
+static tss_t owner;
+
+static void ring_orphan( void *ring ) {
+	atomic_store_explicit( &( ( struct ring* ) ring )->orphaned, true, memory_order_release );
+}
+
+static void init_once( void ) {
+	if ( mtx_init( &async.lock, mtx_plain ) != thrd_success ) {
+		return;
+	}
+
+	if ( cnd_init( &async.wake ) != thrd_success ) {
+		mtx_destroy( &async.lock );
+		return;
+	}
+
+	if ( tss_create( &owner, ring_orphan ) != thrd_success ) {
+		cnd_destroy( &async.wake );
+		mtx_destroy( &async.lock );
+		return;
+	}
+
+	ready = atexit( mm_log_async_stop ) == 0;
+}
+
+static void writer_wake( void ) {
+	atomic_store_explicit( &async.hurry, true, memory_order_relaxed );
+	mtx_lock( &async.lock );
+	cnd_signal( &async.wake );
+	mtx_unlock( &async.lock );
+}
+
+static struct ring* ring_get( void ) {
+	struct ring *ring = local;
+
+	if ( ring ) {
+		return ring;
+	}
+
+	// rings are never freed, flush and stop walk the list from any thread, so a ring left by an exited thread is reused
+	for ( ring = atomic_load_explicit( &async.rings, memory_order_acquire ); ring; ring = ring->next ) {
+		bool orphaned = true;
+
+		if ( atomic_compare_exchange_strong_explicit( &ring->orphaned, &orphaned, false, memory_order_acquire, memory_order_relaxed ) ) {
+			tss_set( owner, ring );
+			local = ring;
+
+			return ring;
+		}
+	}
+
+	ring = MM_MALLOC( sizeof( *ring ) );
+
+	if ( !ring ) {
+		return NULL;
+	}
+
+	ring->data = MM_MALLOC( async.ring_size );
+
+	if ( !ring->data ) {
+		MM_FREE( ring );
+		return NULL;
+	}
+
+	atomic_init( &ring->head, 0 );
+	atomic_init( &ring->tail, 0 );
+	atomic_init( &ring->busy, false );
+	atomic_init( &ring->orphaned, false );
+	atomic_init( &ring->dropped, 0 );
+	ring->cached_head = 0;
+	ring->size = async.ring_size;
+	ring->next = atomic_load_explicit( &async.rings, memory_order_relaxed );
+
+	while ( !atomic_compare_exchange_weak_explicit( &async.rings, &ring->next, ring, memory_order_release, memory_order_relaxed ) );
+
+	tss_set( owner, ring );
+	local = ring;
+
+	return ring;
+}
+
+// contiguous room for need bytes, NULL if the writer hasn't caught up yet
+static struct record* ring_reserve( struct ring *this, size_t need, size_t *tail ) {
+	size_t pos = atomic_load_explicit( &this->tail, memory_order_relaxed );
+	size_t end = this->size - ( pos & ( this->size - 1 ) );
+	size_t total = need <= end ? need : end + need;
+	struct record *pad;
+
+	if ( pos + total - this->cached_head > this->size ) {
+		this->cached_head = atomic_load_explicit( &this->head, memory_order_acquire );
+
+		if ( pos + total - this->cached_head > this->size ) {
+			return NULL;
+		}
+	}
+
+	if ( need > end ) {
+		pad = ( struct record* ) ( this->data + ( pos & ( this->size - 1 ) ) );
+		pad->size = ( uint_least32_t ) end;
+		pad->flags = RECORD_PAD;
+		pos += end;
+	}
+
+	*tail = pos;
+
+	return ( struct record* ) ( this->data + ( pos & ( this->size - 1 ) ) );
+}
+
+static size_t ring_used( struct ring *this ) {
+	return atomic_load_explicit( &this->tail, memory_order_relaxed ) - this->cached_head;
+}
+
+// the ring to log into, NULL if the message has to go out on the calling thread instead
+static struct ring* ring_enter( void ) {
+	struct ring *ring = ring_get();
+
+	if ( !ring ) {
+		return NULL;
+	}
+
+	// mm_log_async_stop() waits for busy to clear before the last drain, so nothing lands after it
+	atomic_store( &ring->busy, true );
+
+	if ( !atomic_load( &async.enabled ) ) {
+		atomic_store_explicit( &ring->busy, false, memory_order_release );
+		return NULL;
+	}
+
+	return ring;
+}
+
+static void ring_leave( struct ring *this ) {
+	atomic_store_explicit( &this->busy, false, memory_order_release );
+
+	if ( ring_used( this ) > this->size / 2 && !atomic_load_explicit( &async.hurry, memory_order_relaxed ) ) {
+		writer_wake();
+	}
+}
+
+static void ring_drop( struct ring *this ) {
+	atomic_fetch_add_explicit( &this->dropped, 1, memory_order_relaxed );
+	atomic_fetch_add_explicit( &async.dropped, 1, memory_order_relaxed );
+}
+
+// room for need bytes as the overflow policy allows, NULL if the message is dropped
+static struct record* ring_wait( struct ring *this, size_t need, size_t *tail ) {
+	struct record *record;
+
+	while ( !( record = ring_reserve( this, need, tail ) ) ) {
+		if ( async.overflow == MM_LOG_DROP ) {
+			return NULL;
+		}
+
+		if ( async.overflow == MM_LOG_COUNT ) {
+			ring_drop( this );
+			return NULL;
+		}
+
+		writer_wake();
+		thrd_yield();
+	}
+
+	return record;
+}
+
+static void ring_publish( struct ring *this, struct record *record, size_t tail, size_t len, unsigned char level, unsigned char flags ) {
+	size_t size = ALIGN8( sizeof( *record ) + len );
+
+	// binary mode writes the padding out as well
+	memset( ( unsigned char* ) ( record + 1 ) + len, 0, size - sizeof( *record ) - len );
+	record->size = ( uint_least32_t ) size;
+	record->len = ( uint_least16_t ) ( len > UINT16_MAX ? UINT16_MAX : len );
+	record->level = level;
+	record->flags = flags;
+	atomic_store_explicit( &this->tail, tail + size, memory_order_release );
+}
+
+// false if the message has to go out on the calling thread instead
+static bool async_vlog( enum mm_log_level level, const char *format, va_list args ) {
+	struct ring *ring = ring_enter();
+	struct record *record;
+	size_t tail;
+	int len;
+
+	if ( !ring ) {
+		return false;
+	}
+
+	if ( ( record = ring_wait( ring, ALIGN8( sizeof( *record ) + MM_LOG_MAX_MESSAGE + 1 ), &tail ) ) ) {
+		len = vsnprintf( ( char* ) ( record + 1 ), MM_LOG_MAX_MESSAGE + 1, format, args );
+
+		if ( len < 0 ) {
+			len = 0;
+		} else if ( len > MM_LOG_MAX_MESSAGE ) {
+			len = MM_LOG_MAX_MESSAGE;
+		}
+
+		ring_publish( ring, record, tail, ( size_t ) len, ( unsigned char ) level, 0 );
+	}
+
+	ring_leave( ring );
+
+	return true;
+}
+
+static void put_u64( unsigned char **pos, uint_least64_t value ) {
+	memcpy( *pos, &value, sizeof( value ) );
+	*pos += sizeof( value );
+}
+
+static uint_least64_t get_u64( const unsigned char **pos ) {
+	uint_least64_t value;
+
+	memcpy( &value, *pos, sizeof( value ) );
+	*pos += sizeof( value );
+
+	return value;
+}
+
+// key, line, level, count, types, then the file and the format, both terminated
+static void async_define( struct ring *ring, const struct mm_log_site *site ) {
+	size_t file = strlen( site->file ) + 1;
+	size_t format = strlen( site->format ) + 1;
+	size_t len = 8 + 4 + 2 + MM_LOG_MAX_ARGS + file + format;
+	struct record *record;
+	unsigned char *pos;
+	int_least32_t line = site->line;
+	size_t tail;
+
+	if ( ALIGN8( sizeof( *record ) + len ) > ring->size / 2 ) {
+		ring_drop( ring );
+		return;
+	}
+
+	if ( !( record = ring_wait( ring, ALIGN8( sizeof( *record ) + len ), &tail ) ) ) {
+		return;
+	}
+
+	pos = ( unsigned char* ) ( record + 1 );
+	put_u64( &pos, ( uint_least64_t ) ( uintptr_t ) site );
+	memcpy( pos, &line, 4 );
+	pos[ 4 ] = site->level;
+	pos[ 5 ] = site->count;
+	memcpy( pos + 6, site->types, MM_LOG_MAX_ARGS );
+	pos += 6 + MM_LOG_MAX_ARGS;
+	memcpy( pos, site->file, file );
+	memcpy( pos + file, site->format, format );
+	ring_publish( ring, record, tail, len, site->level, RECORD_DEFINE );
+}
+
+static bool async_defer( struct mm_log_site *site, const union mm_log_arg *args ) {
+	size_t lens[ MM_LOG_MAX_ARGS ];
+	size_t room = MM_LOG_MAX_MESSAGE;
+	size_t len = 16 + 8 * ( size_t ) site->count;
+	unsigned epoch = atomic_load_explicit( &async.epoch, memory_order_relaxed );
+	struct record *record;
+	unsigned char *pos;
+	struct ring *ring;
+	size_t tail;
+
+	// strings share the room a formatted message has, the rest could never show up anyway
+	for ( size_t i = 0; i < site->count; ++i ) {
+		if ( site->types[ i ] == MM_LOG_ARG_STR ) {
+			lens[ i ] = args[ i ].s ? strnlen( args[ i ].s, room ) : 0;
+			room -= lens[ i ];
+			len += ALIGN8( lens[ i ] + 1 );
+		}
+	}
+
+	if ( !( ring = ring_enter() ) ) {
+		return false;
+	}
+
+	if ( async.binary && atomic_load_explicit( &site->epoch, memory_order_relaxed ) != epoch
+		&& atomic_exchange_explicit( &site->epoch, epoch, memory_order_relaxed ) != epoch ) {
+		async_define( ring, site );
+	}
+
+	if ( ( record = ring_wait( ring, ALIGN8( sizeof( *record ) + len ), &tail ) ) ) {
+		pos = ( unsigned char* ) ( record + 1 );
+		put_u64( &pos, mm_log_tsc() );
+		put_u64( &pos, ( uint_least64_t ) ( uintptr_t ) site );
+
+		for ( size_t i = 0; i < site->count; ++i ) {
+			switch ( site->types[ i ] ) {
+				case MM_LOG_ARG_STR:
+					put_u64( &pos, lens[ i ] );
+					memcpy( pos, args[ i ].s ? args[ i ].s : "", lens[ i ] );
+					memset( pos + lens[ i ], 0, ALIGN8( lens[ i ] + 1 ) - lens[ i ] );
+					pos += ALIGN8( lens[ i ] + 1 );
+					break;
+				case MM_LOG_ARG_PTR:
+					put_u64( &pos, ( uint_least64_t ) ( uintptr_t ) args[ i ].p );
+					break;
+				default:
+					memcpy( pos, &args[ i ], 8 );
+					pos += 8;
+			}
+		}
+
+		ring_publish( ring, record, tail, len, site->level, RECORD_DEFER );
+	}
+
+	ring_leave( ring );
+
+	return true;
+}
+
+// arguments of a deferred record, NULL if they run past end
+static const unsigned char* unpack( const unsigned char *pos, const unsigned char *end, const unsigned char *types, size_t count, union mm_log_arg *args ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		uint_least64_t value;
+
+		if ( end - pos < 8 ) {
+			return NULL;
+		}
+
+		switch ( types[ i ] ) {
+			case MM_LOG_ARG_STR:
+				value = get_u64( &pos );
+
+				if ( ( size_t ) ( end - pos ) < ALIGN8( value + 1 ) || pos[ value ] ) {
+					return NULL;
+				}
+
+				args[ i ].s = ( const char* ) pos;
+				pos += ALIGN8( value + 1 );
+				break;
+			case MM_LOG_ARG_PTR:
+				args[ i ].p = ( const void* ) ( uintptr_t ) get_u64( &pos );
+				break;
+			default:
+				memcpy( &args[ i ], pos, 8 );
+				pos += 8;
+		}
+	}
+
+	return pos;
+}
+
+static void write_all( struct iovec *iov, int count ) {
+	while ( count ) {
+		ssize_t written = writev( async.fd, iov, count );
+
+		if ( written < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+
+			// nowhere to put it, dropping beats spinning
+			return;
+		}
+
+		while ( count && ( size_t ) written >= iov->iov_len ) {
+			written -= ( ssize_t ) iov->iov_len;
+			++iov;
+			--count;
+		}
+
+		if ( count ) {
+			iov->iov_base = ( char* ) iov->iov_base + written;
+			iov->iov_len -= ( size_t ) written;
+		}
+	}
+}
+
+// formats a deferred record into the arena, returns its length
+static size_t format_defer( const struct record *record, char *text, size_t size ) {
+	const unsigned char *pos = ( const unsigned char* ) ( record + 1 ) + 8;
+	const struct mm_log_site *site = ( const struct mm_log_site* ) ( uintptr_t ) get_u64( &pos );
+	union mm_log_arg args[ MM_LOG_MAX_ARGS ];
+
+	unpack( pos, ( const unsigned char* ) record + record->size, site->types, site->count, args );
+
+	return mm_log_format( text, size, site->format, site->types, args, site->count );
+}
+
+// the dropped note has to be a record too when the output is binary
+static size_t dropped_note( unsigned char *buf, size_t size, uint_least64_t lost ) {
+	struct record *record = ( struct record* ) buf;
+	char *text = ( char* ) ( record + 1 );
+	int len;
+
+	if ( !async.binary ) {
+		return ( size_t ) snprintf( ( char* ) buf, size, "%s%llu log messages dropped\n", prefix( MM_WARN ), ( unsigned long long ) lost );
+	}
+
+	len = snprintf( text, size - sizeof( *record ), "%llu log messages dropped", ( unsigned long long ) lost );
+	memset( text + len, 0, size - sizeof( *record ) - ( size_t ) len );
+	record->size = ( uint_least32_t ) ALIGN8( sizeof( *record ) + ( size_t ) len );
+	record->len = ( uint_least16_t ) len;
+	record->level = MM_WARN;
+	record->flags = 0;
+
+	return record->size;
+}
+
+// write out what the ring holds, in batches of up to BATCH / 3 messages
+static bool ring_drain( struct ring *this ) {
+	static struct iovec iov[ BATCH ];
+	static alignas( 8 ) unsigned char dropped[ 64 ];
+	static char arena[ 64 * 1024 ];
+	size_t head = atomic_load_explicit( &this->head, memory_order_relaxed );
+	size_t tail = atomic_load_explicit( &this->tail, memory_order_acquire );
+	uint_least64_t lost = atomic_exchange_explicit( &this->dropped, 0, memory_order_relaxed );
+	bool any = head != tail;
+	size_t used = 0;
+	int count = 0;
+
+	if ( lost ) {
+		iov[ count ].iov_base = dropped;
+		iov[ count++ ].iov_len = dropped_note( dropped, sizeof( dropped ), lost );
+	}
+
+	while ( head != tail ) {
+		struct record *record = ( struct record* ) ( this->data + ( head & ( this->size - 1 ) ) );
+
+		if ( record->flags & RECORD_PAD ) {
+			// nothing to write
+		} else if ( async.binary ) {
+			iov[ count ].iov_base = record;
+			iov[ count++ ].iov_len = record->size;
+		} else {
+			const char *text = prefix( record->level );
+			char *body = ( char* ) ( record + 1 );
+			size_t len = record->len;
+
+			if ( record->flags & RECORD_DEFER ) {
+				body = arena + used;
+				len = format_defer( record, body, MM_LOG_MAX_MESSAGE + 1 );
+				used += len;
+			}
+
+			iov[ count ].iov_base = ( void* ) text;
+			iov[ count++ ].iov_len = strlen( text );
+			iov[ count ].iov_base = body;
+			iov[ count++ ].iov_len = len;
+			iov[ count ].iov_base = "\n";
+			iov[ count++ ].iov_len = 1;
+#ifdef MM_USING_SYSLOG
+			if ( syslog_open ) {
+				syslog( record->level, "%.*s", ( int ) len, body );
+			}
+#endif
+		}
+
+		head += record->size;
+
+		// formatted messages point into the arena, it has to be written out before it runs out
+		if ( count > BATCH - 3 || used > sizeof( arena ) - MM_LOG_MAX_MESSAGE - 1 ) {
+			write_all( iov, count );
+			atomic_store_explicit( &this->head, head, memory_order_release );
+			count = 0;
+			used = 0;
+		}
+	}
+
+	write_all( iov, count );
+	atomic_store_explicit( &this->head, head, memory_order_release );
+
+	return any;
+}
+
+static bool drain_all( void ) {
+	bool any = false;
+
+	for ( struct ring *ring = atomic_load_explicit( &async.rings, memory_order_acquire ); ring; ring = ring->next ) {
+		any |= ring_drain( ring );
+	}
+
+	return any;
+}
+
+static uint_least64_t realtime_ns( void ) {
+	struct timespec ts;
+
+	timespec_get( &ts, TIME_UTC );
+
+	return ( uint_least64_t ) ts.tv_sec * 1000000000u + ( uint_least64_t ) ts.tv_nsec;
+}
+
+// tsc ticks per ns, and a tsc that was read at a known wall clock time
+static double calibrate( uint_least64_t *tsc, uint_least64_t *now ) {
+	struct timespec pause = { 0, CALIBRATE_NS };
+
+	*tsc = mm_log_tsc();
+	*now = realtime_ns();
+	thrd_sleep( &pause, NULL );
+
+	return ( double ) ( mm_log_tsc() - *tsc ) / ( double ) ( realtime_ns() - *now );
+}
+
+static void write_header( void ) {
+	unsigned char header[ 32 ] = BINARY_MAGIC;
+	unsigned char *pos = header + 8;
+	struct iovec iov = { header, sizeof( header ) };
+	uint_least64_t tsc;
+	uint_least64_t now;
+	double rate = calibrate( &tsc, &now );
+
+	memcpy( pos, &rate, 8 );
+	pos += 8;
+	put_u64( &pos, tsc );
+	put_u64( &pos, now );
+	write_all( &iov, 1 );
+}
+
+static int writer_main( void *arg ) {
+	( void ) arg;
+
+	if ( async.binary ) {
+		write_header();
+	}
+
+	while ( !atomic_load( &async.stop ) ) {
+		struct timespec ts;
+
+		if ( drain_all() ) {
+			continue;
+		}
+
+		timespec_get( &ts, TIME_UTC );
+		ts.tv_nsec += IDLE_NS;
+
+		if ( ts.tv_nsec >= 1000000000 ) {
+			++ts.tv_sec;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		mtx_lock( &async.lock );
+
+		if ( !atomic_exchange( &async.hurry, false ) && !atomic_load( &async.stop ) ) {
+			cnd_timedwait( &async.wake, &async.lock, &ts );
+		}
+
+		mtx_unlock( &async.lock );
+	}
+
+	while ( drain_all() );
+
+	return 0;
+}
+
+bool mm_log_async_start( const struct mm_log_async_config *config ) {
+	struct mm_log_async_config defaults = { .fd = -1, .ring_size = 0, .overflow = MM_LOG_BLOCK };
+	size_t min = 2 * RECORD_MAX;
+	size_t size = 1;
+
+	call_once( &once, init_once );
+
+	if ( !ready || atomic_load( &async.enabled ) ) {
+		return false;
+	}
+
+	if ( !config ) {
+		config = &defaults;
+	}
+
+	while ( size < config->ring_size || size < min ) {
+		size <<= 1;
+	}
+
+	// rings of threads that logged in an earlier run keep their size
+	async.ring_size = config->ring_size ? size : MM_LOG_RING_SIZE;
+	async.fd = config->fd >= 0 ? config->fd : fileno( MM_STDOUT );
+	async.overflow = config->overflow;
+	async.binary = config->binary;
+	atomic_fetch_add( &async.epoch, 1 );
+	atomic_store( &async.dropped, 0 );
+	atomic_store( &async.stop, false );
+	atomic_store( &async.hurry, false );
+	MM_FFLUSH( MM_STDOUT );
+
+	if ( thrd_create( &async.writer, writer_main, NULL ) != thrd_success ) {
+		return false;
+	}
+
+	atomic_store( &async.enabled, true );
+
+	return true;
+}
+
+void mm_log_async_stop( void ) {
+	if ( !atomic_exchange( &async.enabled, false ) ) {
+		return;
+	}
+
+	// callers that saw the mode on finish publishing before the last drain
+	for ( struct ring *ring = atomic_load( &async.rings ); ring; ring = ring->next ) {
+		while ( atomic_load( &ring->busy ) ) {
+			thrd_yield();
+		}
+	}
+
+	atomic_store( &async.stop, true );
+	writer_wake();
+	thrd_join( async.writer, NULL );
+}
+
+void mm_log_flush( void ) {
+	if ( !atomic_load( &async.enabled ) ) {
+		MM_FFLUSH( MM_STDOUT );
+		return;
+	}
+
+	for ( struct ring *ring = atomic_load( &async.rings ); ring; ring = ring->next ) {
+		size_t tail = atomic_load_explicit( &ring->tail, memory_order_acquire );
+
+		while ( atomic_load_explicit( &async.enabled, memory_order_relaxed ) && atomic_load_explicit( &ring->head, memory_order_acquire ) < tail ) {
+			writer_wake();
+			thrd_yield();
+		}
+	}
+}
+
+uint_least64_t mm_log_dropped( void ) {
+	return atomic_load_explicit( &async.dropped, memory_order_relaxed );
+}
+
+/*
+	flight recorder
+
+	a header page followed by the ring. frames are reserved with one fetch_add on pos and may wrap
+	around the end of the ring, the seal is the first word of a frame and the last thing written.
+	it depends on the position of the frame, so neither a frame from an earlier lap nor one that is
+	still being written look complete. the decoder starts one ring size before pos and steps over
+	whatever isn't sealed 8 bytes at a time.
+*/
+#define RECORDER_HEADER 4096
+#define RECORDER_MIN 4096
+#define FRAME_EVENT 0x1
+
+struct recorder {
+	char magic[ 8 ];
+	uint_least64_t size;
+	double rate;
+	uint_least64_t tsc;
+	uint_least64_t ns;
+	alignas( 64 ) atomic_uint_least64_t pos;
+};
+
+struct frame {
+	atomic_uint_least32_t seal;
+	uint_least32_t size; //!< \brief bytes up to the next frame, a multiple of 8
+	uint_least64_t tsc;
+	uint_least16_t len;
+	unsigned char level;
+	unsigned char flags;
+	uint_least32_t type;
+};
+
+static _Atomic( struct recorder* ) recorder;
+static size_t recorder_map;
+
+static uint_least32_t frame_seal( uint_least64_t pos ) {
+	return ( uint_least32_t ) ( pos >> 3 ) ^ 0x9e3779b9u;
+}
+
+static void ring_copy( unsigned char *ring, size_t size, uint_least64_t pos, const void *src, size_t len ) {
+	size_t at = ( size_t ) ( pos & ( size - 1 ) );
+	size_t end = size - at < len ? size - at : len;
+
+	memcpy( ring + at, src, end );
+	memcpy( ring, ( const unsigned char* ) src + end, len - end );
+}
+
+static void ring_peek( const unsigned char *ring, size_t size, uint_least64_t pos, void *dst, size_t len ) {
+	size_t at = ( size_t ) ( pos & ( size - 1 ) );
+	size_t end = size - at < len ? size - at : len;
+
+	memcpy( dst, ring + at, end );
+	memcpy( ( unsigned char* ) dst + end, ring, len - end );
+}
+
+static void recorder_append( struct recorder *this, unsigned char level, unsigned char flags, uint_least32_t type, const void *data, size_t len ) {
+	unsigned char *ring = ( unsigned char* ) this + RECORDER_HEADER;
+	size_t size = ( size_t ) this->size;
+	struct frame frame;
+	uint_least64_t pos;
+
+	if ( len > MM_LOG_MAX_MESSAGE ) {
+		len = MM_LOG_MAX_MESSAGE;
+	}
+
+	frame.size = ( uint_least32_t ) ALIGN8( sizeof( frame ) + len );
+	frame.tsc = mm_log_tsc();
+	frame.len = ( uint_least16_t ) len;
+	frame.level = level;
+	frame.flags = flags;
+	frame.type = type;
+	pos = atomic_fetch_add_explicit( &this->pos, frame.size, memory_order_relaxed );
+
+	// everything but the seal, which is 8 byte aligned and so never wraps
+	ring_copy( ring, size, pos + sizeof( frame.seal ), ( unsigned char* ) &frame + sizeof( frame.seal ), sizeof( frame ) - sizeof( frame.seal ) );
+	ring_copy( ring, size, pos + sizeof( frame ), data, len );
+	atomic_store_explicit( ( atomic_uint_least32_t* ) ( ring + ( pos & ( size - 1 ) ) ), frame_seal( pos ), memory_order_release );
+}
+
+bool mm_log_recorder_open( const char *path, size_t size ) {
+	struct recorder *this;
+	size_t ring = RECORDER_MIN;
+	int fd;
+
+	while ( ring < size || ( !size && ring < MM_LOG_RECORDER_SIZE ) ) {
+		ring <<= 1;
+	}
+
+	if ( atomic_load( &recorder ) || ( fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 ) ) < 0 ) {
+		return false;
+	}
+
+	if ( ftruncate( fd, ( off_t ) ( RECORDER_HEADER + ring ) ) ) {
+		close( fd );
+		return false;
+	}
+
+	this = mmap( NULL, RECORDER_HEADER + ring, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if ( this == MAP_FAILED ) {
+		return false;
+	}
+
+	memcpy( this->magic, RECORDER_MAGIC, sizeof( this->magic ) );
+	this->size = ring;
+	this->rate = calibrate( &this->tsc, &this->ns );
+	atomic_init( &this->pos, 0 );
+	recorder_map = RECORDER_HEADER + ring;
+	atomic_store( &recorder, this );
+
+	return true;
+}
+
+void mm_log_recorder_close( void ) {
+	struct recorder *this = atomic_exchange( &recorder, NULL );
+
+	if ( this ) {
+		munmap( this, recorder_map );
+	}
+}
+
+void mm_log_event( uint_least32_t type, const void *data, size_t size ) {
+	struct recorder *this = atomic_load_explicit( &recorder, memory_order_acquire );
+
+	if ( this ) {
+		recorder_append( this, 0, FRAME_EVENT, type, data, size );
+	}
+}
+
+static void print_time( FILE *out, uint_least64_t tsc, double rate, uint_least64_t tsc0, uint_least64_t ns0 ) {
+	uint_least64_t ns = ns0 + ( uint_least64_t ) ( ( double ) ( tsc - tsc0 ) / ( rate > 0.0 ? rate : 1.0 ) );
+
+	MM_FPRINTF( out, "[%llu.%09llu] ", ( unsigned long long ) ( ns / 1000000000u ), ( unsigned long long ) ( ns % 1000000000u ) );
+}
+
+// the sealed frames among the last size bytes before pos, oldest first
+static bool recorder_decode( const unsigned char *data, size_t len, FILE *out ) {
+	struct recorder header;
+	const unsigned char *ring = data + RECORDER_HEADER;
+	unsigned char body[ MM_LOG_MAX_MESSAGE ];
+	uint_least64_t end;
+	size_t size;
+
+	if ( len < sizeof( header ) ) {
+		return false;
+	}
+
+	memcpy( &header, data, sizeof( header ) );
+	size = ( size_t ) header.size;
+	end = atomic_load( &header.pos );
+
+	if ( size < RECORDER_MIN || size & ( size - 1 ) || len < RECORDER_HEADER + size ) {
+		return false;
+	}
+
+	for ( uint_least64_t pos = end > size ? ( end - size + 7 ) & ~( uint_least64_t ) 7 : 0; pos < end; ) {
+		struct frame frame;
+
+		ring_peek( ring, size, pos, &frame, sizeof( frame ) );
+
+		if ( frame.seal != frame_seal( pos ) || frame.size < sizeof( frame ) || frame.size > end - pos || frame.len > MM_LOG_MAX_MESSAGE
+			|| frame.len > frame.size - sizeof( frame ) ) {
+			pos += 8;
+			continue;
+		}
+
+		ring_peek( ring, size, pos + sizeof( frame ), body, frame.len );
+		print_time( out, frame.tsc, header.rate, header.tsc, header.ns );
+
+		if ( frame.flags & FRAME_EVENT ) {
+			MM_FPRINTF( out, "event %lu:", ( unsigned long ) frame.type );
+
+			for ( size_t i = 0; i < frame.len; ++i ) {
+				MM_FPRINTF( out, " %02x", body[ i ] );
+			}
+
+			MM_FPRINTF( out, "\n" );
+		} else {
+			MM_FPRINTF( out, "%s%.*s\n", prefix( frame.level ), ( int ) frame.len, ( const char* ) body );
+		}
+
+		pos += frame.size;
+	}
+
+	return true;
+}
+
+// one conversion of mm_log_format(), spec is the conversion with the length modifier already replaced
+static int format_arg( char *buf, size_t size, const char *spec, char conv, unsigned char type, union mm_log_arg arg ) {
+	switch ( conv ) {
+		case 'd': case 'i': case 'c':
+			switch ( type ) {
+				case MM_LOG_ARG_U64: arg.i = ( int_least64_t ) arg.u; break;
+				case MM_LOG_ARG_F64: arg.i = ( int_least64_t ) arg.f; break;
+				case MM_LOG_ARG_I64: break;
+				default: arg.i = ( int_least64_t ) ( intptr_t ) arg.p;
+			}
+
+			return conv == 'c' ? snprintf( buf, size, spec, ( int ) arg.i ) : snprintf( buf, size, spec, ( long long ) arg.i );
+		case 'u': case 'o': case 'x': case 'X':
+			switch ( type ) {
+				case MM_LOG_ARG_I64: arg.u = ( uint_least64_t ) arg.i; break;
+				case MM_LOG_ARG_F64: arg.u = ( uint_least64_t ) arg.f; break;
+				case MM_LOG_ARG_U64: break;
+				default: arg.u = ( uint_least64_t ) ( uintptr_t ) arg.p;
+			}
+
+			return snprintf( buf, size, spec, ( unsigned long long ) arg.u );
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+			switch ( type ) {
+				case MM_LOG_ARG_I64: arg.f = ( double ) arg.i; break;
+				case MM_LOG_ARG_U64: arg.f = ( double ) arg.u; break;
+				case MM_LOG_ARG_F64: break;
+				default: arg.f = 0.0;
+			}
+
+			return snprintf( buf, size, spec, arg.f );
+		case 's':
+			return snprintf( buf, size, spec, type != MM_LOG_ARG_STR ? "(?)" : arg.s ? arg.s : "(null)" );
+		case 'p':
+			return snprintf( buf, size, spec, type == MM_LOG_ARG_PTR || type == MM_LOG_ARG_STR ? arg.p : ( const void* ) ( uintptr_t ) arg.u );
+	}
+
+	return 0;
+}
+
+size_t mm_log_format( char *buf, size_t size, const char *format, const unsigned char *types, const union mm_log_arg *args, size_t count ) {
+	size_t len = 0;
+	size_t next = 0;
+
+	if ( !size ) {
+		return 0;
+	}
+
+	buf[ 0 ] = '\0';
+
+	while ( *format && len + 1 < size ) {
+		const char *pos = format + 1;
+		char spec[ 32 ];
+		size_t flags;
+		int written;
+
+		if ( *format != '%' || *pos == '%' ) {
+			buf[ len++ ] = *format;
+			format += *format == '%' ? 2 : 1;
+			continue;
+		}
+
+		pos += strspn( pos, "-+ #0" );
+		pos += strspn( pos, "0123456789" );
+
+		if ( *pos == '.' ) {
+			++pos;
+			pos += strspn( pos, "0123456789" );
+		}
+
+		flags = ( size_t ) ( pos - format );
+		pos += strspn( pos, "hljztLq" );
+
+		if ( !*pos || flags > sizeof( spec ) - 4 ) {
+			break;
+		}
+
+		// every integer was widened to 64 bits when it was captured
+		memcpy( spec, format, flags );
+		spec[ flags ] = '\0';
+
+		if ( strchr( "diouxX", *pos ) ) {
+			strcat( spec, "ll" );
+		}
+
+		strncat( spec, pos, 1 );
+		written = next < count ? format_arg( buf + len, size - len, spec, *pos, types[ next ], args[ next ] ) : 0;
+		++next;
+
+		if ( written > 0 ) {
+			len += ( size_t ) written < size - len ? ( size_t ) written : size - len - 1;
+		}
+
+		format = pos + 1;
+	}
+
+	buf[ len ] = '\0';
+
+	return len;
+}
+
+struct site_def {
+	uint_least64_t key;
+	const char *format;
+	const unsigned char *types;
+	unsigned char count;
+};
+
+static int site_def_cmp( const void *lhs, const void *rhs ) {
+	uint_least64_t a = ( ( const struct site_def* ) lhs )->key;
+	uint_least64_t b = ( ( const struct site_def* ) rhs )->key;
+
+	return ( a > b ) - ( a < b );
+}
+
+// whole input in memory, the definitions can come after the first records using them
+static unsigned char* read_all( FILE *in, size_t *size ) {
+	size_t capacity = 1 << 16;
+	unsigned char *data = MM_MALLOC( capacity );
+
+	*size = 0;
+
+	while ( data ) {
+		size_t got = fread( data + *size, 1, capacity - *size, in );
+
+		*size += got;
+
+		if ( got == 0 ) {
+			return data;
+		}
+
+		if ( *size == capacity ) {
+			unsigned char *grown = MM_REALLOC( data, capacity * 2 );
+
+			if ( !grown ) {
+				MM_FREE( data );
+				return NULL;
+			}
+
+			data = grown;
+			capacity *= 2;
+		}
+	}
+
+	return NULL;
+}
+
+// the records between begin and end, NULL if one is cut short
+static struct site_def* collect_defs( const unsigned char *begin, const unsigned char *end, size_t *count ) {
+	struct site_def *defs = NULL;
+	size_t capacity = 0;
+
+	*count = 0;
+
+	for ( const unsigned char *pos = begin; pos < end; ) {
+		struct record record;
+		const unsigned char *body = pos + sizeof( record );
+
+		if ( ( size_t ) ( end - pos ) < sizeof( record ) ) {
+			MM_FREE( defs );
+			return NULL;
+		}
+
+		memcpy( &record, pos, sizeof( record ) );
+
+		if ( record.size < sizeof( record ) || record.size % 8 || record.size > ( size_t ) ( end - pos ) ) {
+			MM_FREE( defs );
+			return NULL;
+		}
+
+		pos += record.size;
+
+		if ( !( record.flags & RECORD_DEFINE ) ) {
+			continue;
+		}
+
+		if ( *count == capacity ) {
+			struct site_def *grown = MM_REALLOC( defs, sizeof( *defs ) * ( capacity = capacity ? capacity * 2 : 64 ) );
+
+			if ( !grown ) {
+				MM_FREE( defs );
+				return NULL;
+			}
+
+			defs = grown;
+		}
+
+		// file and format are both terminated inside the record
+		if ( record.size < sizeof( record ) + 14 + MM_LOG_MAX_ARGS + 2 || pos[ -1 ] != '\0' || body[ 13 ] > MM_LOG_MAX_ARGS ) {
+			MM_FREE( defs );
+			return NULL;
+		}
+
+		defs[ *count ].key = get_u64( &body );
+		defs[ *count ].count = body[ 5 ];
+		defs[ *count ].types = body + 6;
+		body += 6 + MM_LOG_MAX_ARGS;
+		defs[ *count ].format = ( const char* ) body + strlen( ( const char* ) body ) + 1;
+
+		if ( ( const unsigned char* ) defs[ *count ].format >= pos ) {
+			MM_FREE( defs );
+			return NULL;
+		}
+
+		++*count;
+	}
+
+	qsort( defs, *count, sizeof( *defs ), site_def_cmp );
+
+	return defs ? defs : MM_MALLOC( 1 );
+}
+
+bool mm_log_decode( FILE *in, FILE *out ) {
+	char text[ MM_LOG_MAX_MESSAGE + 1 ];
+	union mm_log_arg args[ MM_LOG_MAX_ARGS ];
+	const unsigned char *pos;
+	const unsigned char *end;
+	struct site_def *defs;
+	size_t count;
+	size_t size;
+	unsigned char *data = read_all( in, &size );
+	uint_least64_t tsc0;
+	uint_least64_t ns0;
+	double rate;
+	bool ok = true;
+
+	if ( data && size >= 8 && !memcmp( data, RECORDER_MAGIC, 8 ) ) {
+		ok = recorder_decode( data, size, out );
+		MM_FREE( data );
+		return ok;
+	}
+
+	if ( !data || size < 32 || memcmp( data, BINARY_MAGIC, 8 ) ) {
+		MM_FREE( data );
+		return false;
+	}
+
+	pos = data + 8;
+	end = data + size;
+	memcpy( &rate, pos, 8 );
+	pos += 8;
+	tsc0 = get_u64( &pos );
+	ns0 = get_u64( &pos );
+
+	if ( !( defs = collect_defs( pos, end, &count ) ) ) {
+		MM_FREE( data );
+		return false;
+	}
+
+	while ( pos < end ) {
+		struct record record;
+		const unsigned char *body = pos + sizeof( record );
+		struct site_def key;
+		struct site_def *def;
+		uint_least64_t tsc;
+
+		memcpy( &record, pos, sizeof( record ) );
+		pos += record.size;
+
+		if ( !( record.flags & RECORD_DEFER ) ) {
+			if ( !( record.flags & RECORD_DEFINE ) ) {
+				MM_FPRINTF( out, "%s%.*s\n", prefix( record.level ), ( int ) record.len, ( const char* ) body );
+			}
+
+			continue;
+		}
+
+		if ( record.size < sizeof( record ) + 16 ) {
+			ok = false;
+			break;
+		}
+
+		tsc = get_u64( &body );
+		key.key = get_u64( &body );
+		def = bsearch( &key, defs, count, sizeof( *defs ), site_def_cmp );
+		print_time( out, tsc, rate, tsc0, ns0 );
+		MM_FPRINTF( out, "%s", prefix( record.level ) );
+
+		// the description was lost to an overflow
+		if ( !def || !unpack( body, pos, def->types, def->count, args ) ) {
+			MM_FPRINTF( out, "(unknown site)\n" );
+			continue;
+		}
+
+		mm_log_format( text, sizeof( text ), def->format, def->types, args, def->count );
+		MM_FPRINTF( out, "%s\n", text );
+	}
+
+	MM_FREE( defs );
+	MM_FREE( data );
+
+	return ok;
+}
+
+static inline void vlog( FILE *f, enum mm_log_level level, const char *format, va_list args ) {
 #ifdef MM_USING_SYSLOG
-	va_list tmp;
-	va_copy( tmp, args );
-	vsyslog( level, format, tmp );
+	if ( syslog_open ) {
+		va_list tmp;
+		va_copy( tmp, args );
+		vsyslog( level, format, tmp );
+		va_end( tmp );
+	}
 #endif
-	MM_FPRINTF( f, "%s", prefix );
+	MM_FPRINTF( f, "%s", prefix( level ) );
 	MM_VFPRINTF( f, format, args );
 	MM_FPRINTF( f, "\n" );
 	MM_FFLUSH( f );
 }
 
+void mm_log_set_level( enum mm_log_level level ) {
+	atomic_store_explicit( &mm_log_threshold, MM_LOG_SEVERITY( level ), memory_order_relaxed );
+}
+
+// a few ms of resolution is plenty to limit messages per second, and the coarse clock is much cheaper
+static uint_least64_t monotonic_ns( void ) {
+	struct timespec ts;
+
+#if defined( CLOCK_MONOTONIC_COARSE )
+	clock_gettime( CLOCK_MONOTONIC_COARSE, &ts );
+#elif defined( CLOCK_MONOTONIC )
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+#else
+	timespec_get( &ts, TIME_UTC );
+#endif
+
+	return ( uint_least64_t ) ts.tv_sec * 1000000000u + ( uint_least64_t ) ts.tv_nsec;
+}
+
+// generic cell rate algorithm, the token bucket kept as the time it would be full again
+bool mm_log_limit_take( struct mm_log_limit *this ) {
+	uint_least64_t interval = 1000000000u / ( this->rate ? this->rate : 1 );
+	uint_least64_t tolerance = interval * ( this->burst ? this->burst - 1 : 0 );
+	uint_least64_t next = atomic_load_explicit( &this->next, memory_order_relaxed );
+	uint_least64_t now = monotonic_ns();
+	uint_least64_t lost;
+
+	do {
+		uint_least64_t base = next > now ? next : now;
+
+		if ( base - now > tolerance ) {
+			atomic_fetch_add_explicit( &this->suppressed, 1, memory_order_relaxed );
+			return false;
+		}
+
+		if ( atomic_compare_exchange_weak_explicit( &this->next, &next, base + interval, memory_order_relaxed, memory_order_relaxed ) ) {
+			break;
+		}
+	} while ( true );
+
+	if ( ( lost = atomic_exchange_explicit( &this->suppressed, 0, memory_order_relaxed ) ) ) {
+		mm_log( this->level, "%llu messages suppressed at %s:%d", ( unsigned long long ) lost, this->file, this->line );
+	}
+
+	return true;
+}
+
+// everything but the flight recorder
+static void vlog_out( enum mm_log_level level, const char *format, va_list args ) {
+	if ( atomic_load_explicit( &async.enabled, memory_order_relaxed ) && async_vlog( level, format, args ) ) {
+		return;
+	}
+
+	vlog( MM_STDOUT, level, format, args );
+}
+
+static void log_out( enum mm_log_level level, const char *format, ... ) {
+	va_list args;
+	va_start( args, format );
+	vlog_out( level, format, args );
+	va_end( args );
+}
+
 void mm_vlog( enum mm_log_level level, const char *format, va_list args ) {
-	switch( level ) {
-		case MM_INFO: vlog( MM_STDOUT, MM_INFO, "", format, args ); break;
-		case MM_WARN: vlog( MM_STDOUT, MM_WARN, "\033[34mWARNING\033[0m: ", format, args ); break;
-		case MM_ERR: vlog( MM_STDOUT, MM_ERR, "\033[31mERROR\033[0m: ", format, args ); break;
-		case MM_CRIT: vlog( MM_STDOUT, MM_ERR, "\033[31mCRITICAL033[0m: ", format, args ); break;
+	struct recorder *rec;
+
+	if ( MM_LOG_SEVERITY( level ) < atomic_load_explicit( &mm_log_threshold, memory_order_relaxed ) ) {
+		return;
 	}
+
+	// formatted once for both, unless the message is too long for the recorder
+	if ( ( rec = atomic_load_explicit( &recorder, memory_order_acquire ) ) ) {
+		char text[ MM_LOG_MAX_MESSAGE + 1 ];
+		va_list copy;
+		int len;
+
+		va_copy( copy, args );
+		len = vsnprintf( text, sizeof( text ), format, args );
+
+		if ( len > MM_LOG_MAX_MESSAGE ) {
+			recorder_append( rec, ( unsigned char ) level, 0, 0, text, MM_LOG_MAX_MESSAGE );
+			vlog_out( level, format, copy );
+		} else {
+			recorder_append( rec, ( unsigned char ) level, 0, 0, text, len < 0 ? 0 : ( size_t ) len );
+			log_out( level, "%s", text );
+		}
+
+		va_end( copy );
+		return;
+	}
+
+	vlog_out( level, format, args );
+}
+
+void mm_log_defer( struct mm_log_site *site, const union mm_log_arg *args ) {
+	struct recorder *rec = atomic_load_explicit( &recorder, memory_order_acquire );
+	char text[ MM_LOG_MAX_MESSAGE + 1 ];
+	size_t len = 0;
+
+	if ( rec ) {
+		len = mm_log_format( text, sizeof( text ), site->format, site->types, args, site->count );
+		recorder_append( rec, site->level, 0, 0, text, len );
+	}
+
+	if ( atomic_load_explicit( &async.enabled, memory_order_relaxed ) && async_defer( site, args ) ) {
+		return;
+	}
+
+	if ( !rec ) {
+		mm_log_format( text, sizeof( text ), site->format, site->types, args, site->count );
+	}
+
+	log_out( site->level, "%s", text );
 }
 
 void mm_log( enum mm_log_level level, const char *format, ... ) {
 	va_list args;
-	va_start( args, format );	
+	va_start( args, format );
 	mm_vlog( level, format, args );
 	va_end( args );
 }
@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include "mm/hash.h"
+#include "mm/lru.h"
+
+#define MIN_BUCKETS 16
+
+#define NODE_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_lru_node, list )
+
+static inline struct mm_lru_node** bucket( const struct mm_lru *this, uint_least64_t key ) {
+	return &this->buckets[ mm_hash_u64( key, this->seed ) & this->mask ];
+}
+
+static inline size_t protected_capacity( const struct mm_lru *this ) {
+	return this->capacity / MM_LRU_PROTECTED_DEN * MM_LRU_PROTECTED_NUM;
+}
+
+// double the bucket count, on allocation failure the chains just get longer
+static void index_grow( struct mm_lru *this ) {
+	size_t count = ( this->mask + 1 ) * 2;
+	struct mm_lru_node **buckets = MM_CALLOC( count, sizeof( *buckets ) );
+	struct mm_lru_node **old = this->buckets;
+
+	if ( !buckets ) {
+		return;
+	}
+
+	this->buckets = buckets;
+	this->mask = count - 1;
+
+	for ( size_t i = 0; i < count / 2; ++i ) {
+		struct mm_lru_node *node = old[ i ];
+
+		while ( node ) {
+			struct mm_lru_node *next = node->chain;
+			struct mm_lru_node **head = bucket( this, node->key );
+
+			node->chain = *head;
+			*head = node;
+			node = next;
+		}
+	}
+
+	MM_FREE( old );
+}
+
+static void index_remove( struct mm_lru *this, struct mm_lru_node *node ) {
+	struct mm_lru_node **pos = bucket( this, node->key );
+
+	while ( *pos != node ) {
+		pos = &( *pos )->chain;
+	}
+
+	*pos = node->chain;
+}
+
+static void unlink_node( struct mm_lru *this, struct mm_lru_node *node ) {
+	index_remove( this, node );
+	mm_list_del( &node->list );
+	this->charge -= node->charge;
+	--this->size;
+
+	if ( node->protected ) {
+		this->protected_charge -= node->charge;
+		node->protected = false;
+	}
+}
+
+// CLOCK keeps the hand at the back of the list, referenced entries are moved to the front instead of evicted
+static struct mm_lru_node* victim( struct mm_lru *this ) {
+	struct mm_list *list = mm_list_empty( &this->main ) ? &this->protected : &this->main;
+
+	if ( this->policy == MM_LRU_CLOCK ) {
+		for ( ;; ) {
+			struct mm_lru_node *node = NODE_OF( list->prev );
+
+			if ( !atomic_exchange_explicit( &node->referenced, false, memory_order_relaxed ) ) {
+				return node;
+			}
+
+			mm_list_move( list, &node->list );
+		}
+	}
+
+	return NODE_OF( list->prev );
+}
+
+static void evict_to_capacity( struct mm_lru *this ) {
+	while ( this->charge > this->capacity ) {
+		struct mm_lru_node *node = victim( this );
+
+		unlink_node( this, node );
+
+		if ( this->evict ) {
+			this->evict( node, this->ctx );
+		}
+	}
+}
+
+bool mm_lru_init( struct mm_lru *this, size_t capacity, enum mm_lru_policy policy, mm_lru_evict_t evict, void *ctx ) {
+	mm_list_init( &this->main );
+	mm_list_init( &this->protected );
+	this->buckets = MM_CALLOC( MIN_BUCKETS, sizeof( *this->buckets ) );
+	this->mask = MIN_BUCKETS - 1;
+	this->size = 0;
+	this->charge = 0;
+	this->protected_charge = 0;
+	this->capacity = capacity;
+	this->policy = policy;
+	this->evict = evict;
+	this->ctx = ctx;
+	this->seed = mm_hash_seed();
+
+	return this->buckets != NULL;
+}
+
+void mm_lru_destroy( struct mm_lru *this ) {
+	struct mm_list *lists[] = { &this->main, &this->protected };
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( lists ); ++i ) {
+		struct mm_list *pos, *tmp;
+
+		MM_LIST_FOREACH_SAFE( lists[ i ], pos, tmp ) {
+			mm_list_init( pos );
+
+			if ( this->evict ) {
+				this->evict( NODE_OF( pos ), this->ctx );
+			}
+		}
+
+		mm_list_init( lists[ i ] );
+	}
+
+	MM_FREE( this->buckets );
+	this->buckets = NULL;
+	this->size = 0;
+	this->charge = 0;
+	this->protected_charge = 0;
+}
+
+struct mm_lru_node* mm_lru_peek( const struct mm_lru *this, uint_least64_t key ) {
+	struct mm_lru_node *node = *bucket( this, key );
+
+	while ( node && node->key != key ) {
+		node = node->chain;
+	}
+
+	return node;
+}
+
+struct mm_lru_node* mm_lru_find( struct mm_lru *this, uint_least64_t key ) {
+	struct mm_lru_node *node = mm_lru_peek( this, key );
+
+	if ( !node ) {
+		return NULL;
+	}
+
+	switch ( this->policy ) {
+	case MM_LRU_LRU:
+		mm_list_move( &this->main, &node->list );
+		break;
+	case MM_LRU_CLOCK:
+		// skip the store when already set, so hot entries don't bounce between caches
+		if ( !atomic_load_explicit( &node->referenced, memory_order_relaxed ) ) {
+			atomic_store_explicit( &node->referenced, true, memory_order_relaxed );
+		}
+
+		break;
+	case MM_LRU_SLRU:
+		if ( node->protected ) {
+			mm_list_move( &this->protected, &node->list );
+			break;
+		}
+
+		node->protected = true;
+		this->protected_charge += node->charge;
+		mm_list_move( &this->protected, &node->list );
+
+		// overflow of the protected segment goes back to the front of probation
+		while ( this->protected_charge > protected_capacity( this ) ) {
+			struct mm_lru_node *demoted = NODE_OF( this->protected.prev );
+
+			demoted->protected = false;
+			this->protected_charge -= demoted->charge;
+			mm_list_move( &this->main, &demoted->list );
+		}
+
+		break;
+	}
+
+	return node;
+}
+
+void mm_lru_insert( struct mm_lru *this, struct mm_lru_node *node, uint_least64_t key, size_t charge ) {
+	struct mm_lru_node *old = mm_lru_peek( this, key );
+	struct mm_lru_node **head;
+
+	if ( old ) {
+		unlink_node( this, old );
+
+		if ( this->evict ) {
+			this->evict( old, this->ctx );
+		}
+	}
+
+	if ( this->size >= this->mask + 1 ) {
+		index_grow( this );
+	}
+
+	node->key = key;
+	node->charge = charge;
+	node->protected = false;
+	atomic_init( &node->referenced, false );
+
+	head = bucket( this, key );
+	node->chain = *head;
+	*head = node;
+	mm_list_add( &this->main, &node->list );
+	this->charge += charge;
+	++this->size;
+
+	evict_to_capacity( this );
+}
+
+void mm_lru_erase( struct mm_lru *this, struct mm_lru_node *node ) {
+	unlink_node( this, node );
+}
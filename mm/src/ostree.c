@@ -0,0 +1,58 @@
+#include "mm/ostree.h"
+
+static inline bool compute_size( struct mm_ostree_node *this ) {
+	size_t size = mm_ostree_node_size( this->node.lhs ) + mm_ostree_node_size( this->node.rhs ) + 1;
+
+	if ( this->size == size ) {
+		return false;
+	}
+
+	this->size = size;
+	return true;
+}
+
+MM_RBTREE_AUGMENT_CALLBACKS( static, augment, struct mm_ostree_node, node, size, compute_size );
+
+void mm_ostree_insert_colour( struct mm_ostree *this, struct mm_ostree_node *node ) {
+	mm_rbtree_insert_augmented( &this->tree, &node->node, &augment );
+}
+
+void mm_ostree_erase( struct mm_ostree *this, struct mm_ostree_node *node ) {
+	mm_rbtree_erase_augmented( &this->tree, &node->node, &augment );
+}
+
+struct mm_ostree_node* mm_ostree_select( const struct mm_ostree *this, size_t idx ) {
+	struct mm_rbtree_node *node = this->tree.root;
+
+	while ( node ) {
+		size_t lhs = mm_ostree_node_size( node->lhs );
+
+		if ( idx < lhs ) {
+			node = node->lhs;
+		} else if ( idx > lhs ) {
+			idx -= lhs + 1;
+			node = node->rhs;
+		} else {
+			break;
+		}
+	}
+
+	return MM_OSTREE_NODE( node );
+}
+
+size_t mm_ostree_rank( const struct mm_ostree_node *this ) {
+	const struct mm_rbtree_node *node = &this->node;
+	const struct mm_rbtree_node *parent;
+	size_t rank = mm_ostree_node_size( node->lhs );
+
+	// every time we climb out of a right subtree, the parent and its left subtree are smaller
+	while ( ( parent = mm_rbtree_parent( node ) ) ) {
+		if ( node == parent->rhs ) {
+			rank += mm_ostree_node_size( parent->lhs ) + 1;
+		}
+
+		node = parent;
+	}
+
+	return rank;
+}
@@ -1,28 +1,227 @@
+#include <stdbool.h>
+#include <string.h>
+#include <threads.h>
+#include "mm/hash.h"
 #include "mm/random.h"
 
-unsigned long mm_random_next( struct mm_random *this, unsigned long min, unsigned long max ) {
-	unsigned long tmp = this->a;
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Lemire's multiply-shift, the high half of x * range is uniform once the biased low values are rejected
+static uint_least64_t bounded( struct mm_random *this, uint_least64_t range ) {
+	uint_least64_t lo = mm_random_u64( this );
+	uint_least64_t hi = range;
+
+	mm_hash_mum( &lo, &hi );
+
+	if ( lo < range ) {
+		uint_least64_t threshold = -range % range;
+
+		while ( lo < threshold ) {
+			lo = mm_random_u64( this );
+			hi = range;
+			mm_hash_mum( &lo, &hi );
+		}
+	}
+
+	return hi;
+}
 
-	this->d = this->c;
-	this->c = this->b;
-	this->b = this->a;
+unsigned long mm_random_next( struct mm_random *this, unsigned long min, unsigned long max ) {
+	if ( max <= min ) {
+		return min;
+	}
 
-	tmp ^= tmp >> 2;
-	tmp ^= tmp << 1;
-	tmp ^= this->a ^ ( this->a << 4 );
+	return min + ( unsigned long ) bounded( this, ( uint_least64_t ) ( max - min ) );
+}
 
-	this->a = tmp;
-	this->counter += 362437;
+static uint_least64_t splitmix64( uint_least64_t *x ) {
+	uint_least64_t z = ( *x += 0x9e3779b97f4a7c15u );
 
-	tmp = this->a + this->counter;
+	z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9u;
+	z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebu;
 
-	return min + ( tmp % ( max - min ) );
+	return z ^ ( z >> 31 );
 }
 
+// splitmix64 never yields an all zero xoshiro state from a single seed
 void mm_random_reset( struct mm_random *this, unsigned long seed ) {
-	this->counter = 0;
-	this->a = seed;
-	this->b = 0;
-	this->c = 0;
-	this->d = 0;
+	uint_least64_t x = seed;
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		this->s[ i ] = splitmix64( &x );
+	}
+
+	for ( size_t lane = 0; lane < MM_RANDOM_LANES; ++lane ) {
+		for ( size_t i = 0; i < 4; ++i ) {
+			this->lanes[ i ][ lane ] = splitmix64( &x );
+		}
+	}
+}
+
+// xoshiro256 jump polynomial for 2^128 steps
+static const uint_least64_t jump[] = { 0x180ec6d33cfd0abau, 0xd5a61266f0c9392cu, 0xa9582618e03fc9aau, 0x39abdc4529b1661cu };
+
+static void jump_state( uint_least64_t *s, size_t stride ) {
+	uint_least64_t t[ 4 ] = { 0 };
+	struct mm_random r;
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		r.s[ i ] = s[ i * stride ];
+	}
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( jump ); ++i ) {
+		for ( int b = 0; b < 64; ++b ) {
+			if ( jump[ i ] & ( uint_least64_t ) 1 << b ) {
+				for ( size_t j = 0; j < 4; ++j ) {
+					t[ j ] ^= r.s[ j ];
+				}
+			}
+
+			mm_random_u64( &r );
+		}
+	}
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		s[ i * stride ] = t[ i ];
+	}
+}
+
+void mm_random_jump( struct mm_random *this ) {
+	jump_state( this->s, 1 );
+
+	for ( size_t lane = 0; lane < MM_RANDOM_LANES; ++lane ) {
+		jump_state( &this->lanes[ 0 ][ lane ], MM_RANDOM_LANES );
+	}
+}
+
+void mm_random_split( struct mm_random *this, struct mm_random *streams, size_t count ) {
+	for ( size_t i = 0; i < count; ++i ) {
+		streams[ i ] = *this;
+		mm_random_jump( this );
+	}
+}
+
+static struct mm_random process;
+static mtx_t process_lock;
+static bool process_ready; //!< \brief process_lock was created
+static once_flag process_once = ONCE_FLAG_INIT;
+static _Thread_local struct mm_random local;
+static _Thread_local bool local_ready;
+
+static void process_init( void ) {
+	process_ready = mtx_init( &process_lock, mtx_plain ) == thrd_success;
+	mm_random_reset( &process, ( unsigned long ) mm_hash_seed() );
+}
+
+struct mm_random* mm_random_local( void ) {
+	if ( !local_ready ) {
+		call_once( &process_once, process_init );
+
+		// without the lock every thread seeds its own, the address of local tells threads apart
+		if ( process_ready ) {
+			mtx_lock( &process_lock );
+			mm_random_split( &process, &local, 1 );
+			mtx_unlock( &process_lock );
+		} else {
+			mm_random_reset( &local, ( unsigned long ) ( mm_hash_seed() ^ ( uintptr_t ) &local ) );
+		}
+
+		local_ready = true;
+	}
+
+	return &local;
+}
+
+#ifdef __AVX2__
+static inline __m256i rotl256( __m256i x, int k ) {
+	return _mm256_or_si256( _mm256_slli_epi64( x, k ), _mm256_srli_epi64( x, 64 - k ) );
+}
+
+// one xoshiro256** step of every lane, multiplications by 5 and 9 as shifts and adds
+static inline __m256i step256( __m256i s[ 4 ] ) {
+	__m256i x = _mm256_add_epi64( _mm256_slli_epi64( s[ 1 ], 2 ), s[ 1 ] );
+	__m256i t = _mm256_slli_epi64( s[ 1 ], 17 );
+
+	x = rotl256( x, 7 );
+	x = _mm256_add_epi64( _mm256_slli_epi64( x, 3 ), x );
+	s[ 2 ] = _mm256_xor_si256( s[ 2 ], s[ 0 ] );
+	s[ 3 ] = _mm256_xor_si256( s[ 3 ], s[ 1 ] );
+	s[ 1 ] = _mm256_xor_si256( s[ 1 ], s[ 2 ] );
+	s[ 0 ] = _mm256_xor_si256( s[ 0 ], s[ 3 ] );
+	s[ 2 ] = _mm256_xor_si256( s[ 2 ], t );
+	s[ 3 ] = rotl256( s[ 3 ], 45 );
+
+	return x;
+}
+
+void mm_random_fill( struct mm_random *this, void *buf, size_t size ) {
+	unsigned char *out = buf;
+	__m256i s[ 4 ];
+	__m256i x;
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		s[ i ] = _mm256_loadu_si256( ( const __m256i* ) this->lanes[ i ] );
+	}
+
+	// two blocks per round, the steps of independent lanes overlap
+	for ( ; size >= 64; size -= 64, out += 64 ) {
+		_mm256_storeu_si256( ( __m256i* ) out, step256( s ) );
+		_mm256_storeu_si256( ( __m256i* ) ( out + 32 ), step256( s ) );
+	}
+
+	if ( size >= 32 ) {
+		_mm256_storeu_si256( ( __m256i* ) out, step256( s ) );
+		out += 32;
+		size -= 32;
+	}
+
+	if ( size ) {
+		unsigned char tail[ 32 ];
+
+		x = step256( s );
+		_mm256_storeu_si256( ( __m256i* ) tail, x );
+		memcpy( out, tail, size );
+	}
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		_mm256_storeu_si256( ( __m256i* ) this->lanes[ i ], s[ i ] );
+	}
+}
+#else
+// one step of every lane, the fixed trip count lets the compiler vectorize it with whatever it has
+static inline void step_lanes( uint_least64_t s[ 4 ][ MM_RANDOM_LANES ], uint_least64_t block[ MM_RANDOM_LANES ] ) {
+	for ( size_t lane = 0; lane < MM_RANDOM_LANES; ++lane ) {
+		uint_least64_t t = s[ 1 ][ lane ] << 17;
+
+		block[ lane ] = mm_random_rotl( s[ 1 ][ lane ] * 5, 7 ) * 9;
+		s[ 2 ][ lane ] ^= s[ 0 ][ lane ];
+		s[ 3 ][ lane ] ^= s[ 1 ][ lane ];
+		s[ 1 ][ lane ] ^= s[ 2 ][ lane ];
+		s[ 0 ][ lane ] ^= s[ 3 ][ lane ];
+		s[ 2 ][ lane ] ^= t;
+		s[ 3 ][ lane ] = mm_random_rotl( s[ 3 ][ lane ], 45 );
+	}
+}
+
+void mm_random_fill( struct mm_random *this, void *buf, size_t size ) {
+	uint_least64_t s[ 4 ][ MM_RANDOM_LANES ];
+	uint_least64_t block[ MM_RANDOM_LANES ];
+	unsigned char *out = buf;
+
+	memcpy( s, this->lanes, sizeof( s ) );
+
+	for ( ; size >= sizeof( block ); size -= sizeof( block ), out += sizeof( block ) ) {
+		step_lanes( s, block );
+		memcpy( out, block, sizeof( block ) );
+	}
+
+	if ( size ) {
+		step_lanes( s, block );
+		memcpy( out, block, size );
+	}
+
+	memcpy( this->lanes, s, sizeof( s ) );
 }
+#endif
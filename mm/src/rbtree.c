@@ -0,0 +1,430 @@
+#include "mm/rbtree.h"
+
+static inline bool is_red( const struct mm_rbtree_node *node ) {
+	return mm_rbtree_colour( node ) == MM_RB_RED;
+}
+
+static inline bool is_black( const struct mm_rbtree_node *node ) {
+	return mm_rbtree_colour( node ) == MM_RB_BLACK;
+}
+
+// a red node has a clear colour bit, so the raw value is the parent address
+static inline struct mm_rbtree_node* red_parent( const struct mm_rbtree_node *node ) {
+	return ( struct mm_rbtree_node* ) node->parent;
+}
+
+static inline void set_parent( struct mm_rbtree_node *node, struct mm_rbtree_node *parent ) {
+	node->parent = ( uintptr_t ) parent | mm_rbtree_colour( node );
+}
+
+static inline void set_parent_colour( struct mm_rbtree_node *node, struct mm_rbtree_node *parent, enum mm_rbtree_colour colour ) {
+	node->parent = ( uintptr_t ) parent | colour;
+}
+
+static inline void set_black( struct mm_rbtree_node *node ) {
+	node->parent |= MM_RB_BLACK;
+}
+
+static inline void change_child( struct mm_rbtree *this, struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node, struct mm_rbtree_node *parent ) {
+	if ( !parent ) {
+		this->root = new_node;
+	} else if ( parent->lhs == old_node ) {
+		parent->lhs = new_node;
+	} else {
+		parent->rhs = new_node;
+	}
+}
+
+// new_node takes the place and colour of old_node, which becomes its child
+static inline void rotate_set_parents( struct mm_rbtree *this, struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node, enum mm_rbtree_colour colour ) {
+	struct mm_rbtree_node *parent = mm_rbtree_parent( old_node );
+
+	new_node->parent = old_node->parent;
+	set_parent_colour( old_node, new_node, colour );
+	change_child( this, old_node, new_node, parent );
+}
+
+static void dummy_propagate( struct mm_rbtree_node *node, struct mm_rbtree_node *stop ) {
+	( void ) node;
+	( void ) stop;
+}
+
+static void dummy_copy( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ) {
+	( void ) old_node;
+	( void ) new_node;
+}
+
+static void dummy_rotate( struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ) {
+	( void ) old_node;
+	( void ) new_node;
+}
+
+// inlined into the plain functions so the calls disappear
+static const struct mm_rbtree_augment dummy = {
+	.propagate = dummy_propagate,
+	.copy = dummy_copy,
+	.rotate = dummy_rotate
+};
+
+static inline void insert_colour( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment ) {
+	struct mm_rbtree_node *parent = red_parent( node );
+	struct mm_rbtree_node *gparent;
+	struct mm_rbtree_node *tmp;
+
+	for ( ;; ) {
+		if ( !parent ) {
+			// inserted root or recoloured up to the root
+			set_parent_colour( node, NULL, MM_RB_BLACK );
+			return;
+		}
+
+		if ( is_black( parent ) ) {
+			return;
+		}
+
+		gparent = red_parent( parent );
+		tmp = gparent->rhs;
+
+		if ( parent != tmp ) {
+			if ( tmp && is_red( tmp ) ) {
+				// red uncle, flip colours and continue from the grandparent
+				set_parent_colour( tmp, gparent, MM_RB_BLACK );
+				set_parent_colour( parent, gparent, MM_RB_BLACK );
+				node = gparent;
+				parent = mm_rbtree_parent( node );
+				set_parent_colour( node, parent, MM_RB_RED );
+				continue;
+			}
+
+			tmp = parent->rhs;
+
+			if ( node == tmp ) {
+				// inner child, rotate left at parent to make it an outer child
+				tmp = node->lhs;
+				parent->rhs = tmp;
+				node->lhs = parent;
+
+				if ( tmp ) {
+					set_parent_colour( tmp, parent, MM_RB_BLACK );
+				}
+
+				set_parent_colour( parent, node, MM_RB_RED );
+				augment->rotate( parent, node );
+				parent = node;
+				tmp = node->rhs;
+			}
+
+			// outer child, rotate right at grandparent
+			gparent->lhs = tmp;
+			parent->rhs = gparent;
+
+			if ( tmp ) {
+				set_parent_colour( tmp, gparent, MM_RB_BLACK );
+			}
+
+			rotate_set_parents( this, gparent, parent, MM_RB_RED );
+			augment->rotate( gparent, parent );
+			return;
+		} else {
+			tmp = gparent->lhs;
+
+			if ( tmp && is_red( tmp ) ) {
+				set_parent_colour( tmp, gparent, MM_RB_BLACK );
+				set_parent_colour( parent, gparent, MM_RB_BLACK );
+				node = gparent;
+				parent = mm_rbtree_parent( node );
+				set_parent_colour( node, parent, MM_RB_RED );
+				continue;
+			}
+
+			tmp = parent->lhs;
+
+			if ( node == tmp ) {
+				tmp = node->rhs;
+				parent->lhs = tmp;
+				node->rhs = parent;
+
+				if ( tmp ) {
+					set_parent_colour( tmp, parent, MM_RB_BLACK );
+				}
+
+				set_parent_colour( parent, node, MM_RB_RED );
+				augment->rotate( parent, node );
+				parent = node;
+				tmp = node->lhs;
+			}
+
+			gparent->rhs = tmp;
+			parent->lhs = gparent;
+
+			if ( tmp ) {
+				set_parent_colour( tmp, gparent, MM_RB_BLACK );
+			}
+
+			rotate_set_parents( this, gparent, parent, MM_RB_RED );
+			augment->rotate( gparent, parent );
+			return;
+		}
+	}
+}
+
+// unlink node, returns the parent of a removed black leaf that needs rebalancing or NULL
+static inline struct mm_rbtree_node* unlink( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment ) {
+	struct mm_rbtree_node *child = node->rhs;
+	struct mm_rbtree_node *tmp = node->lhs;
+	struct mm_rbtree_node *parent;
+	struct mm_rbtree_node *rebalance;
+	uintptr_t pc;
+
+	if ( !tmp ) {
+		// at most a single red child on the right, which takes the place and colour of node
+		pc = node->parent;
+		parent = mm_rbtree_parent( node );
+		change_child( this, node, child, parent );
+
+		if ( child ) {
+			child->parent = pc;
+			rebalance = NULL;
+		} else {
+			rebalance = ( pc & 1 ) == MM_RB_BLACK ? parent : NULL;
+		}
+
+		tmp = parent;
+	} else if ( !child ) {
+		// a single red child on the left
+		tmp->parent = pc = node->parent;
+		parent = mm_rbtree_parent( node );
+		change_child( this, node, tmp, parent );
+		rebalance = NULL;
+		tmp = parent;
+	} else {
+		// two children, replace node with its in-order successor
+		struct mm_rbtree_node *successor = child;
+		struct mm_rbtree_node *child2;
+
+		tmp = child->lhs;
+
+		if ( !tmp ) {
+			parent = successor;
+			child2 = successor->rhs;
+			augment->copy( node, successor );
+		} else {
+			do {
+				parent = successor;
+				successor = tmp;
+				tmp = tmp->lhs;
+			} while ( tmp );
+
+			child2 = successor->rhs;
+			parent->lhs = child2;
+			successor->rhs = child;
+			set_parent( child, successor );
+			augment->copy( node, successor );
+			augment->propagate( parent, successor );
+		}
+
+		tmp = node->lhs;
+		successor->lhs = tmp;
+		set_parent( tmp, successor );
+
+		pc = node->parent;
+		change_child( this, node, successor, mm_rbtree_parent( node ) );
+
+		if ( child2 ) {
+			set_parent_colour( child2, parent, MM_RB_BLACK );
+			rebalance = NULL;
+		} else {
+			rebalance = is_black( successor ) ? parent : NULL;
+		}
+
+		successor->parent = pc;
+		tmp = successor;
+	}
+
+	augment->propagate( tmp, NULL );
+
+	return rebalance;
+}
+
+// restore black height after a black leaf was removed beneath parent
+static inline void erase_colour( struct mm_rbtree *this, struct mm_rbtree_node *parent, const struct mm_rbtree_augment *augment ) {
+	struct mm_rbtree_node *node = NULL;
+	struct mm_rbtree_node *sibling;
+	struct mm_rbtree_node *tmp1;
+	struct mm_rbtree_node *tmp2;
+
+	for ( ;; ) {
+		sibling = parent->rhs;
+
+		if ( node != sibling ) {
+			if ( is_red( sibling ) ) {
+				// red sibling, rotate left at parent so the sibling is black
+				tmp1 = sibling->lhs;
+				parent->rhs = tmp1;
+				sibling->lhs = parent;
+				set_parent_colour( tmp1, parent, MM_RB_BLACK );
+				rotate_set_parents( this, parent, sibling, MM_RB_RED );
+				augment->rotate( parent, sibling );
+				sibling = tmp1;
+			}
+
+			tmp1 = sibling->rhs;
+
+			if ( !tmp1 || is_black( tmp1 ) ) {
+				tmp2 = sibling->lhs;
+
+				if ( !tmp2 || is_black( tmp2 ) ) {
+					// black nephews, recolour sibling and move up if parent was black
+					set_parent_colour( sibling, parent, MM_RB_RED );
+
+					if ( is_red( parent ) ) {
+						set_black( parent );
+					} else {
+						node = parent;
+						parent = mm_rbtree_parent( node );
+
+						if ( parent ) {
+							continue;
+						}
+					}
+
+					return;
+				}
+
+				// inner nephew is red, rotate right at sibling
+				tmp1 = tmp2->rhs;
+				sibling->lhs = tmp1;
+				tmp2->rhs = sibling;
+				parent->rhs = tmp2;
+
+				if ( tmp1 ) {
+					set_parent_colour( tmp1, sibling, MM_RB_BLACK );
+				}
+
+				augment->rotate( sibling, tmp2 );
+				tmp1 = sibling;
+				sibling = tmp2;
+			}
+
+			// outer nephew is red, rotate left at parent
+			tmp2 = sibling->lhs;
+			parent->rhs = tmp2;
+			sibling->lhs = parent;
+			set_parent_colour( tmp1, sibling, MM_RB_BLACK );
+
+			if ( tmp2 ) {
+				set_parent( tmp2, parent );
+			}
+
+			rotate_set_parents( this, parent, sibling, MM_RB_BLACK );
+			augment->rotate( parent, sibling );
+			return;
+		} else {
+			sibling = parent->lhs;
+
+			if ( is_red( sibling ) ) {
+				tmp1 = sibling->rhs;
+				parent->lhs = tmp1;
+				sibling->rhs = parent;
+				set_parent_colour( tmp1, parent, MM_RB_BLACK );
+				rotate_set_parents( this, parent, sibling, MM_RB_RED );
+				augment->rotate( parent, sibling );
+				sibling = tmp1;
+			}
+
+			tmp1 = sibling->lhs;
+
+			if ( !tmp1 || is_black( tmp1 ) ) {
+				tmp2 = sibling->rhs;
+
+				if ( !tmp2 || is_black( tmp2 ) ) {
+					set_parent_colour( sibling, parent, MM_RB_RED );
+
+					if ( is_red( parent ) ) {
+						set_black( parent );
+					} else {
+						node = parent;
+						parent = mm_rbtree_parent( node );
+
+						if ( parent ) {
+							continue;
+						}
+					}
+
+					return;
+				}
+
+				tmp1 = tmp2->lhs;
+				sibling->rhs = tmp1;
+				tmp2->lhs = sibling;
+				parent->lhs = tmp2;
+
+				if ( tmp1 ) {
+					set_parent_colour( tmp1, sibling, MM_RB_BLACK );
+				}
+
+				augment->rotate( sibling, tmp2 );
+				tmp1 = sibling;
+				sibling = tmp2;
+			}
+
+			tmp2 = sibling->rhs;
+			parent->lhs = tmp2;
+			sibling->rhs = parent;
+			set_parent_colour( tmp1, sibling, MM_RB_BLACK );
+
+			if ( tmp2 ) {
+				set_parent( tmp2, parent );
+			}
+
+			rotate_set_parents( this, parent, sibling, MM_RB_BLACK );
+			augment->rotate( parent, sibling );
+			return;
+		}
+	}
+}
+
+void mm_rbtree_insert_colour( struct mm_rbtree *this, struct mm_rbtree_node *node ) {
+	insert_colour( this, node, &dummy );
+}
+
+void mm_rbtree_erase( struct mm_rbtree *this, struct mm_rbtree_node *node ) {
+	struct mm_rbtree_node *rebalance = unlink( this, node, &dummy );
+
+	if ( rebalance ) {
+		erase_colour( this, rebalance, &dummy );
+	}
+}
+
+void mm_rbtree_insert_augmented( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment ) {
+	// a new leaf changes every ancestor, so recompute the whole path without stopping early
+	for ( struct mm_rbtree_node *pos = node; pos; pos = mm_rbtree_parent( pos ) ) {
+		augment->propagate( pos, mm_rbtree_parent( pos ) );
+	}
+
+	insert_colour( this, node, augment );
+}
+
+void mm_rbtree_erase_augmented( struct mm_rbtree *this, struct mm_rbtree_node *node, const struct mm_rbtree_augment *augment ) {
+	struct mm_rbtree_node *rebalance = unlink( this, node, augment );
+
+	if ( rebalance ) {
+		erase_colour( this, rebalance, augment );
+	}
+}
+
+void mm_rbtree_replace( struct mm_rbtree *this, struct mm_rbtree_node *old_node, struct mm_rbtree_node *new_node ) {
+	struct mm_rbtree_node *parent = mm_rbtree_parent( old_node );
+
+	*new_node = *old_node;
+
+	if ( old_node->lhs ) {
+		set_parent( old_node->lhs, new_node );
+	}
+
+	if ( old_node->rhs ) {
+		set_parent( old_node->rhs, new_node );
+	}
+
+	change_child( this, old_node, new_node, parent );
+}
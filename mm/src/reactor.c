@@ -0,0 +1,179 @@
+#include <sys/eventfd.h>
+#include <time.h>
+#include "mm/reactor.h"
+
+#define WATCHED ( EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET )
+
+bool mm_reactor_init( struct mm_reactor *this, mm_sched_retire_t retire, void *ctx ) {
+	// the eventfd is level triggered, it stays readable until drained
+	struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+
+	mm_sched_init( &this->sched, retire, ctx );
+	mm_sched_event_init( &this->notified );
+	mm_timer_wheel_init( &this->timers, mm_reactor_now() );
+	atomic_init( &this->pending, false );
+	atomic_init( &this->stop, false );
+	this->epfd = epoll_create1( EPOLL_CLOEXEC );
+
+	if ( this->epfd < 0 ) {
+		return false;
+	}
+
+	this->wakefd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+	if ( this->wakefd < 0 ) {
+		close( this->epfd );
+		return false;
+	}
+
+	if ( epoll_ctl( this->epfd, EPOLL_CTL_ADD, this->wakefd, &ev ) ) {
+		mm_reactor_destroy( this );
+		return false;
+	}
+
+	return true;
+}
+
+void mm_reactor_destroy( struct mm_reactor *this ) {
+	close( this->wakefd );
+	close( this->epfd );
+}
+
+bool mm_reactor_add( struct mm_reactor *this, struct mm_reactor_fd *io, int fd ) {
+	struct epoll_event ev = { .events = WATCHED, .data.ptr = io };
+
+	io->fd = fd;
+	io->ready = 0;
+	mm_sched_event_init( &io->readable );
+	mm_sched_event_init( &io->writable );
+
+	return !epoll_ctl( this->epfd, EPOLL_CTL_ADD, fd, &ev );
+}
+
+bool mm_reactor_del( struct mm_reactor *this, struct mm_reactor_fd *io ) {
+	io->ready = MM_REACTOR_READABLE | MM_REACTOR_WRITABLE;
+	mm_sched_event_broadcast( &this->sched, &io->readable );
+	mm_sched_event_broadcast( &this->sched, &io->writable );
+
+	return !epoll_ctl( this->epfd, EPOLL_CTL_DEL, io->fd, NULL );
+}
+
+static void drain( struct mm_reactor *this ) {
+	uint64_t value;
+
+	// drain before clearing pending, a notify in between then writes again instead of getting lost
+	while ( read( this->wakefd, &value, sizeof( value ) ) > 0 );
+
+	atomic_store_explicit( &this->pending, false, memory_order_release );
+	mm_sched_event_broadcast( &this->sched, &this->notified );
+}
+
+int mm_reactor_poll( struct mm_reactor *this, int timeout ) {
+	size_t fired = 0;
+	int count;
+
+	if ( mm_timer_wheel_size( &this->timers ) ) {
+		uint_least64_t now = mm_reactor_now();
+		uint_least64_t next = mm_timer_wheel_next( &this->timers );
+		uint_least64_t wait = next > now ? next - now : 0;
+
+		if ( timeout < 0 || wait < ( uint_least64_t ) timeout ) {
+			timeout = wait < INT_MAX ? ( int ) wait : INT_MAX;
+		}
+	}
+
+	count = epoll_wait( this->epfd, this->events, MM_REACTOR_BATCH, timeout );
+
+	if ( count < 0 && errno != EINTR ) {
+		return -1;
+	}
+
+	if ( mm_timer_wheel_size( &this->timers ) ) {
+		fired = mm_timer_wheel_advance( &this->timers, mm_reactor_now() );
+	}
+
+	if ( count < 0 ) {
+		return ( int ) fired;
+	}
+
+	for ( int i = 0; i < count; ++i ) {
+		struct mm_reactor_fd *io = this->events[ i ].data.ptr;
+		uint32_t events = this->events[ i ].events;
+
+		if ( !io ) {
+			drain( this );
+			continue;
+		}
+
+		if ( events & ( EPOLLERR | EPOLLHUP ) ) {
+			events |= EPOLLIN | EPOLLOUT;
+		}
+
+		if ( events & ( EPOLLIN | EPOLLRDHUP ) ) {
+			io->ready |= MM_REACTOR_READABLE;
+			mm_sched_event_broadcast( &this->sched, &io->readable );
+		}
+
+		if ( events & EPOLLOUT ) {
+			io->ready |= MM_REACTOR_WRITABLE;
+			mm_sched_event_broadcast( &this->sched, &io->writable );
+		}
+	}
+
+	return count + ( int ) fired;
+}
+
+bool mm_reactor_run( struct mm_reactor *this ) {
+	while ( this->sched.count && !atomic_load_explicit( &this->stop, memory_order_acquire ) ) {
+		mm_sched_run( &this->sched );
+
+		if ( !this->sched.count ) {
+			break;
+		}
+
+		if ( mm_reactor_poll( this, -1 ) < 0 ) {
+			return false;
+		}
+	}
+
+	atomic_store_explicit( &this->stop, false, memory_order_relaxed );
+
+	return true;
+}
+
+void mm_reactor_notify( struct mm_reactor *this ) {
+	uint64_t one = 1;
+
+	if ( !atomic_exchange_explicit( &this->pending, true, memory_order_acq_rel ) ) {
+		// only fails when the counter would overflow, which still leaves the eventfd readable
+		ssize_t ret = write( this->wakefd, &one, sizeof( one ) );
+		( void ) ret;
+	}
+}
+
+uint_least64_t mm_reactor_now( void ) {
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( uint_least64_t ) ts.tv_sec * 1000 + ( uint_least64_t ) ts.tv_nsec / 1000000;
+}
+
+static void on_timeout( struct mm_timer *timer ) {
+	struct mm_reactor_timer *this = MM_TIMER_CONTAINER( timer, struct mm_reactor_timer, timer );
+
+	this->expired = true;
+	mm_sched_wake( &this->reactor->sched, this->task );
+}
+
+void mm_reactor_timer_init( struct mm_reactor_timer *this, struct mm_reactor *reactor, struct mm_sched_task *task ) {
+	mm_timer_init( &this->timer, on_timeout );
+	this->reactor = reactor;
+	this->task = task;
+	this->expired = false;
+}
+
+void mm_reactor_stop( struct mm_reactor *this ) {
+	atomic_store_explicit( &this->stop, true, memory_order_release );
+	mm_reactor_notify( this );
+}
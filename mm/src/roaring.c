@@ -0,0 +1,1364 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mm/assert.h"
+#include "mm/bit.h"
+#include "mm/bitset.h"
+#include "mm/endian.h"
+#include "mm/roaring.h"
+
+#define BITMAP_WORDS 1024
+#define MAGIC 0x31524d4du // "MMR1"
+#define HEADER_BYTES 8
+#define DESCRIPTOR_BYTES 16
+// the other list has to be this many times longer before galloping beats a merge
+#define GALLOP_RATIO 32
+// values of the long list compared at once when intersecting arrays
+#define MERGE_BLOCK 8
+
+struct run {
+	uint_least16_t first;
+	uint_least16_t last;
+};
+
+static size_t element_bytes( unsigned int type ) {
+	return type == MM_ROARING_ARRAY ? 2 : type == MM_ROARING_BITMAP ? 8 : 4;
+}
+
+static void container_free( struct mm_roaring_container *c ) {
+	if ( c->capacity ) {
+		MM_FREE( c->data );
+	}
+}
+
+// empty container of type with room for capacity elements, key is left alone
+static bool container_alloc( struct mm_roaring_container *c, unsigned int type, uint_least32_t capacity ) {
+	void *data;
+
+	capacity = capacity ? capacity : 1;
+	data = MM_MALLOC( element_bytes( type ) * capacity );
+
+	if ( !data ) {
+		return false;
+	}
+
+	c->data = data;
+	c->type = ( uint_least8_t ) type;
+	c->size = 0;
+	c->cardinality = 0;
+	c->capacity = capacity;
+
+	return true;
+}
+
+static bool container_copy( struct mm_roaring_container *this, const struct mm_roaring_container *other ) {
+	this->key = other->key;
+
+	if ( !container_alloc( this, other->type, other->size ) ) {
+		return false;
+	}
+
+	memcpy( this->data, other->data, element_bytes( other->type ) * other->size );
+	this->size = other->size;
+	this->cardinality = other->cardinality;
+
+	return true;
+}
+
+static struct mm_bitset bits_of( const uint_least64_t *words ) {
+	return ( struct mm_bitset ) { .words = ( uint_least64_t* ) words, .size = 65536, .capacity = BITMAP_WORDS };
+}
+
+static uint_least32_t array_lower( const uint_least16_t *values, uint_least32_t size, uint_least16_t low ) {
+	uint_least32_t lo = 0;
+	uint_least32_t hi = size;
+
+	while ( lo < hi ) {
+		uint_least32_t mid = ( lo + hi ) / 2;
+
+		if ( values[ mid ] < low ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static bool run_contains( const struct run *runs, uint_least32_t size, uint_least16_t low ) {
+	uint_least32_t lo = 0;
+	uint_least32_t hi = size;
+
+	while ( lo < hi ) {
+		uint_least32_t mid = ( lo + hi ) / 2;
+
+		if ( runs[ mid ].first <= low ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo && low <= runs[ lo - 1 ].last;
+}
+
+static bool container_contains( const struct mm_roaring_container *c, uint_least16_t low ) {
+	const uint_least16_t *values = c->data;
+	const uint_least64_t *words = c->data;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY: {
+		uint_least32_t at = array_lower( values, c->size, low );
+		return at < c->size && values[ at ] == low;
+	}
+	case MM_ROARING_BITMAP:
+		return words[ low >> 6 ] >> ( low & 63 ) & 1;
+	default:
+		return run_contains( c->data, c->size, low );
+	}
+}
+
+static void set_range( uint_least64_t *words, uint_least32_t first, uint_least32_t last ) {
+	uint_least32_t a = first >> 6;
+	uint_least32_t b = last >> 6;
+	uint_least64_t head = UINT64_MAX << ( first & 63 );
+	uint_least64_t tail = UINT64_MAX >> ( 63 - ( last & 63 ) );
+
+	if ( a == b ) {
+		words[ a ] |= head & tail;
+		return;
+	}
+
+	words[ a ] |= head;
+
+	for ( uint_least32_t i = a + 1; i < b; ++i ) {
+		words[ i ] = UINT64_MAX;
+	}
+
+	words[ b ] |= tail;
+}
+
+static uint_least32_t count_range( const uint_least64_t *words, uint_least32_t first, uint_least32_t last ) {
+	uint_least32_t a = first >> 6;
+	uint_least32_t b = last >> 6;
+	uint_least64_t head = UINT64_MAX << ( first & 63 );
+	uint_least64_t tail = UINT64_MAX >> ( 63 - ( last & 63 ) );
+	uint_least32_t count;
+
+	if ( a == b ) {
+		return mm_popcount_u64( words[ a ] & head & tail );
+	}
+
+	count = mm_popcount_u64( words[ a ] & head ) + mm_popcount_u64( words[ b ] & tail );
+
+	for ( uint_least32_t i = a + 1; i < b; ++i ) {
+		count += mm_popcount_u64( words[ i ] );
+	}
+
+	return count;
+}
+
+static void fill_bitmap( const struct mm_roaring_container *c, uint_least64_t *words ) {
+	const uint_least16_t *values = c->data;
+	const struct run *runs = c->data;
+
+	if ( c->type == MM_ROARING_BITMAP ) {
+		memcpy( words, c->data, sizeof( *words ) * BITMAP_WORDS );
+		return;
+	}
+
+	memset( words, 0, sizeof( *words ) * BITMAP_WORDS );
+
+	if ( c->type == MM_ROARING_ARRAY ) {
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			words[ values[ i ] >> 6 ] |= ( uint_least64_t ) 1 << ( values[ i ] & 63 );
+		}
+	} else {
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			set_range( words, runs[ i ].first, runs[ i ].last );
+		}
+	}
+}
+
+// the words of c, or a copy made in scratch when c is not a bitmap
+static const uint_least64_t* as_bitmap( const struct mm_roaring_container *c, uint_least64_t *scratch ) {
+	if ( c->type == MM_ROARING_BITMAP ) {
+		return c->data;
+	}
+
+	fill_bitmap( c, scratch );
+	return scratch;
+}
+
+static void extract( const struct mm_roaring_container *c, uint_least16_t *out ) {
+	const uint_least64_t *words = c->data;
+	const struct run *runs = c->data;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY:
+		memcpy( out, c->data, sizeof( *out ) * c->size );
+		break;
+	case MM_ROARING_BITMAP:
+		for ( uint_least32_t w = 0; w < BITMAP_WORDS; ++w ) {
+			for ( uint_least64_t word = words[ w ]; word; word &= word - 1 ) {
+				*out++ = ( uint_least16_t ) ( w * 64 + mm_ctz_u64( word ) );
+			}
+		}
+		break;
+	default:
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			for ( uint_least32_t v = runs[ i ].first; v <= runs[ i ].last; ++v ) {
+				*out++ = ( uint_least16_t ) v;
+			}
+		}
+		break;
+	}
+}
+
+static uint_least32_t count_runs( const struct mm_roaring_container *c ) {
+	const uint_least16_t *values = c->data;
+	const uint_least64_t *words = c->data;
+	uint_least64_t carry = 0;
+	uint_least32_t count = 0;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY:
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			count += !i || values[ i ] != values[ i - 1 ] + 1;
+		}
+		return count;
+	case MM_ROARING_BITMAP:
+		// a run starts at every set bit whose lower neighbour is clear
+		for ( uint_least32_t w = 0; w < BITMAP_WORDS; ++w ) {
+			count += mm_popcount_u64( words[ w ] & ~( words[ w ] << 1 | carry ) );
+			carry = words[ w ] >> 63;
+		}
+		return count;
+	default:
+		return c->size;
+	}
+}
+
+static uint_least32_t fill_runs( const struct mm_roaring_container *c, struct run *runs ) {
+	const uint_least16_t *values = c->data;
+	const uint_least64_t *words = c->data;
+	uint_least32_t count = 0;
+	uint_least32_t w = 0;
+	uint_least64_t word;
+
+	if ( c->type == MM_ROARING_ARRAY ) {
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			if ( count && values[ i ] == runs[ count - 1 ].last + 1 ) {
+				runs[ count - 1 ].last = values[ i ];
+			} else {
+				runs[ count++ ] = ( struct run ) { values[ i ], values[ i ] };
+			}
+		}
+
+		return count;
+	}
+
+	// fill the zeros below a run, then its end is the lowest clear bit
+	for ( word = words[ 0 ];; ) {
+		uint_least32_t first;
+
+		while ( !word ) {
+			if ( ++w == BITMAP_WORDS ) {
+				return count;
+			}
+
+			word = words[ w ];
+		}
+
+		first = w * 64 + mm_ctz_u64( word );
+		word |= word - 1;
+
+		while ( word == UINT64_MAX ) {
+			if ( ++w == BITMAP_WORDS ) {
+				runs[ count++ ] = ( struct run ) { ( uint_least16_t ) first, UINT16_MAX };
+				return count;
+			}
+
+			word = words[ w ];
+		}
+
+		runs[ count++ ] = ( struct run ) { ( uint_least16_t ) first, ( uint_least16_t ) ( w * 64 + mm_ctz_u64( ~word ) - 1 ) };
+		word &= word + 1;
+	}
+}
+
+static bool convert( struct mm_roaring_container *c, unsigned int type, uint_least32_t capacity ) {
+	struct mm_roaring_container next = { .key = c->key };
+
+	if ( !container_alloc( &next, type, type == MM_ROARING_BITMAP ? BITMAP_WORDS : capacity ) ) {
+		return false;
+	}
+
+	switch ( type ) {
+	case MM_ROARING_ARRAY:
+		extract( c, next.data );
+		next.size = c->cardinality;
+		break;
+	case MM_ROARING_BITMAP:
+		fill_bitmap( c, next.data );
+		next.size = BITMAP_WORDS;
+		break;
+	default:
+		next.size = fill_runs( c, next.data );
+		break;
+	}
+
+	next.cardinality = c->cardinality;
+	container_free( c );
+	*c = next;
+
+	return true;
+}
+
+// runs are only made by mm_roaring_optimize() and run operations, edits go through the other forms
+static bool unrun( struct mm_roaring_container *c ) {
+	if ( c->cardinality < MM_ROARING_ARRAY_MAX ) {
+		return convert( c, MM_ROARING_ARRAY, c->cardinality + 1 );
+	}
+
+	return convert( c, MM_ROARING_BITMAP, 0 );
+}
+
+// a bitmap result with its cardinality counted, made an array if it is small enough
+static bool settle( struct mm_roaring_container *c ) {
+	if ( c->cardinality > MM_ROARING_ARRAY_MAX ) {
+		return true;
+	}
+
+	return convert( c, MM_ROARING_ARRAY, c->cardinality );
+}
+
+static bool container_add( struct mm_roaring_container *c, uint_least16_t low ) {
+	uint_least16_t *values = c->data;
+	uint_least64_t *words = c->data;
+	uint_least32_t at;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY:
+		at = array_lower( values, c->size, low );
+
+		if ( at < c->size && values[ at ] == low ) {
+			return true;
+		}
+
+		if ( c->size == MM_ROARING_ARRAY_MAX ) {
+			return convert( c, MM_ROARING_BITMAP, 0 ) && container_add( c, low );
+		}
+
+		if ( c->size == c->capacity ) {
+			uint_least32_t capacity = c->capacity * 2 < MM_ROARING_ARRAY_MAX ? c->capacity * 2 : MM_ROARING_ARRAY_MAX;
+
+			if ( !( values = MM_REALLOC( c->data, sizeof( *values ) * capacity ) ) ) {
+				return false;
+			}
+
+			c->data = values;
+			c->capacity = capacity;
+		}
+
+		memmove( values + at + 1, values + at, sizeof( *values ) * ( c->size - at ) );
+		values[ at ] = low;
+		++c->size;
+		++c->cardinality;
+		return true;
+	case MM_ROARING_BITMAP:
+		c->cardinality += !( words[ low >> 6 ] >> ( low & 63 ) & 1 );
+		words[ low >> 6 ] |= ( uint_least64_t ) 1 << ( low & 63 );
+		return true;
+	default:
+		if ( run_contains( c->data, c->size, low ) ) {
+			return true;
+		}
+
+		return unrun( c ) && container_add( c, low );
+	}
+}
+
+static bool container_remove( struct mm_roaring_container *c, uint_least16_t low ) {
+	uint_least16_t *values = c->data;
+	uint_least64_t *words = c->data;
+	uint_least32_t at;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY:
+		at = array_lower( values, c->size, low );
+
+		if ( at < c->size && values[ at ] == low ) {
+			memmove( values + at, values + at + 1, sizeof( *values ) * ( c->size - at - 1 ) );
+			--c->size;
+			--c->cardinality;
+		}
+
+		return true;
+	case MM_ROARING_BITMAP:
+		if ( !( words[ low >> 6 ] >> ( low & 63 ) & 1 ) ) {
+			return true;
+		}
+
+		words[ low >> 6 ] &= ~( ( uint_least64_t ) 1 << ( low & 63 ) );
+		return --c->cardinality != MM_ROARING_ARRAY_MAX || convert( c, MM_ROARING_ARRAY, MM_ROARING_ARRAY_MAX );
+	default:
+		if ( !run_contains( c->data, c->size, low ) ) {
+			return true;
+		}
+
+		return unrun( c ) && container_remove( c, low );
+	}
+}
+
+// out NULL only counts
+static uint_least32_t intersect_arrays( const uint_least16_t *a, uint_least32_t na, const uint_least16_t *b, uint_least32_t nb, uint_least16_t *out ) {
+	uint_least32_t count = 0;
+	uint_least32_t i = 0;
+	uint_least32_t j = 0;
+
+	if ( na > nb ) {
+		const uint_least16_t *t = a;
+		uint_least32_t nt = na;
+
+		a = b;
+		na = nb;
+		b = t;
+		nb = nt;
+	}
+
+	if ( na * GALLOP_RATIO < nb ) {
+		// posting lists of very different lengths, step through the long one in doubling strides
+		for ( ; i < na && j < nb; ++i ) {
+			if ( b[ j ] < a[ i ] ) {
+				uint_least32_t step = 1;
+
+				while ( j + step < nb && b[ j + step ] < a[ i ] ) {
+					j += step;
+					step *= 2;
+				}
+
+				j += array_lower( b + j, ( j + step < nb ? j + step : nb ) - j, a[ i ] );
+			}
+
+			if ( j < nb && b[ j ] == a[ i ] ) {
+				if ( out ) {
+					out[ count ] = a[ i ];
+				}
+
+				++count;
+				++j;
+			}
+		}
+
+		return count;
+	}
+
+	// the short list walks the long one a block at a time and looks for each value in one block without branching
+	for ( ; i < na; ++i ) {
+		unsigned int found = 0;
+
+		while ( j + MERGE_BLOCK <= nb && b[ j + MERGE_BLOCK - 1 ] < a[ i ] ) {
+			j += MERGE_BLOCK;
+		}
+
+		if ( j + MERGE_BLOCK > nb ) {
+			break;
+		}
+
+		for ( unsigned int k = 0; k < MERGE_BLOCK; ++k ) {
+			found |= b[ j + k ] == a[ i ];
+		}
+
+		if ( out ) {
+			out[ count ] = a[ i ];
+		}
+
+		count += found;
+	}
+
+	// what is left once the long list has no whole block
+	for ( ; i < na; ++i ) {
+		while ( j < nb && b[ j ] < a[ i ] ) {
+			++j;
+		}
+
+		if ( j == nb ) {
+			break;
+		}
+
+		if ( b[ j ] == a[ i ] ) {
+			if ( out ) {
+				out[ count ] = a[ i ];
+			}
+
+			++count;
+		}
+	}
+
+	return count;
+}
+
+static uint_least32_t union_arrays( const uint_least16_t *a, uint_least32_t na, const uint_least16_t *b, uint_least32_t nb, uint_least16_t *out ) {
+	uint_least32_t count = 0;
+	uint_least32_t i = 0;
+	uint_least32_t j = 0;
+
+	while ( i < na && j < nb ) {
+		if ( a[ i ] < b[ j ] ) {
+			out[ count++ ] = a[ i++ ];
+		} else if ( a[ i ] > b[ j ] ) {
+			out[ count++ ] = b[ j++ ];
+		} else {
+			out[ count++ ] = a[ i++ ];
+			++j;
+		}
+	}
+
+	memcpy( out + count, a + i, sizeof( *out ) * ( na - i ) );
+	count += na - i;
+	memcpy( out + count, b + j, sizeof( *out ) * ( nb - j ) );
+
+	return count + nb - j;
+}
+
+static uint_least32_t difference_arrays( const uint_least16_t *a, uint_least32_t na, const uint_least16_t *b, uint_least32_t nb, uint_least16_t *out ) {
+	uint_least32_t count = 0;
+	uint_least32_t j = 0;
+
+	for ( uint_least32_t i = 0; i < na; ++i ) {
+		while ( j < nb && b[ j ] < a[ i ] ) {
+			++j;
+		}
+
+		if ( j == nb || b[ j ] != a[ i ] ) {
+			out[ count++ ] = a[ i ];
+		}
+	}
+
+	return count;
+}
+
+static uint_least32_t copy_slice( uint_least16_t *out, uint_least32_t count, const uint_least16_t *values, uint_least32_t from, uint_least32_t to ) {
+	if ( out ) {
+		memcpy( out + count, values + from, sizeof( *out ) * ( to - from ) );
+	}
+
+	return to - from;
+}
+
+// the values of an array that are, or are not, in a bitmap or runs. out NULL only counts
+static uint_least32_t filter_array( const struct mm_roaring_container *array, const struct mm_roaring_container *other, bool keep, uint_least16_t *out ) {
+	const uint_least16_t *values = array->data;
+	const uint_least64_t *words = other->data;
+	const struct run *runs = other->data;
+	uint_least32_t count = 0;
+	uint_least32_t at = 0;
+
+	if ( other->type == MM_ROARING_RUN ) {
+		// each run covers the slice of the array between its two ends, kept or dropped whole
+		for ( uint_least32_t r = 0; r < other->size && at < array->size; ++r ) {
+			uint_least32_t from = at + array_lower( values + at, array->size - at, runs[ r ].first );
+			uint_least32_t to = from + array_lower( values + from, array->size - from, runs[ r ].last );
+
+			to += to < array->size && values[ to ] == runs[ r ].last;
+			count += copy_slice( out, count, values, keep ? from : at, keep ? to : from );
+			at = to;
+		}
+
+		return keep ? count : count + copy_slice( out, count, values, at, array->size );
+	}
+
+	for ( uint_least32_t i = 0; i < array->size; ++i ) {
+		bool found = words[ values[ i ] >> 6 ] >> ( values[ i ] & 63 ) & 1;
+
+		// stored either way and kept by counting it, a branch here mispredicts whenever the odds are even
+		if ( out ) {
+			out[ count ] = values[ i ];
+		}
+
+		count += found == keep;
+	}
+
+	return count;
+}
+
+static uint_least32_t intersect_runs( const struct run *a, uint_least32_t na, const struct run *b, uint_least32_t nb, struct run *out, uint_least32_t *cardinality ) {
+	uint_least32_t count = 0;
+	uint_least32_t i = 0;
+	uint_least32_t j = 0;
+
+	*cardinality = 0;
+
+	while ( i < na && j < nb ) {
+		uint_least16_t first = a[ i ].first > b[ j ].first ? a[ i ].first : b[ j ].first;
+		uint_least16_t last = a[ i ].last < b[ j ].last ? a[ i ].last : b[ j ].last;
+
+		if ( first <= last ) {
+			if ( out ) {
+				out[ count ] = ( struct run ) { first, last };
+			}
+
+			++count;
+			*cardinality += ( uint_least32_t ) last - first + 1;
+		}
+
+		if ( a[ i ].last < b[ j ].last ) {
+			++i;
+		} else {
+			++j;
+		}
+	}
+
+	return count;
+}
+
+static uint_least32_t union_runs( const struct run *a, uint_least32_t na, const struct run *b, uint_least32_t nb, struct run *out, uint_least32_t *cardinality ) {
+	uint_least32_t count = 0;
+	uint_least32_t i = 0;
+	uint_least32_t j = 0;
+
+	*cardinality = 0;
+
+	while ( i < na || j < nb ) {
+		struct run next = j == nb || ( i < na && a[ i ].first < b[ j ].first ) ? a[ i++ ] : b[ j++ ];
+
+		// overlapping or adjacent runs join the one before
+		if ( count && next.first <= ( uint_least32_t ) out[ count - 1 ].last + 1 ) {
+			if ( next.last > out[ count - 1 ].last ) {
+				*cardinality += ( uint_least32_t ) next.last - out[ count - 1 ].last;
+				out[ count - 1 ].last = next.last;
+			}
+		} else {
+			out[ count++ ] = next;
+			*cardinality += ( uint_least32_t ) next.last - next.first + 1;
+		}
+	}
+
+	return count;
+}
+
+// out->key is set, everything else is filled in. out->cardinality 0 is an empty result
+static bool container_and( struct mm_roaring_container *out, const struct mm_roaring_container *a, const struct mm_roaring_container *b ) {
+	uint_least64_t scratch[ BITMAP_WORDS ];
+	struct mm_bitset lhs, rhs;
+
+	if ( b->type == MM_ROARING_ARRAY ) {
+		const struct mm_roaring_container *t = a;
+
+		a = b;
+		b = t;
+	}
+
+	if ( a->type == MM_ROARING_ARRAY ) {
+		if ( !container_alloc( out, MM_ROARING_ARRAY, a->size ) ) {
+			return false;
+		}
+
+		out->size = b->type == MM_ROARING_ARRAY
+			? intersect_arrays( a->data, a->size, b->data, b->size, out->data )
+			: filter_array( a, b, true, out->data );
+		out->cardinality = out->size;
+		return true;
+	}
+
+	if ( a->type == MM_ROARING_RUN && b->type == MM_ROARING_RUN ) {
+		if ( !container_alloc( out, MM_ROARING_RUN, a->size + b->size ) ) {
+			return false;
+		}
+
+		out->size = intersect_runs( a->data, a->size, b->data, b->size, out->data, &out->cardinality );
+		return true;
+	}
+
+	if ( !container_alloc( out, MM_ROARING_BITMAP, BITMAP_WORDS ) ) {
+		return false;
+	}
+
+	fill_bitmap( a, out->data );
+	lhs = bits_of( out->data );
+	rhs = bits_of( as_bitmap( b, scratch ) );
+	mm_bitset_and( &lhs, &rhs );
+	out->size = BITMAP_WORDS;
+	out->cardinality = ( uint_least32_t ) mm_bitset_count( &lhs );
+
+	return settle( out );
+}
+
+static bool container_or( struct mm_roaring_container *out, const struct mm_roaring_container *a, const struct mm_roaring_container *b ) {
+	uint_least64_t scratch[ BITMAP_WORDS ];
+	struct mm_bitset lhs, rhs;
+
+	if ( a->type == MM_ROARING_ARRAY && b->type == MM_ROARING_ARRAY && a->size + b->size <= MM_ROARING_ARRAY_MAX ) {
+		if ( !container_alloc( out, MM_ROARING_ARRAY, a->size + b->size ) ) {
+			return false;
+		}
+
+		out->size = out->cardinality = union_arrays( a->data, a->size, b->data, b->size, out->data );
+		return true;
+	}
+
+	if ( a->type == MM_ROARING_RUN && b->type == MM_ROARING_RUN ) {
+		if ( !container_alloc( out, MM_ROARING_RUN, a->size + b->size ) ) {
+			return false;
+		}
+
+		out->size = union_runs( a->data, a->size, b->data, b->size, out->data, &out->cardinality );
+		return true;
+	}
+
+	if ( !container_alloc( out, MM_ROARING_BITMAP, BITMAP_WORDS ) ) {
+		return false;
+	}
+
+	fill_bitmap( a, out->data );
+	lhs = bits_of( out->data );
+	rhs = bits_of( as_bitmap( b, scratch ) );
+	mm_bitset_or( &lhs, &rhs );
+	out->size = BITMAP_WORDS;
+	out->cardinality = ( uint_least32_t ) mm_bitset_count( &lhs );
+
+	return settle( out );
+}
+
+static bool container_andnot( struct mm_roaring_container *out, const struct mm_roaring_container *a, const struct mm_roaring_container *b ) {
+	uint_least64_t scratch[ BITMAP_WORDS ];
+	struct mm_bitset lhs, rhs;
+
+	if ( a->type == MM_ROARING_ARRAY ) {
+		if ( !container_alloc( out, MM_ROARING_ARRAY, a->size ) ) {
+			return false;
+		}
+
+		out->size = b->type == MM_ROARING_ARRAY
+			? difference_arrays( a->data, a->size, b->data, b->size, out->data )
+			: filter_array( a, b, false, out->data );
+		out->cardinality = out->size;
+		return true;
+	}
+
+	if ( !container_alloc( out, MM_ROARING_BITMAP, BITMAP_WORDS ) ) {
+		return false;
+	}
+
+	fill_bitmap( a, out->data );
+	lhs = bits_of( out->data );
+	rhs = bits_of( as_bitmap( b, scratch ) );
+	mm_bitset_andnot( &lhs, &rhs );
+	out->size = BITMAP_WORDS;
+	out->cardinality = ( uint_least32_t ) mm_bitset_count( &lhs );
+
+	return settle( out );
+}
+
+static uint_least32_t container_and_cardinality( const struct mm_roaring_container *a, const struct mm_roaring_container *b ) {
+	uint_least32_t count = 0;
+	struct mm_bitset lhs, rhs;
+
+	if ( b->type == MM_ROARING_ARRAY || ( b->type == MM_ROARING_RUN && a->type == MM_ROARING_BITMAP ) ) {
+		const struct mm_roaring_container *t = a;
+
+		a = b;
+		b = t;
+	}
+
+	switch ( a->type ) {
+	case MM_ROARING_ARRAY:
+		return b->type == MM_ROARING_ARRAY
+			? intersect_arrays( a->data, a->size, b->data, b->size, NULL )
+			: filter_array( a, b, true, NULL );
+	case MM_ROARING_RUN:
+		if ( b->type == MM_ROARING_RUN ) {
+			intersect_runs( a->data, a->size, b->data, b->size, NULL, &count );
+			return count;
+		}
+
+		for ( uint_least32_t i = 0; i < a->size; ++i ) {
+			const struct run *runs = a->data;
+
+			count += count_range( b->data, runs[ i ].first, runs[ i ].last );
+		}
+
+		return count;
+	default:
+		lhs = bits_of( a->data );
+		rhs = bits_of( b->data );
+		return ( uint_least32_t ) mm_bitset_and_count( &lhs, &rhs );
+	}
+}
+
+// index of the container for key, or where it would go
+static size_t find( const struct mm_roaring *this, uint_least16_t key ) {
+	size_t lo = 0;
+	size_t hi = this->size;
+
+	// values mostly arrive in order, so the last container is tried first
+	if ( hi && this->containers[ hi - 1 ].key <= key ) {
+		return this->containers[ hi - 1 ].key == key ? hi - 1 : hi;
+	}
+
+	while ( lo < hi ) {
+		size_t mid = ( lo + hi ) / 2;
+
+		if ( this->containers[ mid ].key < key ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static bool reserve( struct mm_roaring *this, size_t need ) {
+	size_t capacity = this->capacity ? this->capacity : 4;
+	struct mm_roaring_container *containers;
+
+	if ( need <= this->capacity ) {
+		return true;
+	}
+
+	while ( capacity < need ) {
+		capacity *= 2;
+	}
+
+	containers = MM_REALLOC( this->containers, sizeof( *containers ) * capacity );
+
+	if ( !containers ) {
+		return false;
+	}
+
+	this->containers = containers;
+	this->capacity = capacity;
+
+	return true;
+}
+
+// takes out whether it fails or not, empty results are dropped and the rest trimmed to fit
+static bool keep( struct mm_roaring *this, struct mm_roaring_container *out, bool made ) {
+	if ( made && !out->cardinality ) {
+		container_free( out );
+		return true;
+	}
+
+	if ( made && out->capacity > out->size ) {
+		void *data = MM_REALLOC( out->data, element_bytes( out->type ) * out->size );
+
+		if ( data ) {
+			out->data = data;
+			out->capacity = out->size;
+		}
+	}
+
+	if ( made && reserve( this, this->size + 1 ) ) {
+		this->containers[ this->size++ ] = *out;
+		return true;
+	}
+
+	container_free( out );
+	return false;
+}
+
+static bool fail( struct mm_roaring *result ) {
+	mm_roaring_destroy( result );
+	return false;
+}
+
+void mm_roaring_init( struct mm_roaring *this ) {
+	this->containers = NULL;
+	this->size = 0;
+	this->capacity = 0;
+	this->frozen = false;
+}
+
+bool mm_roaring_copy( struct mm_roaring *this, const struct mm_roaring *other ) {
+	mm_roaring_init( this );
+
+	for ( size_t i = 0; i < other->size; ++i ) {
+		struct mm_roaring_container out = { 0 };
+
+		if ( !keep( this, &out, container_copy( &out, &other->containers[ i ] ) ) ) {
+			return fail( this );
+		}
+	}
+
+	return true;
+}
+
+void mm_roaring_destroy( struct mm_roaring *this ) {
+	for ( size_t i = 0; i < this->size; ++i ) {
+		container_free( &this->containers[ i ] );
+	}
+
+	MM_FREE( this->containers );
+	mm_roaring_init( this );
+}
+
+bool mm_roaring_add( struct mm_roaring *this, uint_least32_t value ) {
+	uint_least16_t key = ( uint_least16_t ) ( value >> 16 );
+	size_t at = find( this, key );
+
+	MM_ASSERT( !this->frozen );
+
+	if ( at == this->size || this->containers[ at ].key != key ) {
+		struct mm_roaring_container c = { .key = key };
+
+		// a new array has room for its first value, so the add below cannot leave it empty
+		if ( !reserve( this, this->size + 1 ) || !container_alloc( &c, MM_ROARING_ARRAY, 4 ) ) {
+			return false;
+		}
+
+		memmove( this->containers + at + 1, this->containers + at, sizeof( c ) * ( this->size - at ) );
+		this->containers[ at ] = c;
+		++this->size;
+	}
+
+	return container_add( &this->containers[ at ], ( uint_least16_t ) value );
+}
+
+bool mm_roaring_remove( struct mm_roaring *this, uint_least32_t value ) {
+	uint_least16_t key = ( uint_least16_t ) ( value >> 16 );
+	size_t at = find( this, key );
+	struct mm_roaring_container *c;
+
+	MM_ASSERT( !this->frozen );
+
+	if ( at == this->size || this->containers[ at ].key != key ) {
+		return true;
+	}
+
+	c = &this->containers[ at ];
+
+	if ( !container_remove( c, ( uint_least16_t ) value ) ) {
+		return false;
+	}
+
+	if ( !c->cardinality ) {
+		container_free( c );
+		memmove( c, c + 1, sizeof( *c ) * ( this->size - at - 1 ) );
+		--this->size;
+	}
+
+	return true;
+}
+
+bool mm_roaring_contains( const struct mm_roaring *this, uint_least32_t value ) {
+	uint_least16_t key = ( uint_least16_t ) ( value >> 16 );
+	size_t at = find( this, key );
+
+	return at < this->size && this->containers[ at ].key == key
+		&& container_contains( &this->containers[ at ], ( uint_least16_t ) value );
+}
+
+uint_least64_t mm_roaring_cardinality( const struct mm_roaring *this ) {
+	uint_least64_t count = 0;
+
+	for ( size_t i = 0; i < this->size; ++i ) {
+		count += this->containers[ i ].cardinality;
+	}
+
+	return count;
+}
+
+bool mm_roaring_optimize( struct mm_roaring *this ) {
+	MM_ASSERT( !this->frozen );
+
+	for ( size_t i = 0; i < this->size; ++i ) {
+		struct mm_roaring_container *c = &this->containers[ i ];
+		uint_least32_t runs = count_runs( c );
+		size_t plain = c->cardinality <= MM_ROARING_ARRAY_MAX ? c->cardinality * element_bytes( MM_ROARING_ARRAY ) : BITMAP_WORDS * element_bytes( MM_ROARING_BITMAP );
+		unsigned int type = c->cardinality <= MM_ROARING_ARRAY_MAX ? MM_ROARING_ARRAY : MM_ROARING_BITMAP;
+
+		if ( runs * element_bytes( MM_ROARING_RUN ) < plain ) {
+			type = MM_ROARING_RUN;
+		}
+
+		if ( type != c->type ) {
+			if ( !convert( c, type, type == MM_ROARING_RUN ? runs : c->cardinality ) ) {
+				return false;
+			}
+		} else if ( c->capacity > c->size ) {
+			// nothing else gets added to an optimized set, as a rule
+			void *data = MM_REALLOC( c->data, element_bytes( c->type ) * c->size );
+
+			if ( data ) {
+				c->data = data;
+				c->capacity = c->size;
+			}
+		}
+	}
+
+	return true;
+}
+
+size_t mm_roaring_to_array( const struct mm_roaring *this, uint_least32_t *out ) {
+	size_t count = 0;
+
+	for ( size_t i = 0; i < this->size; ++i ) {
+		const struct mm_roaring_container *c = &this->containers[ i ];
+		const uint_least16_t *values = c->data;
+		const uint_least64_t *words = c->data;
+		const struct run *runs = c->data;
+		uint_least32_t high = ( uint_least32_t ) c->key << 16;
+
+		switch ( c->type ) {
+		case MM_ROARING_ARRAY:
+			for ( uint_least32_t v = 0; v < c->size; ++v ) {
+				out[ count++ ] = high | values[ v ];
+			}
+			break;
+		case MM_ROARING_BITMAP:
+			for ( uint_least32_t w = 0; w < BITMAP_WORDS; ++w ) {
+				for ( uint_least64_t word = words[ w ]; word; word &= word - 1 ) {
+					out[ count++ ] = high | ( w * 64 + mm_ctz_u64( word ) );
+				}
+			}
+			break;
+		default:
+			for ( uint_least32_t r = 0; r < c->size; ++r ) {
+				for ( uint_least32_t v = runs[ r ].first; v <= runs[ r ].last; ++v ) {
+					out[ count++ ] = high | v;
+				}
+			}
+			break;
+		}
+	}
+
+	return count;
+}
+
+bool mm_roaring_and( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	size_t i = 0;
+	size_t j = 0;
+
+	mm_roaring_init( result );
+
+	while ( i < lhs->size && j < rhs->size ) {
+		const struct mm_roaring_container *a = &lhs->containers[ i ];
+		const struct mm_roaring_container *b = &rhs->containers[ j ];
+
+		if ( a->key < b->key ) {
+			++i;
+		} else if ( a->key > b->key ) {
+			++j;
+		} else {
+			struct mm_roaring_container out = { .key = a->key };
+
+			if ( !keep( result, &out, container_and( &out, a, b ) ) ) {
+				return fail( result );
+			}
+
+			++i;
+			++j;
+		}
+	}
+
+	return true;
+}
+
+bool mm_roaring_or( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	size_t i = 0;
+	size_t j = 0;
+
+	mm_roaring_init( result );
+
+	while ( i < lhs->size || j < rhs->size ) {
+		const struct mm_roaring_container *a = i < lhs->size ? &lhs->containers[ i ] : NULL;
+		const struct mm_roaring_container *b = j < rhs->size ? &rhs->containers[ j ] : NULL;
+		struct mm_roaring_container out = { 0 };
+		bool made;
+
+		if ( a && ( !b || a->key < b->key ) ) {
+			made = container_copy( &out, a );
+			++i;
+		} else if ( !a || a->key > b->key ) {
+			made = container_copy( &out, b );
+			++j;
+		} else {
+			out.key = a->key;
+			made = container_or( &out, a, b );
+			++i;
+			++j;
+		}
+
+		if ( !keep( result, &out, made ) ) {
+			return fail( result );
+		}
+	}
+
+	return true;
+}
+
+bool mm_roaring_andnot( struct mm_roaring *result, const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	size_t j = 0;
+
+	mm_roaring_init( result );
+
+	for ( size_t i = 0; i < lhs->size; ++i ) {
+		const struct mm_roaring_container *a = &lhs->containers[ i ];
+		struct mm_roaring_container out = { .key = a->key };
+		bool made;
+
+		while ( j < rhs->size && rhs->containers[ j ].key < a->key ) {
+			++j;
+		}
+
+		if ( j < rhs->size && rhs->containers[ j ].key == a->key ) {
+			made = container_andnot( &out, a, &rhs->containers[ j ] );
+		} else {
+			made = container_copy( &out, a );
+		}
+
+		if ( !keep( result, &out, made ) ) {
+			return fail( result );
+		}
+	}
+
+	return true;
+}
+
+uint_least64_t mm_roaring_and_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	uint_least64_t count = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	while ( i < lhs->size && j < rhs->size ) {
+		const struct mm_roaring_container *a = &lhs->containers[ i ];
+		const struct mm_roaring_container *b = &rhs->containers[ j ];
+
+		if ( a->key < b->key ) {
+			++i;
+		} else if ( a->key > b->key ) {
+			++j;
+		} else {
+			count += container_and_cardinality( a, b );
+			++i;
+			++j;
+		}
+	}
+
+	return count;
+}
+
+uint_least64_t mm_roaring_or_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	return mm_roaring_cardinality( lhs ) + mm_roaring_cardinality( rhs ) - mm_roaring_and_cardinality( lhs, rhs );
+}
+
+uint_least64_t mm_roaring_andnot_cardinality( const struct mm_roaring *lhs, const struct mm_roaring *rhs ) {
+	return mm_roaring_cardinality( lhs ) - mm_roaring_and_cardinality( lhs, rhs );
+}
+
+/*
+	serialized layout, little endian throughout:
+
+	u32 magic, u32 number of containers
+	per container: u16 key, u16 type, u32 cardinality, u32 size, u32 offset of the payload
+	payloads as they are in memory, each padded to 8 bytes
+*/
+static size_t payload_bytes( const struct mm_roaring_container *c ) {
+	return ( element_bytes( c->type ) * c->size + 7 ) & ~( size_t ) 7;
+}
+
+static void put_16( unsigned char *p, uint_least16_t v ) {
+	v = mm_host_to_le_16( v );
+	memcpy( p, &v, sizeof( v ) );
+}
+
+static void put_32( unsigned char *p, uint_least32_t v ) {
+	v = mm_host_to_le_32( v );
+	memcpy( p, &v, sizeof( v ) );
+}
+
+static uint_least16_t get_16( const unsigned char *p ) {
+	uint_least16_t v;
+
+	memcpy( &v, p, sizeof( v ) );
+	return mm_le_to_host_16( v );
+}
+
+static uint_least32_t get_32( const unsigned char *p ) {
+	uint_least32_t v;
+
+	memcpy( &v, p, sizeof( v ) );
+	return mm_le_to_host_32( v );
+}
+
+// swapping is its own inverse, so this goes both ways. a plain copy on little endian hosts
+static void copy_le( void *dst, const void *src, unsigned int type, uint_least32_t size ) {
+#ifdef MM_LITTLE_ENDIAN
+	memcpy( dst, src, element_bytes( type ) * size );
+#else
+	if ( type == MM_ROARING_BITMAP ) {
+		for ( uint_least32_t i = 0; i < size; ++i ) {
+			uint_least64_t v;
+
+			memcpy( &v, ( const unsigned char* ) src + i * sizeof( v ), sizeof( v ) );
+			v = mm_host_to_le_64( v );
+			memcpy( ( unsigned char* ) dst + i * sizeof( v ), &v, sizeof( v ) );
+		}
+	} else {
+		for ( size_t i = 0; i < element_bytes( type ) / 2 * size; ++i ) {
+			uint_least16_t v;
+
+			memcpy( &v, ( const unsigned char* ) src + i * sizeof( v ), sizeof( v ) );
+			v = mm_host_to_le_16( v );
+			memcpy( ( unsigned char* ) dst + i * sizeof( v ), &v, sizeof( v ) );
+		}
+	}
+#endif
+}
+
+static bool valid_shape( unsigned int type, uint_least32_t cardinality, uint_least32_t size ) {
+	if ( !cardinality || cardinality > 65536 ) {
+		return false;
+	}
+
+	switch ( type ) {
+	case MM_ROARING_ARRAY:
+		return size == cardinality && size <= MM_ROARING_ARRAY_MAX;
+	case MM_ROARING_BITMAP:
+		return size == BITMAP_WORDS;
+	case MM_ROARING_RUN:
+		return size && size <= 32768;
+	default:
+		return false;
+	}
+}
+
+// values sorted and counted right, whatever the buffer came from
+static bool valid_content( const struct mm_roaring_container *c ) {
+	const uint_least16_t *values = c->data;
+	const struct run *runs = c->data;
+	struct mm_bitset bits;
+	uint_least32_t count = 0;
+
+	switch ( c->type ) {
+	case MM_ROARING_ARRAY:
+		for ( uint_least32_t i = 1; i < c->size; ++i ) {
+			if ( values[ i ] <= values[ i - 1 ] ) {
+				return false;
+			}
+		}
+
+		return true;
+	case MM_ROARING_BITMAP:
+		bits = bits_of( c->data );
+		return mm_bitset_count( &bits ) == c->cardinality;
+	default:
+		for ( uint_least32_t i = 0; i < c->size; ++i ) {
+			if ( runs[ i ].first > runs[ i ].last || ( i && runs[ i ].first <= ( uint_least32_t ) runs[ i - 1 ].last + 1 ) ) {
+				return false;
+			}
+
+			count += ( uint_least32_t ) runs[ i ].last - runs[ i ].first + 1;
+		}
+
+		return count == c->cardinality;
+	}
+}
+
+static bool parse( struct mm_roaring *this, const unsigned char *buf, size_t size, bool view ) {
+	size_t count;
+
+	mm_roaring_init( this );
+
+	if ( size < HEADER_BYTES || get_32( buf ) != MAGIC ) {
+		return false;
+	}
+
+	count = get_32( buf + 4 );
+
+	if ( count > 65536 || count > ( size - HEADER_BYTES ) / DESCRIPTOR_BYTES || !reserve( this, count ) ) {
+		return false;
+	}
+
+	this->frozen = view;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		const unsigned char *desc = buf + HEADER_BYTES + i * DESCRIPTOR_BYTES;
+		unsigned int type = get_16( desc + 2 );
+		uint_least32_t cardinality = get_32( desc + 4 );
+		uint_least32_t elements = get_32( desc + 8 );
+		size_t offset = get_32( desc + 12 );
+		struct mm_roaring_container c = { .key = get_16( desc ), .type = ( uint_least8_t ) type };
+
+		if ( !valid_shape( type, cardinality, elements ) || ( i && c.key <= this->containers[ i - 1 ].key )
+		  || offset % 8 || offset > size || element_bytes( type ) * elements > size - offset ) {
+			return fail( this );
+		}
+
+		if ( view ) {
+			c.data = ( void* ) ( buf + offset );
+		} else if ( container_alloc( &c, type, elements ) ) {
+			copy_le( c.data, buf + offset, type, elements );
+		} else {
+			return fail( this );
+		}
+
+		c.cardinality = cardinality;
+		c.size = elements;
+		this->containers[ this->size++ ] = c;
+
+		if ( !valid_content( &c ) ) {
+			return fail( this );
+		}
+	}
+
+	return true;
+}
+
+size_t mm_roaring_serialized_size( const struct mm_roaring *this ) {
+	size_t size = HEADER_BYTES + DESCRIPTOR_BYTES * this->size;
+
+	for ( size_t i = 0; i < this->size; ++i ) {
+		size += payload_bytes( &this->containers[ i ] );
+	}
+
+	return size;
+}
+
+size_t mm_roaring_serialize( const struct mm_roaring *this, void *buf ) {
+	unsigned char *out = buf;
+	size_t offset = HEADER_BYTES + DESCRIPTOR_BYTES * this->size;
+
+	put_32( out, MAGIC );
+	put_32( out + 4, ( uint_least32_t ) this->size );
+
+	for ( size_t i = 0; i < this->size; ++i ) {
+		const struct mm_roaring_container *c = &this->containers[ i ];
+		unsigned char *desc = out + HEADER_BYTES + i * DESCRIPTOR_BYTES;
+		size_t bytes = element_bytes( c->type ) * c->size;
+
+		put_16( desc, c->key );
+		put_16( desc + 2, c->type );
+		put_32( desc + 4, c->cardinality );
+		put_32( desc + 8, c->size );
+		put_32( desc + 12, ( uint_least32_t ) offset );
+		copy_le( out + offset, c->data, c->type, c->size );
+		memset( out + offset + bytes, 0, payload_bytes( c ) - bytes );
+		offset += payload_bytes( c );
+	}
+
+	return offset;
+}
+
+bool mm_roaring_deserialize( struct mm_roaring *this, const void *buf, size_t size ) {
+	return parse( this, buf, size, false );
+}
+
+bool mm_roaring_view( struct mm_roaring *this, const void *buf, size_t size ) {
+#ifdef MM_LITTLE_ENDIAN
+	if ( ( uintptr_t ) buf % 8 ) {
+		mm_roaring_init( this );
+		return false;
+	}
+
+	return parse( this, buf, size, true );
+#else
+	// the payloads would need swapping, mm_roaring_deserialize() does that
+	( void ) buf;
+	( void ) size;
+	mm_roaring_init( this );
+	return false;
+#endif
+}
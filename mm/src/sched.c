@@ -0,0 +1,62 @@
+#include "mm/sched.h"
+
+#define TASK_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_sched_task, list )
+
+bool mm_sched_step( struct mm_sched *this ) {
+	struct mm_sched_task *task;
+
+	if ( mm_list_empty( &this->ready ) ) {
+		return false;
+	}
+
+	task = TASK_OF( this->ready.next );
+
+	switch ( task->func( task ) ) {
+		case MM_CO_WAITING:
+			if ( task->park ) {
+				task->park = false;
+
+				if ( task->event ) {
+					mm_list_move_tail( &task->event->waiters, &task->list );
+					task->event = NULL;
+				} else {
+					mm_list_del( &task->list );
+				}
+
+				break;
+			}
+
+			// waiting on a nested coroutine, keep polling it like a yield
+			/* fallthrough */
+		case MM_CO_SUSPENDED:
+			// the task may have been moved by a wake from inside its own step
+			if ( this->ready.next == &task->list ) {
+				mm_list_rotate_left( &this->ready );
+			}
+
+			break;
+
+		case MM_CO_DONE:
+			mm_list_del( &task->list );
+			--this->count;
+
+			if ( this->retire ) {
+				this->retire( task, this->ctx );
+			}
+
+			break;
+	}
+
+	return true;
+}
+
+size_t mm_sched_run( struct mm_sched *this ) {
+	size_t steps = 0;
+
+	while ( mm_sched_step( this ) ) {
+		++steps;
+	}
+
+	return steps;
+}
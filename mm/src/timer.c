@@ -0,0 +1,187 @@
+#include "mm/bit.h"
+#include "mm/timer.h"
+
+#define MASK ( MM_TIMER_SLOTS - 1 )
+#define TOP ( MM_TIMER_LEVELS - 1 )
+#define DUE ( MM_TIMER_LEVELS * MM_TIMER_SLOTS )
+// ticks covered by one turn of the top level
+#define SPAN ( ( uint_least64_t ) 1 << ( MM_TIMER_BITS * MM_TIMER_LEVELS ) )
+
+#define TIMER_OF( pos )\
+	MM_CONTAINER_OF( pos, struct mm_timer, list )
+
+static inline unsigned int digit( uint_least64_t tick, unsigned int level ) {
+	return ( unsigned int ) ( tick >> ( MM_TIMER_BITS * level ) ) & MASK;
+}
+
+// first tick of the level slot that tick falls into
+static inline uint_least64_t slot_start( uint_least64_t tick, unsigned int level ) {
+	return tick & ~( ( ( uint_least64_t ) 1 << ( MM_TIMER_BITS * level ) ) - 1 );
+}
+
+// the lowest level where expires and now differ, above it both share the same slots
+static void place( struct mm_timer_wheel *this, struct mm_timer *timer ) {
+	uint_least64_t diff = timer->expires ^ this->now;
+	unsigned int level = 0;
+	unsigned int slot;
+
+	if ( timer->expires <= this->now ) {
+		timer->slot = DUE;
+		mm_list_add_tail( &this->due, &timer->list );
+		return;
+	}
+
+	while ( level < TOP && diff >> ( MM_TIMER_BITS * ( level + 1 ) ) ) {
+		++level;
+	}
+
+	slot = digit( timer->expires, level );
+
+	// more than a turn away, wait for the current top slot to come around again and place it once more
+	if ( level == TOP && timer->expires - this->now >= SPAN ) {
+		slot = digit( this->now, TOP );
+	}
+
+	timer->slot = ( unsigned short ) ( level * MM_TIMER_SLOTS + slot );
+	mm_list_add_tail( &this->slots[ level ][ slot ], &timer->list );
+	this->occupied[ level ] |= ( uint_least64_t ) 1 << slot;
+}
+
+void mm_timer_wheel_init( struct mm_timer_wheel *this, uint_least64_t now ) {
+	this->now = now;
+	this->count = 0;
+	mm_list_init( &this->due );
+
+	for ( unsigned int level = 0; level < MM_TIMER_LEVELS; ++level ) {
+		this->occupied[ level ] = 0;
+
+		for ( unsigned int slot = 0; slot < MM_TIMER_SLOTS; ++slot ) {
+			mm_list_init( &this->slots[ level ][ slot ] );
+		}
+	}
+}
+
+void mm_timer_add( struct mm_timer_wheel *this, struct mm_timer *timer, uint_least64_t expires ) {
+	mm_timer_cancel( this, timer );
+	timer->expires = expires;
+	place( this, timer );
+	++this->count;
+}
+
+void mm_timer_cancel( struct mm_timer_wheel *this, struct mm_timer *timer ) {
+	struct mm_list *head;
+
+	if ( !mm_timer_pending( timer ) ) {
+		return;
+	}
+
+	mm_list_del( &timer->list );
+	--this->count;
+
+	if ( timer->slot == DUE ) {
+		return;
+	}
+
+	head = &this->slots[ timer->slot / MM_TIMER_SLOTS ][ timer->slot & MASK ];
+
+	if ( mm_list_empty( head ) ) {
+		this->occupied[ timer->slot / MM_TIMER_SLOTS ] &= ~( ( uint_least64_t ) 1 << ( timer->slot & MASK ) );
+	}
+}
+
+// next tick a slot needs attention, ignoring the due list
+static uint_least64_t next_slot( const struct mm_timer_wheel *this ) {
+	for ( unsigned int level = 0; level < MM_TIMER_LEVELS; ++level ) {
+		unsigned int shift = MM_TIMER_BITS * level;
+		unsigned int current = digit( this->now, level );
+		uint_least64_t above = current == MASK ? 0 : this->occupied[ level ] & ( ~( uint_least64_t ) 0 << ( current + 1 ) );
+
+		if ( above ) {
+			return slot_start( this->now, level + 1 ) + ( ( uint_least64_t ) mm_ctz_u64( above ) << shift );
+		}
+
+		// only the top level wraps around, lower levels are emptied before now leaves their range
+		if ( level == TOP && this->occupied[ level ] ) {
+			return slot_start( this->now, MM_TIMER_LEVELS ) + SPAN + ( ( uint_least64_t ) mm_ctz_u64( this->occupied[ level ] ) << shift );
+		}
+	}
+
+	return UINT_LEAST64_MAX;
+}
+
+uint_least64_t mm_timer_wheel_next( struct mm_timer_wheel *this ) {
+	return mm_list_empty( &this->due ) ? next_slot( this ) : this->now;
+}
+
+static void take( struct mm_timer_wheel *this, unsigned int level, unsigned int slot, struct mm_list *out ) {
+	mm_list_splice_tail( out, &this->slots[ level ][ slot ] );
+	this->occupied[ level ] &= ~( ( uint_least64_t ) 1 << slot );
+}
+
+static size_t fire( struct mm_timer_wheel *this, struct mm_list *batch ) {
+	size_t fired = 0;
+
+	// callbacks may cancel timers of the same batch, so unlink one at a time
+	while ( !mm_list_empty( batch ) ) {
+		struct mm_timer *timer = TIMER_OF( batch->next );
+
+		mm_list_del( &timer->list );
+		--this->count;
+		++fired;
+		timer->func( timer );
+	}
+
+	return fired;
+}
+
+size_t mm_timer_wheel_advance( struct mm_timer_wheel *this, uint_least64_t now ) {
+	size_t fired = 0;
+
+	for ( ;; ) {
+		MM_LIST_DECLARE( batch );
+		uint_least64_t next;
+
+		if ( !mm_list_empty( &this->due ) ) {
+			mm_list_splice_tail( &batch, &this->due );
+			fired += fire( this, &batch );
+			continue;
+		}
+
+		next = next_slot( this );
+
+		if ( next > now ) {
+			break;
+		}
+
+		this->now = next;
+
+		// entering the range of higher level slots, move their timers down starting from the top
+		for ( unsigned int level = TOP; level > 0; --level ) {
+			unsigned int slot = digit( next, level );
+
+			if ( slot_start( next, level ) != next || !( this->occupied[ level ] & ( ( uint_least64_t ) 1 << slot ) ) ) {
+				continue;
+			}
+
+			take( this, level, slot, &batch );
+
+			while ( !mm_list_empty( &batch ) ) {
+				struct mm_timer *timer = TIMER_OF( batch.next );
+
+				mm_list_del( &timer->list );
+				place( this, timer );
+			}
+		}
+
+		if ( this->occupied[ 0 ] & ( ( uint_least64_t ) 1 << digit( next, 0 ) ) ) {
+			take( this, 0, digit( next, 0 ), &batch );
+			fired += fire( this, &batch );
+		}
+	}
+
+	if ( now > this->now ) {
+		this->now = now;
+	}
+
+	return fired;
+}
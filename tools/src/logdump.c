@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <string.h>
+#include "mm/log.h"
+
+// turns the output of a binary async mm_log run or a flight recording into text, reads stdin without a file argument
+int main( int argc, char **argv ) {
+	FILE *in = stdin;
+	bool ok;
+
+	if ( argc > 2 || ( argc == 2 && !strcmp( argv[ 1 ], "-h" ) ) ) {
+		fprintf( stderr, "usage: %s [binary log or recording]\n", argv[ 0 ] );
+		return 2;
+	}
+
+	if ( argc == 2 && !( in = fopen( argv[ 1 ], "rb" ) ) ) {
+		perror( argv[ 1 ] );
+		return 1;
+	}
+
+	ok = mm_log_decode( in, stdout );
+
+	if ( in != stdin ) {
+		fclose( in );
+	}
+
+	if ( !ok ) {
+		fprintf( stderr, "%s: not a binary mm_log file or recording, or cut short\n", argc == 2 ? argv[ 1 ] : "stdin" );
+		return 1;
+	}
+
+	return 0;
+}
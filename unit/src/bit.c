@@ -0,0 +1,176 @@
+#include "mm/bit.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define WORDS 100000
+
+static unsigned int naive_popcount( uint_least64_t i ) {
+	unsigned int n = 0;
+
+	for ( ; i; i >>= 1 ) {
+		n += i & 1;
+	}
+
+	return n;
+}
+
+static unsigned int naive_clz( uint_least64_t i, unsigned int width ) {
+	unsigned int n = 0;
+
+	while ( !( i & ( uint_least64_t ) 1 << ( width - 1 - n ) ) ) {
+		++n;
+	}
+
+	return n;
+}
+
+static unsigned int naive_ctz( uint_least64_t i ) {
+	unsigned int n = 0;
+
+	while ( !( i & ( uint_least64_t ) 1 << n ) ) {
+		++n;
+	}
+
+	return n;
+}
+
+// random words with every density, the set bits are what the fallbacks loop over
+static uint_least64_t word( struct mm_random *r ) {
+	switch ( mm_random_u64( r ) & 3 ) {
+	case 0: return mm_random_u64( r ) & mm_random_u64( r ) & mm_random_u64( r );
+	case 1: return mm_random_u64( r ) | mm_random_u64( r ) | mm_random_u64( r );
+	case 2: return ( uint_least64_t ) 1 << ( mm_random_u64( r ) & 63 );
+	default: return mm_random_u64( r );
+	}
+}
+
+// 8 bits exhaustively, wider ones on random words against one bit at a time
+MM_UNIT_CASE( bit_count_case, NULL, NULL ) {
+	struct mm_random r;
+
+	for ( unsigned int i = 1; i < 256; ++i ) {
+		MM_UNIT_ASSERT_EQ( naive_popcount( i ), mm_popcount_u8( i ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i ) & 1, mm_parity_u8( i ) );
+		MM_UNIT_ASSERT_EQ( naive_clz( i, 8 ), mm_clz_u8( i ) );
+		MM_UNIT_ASSERT_EQ( naive_ctz( i ), mm_ctz_u8( i ) );
+	}
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t n = 0; n < WORDS; ++n ) {
+		uint_least64_t i = word( &r ) | 1 << ( n & 7 );
+		uint_least16_t i16 = ( uint_least16_t ) i;
+		uint_least32_t i32 = ( uint_least32_t ) i;
+
+		MM_UNIT_ASSERT_EQ( naive_popcount( i16 ), mm_popcount_u16( i16 ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i32 ), mm_popcount_u32( i32 ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i ), mm_popcount_u64( i ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i16 ) & 1, mm_parity_u16( i16 ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i32 ) & 1, mm_parity_u32( i32 ) );
+		MM_UNIT_ASSERT_EQ( naive_popcount( i ) & 1, mm_parity_u64( i ) );
+		MM_UNIT_ASSERT_EQ( naive_clz( i16, 16 ), mm_clz_u16( i16 ) );
+		MM_UNIT_ASSERT_EQ( naive_clz( i32, 32 ), mm_clz_u32( i32 ) );
+		MM_UNIT_ASSERT_EQ( naive_clz( i, 64 ), mm_clz_u64( i ) );
+		MM_UNIT_ASSERT_EQ( naive_ctz( i16 ), mm_ctz_u16( i16 ) );
+		MM_UNIT_ASSERT_EQ( naive_ctz( i32 ), mm_ctz_u32( i32 ) );
+		MM_UNIT_ASSERT_EQ( naive_ctz( i ), mm_ctz_u64( i ) );
+	}
+
+	MM_UNIT_ASSERT_EQ( 0, mm_popcount_u64( 0 ) );
+	MM_UNIT_ASSERT_EQ( 64, mm_popcount_u64( UINT64_MAX ) );
+	MM_UNIT_ASSERT_EQ( 0, mm_parity_u64( UINT64_MAX ) );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bit_pow2_case, NULL, NULL ) {
+	MM_UNIT_ASSERT_EQ( 0, mm_bit_floor_log2_u32( 1 ) );
+	MM_UNIT_ASSERT_EQ( 31, mm_bit_floor_log2_u32( UINT32_MAX ) );
+	MM_UNIT_ASSERT_EQ( 63, mm_bit_floor_log2_u64( UINT64_MAX ) );
+	MM_UNIT_ASSERT_EQ( 1, mm_bit_ceil_pow2_u32( 0 ) );
+	MM_UNIT_ASSERT_EQ( 1, mm_bit_ceil_pow2_u32( 1 ) );
+	MM_UNIT_ASSERT_EQ( 2, mm_bit_ceil_pow2_u32( 2 ) );
+	MM_UNIT_ASSERT_EQ( 4, mm_bit_ceil_pow2_u32( 3 ) );
+	MM_UNIT_ASSERT_EQ( UINT32_C( 1 ) << 31, mm_bit_ceil_pow2_u32( ( UINT32_C( 1 ) << 30 ) + 1 ) );
+	MM_UNIT_ASSERT_EQ( UINT32_C( 1 ) << 31, mm_bit_ceil_pow2_u32( UINT32_C( 1 ) << 31 ) );
+	MM_UNIT_ASSERT_EQ( 0, mm_bit_ceil_pow2_u32( ( UINT32_C( 1 ) << 31 ) + 1 ) );
+	MM_UNIT_ASSERT_EQ( UINT64_C( 1 ) << 63, mm_bit_ceil_pow2_u64( ( UINT64_C( 1 ) << 62 ) + 1 ) );
+	MM_UNIT_ASSERT_EQ( 0, mm_bit_ceil_pow2_u64( UINT64_MAX ) );
+
+	for ( unsigned int b = 0; b < 64; ++b ) {
+		uint_least64_t p = ( uint_least64_t ) 1 << b;
+
+		MM_UNIT_ASSERT_EQ( b, mm_bit_floor_log2_u64( p ) );
+		MM_UNIT_ASSERT_EQ( b, mm_bit_floor_log2_u64( p | ( p - 1 ) ) );
+		MM_UNIT_ASSERT_EQ( p, mm_bit_ceil_pow2_u64( p ) );
+
+		if ( b > 1 ) {
+			MM_UNIT_ASSERT_EQ( p, mm_bit_ceil_pow2_u64( ( p >> 1 ) + 1 ) );
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
+// whatever was picked at run time, the software versions and the dispatched ones agree
+MM_UNIT_CASE( bit_pdep_case, NULL, NULL ) {
+	struct mm_random r;
+
+	MM_UNIT_ASSERT_EQ( UINT64_C( 0x50 ), mm_bit_pdep_soft( 0x5, 0xf0 ) );
+	MM_UNIT_ASSERT_EQ( UINT64_C( 0x8001 ), mm_bit_pdep_soft( 0x3, 0x8001 ) );
+	MM_UNIT_ASSERT_EQ( UINT64_C( 0x3 ), mm_bit_pext_soft( 0x8001, 0x8001 ) );
+	MM_UNIT_ASSERT_EQ( UINT64_C( 0xa ), mm_bit_pext_soft( 0x0a0, 0xf0 ) );
+	mm_random_reset( &r, 42 );
+
+	for ( size_t n = 0; n < WORDS; ++n ) {
+		uint_least64_t i = word( &r );
+		uint_least64_t mask = word( &r );
+		uint_least64_t deposited = mm_bit_pdep_soft( i, mask );
+
+		MM_UNIT_ASSERT_EQ( deposited, mm_bit_pdep_u64( i, mask ) );
+		MM_UNIT_ASSERT_EQ( mm_bit_pext_soft( i, mask ), mm_bit_pext_u64( i, mask ) );
+		MM_UNIT_ASSERT_EQ( ( uint_least32_t ) deposited, mm_bit_pdep_u32( ( uint_least32_t ) i, ( uint_least32_t ) mask ) );
+		MM_UNIT_ASSERT_EQ( ( uint_least32_t ) mm_bit_pext_soft( ( uint_least32_t ) i, ( uint_least32_t ) mask ),
+			mm_bit_pext_u32( ( uint_least32_t ) i, ( uint_least32_t ) mask ) );
+		// extracting what was deposited gives back as many low bits as the mask has
+		MM_UNIT_ASSERT_EQ( mm_popcount_u64( mask ) == 64 ? i : i & ( ( ( uint_least64_t ) 1 << mm_popcount_u64( mask ) ) - 1 ),
+			mm_bit_pext_u64( deposited, mask ) );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bit_rank_select_case, NULL, NULL ) {
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t n = 0; n < WORDS / 10; ++n ) {
+		uint_least64_t i = word( &r );
+		unsigned int rank = 0;
+
+		for ( unsigned int pos = 0; pos < 64; ++pos ) {
+			MM_UNIT_ASSERT_EQ( rank, mm_bit_rank_u64( i, pos ) );
+
+			if ( i & ( uint_least64_t ) 1 << pos ) {
+				MM_UNIT_ASSERT_EQ( pos, mm_bit_select_u64( i, rank ) );
+
+				if ( pos < 32 ) {
+					MM_UNIT_ASSERT_EQ( pos, mm_bit_select_u32( ( uint_least32_t ) i, rank ) );
+				}
+
+				++rank;
+			}
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( bit_suite ) {
+	MM_UNIT_RUN( bit_count_case );
+	MM_UNIT_RUN( bit_pow2_case );
+	MM_UNIT_RUN( bit_pdep_case );
+	MM_UNIT_RUN( bit_rank_select_case );
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,125 @@
+#include "mm/bitset.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+// sizes around the vector widths, so the kernels end in every possible tail
+static const size_t sizes[] = { 0, 1, 63, 64, 65, 255, 256, 511, 512, 513, 1000, 4096 + 448 + 7 };
+
+static bool fill( struct mm_bitset *bs, struct mm_random *r, size_t size ) {
+	if ( !mm_bitset_init( bs, size ) ) {
+		return false;
+	}
+
+	for ( size_t i = 0; i < size; ++i ) {
+		if ( mm_random_next( r, 0, 3 ) == 0 ) {
+			mm_bitset_set( bs, i );
+		}
+	}
+
+	return true;
+}
+
+MM_UNIT_CASE( bitset_bits_case, NULL, NULL ) {
+	struct mm_bitset bs;
+	size_t count = 0;
+	size_t i;
+
+	MM_UNIT_ASSERT( mm_bitset_init( &bs, 1000 ), "bitset init failed" );
+	MM_UNIT_ASSERT_EQ( 0, mm_bitset_count( &bs ) );
+	MM_UNIT_ASSERT_EQ( 1000, mm_bitset_find_next( &bs, 0 ) );
+
+	for ( i = 0; i < 1000; i += 7 ) {
+		mm_bitset_set( &bs, i );
+	}
+
+	mm_bitset_clear( &bs, 7 );
+	MM_UNIT_ASSERT( mm_bitset_test( &bs, 0 ), "bit 0 not set" );
+	MM_UNIT_ASSERT( !mm_bitset_test( &bs, 7 ), "bit 7 not cleared" );
+	MM_UNIT_ASSERT( !mm_bitset_test( &bs, 8 ), "bit 8 set" );
+	MM_UNIT_ASSERT_EQ( 14, mm_bitset_find_next( &bs, 1 ) );
+	MM_UNIT_ASSERT_EQ( 994, mm_bitset_find_next( &bs, 994 ) );
+	MM_UNIT_ASSERT_EQ( 1000, mm_bitset_find_next( &bs, 995 ) );
+	MM_UNIT_ASSERT_EQ( 1000, mm_bitset_find_next( &bs, 5000 ) );
+
+	MM_BITSET_FOR_EACH( &bs, i ) {
+		MM_UNIT_ASSERT( i % 7 == 0 && i != 7, "visited a clear bit" );
+		++count;
+	}
+
+	MM_UNIT_ASSERT_EQ( 142, count );
+	MM_UNIT_ASSERT_EQ( 142, mm_bitset_count( &bs ) );
+
+	// shrinking drops the bits past the end, growing back brings them in clear
+	MM_UNIT_ASSERT( mm_bitset_resize( &bs, 500 ), "resize failed" );
+	MM_UNIT_ASSERT_EQ( 71, mm_bitset_count( &bs ) );
+	MM_UNIT_ASSERT( mm_bitset_resize( &bs, 100000 ), "resize failed" );
+	MM_UNIT_ASSERT_EQ( 71, mm_bitset_count( &bs ) );
+	MM_UNIT_ASSERT_EQ( 100000, mm_bitset_find_next( &bs, 498 ) );
+	mm_bitset_set( &bs, 99999 );
+	MM_UNIT_ASSERT_EQ( 99999, mm_bitset_find_next( &bs, 498 ) );
+	mm_bitset_destroy( &bs );
+
+	return MM_UNIT_DONE;
+}
+
+// every operation and its fused count against the same thing done one bit at a time
+MM_UNIT_CASE( bitset_ops_case, NULL, NULL ) {
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t s = 0; s < MM_ARR_SIZE( sizes ); ++s ) {
+		struct mm_bitset a, b, result;
+		size_t expected[ 4 ] = { 0 };
+
+		MM_UNIT_ASSERT( fill( &a, &r, sizes[ s ] ) && fill( &b, &r, sizes[ s ] ), "bitset init failed" );
+
+		for ( size_t i = 0; i < sizes[ s ]; ++i ) {
+			bool x = mm_bitset_test( &a, i );
+			bool y = mm_bitset_test( &b, i );
+
+			expected[ 0 ] += x && y;
+			expected[ 1 ] += x || y;
+			expected[ 2 ] += x != y;
+			expected[ 3 ] += x && !y;
+		}
+
+		MM_UNIT_ASSERT_EQ( expected[ 0 ], mm_bitset_and_count( &a, &b ) );
+		MM_UNIT_ASSERT_EQ( expected[ 1 ], mm_bitset_or_count( &a, &b ) );
+		MM_UNIT_ASSERT_EQ( expected[ 2 ], mm_bitset_xor_count( &a, &b ) );
+		MM_UNIT_ASSERT_EQ( expected[ 3 ], mm_bitset_andnot_count( &a, &b ) );
+
+		for ( int op = 0; op < 4; ++op ) {
+			MM_UNIT_ASSERT( mm_bitset_copy( &result, &a ), "bitset copy failed" );
+
+			switch ( op ) {
+			case 0: mm_bitset_and( &result, &b ); break;
+			case 1: mm_bitset_or( &result, &b ); break;
+			case 2: mm_bitset_xor( &result, &b ); break;
+			default: mm_bitset_andnot( &result, &b ); break;
+			}
+
+			for ( size_t i = 0; i < sizes[ s ]; ++i ) {
+				bool x = mm_bitset_test( &a, i );
+				bool y = mm_bitset_test( &b, i );
+				bool z = op == 0 ? x && y : op == 1 ? x || y : op == 2 ? x != y : x && !y;
+
+				MM_UNIT_ASSERT_EQ( z, mm_bitset_test( &result, i ) );
+			}
+
+			MM_UNIT_ASSERT_EQ( expected[ op ], mm_bitset_count( &result ) );
+			mm_bitset_destroy( &result );
+		}
+
+		mm_bitset_destroy( &a );
+		mm_bitset_destroy( &b );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( bitset_suite ) {
+	MM_UNIT_RUN( bitset_bits_case );
+	MM_UNIT_RUN( bitset_ops_case );
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,126 @@
+#include "mm/bitvector.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+// every rank and every select against a walk over the bits
+static struct mm_unit_err check( struct mm_bitvector *bv ) {
+	uint_least64_t rank = 0;
+
+	for ( uint_least64_t i = 0; i < bv->size; ++i ) {
+		MM_UNIT_ASSERT_EQ( rank, mm_bitvector_rank1( bv, i ) );
+
+		if ( mm_bitvector_get( bv, i ) ) {
+			MM_UNIT_ASSERT_EQ( i, mm_bitvector_select1( bv, rank ) );
+			++rank;
+		}
+	}
+
+	MM_UNIT_ASSERT_EQ( rank, mm_bitvector_rank1( bv, bv->size ) );
+	MM_UNIT_ASSERT_EQ( bv->size - rank, mm_bitvector_rank0( bv, bv->size ) );
+	MM_UNIT_ASSERT_EQ( rank, bv->ones );
+	MM_UNIT_ASSERT_EQ( bv->size, mm_bitvector_select1( bv, rank ) );
+
+	return MM_UNIT_DONE;
+}
+
+// from empty to full, sparse enough that select samples are many blocks apart, odd sizes and chunks
+MM_UNIT_CASE( bitvector_stream_case, NULL, NULL ) {
+	static const unsigned int densities[] = { 0, 1, 64, 512, 32768, 65535, 65536 };
+	static const uint_least64_t sizes[] = { 0, 1, 63, 64, 2047, 2048, 100000, 1000003 };
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t d = 0; d < MM_ARR_SIZE( densities ); ++d ) {
+		for ( size_t s = 0; s < MM_ARR_SIZE( sizes ); ++s ) {
+			struct mm_bitvector bv;
+			struct mm_unit_err err;
+
+			MM_UNIT_ASSERT( mm_bitvector_init( &bv, 0 ), "bitvector init failed" );
+
+			for ( uint_least64_t i = 0; i < sizes[ s ]; ) {
+				unsigned int count = ( unsigned int ) mm_random_next( &r, 1, 65 );
+				uint_least64_t bits = 0;
+
+				if ( count > sizes[ s ] - i ) {
+					count = ( unsigned int ) ( sizes[ s ] - i );
+				}
+
+				for ( unsigned int b = 0; b < count; ++b ) {
+					bits |= ( uint_least64_t ) ( mm_random_next( &r, 0, 65536 ) < densities[ d ] ) << b;
+				}
+
+				// garbage above count is ignored
+				MM_UNIT_ASSERT( mm_bitvector_append( &bv, bits | ( count < 64 ? UINT64_MAX << count : 0 ), count ), "append failed" );
+				i += count;
+			}
+
+			MM_UNIT_ASSERT_EQ( sizes[ s ], bv.size );
+			MM_UNIT_ASSERT( mm_bitvector_build( &bv ), "build failed" );
+			err = check( &bv );
+			mm_bitvector_destroy( &bv );
+
+			if ( err.err ) {
+				return err;
+			}
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bitvector_positions_case, NULL, NULL ) {
+	MM_VECTOR_DECLARE( positions, uint_least64_t, NULL );
+	struct mm_bitvector bv;
+	struct mm_random r;
+	struct mm_unit_err err;
+	uint_least64_t pos;
+
+	mm_random_reset( &r, 42 );
+
+	// unordered and with repeats
+	for ( size_t i = 0; i < 5000; ++i ) {
+		pos = mm_random_next( &r, 0, 300000 );
+		MM_UNIT_ASSERT( mm_vector_push_back( &positions, &pos ), "push failed" );
+	}
+
+	MM_UNIT_ASSERT( mm_bitvector_from_positions( &bv, &positions, 300000 ), "from positions failed" );
+
+	for ( size_t i = 0; i < mm_vector_size( &positions ); ++i ) {
+		MM_UNIT_ASSERT( mm_bitvector_get( &bv, *( uint_least64_t* ) mm_vector_at( &positions, i ) ), "position not set" );
+	}
+
+	err = check( &bv );
+	mm_bitvector_destroy( &bv );
+
+	if ( err.err ) {
+		mm_vector_destroy( &positions );
+		return err;
+	}
+
+	// appending after a build and building again
+	MM_UNIT_ASSERT( mm_bitvector_from_positions( &bv, &positions, 300000 ), "from positions failed" );
+	MM_UNIT_ASSERT( mm_bitvector_append( &bv, 0x5, 3 ), "append failed" );
+	MM_UNIT_ASSERT( mm_bitvector_build( &bv ), "build failed" );
+	MM_UNIT_ASSERT_EQ( 300002, mm_bitvector_select1( &bv, bv.ones - 1 ) );
+	err = check( &bv );
+	mm_bitvector_destroy( &bv );
+
+	if ( err.err ) {
+		mm_vector_destroy( &positions );
+		return err;
+	}
+
+	pos = 300000;
+	MM_UNIT_ASSERT( mm_vector_push_back( &positions, &pos ), "push failed" );
+	MM_UNIT_ASSERT( !mm_bitvector_from_positions( &bv, &positions, 300000 ), "position past the end accepted" );
+	mm_vector_destroy( &positions );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( bitvector_suite ) {
+	MM_UNIT_RUN( bitvector_stream_case );
+	MM_UNIT_RUN( bitvector_positions_case );
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,116 @@
+#include "mm/btree.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 20000
+
+static bool present[ COUNT ];
+
+static bool tree_matches( struct mm_btree *tree ) {
+	struct mm_btree_iter it = mm_btree_first( tree );
+	size_t size = 0;
+
+	for ( mm_btree_key_t key = 0; key < COUNT; ++key ) {
+		if ( !present[ key ] ) {
+			continue;
+		}
+
+		if ( mm_btree_iter_end( &it ) || mm_btree_iter_key( &it ) != key || mm_btree_iter_value( &it ) != &present[ key ] ) {
+			return false;
+		}
+
+		mm_btree_iter_next( &it );
+		++size;
+	}
+
+	return mm_btree_iter_end( &it ) && mm_btree_size( tree ) == size;
+}
+
+MM_UNIT_CASE( insert_erase_case, NULL, NULL ) {
+	struct mm_random r;
+	MM_BTREE_DECLARE( tree );
+
+	mm_random_reset( &r, 5 );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		present[ i ] = false;
+	}
+
+	// grow, then mostly shrink, so both splits and merges happen at every level
+	for ( size_t round = 0; round < 2; ++round ) {
+		for ( size_t i = 0; i < COUNT * 2; ++i ) {
+			mm_btree_key_t key = mm_random_next( &r, 0, COUNT );
+			bool insert = mm_random_next( &r, 0, 100 ) < ( round ? 30 : 70 );
+
+			if ( insert ) {
+				MM_UNIT_ASSERT_EQ( mm_btree_insert( &tree, key, &present[ key ] ), true );
+				present[ key ] = true;
+			} else {
+				void *value = NULL;
+
+				MM_UNIT_ASSERT_EQ( mm_btree_erase( &tree, key, &value ), present[ key ] );
+				MM_UNIT_ASSERT( !present[ key ] || value == &present[ key ], "erase returned the wrong value" );
+				present[ key ] = false;
+			}
+		}
+
+		MM_UNIT_ASSERT( tree_matches( &tree ), "btree doesn't match reference" );
+	}
+
+	for ( mm_btree_key_t key = 0; key < COUNT; ++key ) {
+		void **value = mm_btree_find( &tree, key );
+
+		MM_UNIT_ASSERT_EQ( value != NULL, present[ key ] );
+		mm_btree_erase( &tree, key, NULL );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_btree_empty( &tree ), true );
+	MM_UNIT_ASSERT_EQ( tree.root, NULL );
+	mm_btree_destroy( &tree );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bulk_load_case, NULL, NULL ) {
+	MM_VECTOR_DECLARE( entries, struct mm_btree_entry, NULL );
+	MM_BTREE_DECLARE( tree );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		present[ i ] = i % 3 != 0;
+
+		if ( present[ i ] ) {
+			struct mm_btree_entry entry = { .key = i, .value = &present[ i ] };
+			MM_UNIT_ASSERT_EQ( mm_vector_push_back( &entries, &entry ), true );
+		}
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_btree_bulk_load( &tree, &entries ), true );
+	MM_UNIT_ASSERT( tree_matches( &tree ), "bulk loaded btree doesn't match reference" );
+
+	// lower bound lands on the next present key
+	struct mm_btree_iter it = mm_btree_lower_bound( &tree, 3 );
+	MM_UNIT_ASSERT_EQ( mm_btree_iter_key( &it ), 4 );
+
+	it = mm_btree_lower_bound( &tree, COUNT );
+	MM_UNIT_ASSERT_EQ( mm_btree_iter_end( &it ), true );
+
+	// the bulk loaded tree must stay valid when modified afterwards
+	for ( mm_btree_key_t key = 0; key < COUNT; key += 3 ) {
+		MM_UNIT_ASSERT_EQ( mm_btree_insert( &tree, key, &present[ key ] ), true );
+		present[ key ] = true;
+	}
+
+	MM_UNIT_ASSERT( tree_matches( &tree ), "btree doesn't match reference" );
+
+	mm_btree_destroy( &tree );
+	mm_vector_destroy( &entries );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( btree_suite ) {
+	MM_UNIT_RUN( insert_erase_case );
+	MM_UNIT_RUN( bulk_load_case );
+
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,363 @@
+#include "mm/cchan.h"
+#include "mm/chan.h"
+#include "mm/unit.h"
+
+#define VALUES 100
+#define SUBS 3
+#define PRODUCERS 4
+#define WORKERS 4
+
+static struct mm_sched sched;
+static struct mm_chan chans[ 2 ];
+
+struct peer {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_chan *chan;
+	enum mm_chan_status status;
+	int value;
+	int count;
+	long sum;
+	bool ordered;
+};
+
+static struct peer peers[ SUBS + 2 ];
+
+static void peers_init( void ) {
+	mm_sched_init( &sched, NULL, NULL );
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( peers ); ++i ) {
+		MM_CO_INIT( &peers[ i ].co );
+		peers[ i ].count = 0;
+		peers[ i ].sum = 0;
+		peers[ i ].ordered = true;
+	}
+}
+
+static bool chan_setup( void ) {
+	peers_init();
+
+	return MM_CHAN_INIT( &chans[ 0 ], &sched, int, 4 ) && MM_CHAN_INIT( &chans[ 1 ], &sched, int, 0 );
+}
+
+static void chan_teardown( void ) {
+	mm_chan_destroy( &chans[ 0 ] );
+	mm_chan_destroy( &chans[ 1 ] );
+}
+
+MM_COROUTINE( chan_producer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->value = 0; this->value < VALUES; ++this->value ) {
+		MM_CO_SEND( &this->co, task, this->chan, &this->value, this->status );
+		++this->count;
+	}
+
+	mm_chan_close( this->chan );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( chan_consumer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_RECV( &this->co, task, this->chan, &this->value, this->status );
+
+		if ( this->status == MM_CHAN_CLOSED ) {
+			break;
+		}
+
+		this->ordered &= this->value == this->count;
+		this->sum += this->value;
+		++this->count;
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( chan_buffered_case, chan_setup, chan_teardown ) {
+	peers[ 0 ].chan = &chans[ 0 ];
+	mm_sched_spawn( &sched, &peers[ 0 ].task, chan_producer );
+
+	// fills the buffer, then parks instead of spinning
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].count, 4 );
+	MM_UNIT_ASSERT_EQ( mm_chan_size( &chans[ 0 ] ), 4 );
+	MM_UNIT_ASSERT_EQ( mm_sched_event_has_waiters( &chans[ 0 ].senders ), true );
+
+	peers[ 1 ].chan = &chans[ 0 ];
+	mm_sched_spawn( &sched, &peers[ 1 ].task, chan_consumer );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( sched.count, 0 );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].count, VALUES );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].sum, VALUES * ( VALUES - 1 ) / 2 );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].ordered, true );
+	MM_UNIT_ASSERT_EQ( mm_chan_try_send( &chans[ 0 ], &peers[ 0 ].value ), MM_CHAN_CLOSED );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( chan_unbuffered_case, chan_setup, chan_teardown ) {
+	int value = 7;
+
+	// nobody receives, so nothing goes through
+	MM_UNIT_ASSERT_EQ( mm_chan_try_send( &chans[ 1 ], &value ), MM_CHAN_AGAIN );
+
+	peers[ 0 ].chan = &chans[ 1 ];
+	mm_sched_spawn( &sched, &peers[ 0 ].task, chan_producer );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].count, 0 );
+	MM_UNIT_ASSERT_EQ( mm_chan_size( &chans[ 1 ] ), 0 );
+
+	peers[ 1 ].chan = &chans[ 1 ];
+	mm_sched_spawn( &sched, &peers[ 1 ].task, chan_consumer );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( sched.count, 0 );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].count, VALUES );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].ordered, true );
+
+	return MM_UNIT_DONE;
+}
+
+static struct mm_chan_case cases[ 2 ];
+static struct mm_chan_select selection;
+static int selected[ 2 ];
+
+MM_COROUTINE( chan_selector, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	while ( selection.count ) {
+		MM_CO_SELECT( &this->co, &selection, this->count );
+
+		if ( selection.status == MM_CHAN_CLOSED ) {
+			// drop the case, a closed channel would always be ready
+			cases[ this->count ] = cases[ --selection.count ];
+			mm_list_init( &cases[ this->count ].list );
+		} else {
+			selected[ cases[ this->count ].chan == &chans[ 1 ] ] += 1;
+			this->sum += this->value;
+		}
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( chan_select_case, chan_setup, chan_teardown ) {
+	selected[ 0 ] = 0;
+	selected[ 1 ] = 0;
+	mm_chan_case_recv( &cases[ 0 ], &chans[ 0 ], &peers[ 2 ].value );
+	mm_chan_case_recv( &cases[ 1 ], &chans[ 1 ], &peers[ 2 ].value );
+	mm_chan_select_init( &selection, &peers[ 2 ].task, cases, 2 );
+
+	// the chan_selector parks on both channels before anything is sent
+	mm_sched_spawn( &sched, &peers[ 2 ].task, chan_selector );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( sched.count, 1 );
+
+	peers[ 0 ].chan = &chans[ 0 ];
+	peers[ 1 ].chan = &chans[ 1 ];
+	mm_sched_spawn( &sched, &peers[ 0 ].task, chan_producer );
+	mm_sched_spawn( &sched, &peers[ 1 ].task, chan_producer );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( sched.count, 0 );
+	MM_UNIT_ASSERT_EQ( selected[ 0 ], VALUES );
+	MM_UNIT_ASSERT_EQ( selected[ 1 ], VALUES );
+	MM_UNIT_ASSERT_EQ( peers[ 2 ].sum, VALUES * ( VALUES - 1 ) );
+
+	return MM_UNIT_DONE;
+}
+
+static struct mm_chan_bcast bcast;
+static struct mm_chan_sub subs[ SUBS ];
+
+static bool bcast_setup( void ) {
+	peers_init();
+
+	return MM_CHAN_BCAST_INIT( &bcast, &sched, int, 2 );
+}
+
+static void bcast_teardown( void ) {
+	mm_chan_bcast_destroy( &bcast );
+}
+
+MM_COROUTINE( bcast_producer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->value = 0; this->value < VALUES; ++this->value ) {
+		MM_CO_BCAST_SEND( &this->co, task, &bcast, &this->value, this->status );
+	}
+
+	mm_chan_bcast_close( &bcast );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( chan_subscriber, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+	struct mm_chan_sub *sub = &subs[ this - peers - 1 ];
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_SUB_RECV( &this->co, task, sub, &this->value, this->status );
+
+		if ( this->status == MM_CHAN_CLOSED ) {
+			break;
+		}
+
+		this->ordered &= this->value == this->count;
+		++this->count;
+	}
+
+	mm_chan_sub_destroy( sub );
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( chan_bcast_case, bcast_setup, bcast_teardown ) {
+	int value = 1;
+
+	// dropped, nobody listens yet
+	MM_UNIT_ASSERT_EQ( mm_chan_bcast_try_send( &bcast, &value ), MM_CHAN_OK );
+
+	for ( size_t i = 0; i < SUBS; ++i ) {
+		mm_chan_sub_init( &subs[ i ], &bcast );
+		mm_sched_spawn( &sched, &peers[ i + 1 ].task, chan_subscriber );
+	}
+
+	mm_sched_spawn( &sched, &peers[ 0 ].task, bcast_producer );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( sched.count, 0 );
+
+	for ( size_t i = 0; i < SUBS; ++i ) {
+		MM_UNIT_ASSERT_EQ( peers[ i + 1 ].count, VALUES );
+		MM_UNIT_ASSERT_EQ( peers[ i + 1 ].ordered, true );
+	}
+
+	MM_UNIT_ASSERT_EQ( bcast.head, bcast.tail );
+	MM_UNIT_ASSERT_EQ( bcast.subs, 0 );
+
+	return MM_UNIT_DONE;
+}
+
+static struct mm_executor executor;
+static struct mm_cchan cchan;
+static atomic_int producing;
+
+struct cpeer {
+	struct mm_executor_task task;
+	struct mm_co co;
+	enum mm_chan_status status;
+	int value;
+	long sum;
+};
+
+static struct cpeer cpeers[ PRODUCERS + 1 ];
+
+static bool cchan_setup( size_t capacity ) {
+	atomic_store( &producing, PRODUCERS );
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( cpeers ); ++i ) {
+		MM_CO_INIT( &cpeers[ i ].co );
+		cpeers[ i ].sum = 0;
+	}
+
+	if ( !mm_executor_init( &executor, WORKERS, false, NULL, NULL ) ) {
+		return false;
+	}
+
+	if ( !MM_CCHAN_INIT( &cchan, &executor, int, capacity ) ) {
+		mm_executor_destroy( &executor );
+		return false;
+	}
+
+	return true;
+}
+
+static bool cchan_buffered_setup( void ) {
+	return cchan_setup( 16 );
+}
+
+static bool cchan_unbuffered_setup( void ) {
+	return cchan_setup( 0 );
+}
+
+static void cchan_teardown( void ) {
+	mm_executor_destroy( &executor );
+	mm_cchan_destroy( &cchan );
+}
+
+MM_COROUTINE( cproducer, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->value = 0; this->value < VALUES * 10; ++this->value ) {
+		MM_CO_CCHAN_SEND( &this->co, task, &cchan, &this->value, this->status );
+	}
+
+	if ( atomic_fetch_sub( &producing, 1 ) == 1 ) {
+		mm_cchan_close( &cchan );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( cconsumer, struct mm_executor_task *task ) {
+	struct cpeer *this = MM_EXECUTOR_CONTAINER( task, struct cpeer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_CCHAN_RECV( &this->co, task, &cchan, &this->value, this->status );
+
+		if ( this->status == MM_CHAN_CLOSED ) {
+			break;
+		}
+
+		this->sum += this->value;
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static bool cchan_fan_in( void ) {
+	mm_executor_spawn( &executor, &cpeers[ PRODUCERS ].task, cconsumer );
+
+	for ( size_t i = 0; i < PRODUCERS; ++i ) {
+		mm_executor_spawn( &executor, &cpeers[ i ].task, cproducer );
+	}
+
+	mm_executor_wait( &executor );
+
+	return cpeers[ PRODUCERS ].sum == ( long ) PRODUCERS * VALUES * 10 * ( VALUES * 10 - 1 ) / 2;
+}
+
+MM_UNIT_CASE( cchan_buffered_case, cchan_buffered_setup, cchan_teardown ) {
+	MM_UNIT_ASSERT_EQ( cchan_fan_in(), true );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( cchan_unbuffered_case, cchan_unbuffered_setup, cchan_teardown ) {
+	MM_UNIT_ASSERT_EQ( cchan_fan_in(), true );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( chan_suite ) {
+	MM_UNIT_RUN( chan_buffered_case );
+	MM_UNIT_RUN( chan_unbuffered_case );
+	MM_UNIT_RUN( chan_select_case );
+	MM_UNIT_RUN( chan_bcast_case );
+	MM_UNIT_RUN( cchan_buffered_case );
+	MM_UNIT_RUN( cchan_unbuffered_case );
+
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,143 @@
+#include <threads.h>
+#include "mm/cmap.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 20000
+#define STABLE 1000
+#define WRITERS 2
+#define READERS 2
+
+// values are pointers into this array, value[ key ] belongs to key
+static char values[ COUNT ];
+static bool present[ COUNT ];
+
+static struct mm_cmap shared;
+static atomic_bool stop;
+static atomic_size_t errors;
+
+MM_UNIT_CASE( single_thread_case, NULL, NULL ) {
+	struct mm_cmap map;
+	struct mm_random r;
+
+	MM_UNIT_ASSERT_EQ( mm_cmap_init( &map, 4 ), true );
+	MM_UNIT_ASSERT_EQ( mm_cmap_find( &map, 0 ), NULL );
+	mm_random_reset( &r, 21 );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		present[ i ] = false;
+	}
+
+	for ( size_t round = 0; round < 2; ++round ) {
+		for ( size_t i = 0; i < COUNT * 4; ++i ) {
+			uint_least64_t key = mm_random_next( &r, 0, COUNT );
+
+			if ( mm_random_next( &r, 0, 100 ) < ( round ? 30 : 70 ) ) {
+				MM_UNIT_ASSERT_EQ( mm_cmap_insert( &map, key, &values[ key ] ), true );
+				present[ key ] = true;
+			} else {
+				void *value = NULL;
+
+				MM_UNIT_ASSERT_EQ( mm_cmap_erase( &map, key, &value ), present[ key ] );
+				MM_UNIT_ASSERT( !present[ key ] || value == &values[ key ], "erase returned the wrong value" );
+				present[ key ] = false;
+			}
+		}
+
+		size_t size = 0;
+
+		for ( uint_least64_t key = 0; key < COUNT; ++key ) {
+			MM_UNIT_ASSERT_EQ( mm_cmap_find( &map, key ), present[ key ] ? &values[ key ] : NULL );
+			size += present[ key ];
+		}
+
+		MM_UNIT_ASSERT_EQ( mm_cmap_size( &map ), size );
+		mm_cmap_reclaim( &map );
+	}
+
+	mm_cmap_destroy( &map );
+
+	return MM_UNIT_DONE;
+}
+
+// keys below STABLE never change, the rest are owned by one writer each and keep flipping
+static int writer( void *arg ) {
+	uint_least64_t id = ( uintptr_t ) arg;
+
+	for ( size_t round = 0; round < 20; ++round ) {
+		for ( uint_least64_t key = STABLE + id; key < COUNT; key += WRITERS ) {
+			if ( !mm_cmap_insert( &shared, key, &values[ key ] ) ) {
+				atomic_fetch_add( &errors, 1 );
+			}
+		}
+
+		for ( uint_least64_t key = STABLE + id; key < COUNT; key += WRITERS ) {
+			mm_cmap_erase( &shared, key, NULL );
+		}
+	}
+
+	return 0;
+}
+
+static int reader( void *arg ) {
+	( void ) arg;
+
+	while ( !atomic_load( &stop ) ) {
+		for ( uint_least64_t key = 0; key < COUNT; ++key ) {
+			void *value = mm_cmap_find( &shared, key );
+
+			if ( key < STABLE ? value != &values[ key ] : value && value != &values[ key ] ) {
+				atomic_fetch_add( &errors, 1 );
+			}
+		}
+
+		thrd_yield();
+	}
+
+	return 0;
+}
+
+MM_UNIT_CASE( concurrent_case, NULL, NULL ) {
+	thrd_t writers[ WRITERS ];
+	thrd_t readers[ READERS ];
+
+	MM_UNIT_ASSERT_EQ( mm_cmap_init( &shared, 2 ), true );
+	atomic_store( &stop, false );
+	atomic_store( &errors, 0 );
+
+	for ( uint_least64_t key = 0; key < STABLE; ++key ) {
+		MM_UNIT_ASSERT_EQ( mm_cmap_insert( &shared, key, &values[ key ] ), true );
+	}
+
+	// readers run through every resize and tombstone reuse the writers cause
+	for ( size_t i = 0; i < READERS; ++i ) {
+		MM_UNIT_ASSERT_EQ( thrd_create( &readers[ i ], reader, NULL ), thrd_success );
+	}
+
+	for ( size_t i = 0; i < WRITERS; ++i ) {
+		MM_UNIT_ASSERT_EQ( thrd_create( &writers[ i ], writer, ( void* ) ( uintptr_t ) i ), thrd_success );
+	}
+
+	for ( size_t i = 0; i < WRITERS; ++i ) {
+		thrd_join( writers[ i ], NULL );
+	}
+
+	atomic_store( &stop, true );
+
+	for ( size_t i = 0; i < READERS; ++i ) {
+		thrd_join( readers[ i ], NULL );
+	}
+
+	MM_UNIT_ASSERT_EQ( atomic_load( &errors ), 0 );
+	MM_UNIT_ASSERT_EQ( mm_cmap_size( &shared ), STABLE );
+	mm_cmap_destroy( &shared );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( cmap_suite ) {
+	MM_UNIT_RUN( single_thread_case );
+	MM_UNIT_RUN( concurrent_case );
+
+	return MM_UNIT_DONE;
+}
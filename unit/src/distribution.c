@@ -0,0 +1,172 @@
+#include <math.h>
+#include "mm/distribution.h"
+#include "mm/unit.h"
+
+#define SAMPLES 1000000
+
+// small n against the exact probabilities, s on both sides of 1 and at 1 where the helpers kick in
+MM_UNIT_CASE( zipf_case, NULL, NULL ) {
+	static const double exponents[] = { 0.5, 1.0, 1.5 };
+	struct mm_zipf zipf;
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+	MM_UNIT_ASSERT( !mm_zipf_init( &zipf, 0, 1.0 ), "zipf over no ranks" );
+	MM_UNIT_ASSERT( !mm_zipf_init( &zipf, 10, 0.0 ), "zipf with s = 0" );
+
+	for ( size_t e = 0; e < MM_ARR_SIZE( exponents ); ++e ) {
+		unsigned long hits[ 10 ] = { 0 };
+		double norm = 0.0;
+
+		MM_UNIT_ASSERT( mm_zipf_init( &zipf, 10, exponents[ e ] ), "zipf init failed" );
+
+		for ( size_t k = 0; k < 10; ++k ) {
+			norm += pow( ( double ) k + 1.0, -exponents[ e ] );
+		}
+
+		for ( size_t i = 0; i < SAMPLES; ++i ) {
+			uint_least64_t k = mm_zipf_next( &zipf, &r );
+
+			MM_UNIT_ASSERT_LESS( k, 10 );
+			++hits[ k ];
+		}
+
+		for ( size_t k = 0; k < 10; ++k ) {
+			double expected = pow( ( double ) k + 1.0, -exponents[ e ] ) / norm;
+			double seen = ( double ) hits[ k ] / SAMPLES;
+
+			MM_UNIT_ASSERT_RANGE( expected * 0.95, expected * 1.05, seen );
+		}
+	}
+
+	// no table behind it, so the number of ranks doesn't matter
+	MM_UNIT_ASSERT( mm_zipf_init( &zipf, UINT64_C( 1 ) << 40, 1.1 ), "zipf init failed" );
+
+	{
+		uint_least64_t out[ 1024 ];
+		size_t first = 0;
+
+		mm_zipf_fill( &zipf, &r, out, MM_ARR_SIZE( out ) );
+
+		for ( size_t i = 0; i < MM_ARR_SIZE( out ); ++i ) {
+			MM_UNIT_ASSERT_LESS( out[ i ], UINT64_C( 1 ) << 40 );
+			first += out[ i ] == 0;
+		}
+
+		// P( 0 ) is 1 / zeta( 1.1 ) up to the cut off tail, about 0.094
+		MM_UNIT_ASSERT_RANGE( 60, 135, first );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( normal_case, NULL, NULL ) {
+	static double out[ 1000 ];
+	struct mm_random r;
+	double sum = 0.0;
+	double squares = 0.0;
+	unsigned long tail = 0;
+	unsigned long far = 0;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < SAMPLES; i += MM_ARR_SIZE( out ) ) {
+		mm_random_normal_fill( &r, out, MM_ARR_SIZE( out ) );
+
+		for ( size_t j = 0; j < MM_ARR_SIZE( out ); ++j ) {
+			sum += out[ j ];
+			squares += out[ j ] * out[ j ];
+			tail += fabs( out[ j ] ) > 3.0;
+			far += out[ j ] > 3.6541528853610088;
+		}
+	}
+
+	sum /= SAMPLES;
+	squares /= SAMPLES;
+
+	MM_UNIT_ASSERT_RANGE( -0.005, 0.005, sum );
+	MM_UNIT_ASSERT_RANGE( 0.99, 1.01, squares - sum * sum );
+	// P( |X| > 3 ) = 0.0027, P( X > r ) = 0.000129 comes from the tail sampler alone
+	MM_UNIT_ASSERT_RANGE( 2450, 2950, tail );
+	MM_UNIT_ASSERT_RANGE( 90, 170, far );
+	MM_UNIT_ASSERT( isfinite( mm_random_normal( &r ) ), "normal sample not finite" );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( exponential_case, NULL, NULL ) {
+	static double out[ 1000 ];
+	struct mm_random r;
+	double sum = 0.0;
+	unsigned long above = 0;
+
+	mm_random_reset( &r, 42 );
+
+	for ( size_t i = 0; i < SAMPLES; i += MM_ARR_SIZE( out ) ) {
+		mm_random_exponential_fill( &r, out, MM_ARR_SIZE( out ) );
+
+		for ( size_t j = 0; j < MM_ARR_SIZE( out ); ++j ) {
+			MM_UNIT_ASSERT_GREATER_EQ( out[ j ], 0.0 );
+			sum += out[ j ];
+			above += out[ j ] > 3.0;
+		}
+	}
+
+	// P( X > 3 ) = e^-3 = 0.0498
+	MM_UNIT_ASSERT_RANGE( 0.99, 1.01, sum / SAMPLES );
+	MM_UNIT_ASSERT_RANGE( 48500, 51200, above );
+	MM_UNIT_ASSERT_GREATER_EQ( mm_random_exponential( &r ), 0.0 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( alias_case, NULL, NULL ) {
+	static const double weights[] = { 1.0, 0.0, 2.0, 3.0, 0.0, 4.0, 0.5, 0.5 };
+	static const double invalid[] = { 1.0, -1.0 };
+	static const double zero[] = { 0.0, 0.0 };
+	unsigned long hits[ MM_ARR_SIZE( weights ) ] = { 0 };
+	size_t out[ 1000 ];
+	struct mm_alias alias;
+	struct mm_random r;
+
+	mm_random_reset( &r, 42 );
+	MM_UNIT_ASSERT( !mm_alias_init( &alias, weights, 0 ), "alias over no weights" );
+	MM_UNIT_ASSERT( !mm_alias_init( &alias, invalid, MM_ARR_SIZE( invalid ) ), "alias with a negative weight" );
+	MM_UNIT_ASSERT( !mm_alias_init( &alias, zero, MM_ARR_SIZE( zero ) ), "alias with no mass" );
+	MM_UNIT_ASSERT( mm_alias_init( &alias, weights, MM_ARR_SIZE( weights ) ), "alias init failed" );
+
+	for ( size_t i = 0; i < SAMPLES; i += MM_ARR_SIZE( out ) ) {
+		mm_alias_fill( &alias, &r, out, MM_ARR_SIZE( out ) );
+
+		for ( size_t j = 0; j < MM_ARR_SIZE( out ); ++j ) {
+			MM_UNIT_ASSERT_LESS( out[ j ], MM_ARR_SIZE( weights ) );
+			++hits[ out[ j ] ];
+		}
+	}
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( weights ); ++i ) {
+		double expected = weights[ i ] / 11.0;
+		double seen = ( double ) hits[ i ] / SAMPLES;
+
+		MM_UNIT_ASSERT_RANGE( expected * 0.97, expected * 1.03, seen );
+	}
+
+	MM_UNIT_ASSERT_EQ( 0, hits[ 1 ] );
+	MM_UNIT_ASSERT_EQ( 0, hits[ 4 ] );
+	mm_alias_destroy( &alias );
+
+	// a single weight always comes up
+	MM_UNIT_ASSERT( mm_alias_init( &alias, weights + 2, 1 ), "alias init failed" );
+	MM_UNIT_ASSERT_EQ( 0, mm_alias_next( &alias, &r ) );
+	mm_alias_destroy( &alias );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( distribution_suite ) {
+	MM_UNIT_RUN( zipf_case );
+	MM_UNIT_RUN( normal_case );
+	MM_UNIT_RUN( exponential_case );
+	MM_UNIT_RUN( alias_case );
+	return MM_UNIT_DONE;
+}
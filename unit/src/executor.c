@@ -0,0 +1,284 @@
+#include <time.h>
+#include "mm/executor.h"
+#include "mm/unit.h"
+
+#define WORKERS 4
+#define TASKS 10000
+#define WAKES 1000
+#define FIB_N 18
+
+static struct mm_executor executor;
+static atomic_size_t steps;
+static atomic_size_t retired;
+
+static void on_retire( struct mm_executor_task *task, void *ctx ) {
+	( void ) task;
+	( void ) ctx;
+	atomic_fetch_add( &retired, 1 );
+}
+
+static bool setup( void ) {
+	atomic_store( &steps, 0 );
+	atomic_store( &retired, 0 );
+
+	return mm_executor_init( &executor, WORKERS, false, on_retire, NULL );
+}
+
+static void teardown( void ) {
+	mm_executor_destroy( &executor );
+}
+
+struct job {
+	struct mm_executor_task task;
+	struct mm_co co;
+	size_t rounds;
+};
+
+static struct job jobs[ TASKS ];
+
+MM_COROUTINE( yielding_job, struct mm_executor_task *task ) {
+	struct job *this = MM_EXECUTOR_CONTAINER( task, struct job, task );
+
+	MM_CO_BEGIN( &this->co );
+	atomic_fetch_add( &steps, 1 );
+	MM_CO_YIELD( &this->co );
+	atomic_fetch_add( &steps, 1 );
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( spawn_case, setup, teardown ) {
+	for ( size_t i = 0; i < TASKS; ++i ) {
+		MM_CO_INIT( &jobs[ i ].co );
+		mm_executor_spawn( &executor, &jobs[ i ].task, yielding_job );
+	}
+
+	mm_executor_wait( &executor );
+	MM_UNIT_ASSERT_EQ( atomic_load( &steps ), TASKS * 2 );
+	MM_UNIT_ASSERT_EQ( atomic_load( &retired ), TASKS );
+
+	for ( size_t i = 0; i < TASKS; ++i ) {
+		MM_UNIT_ASSERT_EQ( atomic_load( &jobs[ i ].task.state ), MM_EXECUTOR_DONE );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+// parks after every round, only a wake from another thread moves it on
+MM_COROUTINE( parking_job, struct mm_executor_task *task ) {
+	struct job *this = MM_EXECUTOR_CONTAINER( task, struct job, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->rounds = 0; this->rounds < WAKES; ++this->rounds ) {
+		atomic_fetch_add( &steps, 1 );
+		MM_CO_WAIT_WAKE( &this->co );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static int waker( void *arg ) {
+	size_t count = *( size_t* ) arg;
+
+	// wakes land at any point, including while the task still runs, none may get lost
+	while ( atomic_load( &retired ) < count ) {
+		for ( size_t i = 0; i < count; ++i ) {
+			mm_executor_wake( &executor, &jobs[ i ].task );
+		}
+	}
+
+	return 0;
+}
+
+MM_UNIT_CASE( wake_case, setup, teardown ) {
+	size_t count = 8;
+	thrd_t thread;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		MM_CO_INIT( &jobs[ i ].co );
+		mm_executor_spawn( &executor, &jobs[ i ].task, parking_job );
+	}
+
+	MM_UNIT_ASSERT_EQ( thrd_create( &thread, waker, &count ), thrd_success );
+	mm_executor_wait( &executor );
+	thrd_join( thread, NULL );
+	MM_UNIT_ASSERT_EQ( atomic_load( &steps ), count * WAKES );
+	MM_UNIT_ASSERT_EQ( atomic_load( &retired ), count );
+
+	return MM_UNIT_DONE;
+}
+
+static atomic_bool flags[ WORKERS ];
+static atomic_bool lost;
+
+// checks its flag before it parks, like any lock free user of MM_CO_WAIT_WAKE
+MM_COROUTINE( flag_job, struct mm_executor_task *task ) {
+	struct job *this = MM_EXECUTOR_CONTAINER( task, struct job, task );
+	atomic_bool *flag = &flags[ this - jobs ];
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->rounds = 0; this->rounds < WAKES; ) {
+		if ( atomic_load( flag ) ) {
+			atomic_store( flag, false );
+			++this->rounds;
+		} else {
+			MM_CO_WAIT_WAKE( &this->co );
+		}
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static uint_least64_t now_ns( void ) {
+	struct timespec ts;
+
+	timespec_get( &ts, TIME_UTC );
+
+	return ( uint_least64_t ) ts.tv_sec * 1000000000u + ( uint_least64_t ) ts.tv_nsec;
+}
+
+// one wake per flag, sent as soon as the task consumed the last one, so it often arrives while the task is picked up
+static int flag_waker( void *arg ) {
+	uint_least64_t progress = now_ns();
+
+	( void ) arg;
+
+	while ( atomic_load( &retired ) < WORKERS ) {
+		bool sent = false;
+
+		for ( size_t i = 0; i < WORKERS; ++i ) {
+			if ( !atomic_load( &flags[ i ] ) ) {
+				atomic_store( &flags[ i ], true );
+				mm_executor_wake( &executor, &jobs[ i ].task );
+				progress = now_ns();
+				sent = true;
+			}
+		}
+
+		if ( !sent ) {
+			thrd_yield();
+		}
+
+		// a flag nobody consumed for a second means its wake got lost, waking again lets the test finish
+		if ( now_ns() - progress > 1000000000u ) {
+			atomic_store( &lost, true );
+
+			for ( size_t i = 0; i < WORKERS; ++i ) {
+				mm_executor_wake( &executor, &jobs[ i ].task );
+			}
+		}
+	}
+
+	return 0;
+}
+
+MM_UNIT_CASE( wake_flag_case, setup, teardown ) {
+	thrd_t thread;
+
+	atomic_store( &lost, false );
+
+	for ( size_t i = 0; i < WORKERS; ++i ) {
+		atomic_store( &flags[ i ], false );
+		MM_CO_INIT( &jobs[ i ].co );
+		mm_executor_spawn( &executor, &jobs[ i ].task, flag_job );
+	}
+
+	MM_UNIT_ASSERT_EQ( thrd_create( &thread, flag_waker, NULL ), thrd_success );
+	mm_executor_wait( &executor );
+	thrd_join( thread, NULL );
+	MM_UNIT_ASSERT( !atomic_load( &lost ), "wake lost" );
+	MM_UNIT_ASSERT_EQ( atomic_load( &retired ), WORKERS );
+
+	return MM_UNIT_DONE;
+}
+
+struct fib {
+	struct mm_executor_task task;
+	struct mm_co co;
+	struct fib *parent;
+	atomic_ulong sum; //!< \brief results of the children
+	atomic_int pending;
+	unsigned int n;
+	unsigned long result;
+};
+
+static void fib_retire( struct mm_executor_task *task, void *ctx ) {
+	struct fib *this = MM_EXECUTOR_CONTAINER( task, struct fib, task );
+
+	( void ) ctx;
+
+	// the root lives on the stack of the test, every other node is freed once the executor lets go of it
+	if ( this->parent ) {
+		MM_FREE( this );
+	}
+}
+
+static bool fib_setup( void ) {
+	return mm_executor_init( &executor, WORKERS, false, fib_retire, NULL );
+}
+
+MM_COROUTINE( fib_job, struct mm_executor_task *task ) {
+	struct fib *this = MM_EXECUTOR_CONTAINER( task, struct fib, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	if ( this->n < 2 ) {
+		this->result = this->n;
+	} else {
+		atomic_init( &this->sum, 0 );
+		atomic_init( &this->pending, 2 );
+
+		for ( unsigned int i = 0; i < 2; ++i ) {
+			struct fib *child = MM_MALLOC( sizeof( *child ) );
+
+			child->parent = this;
+			child->n = this->n - 1 - i;
+			MM_CO_INIT( &child->co );
+			mm_executor_spawn( &executor, &child->task, fib_job );
+		}
+
+		// the last child to finish wakes the parent
+		MM_CO_WAIT_WAKE( &this->co );
+		this->result = atomic_load( &this->sum );
+	}
+
+	if ( this->parent ) {
+		atomic_fetch_add( &this->parent->sum, this->result );
+
+		if ( atomic_fetch_sub( &this->parent->pending, 1 ) == 1 ) {
+			mm_executor_wake( &executor, &this->parent->task );
+		}
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( fork_join_case, fib_setup, teardown ) {
+	struct fib root = { .parent = NULL, .n = FIB_N };
+	unsigned long a = 0, b = 1;
+
+	MM_CO_INIT( &root.co );
+	mm_executor_spawn( &executor, &root.task, fib_job );
+	mm_executor_wait( &executor );
+
+	for ( unsigned int i = 0; i < FIB_N; ++i ) {
+		unsigned long next = a + b;
+
+		a = b;
+		b = next;
+	}
+
+	MM_UNIT_ASSERT_EQ( root.result, a );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( executor_suite ) {
+	MM_UNIT_RUN( spawn_case );
+	MM_UNIT_RUN( wake_case );
+	MM_UNIT_RUN( wake_flag_case );
+	MM_UNIT_RUN( fork_join_case );
+
+	return MM_UNIT_DONE;
+}
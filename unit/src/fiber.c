@@ -0,0 +1,177 @@
+#include "mm/fiber.h"
+#include "mm/unit.h"
+
+#define DEPTH 200
+#define STACK_SIZE ( 256 * 1024 )
+
+static struct mm_fiber_pool pool;
+static int produced;
+static bool self_ok;
+
+// yields from every level of a deep recursion, the locals of each frame have to survive
+static int descend( int depth ) {
+	volatile int local = depth * 3;
+
+	produced = depth;
+	mm_fiber_yield( mm_fiber_self() );
+
+	if ( depth < DEPTH ) {
+		return local + descend( depth + 1 );
+	}
+
+	return local;
+}
+
+static void deep( struct mm_fiber *fiber, void *arg ) {
+	int *result = arg;
+
+	self_ok = mm_fiber_self() == fiber;
+	*result = descend( 0 );
+}
+
+static bool setup( void ) {
+	return mm_fiber_pool_init( &pool, STACK_SIZE, 4 );
+}
+
+static void teardown( void ) {
+	mm_fiber_pool_destroy( &pool );
+}
+
+MM_UNIT_CASE( nested_yield_case, setup, teardown ) {
+	struct mm_fiber fiber;
+	int result = -1;
+	int expected = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fiber, &pool, deep, &result ), true );
+	MM_UNIT_ASSERT_EQ( mm_fiber_self(), NULL );
+
+	for ( int i = 0; i <= DEPTH; ++i ) {
+		MM_UNIT_ASSERT_EQ( mm_fiber_resume( &fiber ), MM_CO_SUSPENDED );
+		MM_UNIT_ASSERT_EQ( produced, i );
+		MM_UNIT_ASSERT_EQ( mm_fiber_self(), NULL );
+		expected += i * 3;
+	}
+
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fiber ), false );
+	MM_UNIT_ASSERT_EQ( result, expected );
+	MM_UNIT_ASSERT_EQ( self_ok, true );
+
+	// resuming a finished fiber is harmless
+	MM_UNIT_ASSERT_EQ( mm_fiber_resume( &fiber ), MM_CO_DONE );
+	mm_fiber_destroy( &fiber );
+
+	return MM_UNIT_DONE;
+}
+
+// callee saved floating point registers belong to each side of a switch
+static void accumulate( struct mm_fiber *fiber, void *arg ) {
+	double *out = arg;
+	double sum = 0;
+
+	for ( int i = 1; i <= 100; ++i ) {
+		sum += 1.0 / i;
+		MM_FIBER_YIELD( fiber );
+	}
+
+	*out = sum;
+}
+
+MM_UNIT_CASE( float_state_case, setup, teardown ) {
+	struct mm_fiber fiber;
+	double inside = 0, outside = 0, expected = 0, expected_outside = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fiber, &pool, accumulate, &inside ), true );
+
+	for ( int i = 1; MM_FIBER_RESUME( &fiber ); ++i ) {
+		outside += 2.0 / i;
+	}
+
+	for ( int i = 1; i <= 100; ++i ) {
+		expected += 1.0 / i;
+		expected_outside += 2.0 / i;
+	}
+
+	MM_UNIT_ASSERT_EQ( inside, expected );
+	MM_UNIT_ASSERT_EQ( outside, expected_outside );
+	mm_fiber_destroy( &fiber );
+
+	return MM_UNIT_DONE;
+}
+
+static struct mm_fiber inner_fiber;
+
+static void inner( struct mm_fiber *fiber, void *arg ) {
+	( void ) arg;
+	MM_FIBER_YIELD( fiber );
+}
+
+// a fiber resuming another fiber gets control back, and self follows along
+static void outer( struct mm_fiber *fiber, void *arg ) {
+	int *steps = arg;
+
+	while ( MM_FIBER_RESUME( &inner_fiber ) ) {
+		++*steps;
+		self_ok &= mm_fiber_self() == fiber;
+		MM_FIBER_YIELD( fiber );
+	}
+}
+
+MM_UNIT_CASE( nested_fiber_case, setup, teardown ) {
+	struct mm_fiber fiber;
+	int steps = 0;
+
+	self_ok = true;
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &inner_fiber, &pool, inner, NULL ), true );
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fiber, &pool, outer, &steps ), true );
+
+	while ( MM_FIBER_RESUME( &fiber ) );
+
+	MM_UNIT_ASSERT_EQ( steps, 1 );
+	MM_UNIT_ASSERT_EQ( self_ok, true );
+	mm_fiber_destroy( &fiber );
+	mm_fiber_destroy( &inner_fiber );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( pool_reuse_case, setup, teardown ) {
+	struct mm_fiber fibers[ 6 ];
+	void *stacks[ 6 ];
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( fibers ); ++i ) {
+		MM_UNIT_ASSERT_EQ( mm_fiber_init( &fibers[ i ], &pool, inner, NULL ), true );
+		stacks[ i ] = fibers[ i ].stack;
+	}
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( fibers ); ++i ) {
+		mm_fiber_destroy( &fibers[ i ] );
+	}
+
+	// only max_cached stacks stay mapped, handed out again newest first
+	MM_UNIT_ASSERT_EQ( pool.cached, 4 );
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fibers[ 0 ], &pool, inner, NULL ), true );
+	MM_UNIT_ASSERT_EQ( fibers[ 0 ].stack, stacks[ 3 ] );
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fibers[ 0 ] ), true );
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fibers[ 0 ] ), false );
+	mm_fiber_destroy( &fibers[ 0 ] );
+
+	// a fiber dropped halfway leaves a usable stack behind
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fibers[ 0 ], &pool, inner, NULL ), true );
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fibers[ 0 ] ), true );
+	mm_fiber_destroy( &fibers[ 0 ] );
+	MM_UNIT_ASSERT_EQ( mm_fiber_init( &fibers[ 0 ], &pool, inner, NULL ), true );
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fibers[ 0 ] ), true );
+	MM_UNIT_ASSERT_EQ( MM_FIBER_RESUME( &fibers[ 0 ] ), false );
+	mm_fiber_destroy( &fibers[ 0 ] );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( fiber_suite ) {
+	MM_UNIT_RUN( nested_yield_case );
+	MM_UNIT_RUN( float_state_case );
+	MM_UNIT_RUN( nested_fiber_case );
+	MM_UNIT_RUN( pool_reuse_case );
+
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,137 @@
+#include "mm/hash.h"
+#include "mm/hashmap.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define MAX_LEN 400
+#define KEYS 100000
+
+static unsigned char data[ MAX_LEN ];
+
+static bool setup( void ) {
+	struct mm_random r;
+
+	mm_random_reset( &r, 3 );
+
+	for ( size_t i = 0; i < MAX_LEN; ++i ) {
+		data[ i ] = ( unsigned char ) mm_random_next( &r, 0, 256 );
+	}
+
+	return true;
+}
+
+static inline uint_least64_t hash_id( uint_least64_t key ) {
+	return key;
+}
+
+static inline bool eq_key( uint_least64_t lhs, uint_least64_t rhs ) {
+	return lhs == rhs;
+}
+
+MM_HASHMAP_DEFINE( hash_set, uint_least64_t, bool, hash_id, eq_key )
+
+MM_UNIT_CASE( stream_case, setup, NULL ) {
+	struct mm_random r;
+
+	mm_random_reset( &r, 4 );
+
+	// every length around the 16 and 48 byte boundaries, split into random chunks
+	for ( size_t len = 0; len <= MAX_LEN; ++len ) {
+		uint_least64_t expected = mm_hash_bytes( data, len, 99 );
+
+		for ( size_t round = 0; round < 8; ++round ) {
+			struct mm_hash_state state;
+			size_t done = 0;
+
+			mm_hash_init( &state, 99 );
+
+			while ( done < len ) {
+				size_t chunk = mm_random_next( &r, 0, round < 4 ? 20 : 120 );
+
+				chunk = chunk > len - done ? len - done : chunk;
+				mm_hash_update( &state, data + done, chunk );
+				done += chunk;
+			}
+
+			MM_UNIT_ASSERT_EQ( mm_hash_final( &state ), expected );
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( fixed_size_case, setup, NULL ) {
+	uint_least64_t keys[ 64 ];
+	uint_least64_t batch[ 64 ];
+	const void *ptrs[ 64 ];
+	size_t lens[ 64 ];
+
+	for ( size_t i = 0; i < 64; ++i ) {
+		uint_least32_t key32;
+		uint_least64_t key128[ 2 ];
+
+		memcpy( &keys[ i ], data + i, sizeof( keys[ i ] ) );
+		memcpy( &key32, data + i, sizeof( key32 ) );
+		memcpy( key128, data + i, sizeof( key128 ) );
+
+		MM_UNIT_ASSERT_EQ( mm_hash_u32( key32, 7 ), mm_hash_bytes( data + i, 4, 7 ) );
+		MM_UNIT_ASSERT_EQ( mm_hash_u64( keys[ i ], 7 ), mm_hash_bytes( data + i, 8, 7 ) );
+		MM_UNIT_ASSERT_EQ( mm_hash_u128( key128[ 0 ], key128[ 1 ], 7 ), mm_hash_bytes( data + i, 16, 7 ) );
+
+		ptrs[ i ] = data + i;
+		lens[ i ] = i * 5;
+	}
+
+	mm_hash_u64_batch( keys, 64, 7, batch );
+
+	for ( size_t i = 0; i < 64; ++i ) {
+		MM_UNIT_ASSERT_EQ( batch[ i ], mm_hash_u64( keys[ i ], 7 ) );
+	}
+
+	mm_hash_bytes_batch( ptrs, lens, 64, 7, batch );
+
+	for ( size_t i = 0; i < 64; ++i ) {
+		MM_UNIT_ASSERT_EQ( batch[ i ], mm_hash_bytes( ptrs[ i ], lens[ i ], 7 ) );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( distribution_case, NULL, NULL ) {
+	struct hash_set set = MM_HASHMAP_INIT;
+	size_t bits[ 64 ] = { 0 };
+	uint_least64_t seed = mm_hash_seed();
+
+	MM_UNIT_ASSERT_NOT_EQ( seed, 0 );
+	MM_UNIT_ASSERT_EQ( mm_hash_seed(), seed );
+	MM_UNIT_ASSERT_NOT_EQ( mm_hash_u64( 1, seed ), mm_hash_u64( 1, seed + 1 ) );
+
+	// sequential keys must neither collide nor leave any output bit biased
+	for ( uint_least64_t key = 0; key < KEYS; ++key ) {
+		uint_least64_t h = mm_hash_u64( key, seed );
+		bool inserted;
+
+		MM_UNIT_ASSERT_NOT_EQ( hash_set_emplace( &set, h, &inserted ), NULL );
+		MM_UNIT_ASSERT_EQ( inserted, true );
+
+		for ( unsigned int i = 0; i < 64; ++i ) {
+			bits[ i ] += ( h >> i ) & 1;
+		}
+	}
+
+	for ( unsigned int i = 0; i < 64; ++i ) {
+		MM_UNIT_ASSERT_RANGE( KEYS / 2 - KEYS / 50, KEYS / 2 + KEYS / 50, bits[ i ] );
+	}
+
+	hash_set_destroy( &set );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( hash_suite ) {
+	MM_UNIT_RUN( stream_case );
+	MM_UNIT_RUN( fixed_size_case );
+	MM_UNIT_RUN( distribution_case );
+
+	return MM_UNIT_DONE;
+}
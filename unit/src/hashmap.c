@@ -0,0 +1,163 @@
+#include "mm/hashmap.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 20000
+
+static inline uint_least64_t hash_mix( uint_least64_t key ) {
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+
+	return key;
+}
+
+// few distinct hashes, so probe sequences run long and collide on h2
+static inline uint_least64_t hash_poor( uint_least64_t key ) {
+	return hash_mix( key % 64 );
+}
+
+static inline bool eq_key( uint_least64_t lhs, uint_least64_t rhs ) {
+	return lhs == rhs;
+}
+
+MM_HASHMAP_DEFINE( map_mix, uint_least64_t, size_t, hash_mix, eq_key )
+MM_HASHMAP_DEFINE( map_poor, uint_least64_t, size_t, hash_poor, eq_key )
+
+static size_t values[ COUNT ];
+static bool present[ COUNT ];
+
+#define CHECK_MAP( name, map, count )\
+	do {\
+		size_t size = 0;\
+		struct name##_slot *pos;\
+		\
+		for ( size_t i = 0; i < ( count ); ++i ) {\
+			size_t *value = name##_find( map, i );\
+			\
+			MM_UNIT_ASSERT_EQ( value != NULL, present[ i ] );\
+			MM_UNIT_ASSERT( !value || *value == values[ i ], "hashmap returned the wrong value" );\
+			size += present[ i ];\
+		}\
+		\
+		MM_UNIT_ASSERT_EQ( name##_size( map ), size );\
+		\
+		MM_HASHMAP_FOREACH( name, map, pos ) {\
+			MM_UNIT_ASSERT( pos->key < ( count ) && present[ pos->key ], "iterated a missing key" );\
+			--size;\
+		}\
+		\
+		MM_UNIT_ASSERT_EQ( size, 0 );\
+	} while ( 0 )
+
+#define RANDOM_OPS( name, map, count, seed )\
+	do {\
+		struct mm_random r;\
+		\
+		mm_random_reset( &r, seed );\
+		\
+		for ( size_t i = 0; i < ( count ); ++i ) {\
+			present[ i ] = false;\
+		}\
+		\
+		/* grow, then mostly shrink, so both rehashes and tombstone reuse happen */\
+		for ( size_t round = 0; round < 2; ++round ) {\
+			for ( size_t i = 0; i < ( count ) * 4; ++i ) {\
+				uint_least64_t key = mm_random_next( &r, 0, ( count ) );\
+				bool insert = mm_random_next( &r, 0, 100 ) < ( round ? 30 : 70 );\
+				\
+				if ( insert ) {\
+					bool inserted;\
+					size_t *value = name##_emplace( map, key, &inserted );\
+					\
+					MM_UNIT_ASSERT_NOT_EQ( value, NULL );\
+					MM_UNIT_ASSERT_EQ( inserted, !present[ key ] );\
+					values[ key ] = i;\
+					*value = i;\
+					present[ key ] = true;\
+				} else {\
+					size_t value = 0;\
+					\
+					MM_UNIT_ASSERT_EQ( name##_erase( map, key, &value ), present[ key ] );\
+					MM_UNIT_ASSERT( !present[ key ] || value == values[ key ], "erase returned the wrong value" );\
+					present[ key ] = false;\
+				}\
+			}\
+			\
+			CHECK_MAP( name, map, count );\
+		}\
+	} while ( 0 )
+
+MM_UNIT_CASE( emplace_erase_case, NULL, NULL ) {
+	struct map_mix map = MM_HASHMAP_INIT;
+
+	MM_UNIT_ASSERT_EQ( map_mix_find( &map, 0 ), NULL );
+	MM_UNIT_ASSERT_EQ( map_mix_erase( &map, 0, NULL ), false );
+
+	RANDOM_OPS( map_mix, &map, COUNT, 11 );
+
+	map_mix_clear( &map );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		present[ i ] = false;
+	}
+
+	CHECK_MAP( map_mix, &map, COUNT );
+	map_mix_destroy( &map );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( collision_case, NULL, NULL ) {
+	struct map_poor map;
+
+	map_poor_init( &map );
+	RANDOM_OPS( map_poor, &map, 2000, 12 );
+	map_poor_destroy( &map );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( reserve_churn_case, NULL, NULL ) {
+	struct map_mix map = MM_HASHMAP_INIT;
+
+	MM_UNIT_ASSERT_EQ( map_mix_reserve( &map, COUNT ), true );
+
+	size_t capacity = map.capacity;
+
+	MM_UNIT_ASSERT_GREATER_EQ( mm_hashmap_max_load( capacity ), COUNT );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		values[ i ] = i * 3;
+		present[ i ] = true;
+		MM_UNIT_ASSERT_EQ( map_mix_put( &map, i, values[ i ] ), true );
+	}
+
+	// a reserved map never rehashes while filling up
+	MM_UNIT_ASSERT_EQ( map.capacity, capacity );
+	CHECK_MAP( map_mix, &map, COUNT );
+
+	// churn at a constant size reuses erased slots instead of growing the table
+	for ( size_t i = 0; i < COUNT * 8; ++i ) {
+		size_t key = i % COUNT;
+
+		MM_UNIT_ASSERT_EQ( map_mix_erase( &map, key, NULL ), true );
+		MM_UNIT_ASSERT_EQ( map_mix_put( &map, key, values[ key ] ), true );
+	}
+
+	MM_UNIT_ASSERT_EQ( map.capacity, capacity );
+	CHECK_MAP( map_mix, &map, COUNT );
+	map_mix_destroy( &map );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( hashmap_suite ) {
+	MM_UNIT_RUN( emplace_erase_case );
+	MM_UNIT_RUN( collision_case );
+	MM_UNIT_RUN( reserve_churn_case );
+
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,76 @@
+#include "mm/itree.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 300
+#define RANGE 1000
+
+static struct mm_itree_node nodes[ COUNT ];
+static bool inserted[ COUNT ];
+
+static bool overlaps( struct mm_itree_node *node, uint_least64_t start, uint_least64_t end ) {
+	return node->start <= end && start <= node->end;
+}
+
+// check the tree returns exactly the intervals a linear scan finds, in start order
+static bool query_matches( struct mm_itree *tree, uint_least64_t start, uint_least64_t end ) {
+	struct mm_itree_node *pos;
+	size_t expected = 0;
+	size_t found = 0;
+	uint_least64_t prev = 0;
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		expected += inserted[ i ] && overlaps( &nodes[ i ], start, end );
+	}
+
+	MM_ITREE_FOREACH_OVERLAP( tree, pos, start, end ) {
+		if ( !inserted[ pos - nodes ] || !overlaps( pos, start, end ) || pos->start < prev ) {
+			return false;
+		}
+
+		prev = pos->start;
+		++found;
+	}
+
+	return found == expected;
+}
+
+MM_UNIT_CASE( overlap_case, NULL, NULL ) {
+	struct mm_random r;
+	MM_ITREE_DECLARE( tree );
+
+	mm_random_reset( &r, 7 );
+
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		nodes[ i ].start = mm_random_next( &r, 0, RANGE );
+		nodes[ i ].end = nodes[ i ].start + mm_random_next( &r, 0, 50 );
+		inserted[ i ] = false;
+	}
+
+	for ( size_t i = 0; i < COUNT * 4; ++i ) {
+		size_t j = mm_random_next( &r, 0, COUNT );
+
+		if ( inserted[ j ] ) {
+			mm_itree_erase( &tree, &nodes[ j ] );
+		} else {
+			mm_itree_insert( &tree, &nodes[ j ] );
+		}
+
+		inserted[ j ] = !inserted[ j ];
+
+		uint_least64_t start = mm_random_next( &r, 0, RANGE );
+		MM_UNIT_ASSERT( query_matches( &tree, start, start ), "point query mismatch" );
+		MM_UNIT_ASSERT( query_matches( &tree, start, start + mm_random_next( &r, 0, 100 ) ), "range query mismatch" );
+	}
+
+	MM_UNIT_ASSERT( query_matches( &tree, 0, RANGE * 2 ), "full range query mismatch" );
+	MM_UNIT_ASSERT_EQ( mm_itree_first_overlap( &tree, RANGE * 2, RANGE * 3 ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( itree_suite ) {
+	MM_UNIT_RUN( overlap_case );
+
+	return MM_UNIT_DONE;
+}
@@ -0,0 +1,109 @@
+#include <threads.h>
+#include "mm/lfstack.h"
+#include "mm/unit.h"
+
+#define THREADS 4
+#define NODES 64
+#define ITERATIONS 100000
+
+struct item {
+	struct mm_lfstack_node node;
+	atomic_bool taken;
+};
+
+static struct item items[ NODES ];
+static struct mm_lfstack stack;
+static atomic_size_t errors;
+
+// pop and push back the same few nodes as fast as possible, the pattern that triggers ABA
+static int worker( void *arg ) {
+	( void ) arg;
+
+	for ( size_t i = 0; i < ITERATIONS; ++i ) {
+		struct mm_lfstack_node *node = mm_lfstack_pop( &stack );
+		struct item *item;
+
+		if ( !node ) {
+			continue;
+		}
+
+		item = MM_LFSTACK_CONTAINER( node, struct item, node );
+
+		// a node handed to two threads at once means the stack got corrupted
+		if ( atomic_exchange( &item->taken, true ) ) {
+			atomic_fetch_add( &errors, 1 );
+		}
+
+		atomic_store( &item->taken, false );
+		mm_lfstack_push( &stack, node );
+	}
+
+	return 0;
+}
+
+MM_UNIT_CASE( lifo_case, NULL, NULL ) {
+	struct item local[ 3 ];
+	struct mm_lfstack_node *node;
+
+	mm_lfstack_init( &stack );
+	MM_UNIT_ASSERT_EQ( mm_lfstack_empty( &stack ), true );
+	MM_UNIT_ASSERT_EQ( mm_lfstack_pop( &stack ), NULL );
+
+	for ( size_t i = 0; i < 3; ++i ) {
+		mm_lfstack_push( &stack, &local[ i ].node );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_lfstack_pop( &stack ), &local[ 2 ].node );
+	node = mm_lfstack_pop_all( &stack );
+	MM_UNIT_ASSERT_EQ( node, &local[ 1 ].node );
+	MM_UNIT_ASSERT_EQ( atomic_load( &node->next ), &local[ 0 ].node );
+	MM_UNIT_ASSERT_EQ( mm_lfstack_empty( &stack ), true );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( contention_stack_case, NULL, NULL ) {
+	thrd_t threads[ THREADS ];
+	bool seen[ NODES ] = { false };
+	struct mm_lfstack_node *node;
+	size_t count = 0;
+
+	mm_lfstack_init( &stack );
+	atomic_store( &errors, 0 );
+
+	for ( size_t i = 0; i < NODES; ++i ) {
+		atomic_init( &items[ i ].taken, false );
+		mm_lfstack_push( &stack, &items[ i ].node );
+	}
+
+	for ( size_t i = 0; i < THREADS; ++i ) {
+		MM_UNIT_ASSERT_EQ( thrd_create( &threads[ i ], worker, NULL ), thrd_success );
+	}
+
+	for ( size_t i = 0; i < THREADS; ++i ) {
+		thrd_join( threads[ i ], NULL );
+	}
+
+	MM_UNIT_ASSERT_EQ( atomic_load( &errors ), 0 );
+
+	// no node lost or duplicated
+	while ( ( node = mm_lfstack_pop( &stack ) ) ) {
+		size_t idx = ( size_t ) ( MM_LFSTACK_CONTAINER( node, struct item, node ) - items );
+
+		MM_UNIT_ASSERT_LESS( idx, NODES );
+		MM_UNIT_ASSERT_EQ( seen[ idx ], false );
+		seen[ idx ] = true;
+		++count;
+	}
+
+	MM_UNIT_ASSERT_EQ( count, NODES );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( lfstack_suite ) {
+	MM_UNIT_RUN( lifo_case );
+	MM_UNIT_RUN( contention_stack_case );
+
+	return MM_UNIT_DONE;
+}
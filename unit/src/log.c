@@ -0,0 +1,411 @@
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "mm/log.h"
+#include "mm/unit.h"
+
+#define THREADS 4
+#define MESSAGES 5000
+
+static FILE *out;
+
+static bool log_setup( void ) {
+	out = tmpfile();
+
+	return out != NULL;
+}
+
+static void log_teardown( void ) {
+	mm_log_async_stop();
+	mm_log_set_level( MM_INFO );
+	fclose( out );
+}
+
+static int logger( void *arg ) {
+	int id = ( int ) ( intptr_t ) arg;
+
+	for ( int i = 0; i < MESSAGES; ++i ) {
+		mm_log( MM_INFO, "%d %d", id, i );
+	}
+
+	return 0;
+}
+
+static bool log_threads( void ) {
+	thrd_t threads[ THREADS ];
+
+	for ( int i = 0; i < THREADS; ++i ) {
+		if ( thrd_create( &threads[ i ], logger, ( void* ) ( intptr_t ) i ) != thrd_success ) {
+			return false;
+		}
+	}
+
+	for ( int i = 0; i < THREADS; ++i ) {
+		thrd_join( threads[ i ], NULL );
+	}
+
+	return true;
+}
+
+// lines of each thread must come out complete and in order, returns the number read or -1
+static long read_back( bool gaps ) {
+	int next[ THREADS ] = { 0 };
+	char line[ 256 ];
+	long count = 0;
+
+	rewind( out );
+
+	while ( fgets( line, sizeof( line ), out ) ) {
+		int id, i;
+
+		if ( strstr( line, "log messages dropped" ) ) {
+			continue;
+		}
+
+		if ( sscanf( line, "%d %d", &id, &i ) != 2 || id < 0 || id >= THREADS ) {
+			return -1;
+		}
+
+		if ( gaps ? i < next[ id ] : i != next[ id ] ) {
+			return -1;
+		}
+
+		next[ id ] = i + 1;
+		++count;
+	}
+
+	return count;
+}
+
+MM_UNIT_CASE( log_async_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 4096, .overflow = MM_LOG_BLOCK };
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), false );
+	MM_UNIT_ASSERT_EQ( log_threads(), true );
+
+	// the threads are gone, stopping must still write out everything they left in their rings
+	mm_log_async_stop();
+	MM_UNIT_ASSERT_EQ( read_back( false ), THREADS * MESSAGES );
+	MM_UNIT_ASSERT_EQ( mm_log_dropped(), 0 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( log_count_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 4096, .overflow = MM_LOG_COUNT };
+	long count;
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+	MM_UNIT_ASSERT_EQ( log_threads(), true );
+	mm_log_async_stop();
+
+	// whatever didn't fit was counted instead
+	count = read_back( true );
+	MM_UNIT_ASSERT_GREATER( count, 0 );
+	MM_UNIT_ASSERT_EQ( ( uint_least64_t ) count + mm_log_dropped(), THREADS * MESSAGES );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( log_flush_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 0, .overflow = MM_LOG_BLOCK };
+	char line[ 256 ];
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+	mm_log( MM_ERR, "%s", "flushed" );
+	mm_log_flush();
+	rewind( out );
+	MM_UNIT_ASSERT_NOT_EQ( fgets( line, sizeof( line ), out ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( strstr( line, "ERROR" ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( strstr( line, "flushed\n" ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+static int short_logger( void *arg ) {
+	mm_log( MM_INFO, "%d %d", 0, ( int ) ( intptr_t ) arg );
+
+	return 0;
+}
+
+static int churn( void *arg ) {
+	atomic_bool *done = arg;
+
+	for ( int i = 0; i < MESSAGES / 10; ++i ) {
+		thrd_t thread;
+
+		if ( thrd_create( &thread, short_logger, ( void* ) ( intptr_t ) i ) == thrd_success ) {
+			thrd_join( thread, NULL );
+		}
+	}
+
+	atomic_store( done, true );
+
+	return 0;
+}
+
+// threads that log once and exit leave their rings behind while another thread walks them in flush
+MM_UNIT_CASE( log_churn_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 4096, .overflow = MM_LOG_BLOCK };
+	atomic_bool done = false;
+	thrd_t thread;
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+	MM_UNIT_ASSERT_EQ( thrd_create( &thread, churn, &done ), thrd_success );
+
+	while ( !atomic_load( &done ) ) {
+		mm_log_flush();
+	}
+
+	thrd_join( thread, NULL );
+	mm_log_async_stop();
+	MM_UNIT_ASSERT_EQ( read_back( false ), MESSAGES / 10 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( log_format_case, NULL, NULL ) {
+	unsigned char types[] = { MM_LOG_ARG_I64, MM_LOG_ARG_F64, MM_LOG_ARG_STR, MM_LOG_ARG_U64, MM_LOG_ARG_PTR };
+	union mm_log_arg args[] = { { .i = -42 }, { .f = 2.5 }, { .s = "abc" }, { .u = 255 }, { .p = NULL } };
+	char buf[ 64 ];
+
+	MM_UNIT_ASSERT_EQ( mm_log_format( buf, sizeof( buf ), "%hd|%6.2f|%-4s|%#lx|%%", types, args, 4 ), 22 );
+	MM_UNIT_ASSERT_EQ( strcmp( buf, "-42|  2.50|abc |0xff|%" ), 0 );
+
+	// mismatched and missing arguments don't crash the writer
+	MM_UNIT_ASSERT_EQ( mm_log_format( buf, sizeof( buf ), "%s %d %d", types, args, 1 ), 5 );
+	MM_UNIT_ASSERT_EQ( strcmp( buf, "(?)  " ), 0 );
+
+	MM_UNIT_ASSERT_EQ( mm_log_format( buf, 6, "%s%s", types + 2, args + 2, 1 ), 3 );
+	MM_UNIT_ASSERT_EQ( mm_log_format( buf, 5, "%d %d", types, args, 2 ), 4 );
+	MM_UNIT_ASSERT_EQ( strcmp( buf, "-42 " ), 0 );
+
+	return MM_UNIT_DONE;
+}
+
+static void log_deferred( int i ) {
+	const char *name = i % 2 ? "odd" : "even";
+	unsigned short small = ( unsigned short ) i;
+
+	MM_LOG_DEFER( MM_INFO, "%d %s %.1f %hu", i, name, i / 2.0, small );
+	MM_LOG_DEFER( MM_WARN, "no arguments" );
+}
+
+MM_UNIT_CASE( log_defer_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 4096, .overflow = MM_LOG_BLOCK };
+	char line[ 256 ];
+	char expect[ 64 ];
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+
+	for ( int i = 0; i < 1000; ++i ) {
+		log_deferred( i );
+	}
+
+	mm_log_async_stop();
+	rewind( out );
+
+	for ( int i = 0; i < 1000; ++i ) {
+		snprintf( expect, sizeof( expect ), "%d %s %.1f %hu\n", i, i % 2 ? "odd" : "even", i / 2.0, ( unsigned short ) i );
+		MM_UNIT_ASSERT_NOT_EQ( fgets( line, sizeof( line ), out ), NULL );
+		MM_UNIT_ASSERT_EQ( strcmp( line, expect ), 0 );
+		MM_UNIT_ASSERT_NOT_EQ( fgets( line, sizeof( line ), out ), NULL );
+		MM_UNIT_ASSERT_NOT_EQ( strstr( line, "WARNING" ), NULL );
+		MM_UNIT_ASSERT_NOT_EQ( strstr( line, "no arguments\n" ), NULL );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( log_binary_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 4096, .overflow = MM_LOG_BLOCK, .binary = true };
+	FILE *text = tmpfile();
+	char line[ 256 ];
+	char expect[ 64 ];
+	bool decoded;
+
+	MM_UNIT_ASSERT_NOT_EQ( text, NULL );
+	MM_UNIT_ASSERT_EQ( mm_log_decode( out, text ), false );
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+
+	for ( int i = 0; i < 1000; ++i ) {
+		log_deferred( i );
+	}
+
+	mm_log( MM_ERR, "formatted %d", 7 );
+	mm_log_async_stop();
+	rewind( out );
+	decoded = mm_log_decode( out, text );
+	rewind( text );
+
+	for ( int i = 0; i < 1000 && decoded; ++i ) {
+		snprintf( expect, sizeof( expect ), "] %d %s %.1f %hu\n", i, i % 2 ? "odd" : "even", i / 2.0, ( unsigned short ) i );
+
+		if ( !fgets( line, sizeof( line ), text ) || line[ 0 ] != '[' || !strstr( line, expect ) ) {
+			decoded = false;
+		}
+
+		if ( !fgets( line, sizeof( line ), text ) || !strstr( line, "no arguments\n" ) ) {
+			decoded = false;
+		}
+	}
+
+	if ( decoded ) {
+		decoded = fgets( line, sizeof( line ), text ) && strstr( line, "formatted 7\n" );
+	}
+
+	fclose( text );
+	MM_UNIT_ASSERT_EQ( decoded, true );
+
+	return MM_UNIT_DONE;
+}
+
+static int evaluated( int *count ) {
+	return ++*count;
+}
+
+MM_UNIT_CASE( log_level_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 0, .overflow = MM_LOG_BLOCK };
+	char line[ 256 ];
+	int count = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+	mm_log_set_level( MM_ERR );
+	MM_UNIT_ASSERT_EQ( mm_log_enabled( MM_WARN ), false );
+	MM_UNIT_ASSERT_EQ( mm_log_enabled( MM_CRIT ), true );
+
+	// filtered calls don't even evaluate their arguments
+	mm_log( MM_WARN, "hidden" );
+	MM_LOG( MM_INFO, "hidden %d", evaluated( &count ) );
+	MM_LOG_DEFER( MM_WARN, "hidden %d", evaluated( &count ) );
+	MM_LOG( MM_ERR, "shown %d", evaluated( &count ) );
+	MM_UNIT_ASSERT_EQ( count, 1 );
+
+	mm_log_async_stop();
+	rewind( out );
+	MM_UNIT_ASSERT_NOT_EQ( fgets( line, sizeof( line ), out ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( strstr( line, "shown 1\n" ), NULL );
+	MM_UNIT_ASSERT_EQ( fgets( line, sizeof( line ), out ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+static void storm( int count ) {
+	for ( int i = 0; i < count; ++i ) {
+		MM_LOG_LIMITED( MM_WARN, 10, 3, "storm %d", i );
+	}
+}
+
+MM_UNIT_CASE( log_limit_case, log_setup, log_teardown ) {
+	struct mm_log_async_config config = { .fd = fileno( out ), .ring_size = 0, .overflow = MM_LOG_BLOCK };
+	struct timespec pause = { 0, 150000000 };
+	char line[ 256 ];
+	int count = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_log_async_start( &config ), true );
+
+	// a burst of 3 goes through, after that one message per 100 ms
+	storm( 100 );
+	thrd_sleep( &pause, NULL );
+	storm( 1 );
+	mm_log_async_stop();
+	rewind( out );
+
+	while ( fgets( line, sizeof( line ), out ) ) {
+		if ( ++count == 4 ) {
+			MM_UNIT_ASSERT_NOT_EQ( strstr( line, "97 messages suppressed at" ), NULL );
+		}
+	}
+
+	MM_UNIT_ASSERT_EQ( count, 5 );
+
+	return MM_UNIT_DONE;
+}
+
+// logs far more than the ring holds and dies without any chance to clean up
+static void recorder_child( const char *path ) {
+	int last = 999;
+
+	if ( !freopen( "/dev/null", "w", stdout ) || !mm_log_recorder_open( path, 4096 ) ) {
+		_Exit( 1 );
+	}
+
+	for ( int i = 0; i <= last; ++i ) {
+		mm_log( MM_INFO, "line %d", i );
+	}
+
+	mm_log_event( 7, "\x01\xff", 2 );
+	MM_LOG_DEFER( MM_WARN, "deferred %d", last );
+	raise( SIGKILL );
+}
+
+MM_UNIT_CASE( log_recorder_case, log_setup, log_teardown ) {
+	char path[] = "/tmp/mm-unit-recorder-XXXXXX";
+	int fd = mkstemp( path );
+	char line[ 256 ];
+	FILE *in;
+	pid_t pid;
+	int status;
+	int next = -1;
+	int count = 0;
+	bool decoded;
+
+	MM_UNIT_ASSERT_GREATER_EQ( fd, 0 );
+	close( fd );
+	fflush( NULL );
+
+	if ( !( pid = fork() ) ) {
+		recorder_child( path );
+	}
+
+	waitpid( pid, &status, 0 );
+	in = fopen( path, "rb" );
+	decoded = in && mm_log_decode( in, out );
+
+	if ( in ) {
+		fclose( in );
+	}
+
+	remove( path );
+	MM_UNIT_ASSERT_EQ( WIFSIGNALED( status ), true );
+	MM_UNIT_ASSERT_EQ( decoded, true );
+	rewind( out );
+
+	// the newest lines survived, oldest first, and nothing torn in between
+	while ( fgets( line, sizeof( line ), out ) && strstr( line, "line " ) ) {
+		int i = atoi( strstr( line, "line " ) + 5 );
+
+		MM_UNIT_ASSERT_EQ( next < 0 || i == next, true );
+		next = i + 1;
+		++count;
+	}
+
+	MM_UNIT_ASSERT_EQ( next, 1000 );
+	MM_UNIT_ASSERT_GREATER( count, 10 );
+	MM_UNIT_ASSERT_NOT_EQ( strstr( line, "event 7: 01 ff\n" ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( fgets( line, sizeof( line ), out ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( strstr( line, "deferred 999\n" ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( log_suite ) {
+	MM_UNIT_RUN( log_async_case );
+	MM_UNIT_RUN( log_count_case );
+	MM_UNIT_RUN( log_flush_case );
+	MM_UNIT_RUN( log_churn_case );
+	MM_UNIT_RUN( log_format_case );
+	MM_UNIT_RUN( log_defer_case );
+	MM_UNIT_RUN( log_binary_case );
+	MM_UNIT_RUN( log_level_case );
+	MM_UNIT_RUN( log_limit_case );
+	MM_UNIT_RUN( log_recorder_case );
+
+	return MM_UNIT_DONE;
+}
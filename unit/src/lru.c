@@ -0,0 +1,180 @@
+#include "mm/lru.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 64
+#define CAPACITY 16
+
+struct entry {
+	struct mm_lru_node node;
+	bool cached;
+	size_t evictions;
+};
+
+static struct entry entries[ COUNT ];
+
+static void on_evict( struct mm_lru_node *node, void *ctx ) {
+	struct entry *entry = MM_LRU_CONTAINER( node, struct entry, node );
+
+	++*( size_t* ) ctx;
+	++entry->evictions;
+	entry->cached = false;
+}
+
+static bool reset( void ) {
+	for ( size_t i = 0; i < COUNT; ++i ) {
+		entries[ i ].cached = false;
+		entries[ i ].evictions = 0;
+	}
+
+	return true;
+}
+
+static void put( struct mm_lru *lru, size_t key, size_t charge ) {
+	entries[ key ].cached = true;
+	mm_lru_insert( lru, &entries[ key ].node, key, charge );
+}
+
+MM_UNIT_CASE( lru_order_case, reset, NULL ) {
+	struct mm_lru lru;
+	size_t evicted = 0;
+	uint_least64_t last_use[ COUNT ] = { 0 };
+	struct mm_random r;
+
+	MM_UNIT_ASSERT_EQ( mm_lru_init( &lru, CAPACITY, MM_LRU_LRU, on_evict, &evicted ), true );
+	mm_random_reset( &r, 8 );
+
+	// the evicted entry must always be the least recently used one of a reference model
+	for ( uint_least64_t now = 1; now < 20000; ++now ) {
+		size_t key = mm_random_next( &r, 0, COUNT );
+
+		if ( mm_lru_find( &lru, key ) ) {
+			MM_UNIT_ASSERT_EQ( entries[ key ].cached, true );
+		} else {
+			size_t oldest = SIZE_MAX;
+
+			MM_UNIT_ASSERT_EQ( entries[ key ].cached, false );
+
+			if ( mm_lru_size( &lru ) == CAPACITY ) {
+				for ( size_t i = 0; i < COUNT; ++i ) {
+					if ( entries[ i ].cached && ( oldest == SIZE_MAX || last_use[ i ] < last_use[ oldest ] ) ) {
+						oldest = i;
+					}
+				}
+			}
+
+			put( &lru, key, 1 );
+
+			if ( oldest != SIZE_MAX ) {
+				MM_UNIT_ASSERT_EQ( entries[ oldest ].cached, false );
+			}
+		}
+
+		last_use[ key ] = now;
+		MM_UNIT_ASSERT_LESS_EQ( mm_lru_size( &lru ), CAPACITY );
+	}
+
+	size_t before = evicted;
+
+	mm_lru_destroy( &lru );
+	MM_UNIT_ASSERT_EQ( evicted - before, CAPACITY );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( byte_budget_case, reset, NULL ) {
+	struct mm_lru lru;
+	size_t evicted = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_lru_init( &lru, 100, MM_LRU_LRU, on_evict, &evicted ), true );
+
+	put( &lru, 0, 40 );
+	put( &lru, 1, 40 );
+	MM_UNIT_ASSERT_EQ( mm_lru_charge( &lru ), 80 );
+
+	// needs room for 30, so only the least recently used entry goes
+	MM_UNIT_ASSERT_NOT_EQ( mm_lru_find( &lru, 0 ), NULL );
+	put( &lru, 2, 30 );
+	MM_UNIT_ASSERT_EQ( entries[ 1 ].cached, false );
+	MM_UNIT_ASSERT_EQ( mm_lru_charge( &lru ), 70 );
+
+	// replacing a key evicts the old node
+	put( &lru, 2, 10 );
+	MM_UNIT_ASSERT_EQ( entries[ 2 ].evictions, 1 );
+	MM_UNIT_ASSERT_EQ( mm_lru_charge( &lru ), 50 );
+
+	// larger than the whole cache, evicted right away
+	put( &lru, 3, 101 );
+	MM_UNIT_ASSERT_EQ( entries[ 3 ].cached, false );
+	MM_UNIT_ASSERT_EQ( mm_lru_size( &lru ), 0 );
+
+	put( &lru, 4, 10 );
+	mm_lru_erase( &lru, &entries[ 4 ].node );
+	MM_UNIT_ASSERT_EQ( mm_lru_peek( &lru, 4 ), NULL );
+	MM_UNIT_ASSERT_EQ( entries[ 4 ].evictions, 0 );
+
+	mm_lru_destroy( &lru );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( clock_case, reset, NULL ) {
+	struct mm_lru lru;
+	size_t evicted = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_lru_init( &lru, CAPACITY, MM_LRU_CLOCK, on_evict, &evicted ), true );
+
+	for ( size_t key = 0; key < CAPACITY; ++key ) {
+		put( &lru, key, 1 );
+	}
+
+	// referenced entries get a second chance, the oldest unreferenced one is evicted
+	MM_UNIT_ASSERT_NOT_EQ( mm_lru_find( &lru, 0 ), NULL );
+	MM_UNIT_ASSERT_NOT_EQ( mm_lru_find( &lru, 1 ), NULL );
+	put( &lru, CAPACITY, 1 );
+
+	MM_UNIT_ASSERT_EQ( entries[ 0 ].cached, true );
+	MM_UNIT_ASSERT_EQ( entries[ 1 ].cached, true );
+	MM_UNIT_ASSERT_EQ( entries[ 2 ].cached, false );
+	MM_UNIT_ASSERT_EQ( evicted, 1 );
+
+	mm_lru_destroy( &lru );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( slru_case, reset, NULL ) {
+	struct mm_lru lru;
+	size_t evicted = 0;
+
+	MM_UNIT_ASSERT_EQ( mm_lru_init( &lru, CAPACITY, MM_LRU_SLRU, on_evict, &evicted ), true );
+
+	// a hot set hit twice is protected
+	for ( size_t key = 0; key < 4; ++key ) {
+		put( &lru, key, 1 );
+		MM_UNIT_ASSERT_NOT_EQ( mm_lru_find( &lru, key ), NULL );
+	}
+
+	// from a scan of single use keys
+	for ( size_t key = 4; key < COUNT; ++key ) {
+		put( &lru, key, 1 );
+	}
+
+	for ( size_t key = 0; key < 4; ++key ) {
+		MM_UNIT_ASSERT_EQ( entries[ key ].cached, true );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_lru_size( &lru ), CAPACITY );
+	mm_lru_destroy( &lru );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( lru_suite ) {
+	MM_UNIT_RUN( lru_order_case );
+	MM_UNIT_RUN( byte_budget_case );
+	MM_UNIT_RUN( clock_case );
+	MM_UNIT_RUN( slru_case );
+
+	return MM_UNIT_DONE;
+}
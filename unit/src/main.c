@@ -1,13 +1,57 @@
 #include "mm/common.h"
 #include "mm/unit.h"
 
+MM_UNIT_IMPORT( bit_suite );
+MM_UNIT_IMPORT( bitset_suite );
+MM_UNIT_IMPORT( bitvector_suite );
+MM_UNIT_IMPORT( btree_suite );
+MM_UNIT_IMPORT( chan_suite );
+MM_UNIT_IMPORT( cmap_suite );
 MM_UNIT_IMPORT( co_suite );
+MM_UNIT_IMPORT( distribution_suite );
+MM_UNIT_IMPORT( executor_suite );
+MM_UNIT_IMPORT( fiber_suite );
+MM_UNIT_IMPORT( hash_suite );
+MM_UNIT_IMPORT( hashmap_suite );
+MM_UNIT_IMPORT( itree_suite );
+MM_UNIT_IMPORT( lfstack_suite );
+MM_UNIT_IMPORT( log_suite );
+MM_UNIT_IMPORT( lru_suite );
+MM_UNIT_IMPORT( mpsc_suite );
+MM_UNIT_IMPORT( ostree_suite );
 MM_UNIT_IMPORT( random_suite );
+MM_UNIT_IMPORT( rbtree_suite );
+MM_UNIT_IMPORT( reactor_suite );
+MM_UNIT_IMPORT( roaring_suite );
+MM_UNIT_IMPORT( sched_suite );
+MM_UNIT_IMPORT( timer_suite );
 MM_UNIT_IMPORT( vector_suite );
 
 int main( int argc, const char *argv[] ) {
+	MM_UNIT_RUN_SUITE( bit_suite );
+	MM_UNIT_RUN_SUITE( bitset_suite );
+	MM_UNIT_RUN_SUITE( bitvector_suite );
+	MM_UNIT_RUN_SUITE( btree_suite );
+	MM_UNIT_RUN_SUITE( chan_suite );
+	MM_UNIT_RUN_SUITE( cmap_suite );
 	MM_UNIT_RUN_SUITE( co_suite );
+	MM_UNIT_RUN_SUITE( distribution_suite );
+	MM_UNIT_RUN_SUITE( executor_suite );
+	MM_UNIT_RUN_SUITE( fiber_suite );
+	MM_UNIT_RUN_SUITE( hash_suite );
+	MM_UNIT_RUN_SUITE( hashmap_suite );
+	MM_UNIT_RUN_SUITE( itree_suite );
+	MM_UNIT_RUN_SUITE( lfstack_suite );
+	MM_UNIT_RUN_SUITE( log_suite );
+	MM_UNIT_RUN_SUITE( lru_suite );
+	MM_UNIT_RUN_SUITE( mpsc_suite );
+	MM_UNIT_RUN_SUITE( ostree_suite );
 	MM_UNIT_RUN_SUITE( random_suite );
+	MM_UNIT_RUN_SUITE( rbtree_suite );
+	MM_UNIT_RUN_SUITE( reactor_suite );
+	MM_UNIT_RUN_SUITE( roaring_suite );
+	MM_UNIT_RUN_SUITE( sched_suite );
+	MM_UNIT_RUN_SUITE( timer_suite );
 	MM_UNIT_RUN_SUITE( vector_suite );
 
 	return EXIT_SUCCESS;
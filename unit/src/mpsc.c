@@ -0,0 +1,107 @@
+#include <threads.h>
+#include "mm/mpsc.h"
+#include "mm/unit.h"
+
+#define PRODUCERS 4
+#define PER_PRODUCER 50000
+
+struct item {
+	struct mm_mpsc_node node;
+	unsigned int producer;
+	unsigned int seq;
+};
+
+static struct item items[ PRODUCERS ][ PER_PRODUCER ];
+static struct mm_mpsc queue;
+
+static int producer( void *arg ) {
+	struct item *own = arg;
+
+	for ( unsigned int i = 0; i < PER_PRODUCER; ++i ) {
+		mm_mpsc_push( &queue, &own[ i ].node );
+
+		if ( i % 64 == 0 ) {
+			thrd_yield();
+		}
+	}
+
+	return 0;
+}
+
+MM_UNIT_CASE( single_thread_fifo_case, NULL, NULL ) {
+	struct item local[ 3 ];
+
+	mm_mpsc_init( &queue );
+	MM_UNIT_ASSERT_EQ( mm_mpsc_empty( &queue ), true );
+	MM_UNIT_ASSERT_EQ( mm_mpsc_pop( &queue ), NULL );
+
+	// drain completely in between, so the stub gets pushed back more than once
+	for ( unsigned int round = 0; round < 3; ++round ) {
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			local[ i ].seq = i;
+			mm_mpsc_push( &queue, &local[ i ].node );
+		}
+
+		MM_UNIT_ASSERT_EQ( mm_mpsc_empty( &queue ), false );
+
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			struct mm_mpsc_node *node = mm_mpsc_pop( &queue );
+
+			MM_UNIT_ASSERT_NOT_EQ( node, NULL );
+			MM_UNIT_ASSERT_EQ( MM_MPSC_CONTAINER( node, struct item, node )->seq, i );
+		}
+
+		MM_UNIT_ASSERT_EQ( mm_mpsc_pop( &queue ), NULL );
+		MM_UNIT_ASSERT_EQ( mm_mpsc_empty( &queue ), true );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( contention_queue_case, NULL, NULL ) {
+	thrd_t threads[ PRODUCERS ];
+	unsigned int next_seq[ PRODUCERS ] = { 0 };
+	size_t received = 0;
+
+	mm_mpsc_init( &queue );
+
+	for ( unsigned int p = 0; p < PRODUCERS; ++p ) {
+		for ( unsigned int i = 0; i < PER_PRODUCER; ++i ) {
+			items[ p ][ i ].producer = p;
+			items[ p ][ i ].seq = i;
+		}
+
+		MM_UNIT_ASSERT_EQ( thrd_create( &threads[ p ], producer, items[ p ] ), thrd_success );
+	}
+
+	// every node arrives exactly once, and in push order per producer
+	while ( received < PRODUCERS * PER_PRODUCER ) {
+		struct mm_mpsc_node *node = mm_mpsc_pop( &queue );
+		struct item *item;
+
+		if ( !node ) {
+			thrd_yield();
+			continue;
+		}
+
+		item = MM_MPSC_CONTAINER( node, struct item, node );
+		MM_UNIT_ASSERT_EQ( item->seq, next_seq[ item->producer ] );
+		++next_seq[ item->producer ];
+		++received;
+	}
+
+	for ( unsigned int p = 0; p < PRODUCERS; ++p ) {
+		thrd_join( threads[ p ], NULL );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_mpsc_pop( &queue ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( mpsc_suite ) {
+	MM_UNIT_RUN( single_thread_fifo_case );
+	MM_UNIT_RUN( contention_queue_case );
+
+	return MM_UNIT_DONE;
+}
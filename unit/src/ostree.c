@@ -0,0 +1,84 @@
+#include "mm/ostree.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 500
+
+struct entry {
+	struct mm_ostree_node node;
+	int key;
+};
+
+static int entry_cmp( const struct mm_ostree_node *lhs, const struct mm_ostree_node *rhs ) {
+	return MM_CONTAINER_OF( lhs, struct entry, node )->key - MM_CONTAINER_OF( rhs, struct entry, node )->key;
+}
+
+static int key_cmp( const void *key, const struct mm_ostree_node *node ) {
+	return *( const int* ) key - MM_CONTAINER_OF( node, struct entry, node )->key;
+}
+
+static int key_of( struct mm_ostree_node *node ) {
+	return MM_CONTAINER_OF( node, struct entry, node )->key;
+}
+
+MM_UNIT_CASE( select_rank_case, NULL, NULL ) {
+	static struct entry entries[ COUNT ];
+	static bool inserted[ COUNT ];
+	struct mm_random r;
+	MM_OSTREE_DECLARE( tree );
+	size_t size = 0;
+
+	mm_random_reset( &r, 99 );
+
+	for ( int i = 0; i < COUNT; ++i ) {
+		entries[ i ].key = i * 2;
+		inserted[ i ] = false;
+	}
+
+	for ( int i = 0; i < COUNT * 4; ++i ) {
+		int j = ( int ) mm_random_next( &r, 0, COUNT );
+
+		if ( inserted[ j ] ) {
+			mm_ostree_erase( &tree, &entries[ j ].node );
+			--size;
+		} else {
+			MM_UNIT_ASSERT_EQ( mm_ostree_insert( &tree, &entries[ j ].node, entry_cmp ), NULL );
+			++size;
+		}
+
+		inserted[ j ] = !inserted[ j ];
+		MM_UNIT_ASSERT_EQ( mm_ostree_size( &tree ), size );
+	}
+
+	// compare against the expected sorted order
+	size_t idx = 0;
+
+	for ( int i = 0; i < COUNT; ++i ) {
+		int odd = i * 2 + 1;
+
+		MM_UNIT_ASSERT_EQ( mm_ostree_rank_key( &tree, &odd, key_cmp ), idx + inserted[ i ] );
+
+		if ( !inserted[ i ] ) {
+			continue;
+		}
+
+		struct mm_ostree_node *node = mm_ostree_select( &tree, idx );
+
+		MM_UNIT_ASSERT_NOT_EQ( node, NULL );
+		MM_UNIT_ASSERT_EQ( key_of( node ), entries[ i ].key );
+		MM_UNIT_ASSERT_EQ( mm_ostree_rank( node ), idx );
+		MM_UNIT_ASSERT_EQ( mm_ostree_rank_key( &tree, &entries[ i ].key, key_cmp ), idx );
+		++idx;
+	}
+
+	MM_UNIT_ASSERT_EQ( idx, size );
+	MM_UNIT_ASSERT_EQ( mm_ostree_select( &tree, size ), NULL );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( ostree_suite ) {
+	MM_UNIT_RUN( select_rank_case );
+
+	return MM_UNIT_DONE;
+}
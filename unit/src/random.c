@@ -1,6 +1,10 @@
 #include "mm/common.h"
 #include "mm/random.h"
 #include "mm/unit.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 #include <time.h>
 
 #define MIN 0
@@ -43,8 +47,192 @@ MM_UNIT_CASE( uniform_dist_seeds_case, NULL, NULL ) {
 	return MM_UNIT_DONE;
 }
 
+MM_UNIT_CASE( xoshiro_reference_case, NULL, NULL ) {
+	struct mm_random r = { .s = { 1, 2, 3, 4 } };
+
+	MM_UNIT_ASSERT_EQ( mm_random_u64( &r ), 11520 );
+	MM_UNIT_ASSERT_EQ( mm_random_u64( &r ), 0 );
+	MM_UNIT_ASSERT_EQ( mm_random_u64( &r ), 1509978240 );
+	MM_UNIT_ASSERT_EQ( mm_random_u64( &r ), 1215971899390074240u );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bounded_case, NULL, NULL ) {
+	unsigned long max = ULONG_MAX / 3 * 2;
+	struct mm_random r;
+	unsigned long low = 0;
+
+	mm_random_reset( &r, 11 );
+	MM_UNIT_ASSERT_EQ( mm_random_next( &r, 5, 5 ), 5 );
+	MM_UNIT_ASSERT_EQ( mm_random_next( &r, 5, 6 ), 5 );
+	MM_UNIT_ASSERT_EQ( mm_random_next( &r, 7, 3 ), 7 );
+
+	// with a modulo the lower half of this range would come up twice as often as the upper half
+	for ( unsigned long i = 0; i < ITERATIONS; ++i ) {
+		unsigned long value = mm_random_next( &r, 0, max );
+
+		MM_UNIT_ASSERT_LESS( value, max );
+		low += value < max / 2;
+	}
+
+	MM_UNIT_ASSERT_RANGE( 0.49f, 0.51f, ( float ) low / ( float ) ITERATIONS );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( double_case, NULL, NULL ) {
+	struct mm_random r;
+	double sum = 0.0;
+
+	mm_random_reset( &r, 12 );
+
+	for ( unsigned long i = 0; i < ITERATIONS; ++i ) {
+		double value = mm_random_double( &r );
+
+		MM_UNIT_ASSERT_EQ( value >= 0.0 && value < 1.0, true );
+		sum += value;
+	}
+
+	MM_UNIT_ASSERT_RANGE( 0.49, 0.51, sum / ITERATIONS );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( fill_case, NULL, NULL ) {
+	static unsigned char buf[ 1 << 20 ];
+	unsigned long hits[ 256 ] = { 0 };
+	struct mm_random r;
+	struct mm_random lanes[ MM_RANDOM_LANES ];
+
+	mm_random_reset( &r, 13 );
+
+	// every lane is a plain xoshiro256** generator, interleaved 8 bytes at a time
+	for ( size_t lane = 0; lane < MM_RANDOM_LANES; ++lane ) {
+		for ( size_t i = 0; i < 4; ++i ) {
+			lanes[ lane ].s[ i ] = r.lanes[ i ][ lane ];
+		}
+	}
+
+	mm_random_fill( &r, buf, 1000 );
+
+	for ( size_t i = 0; i < 1000 / 8; ++i ) {
+		uint_least64_t expect = mm_random_u64( &lanes[ i % MM_RANDOM_LANES ] );
+
+		MM_UNIT_ASSERT_EQ( memcmp( buf + i * 8, &expect, 8 ), 0 );
+	}
+
+	// odd sizes stay inside the buffer
+	memset( buf, 0xAB, 64 );
+	mm_random_fill( &r, buf + 1, 37 );
+	MM_UNIT_ASSERT_EQ( buf[ 0 ], 0xAB );
+	MM_UNIT_ASSERT_EQ( buf[ 38 ], 0xAB );
+
+	mm_random_fill( &r, buf, sizeof( buf ) );
+
+	for ( size_t i = 0; i < sizeof( buf ); ++i ) {
+		++hits[ buf[ i ] ];
+	}
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( hits ); ++i ) {
+		MM_UNIT_ASSERT_RANGE( 0.9f, 1.1f, ( float ) hits[ i ] * 256.0f / ( float ) sizeof( buf ) );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+#define STREAMS 4
+#define STREAM_DRAWS 100000
+
+static int cmp_u64( const void *lhs, const void *rhs ) {
+	uint_least64_t a = *( const uint_least64_t* ) lhs;
+	uint_least64_t b = *( const uint_least64_t* ) rhs;
+
+	return ( a > b ) - ( a < b );
+}
+
+MM_UNIT_CASE( split_case, NULL, NULL ) {
+	struct mm_random streams[ STREAMS + 1 ];
+	struct mm_random r;
+	struct mm_random stepped;
+	uint_least64_t *values = MM_MALLOC( sizeof( *values ) * ( STREAMS + 1 ) * STREAM_DRAWS );
+	size_t count = 0;
+	size_t repeats = 0;
+
+	MM_UNIT_ASSERT_NOT_EQ( values, NULL );
+
+	// a jump is a polynomial in the step, so the two commute
+	mm_random_reset( &r, 14 );
+	stepped = r;
+	mm_random_u64( &stepped );
+	mm_random_jump( &stepped );
+	mm_random_jump( &r );
+	mm_random_u64( &r );
+	MM_UNIT_ASSERT_EQ( memcmp( r.s, stepped.s, sizeof( r.s ) ), 0 );
+
+	// nothing any stream draws shows up in another one, the parent included
+	mm_random_split( &r, streams, STREAMS );
+	streams[ STREAMS ] = r;
+
+	for ( size_t i = 0; i <= STREAMS; ++i ) {
+		for ( size_t j = 0; j < STREAM_DRAWS; ++j ) {
+			values[ count++ ] = mm_random_u64( &streams[ i ] );
+		}
+	}
+
+	qsort( values, count, sizeof( *values ), cmp_u64 );
+
+	for ( size_t i = 1; i < count; ++i ) {
+		repeats += values[ i ] == values[ i - 1 ];
+	}
+
+	MM_FREE( values );
+	MM_UNIT_ASSERT_EQ( repeats, 0 );
+	MM_UNIT_ASSERT_NOT_EQ( memcmp( streams[ 0 ].lanes, streams[ 1 ].lanes, sizeof( streams[ 0 ].lanes ) ), 0 );
+
+	return MM_UNIT_DONE;
+}
+
+static int local_draw( void *arg ) {
+	uint_least64_t *out = arg;
+
+	out[ 0 ] = ( uint_least64_t ) ( uintptr_t ) mm_random_local();
+	out[ 1 ] = mm_random_u64( mm_random_local() );
+
+	return 0;
+}
+
+MM_UNIT_CASE( local_case, NULL, NULL ) {
+	uint_least64_t seen[ STREAMS ][ 2 ];
+	thrd_t threads[ STREAMS ];
+
+	for ( size_t i = 0; i < STREAMS; ++i ) {
+		MM_UNIT_ASSERT_EQ( thrd_create( &threads[ i ], local_draw, seen[ i ] ), thrd_success );
+	}
+
+	for ( size_t i = 0; i < STREAMS; ++i ) {
+		thrd_join( threads[ i ], NULL );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_random_local(), mm_random_local() );
+
+	for ( size_t i = 0; i < STREAMS; ++i ) {
+		for ( size_t j = 0; j < i; ++j ) {
+			MM_UNIT_ASSERT_NOT_EQ( seen[ i ][ 1 ], seen[ j ][ 1 ] );
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
 MM_UNIT_SUITE( random_suite ) {
 	MM_UNIT_RUN( uniform_dist_values_case );
 	MM_UNIT_RUN( uniform_dist_seeds_case );
+	MM_UNIT_RUN( xoshiro_reference_case );
+	MM_UNIT_RUN( bounded_case );
+	MM_UNIT_RUN( double_case );
+	MM_UNIT_RUN( fill_case );
+	MM_UNIT_RUN( split_case );
+	MM_UNIT_RUN( local_case );
 	return MM_UNIT_DONE;
 }
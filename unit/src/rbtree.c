@@ -0,0 +1,229 @@
+#include "mm/rbtree.h"
+#include "mm/random.h"
+#include "mm/unit.h"
+
+#define COUNT 1000
+
+struct entry {
+	struct mm_rbtree_node node;
+	int key;
+};
+
+static int entry_cmp( const struct mm_rbtree_node *lhs, const struct mm_rbtree_node *rhs ) {
+	return MM_CONTAINER_OF( lhs, struct entry, node )->key - MM_CONTAINER_OF( rhs, struct entry, node )->key;
+}
+
+static int key_cmp( const void *key, const struct mm_rbtree_node *node ) {
+	return *( const int* ) key - MM_CONTAINER_OF( node, struct entry, node )->key;
+}
+
+static int key_of( struct mm_rbtree_node *node ) {
+	return MM_CONTAINER_OF( node, struct entry, node )->key;
+}
+
+// returns black height or -1 if any red-black property is broken
+static int validate( struct mm_rbtree_node *node, struct mm_rbtree_node *parent ) {
+	if ( !node ) {
+		return 1;
+	}
+
+	if ( mm_rbtree_parent( node ) != parent ) {
+		return -1;
+	}
+
+	if ( mm_rbtree_colour( node ) == MM_RB_RED
+	  && ( ( node->lhs && mm_rbtree_colour( node->lhs ) == MM_RB_RED )
+	    || ( node->rhs && mm_rbtree_colour( node->rhs ) == MM_RB_RED ) ) ) {
+		return -1;
+	}
+
+	int lhs = validate( node->lhs, node );
+	int rhs = validate( node->rhs, node );
+
+	if ( lhs < 0 || lhs != rhs ) {
+		return -1;
+	}
+
+	return lhs + ( mm_rbtree_colour( node ) == MM_RB_BLACK );
+}
+
+static bool valid( struct mm_rbtree *tree ) {
+	return ( !tree->root || mm_rbtree_colour( tree->root ) == MM_RB_BLACK )
+	    && validate( tree->root, NULL ) > 0;
+}
+
+MM_UNIT_CASE( node_size_case, NULL, NULL ) {
+	MM_UNIT_ASSERT_EQ( sizeof( struct mm_rbtree_node ), 3 * sizeof( void* ) );
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( insert_find_case, NULL, NULL ) {
+	static struct entry entries[ COUNT ];
+	MM_RBTREE_DECLARE( tree );
+
+	// insert odd keys out of order
+	for ( int i = 0; i < COUNT; ++i ) {
+		entries[ i ].key = ( ( i * 7919 ) % COUNT ) * 2 + 1;
+		MM_UNIT_ASSERT_EQ( mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp ), NULL );
+		MM_UNIT_ASSERT( valid( &tree ), "red-black properties broken on insert" );
+	}
+
+	struct entry dup = { .key = 1 };
+	MM_UNIT_ASSERT_NOT_EQ( mm_rbtree_insert( &tree, &dup.node, entry_cmp ), NULL );
+
+	for ( int key = 0; key < COUNT * 2; ++key ) {
+		struct mm_rbtree_node *node = mm_rbtree_find( &tree, &key, key_cmp );
+
+		if ( key % 2 ) {
+			MM_UNIT_ASSERT_NOT_EQ( node, NULL );
+			MM_UNIT_ASSERT_EQ( key_of( node ), key );
+		} else {
+			MM_UNIT_ASSERT_EQ( node, NULL );
+		}
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( bound_case, NULL, NULL ) {
+	struct entry entries[ 10 ];
+	MM_RBTREE_DECLARE( tree );
+
+	for ( int i = 0; i < 10; ++i ) {
+		entries[ i ].key = i * 10;
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	int key = 20;
+	MM_UNIT_ASSERT_EQ( key_of( mm_rbtree_lower_bound( &tree, &key, key_cmp ) ), 20 );
+	MM_UNIT_ASSERT_EQ( key_of( mm_rbtree_upper_bound( &tree, &key, key_cmp ) ), 30 );
+
+	key = 25;
+	MM_UNIT_ASSERT_EQ( key_of( mm_rbtree_lower_bound( &tree, &key, key_cmp ) ), 30 );
+	MM_UNIT_ASSERT_EQ( key_of( mm_rbtree_upper_bound( &tree, &key, key_cmp ) ), 30 );
+
+	key = 90;
+	MM_UNIT_ASSERT_EQ( mm_rbtree_upper_bound( &tree, &key, key_cmp ), NULL );
+
+	key = -1;
+	MM_UNIT_ASSERT_EQ( mm_rbtree_lower_bound( &tree, &key, key_cmp ), mm_rbtree_first( &tree ) );
+	MM_UNIT_ASSERT_EQ( key_of( mm_rbtree_last( &tree ) ), 90 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( iterate_case, NULL, NULL ) {
+	struct entry entries[ 100 ];
+	struct entry *pos;
+	MM_RBTREE_DECLARE( tree );
+	int i = 0;
+
+	for ( i = 0; i < 100; ++i ) {
+		entries[ i ].key = 99 - i;
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	i = 0;
+
+	MM_RBTREE_FOREACH_CONTAINER( &tree, pos, struct entry, node ) {
+		MM_UNIT_ASSERT_EQ( pos->key, i++ );
+	}
+
+	MM_UNIT_ASSERT_EQ( i, 100 );
+
+	MM_RBTREE_FOREACH_CONTAINER_REVERSE( &tree, pos, struct entry, node ) {
+		MM_UNIT_ASSERT_EQ( pos->key, --i );
+	}
+
+	struct mm_rbtree_node *node, *tmp;
+
+	MM_RBTREE_FOREACH_POSTORDER_SAFE( &tree, node, tmp ) {
+		++i;
+	}
+
+	MM_UNIT_ASSERT_EQ( i, 100 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( erase_case, NULL, NULL ) {
+	static struct entry entries[ COUNT ];
+	static bool inserted[ COUNT ];
+	struct mm_random r;
+	MM_RBTREE_DECLARE( tree );
+	size_t size = 0;
+
+	mm_random_reset( &r, 1234 );
+
+	for ( int i = 0; i < COUNT; ++i ) {
+		entries[ i ].key = i;
+		inserted[ i ] = false;
+	}
+
+	// random mix of inserts and erases
+	for ( int i = 0; i < COUNT * 10; ++i ) {
+		int j = ( int ) mm_random_next( &r, 0, COUNT );
+
+		if ( inserted[ j ] ) {
+			mm_rbtree_erase( &tree, &entries[ j ].node );
+			--size;
+		} else {
+			MM_UNIT_ASSERT_EQ( mm_rbtree_insert( &tree, &entries[ j ].node, entry_cmp ), NULL );
+			++size;
+		}
+
+		inserted[ j ] = !inserted[ j ];
+		MM_UNIT_ASSERT( valid( &tree ), "red-black properties broken" );
+	}
+
+	struct mm_rbtree_node *node;
+	int prev = -1;
+
+	MM_RBTREE_FOREACH( &tree, node ) {
+		MM_UNIT_ASSERT( inserted[ key_of( node ) ], "erased node still in tree" );
+		MM_UNIT_ASSERT_LESS( prev, key_of( node ) );
+		prev = key_of( node );
+		--size;
+	}
+
+	MM_UNIT_ASSERT_EQ( size, 0 );
+
+	for ( int i = 0; i < COUNT; ++i ) {
+		if ( inserted[ i ] ) {
+			mm_rbtree_erase( &tree, &entries[ i ].node );
+		}
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_rbtree_empty( &tree ), true );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( replace_case, NULL, NULL ) {
+	struct entry entries[ 3 ] = { { .key = 1 }, { .key = 2 }, { .key = 3 } };
+	struct entry other = { .key = 2 };
+	MM_RBTREE_DECLARE( tree );
+
+	for ( int i = 0; i < 3; ++i ) {
+		mm_rbtree_insert( &tree, &entries[ i ].node, entry_cmp );
+	}
+
+	mm_rbtree_replace( &tree, &entries[ 1 ].node, &other.node );
+
+	int key = 2;
+	MM_UNIT_ASSERT_EQ( mm_rbtree_find( &tree, &key, key_cmp ), &other.node );
+	MM_UNIT_ASSERT( valid( &tree ), "red-black properties broken" );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( rbtree_suite ) {
+	MM_UNIT_RUN( node_size_case );
+	MM_UNIT_RUN( insert_find_case );
+	MM_UNIT_RUN( bound_case );
+	MM_UNIT_RUN( iterate_case );
+	MM_UNIT_RUN( erase_case );
+	MM_UNIT_RUN( replace_case );
+
+	return MM_UNIT_DONE;
+}
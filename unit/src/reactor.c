@@ -0,0 +1,426 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <threads.h>
+#include "mm/reactor.h"
+#include "mm/unit.h"
+
+// larger than the default pipe buffer, so the writer has to wait for the reader
+#define STREAM_BYTES ( 1u << 20 )
+#define ECHO_ROUNDS 1000
+
+struct peer {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_reactor_fd io;
+	unsigned char buf[ 4096 ];
+	size_t done;
+	size_t sum;
+	ssize_t len;
+};
+
+static struct mm_reactor reactor;
+static struct peer peers[ 2 ];
+
+static bool set_nonblocking( int fd ) {
+	int flags = fcntl( fd, F_GETFL );
+
+	return flags >= 0 && !fcntl( fd, F_SETFL, flags | O_NONBLOCK );
+}
+
+MM_COROUTINE( stream_writer, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	while ( this->done < STREAM_BYTES ) {
+		MM_CO_AWAIT_WRITABLE( &this->co, task, &this->io );
+
+		for ( size_t i = 0; i < sizeof( this->buf ); ++i ) {
+			this->buf[ i ] = ( unsigned char ) ( this->done + i );
+		}
+
+		this->len = mm_reactor_write( &this->io, this->buf, sizeof( this->buf ) );
+
+		if ( this->len > 0 ) {
+			for ( ssize_t i = 0; i < this->len; ++i ) {
+				this->sum += this->buf[ i ];
+			}
+
+			this->done += ( size_t ) this->len;
+		}
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( stream_reader, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+		this->len = mm_reactor_read( &this->io, this->buf, sizeof( this->buf ) );
+
+		if ( this->len == 0 ) {
+			break;
+		}
+
+		for ( ssize_t i = 0; i < this->len; ++i ) {
+			this->sum += this->buf[ i ];
+		}
+
+		if ( this->len > 0 ) {
+			this->done += ( size_t ) this->len;
+		}
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+static bool start( int fds[ 2 ], mm_sched_func_t first, mm_sched_func_t second ) {
+	mm_sched_func_t funcs[ 2 ] = { first, second };
+
+	for ( size_t i = 0; i < 2; ++i ) {
+		memset( &peers[ i ], 0, sizeof( peers[ i ] ) );
+		MM_CO_INIT( &peers[ i ].co );
+
+		if ( !set_nonblocking( fds[ i ] ) || !mm_reactor_add( &reactor, &peers[ i ].io, fds[ i ] ) ) {
+			return false;
+		}
+
+		mm_sched_spawn( &reactor.sched, &peers[ i ].task, funcs[ i ] );
+	}
+
+	return true;
+}
+
+static bool setup( void ) {
+	return mm_reactor_init( &reactor, NULL, NULL );
+}
+
+static void teardown( void ) {
+	mm_reactor_destroy( &reactor );
+}
+
+MM_UNIT_CASE( pipe_case, setup, teardown ) {
+	int fds[ 2 ];
+
+	MM_UNIT_ASSERT_EQ( pipe( fds ), 0 );
+
+	// peers[ 0 ] reads fds[ 0 ], peers[ 1 ] writes fds[ 1 ]
+	MM_UNIT_ASSERT_EQ( start( fds, stream_reader, stream_writer ), true );
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+	MM_UNIT_ASSERT_EQ( reactor.sched.count, 0 );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].done, peers[ 1 ].done );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].sum, peers[ 1 ].sum );
+	MM_UNIT_ASSERT_LESS( STREAM_BYTES - 1, peers[ 0 ].done );
+
+	return MM_UNIT_DONE;
+}
+
+// sends a counter, waits for it to come back incremented
+MM_COROUTINE( echo_client, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->done = 0; this->done < ECHO_ROUNDS; ++this->done ) {
+		MM_CO_AWAIT_WRITABLE( &this->co, task, &this->io );
+		memcpy( this->buf, &this->done, sizeof( this->done ) );
+
+		if ( mm_reactor_write( &this->io, this->buf, sizeof( this->done ) ) != sizeof( this->done ) ) {
+			break;
+		}
+
+		do {
+			MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+			this->len = mm_reactor_read( &this->io, this->buf, sizeof( this->done ) );
+		} while ( this->len < 0 && errno == EAGAIN );
+
+		if ( this->len != sizeof( this->done ) ) {
+			break;
+		}
+
+		memcpy( &this->sum, this->buf, sizeof( this->sum ) );
+
+		if ( this->sum != this->done + 1 ) {
+			break;
+		}
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+MM_COROUTINE( echo_server, struct mm_sched_task *task ) {
+	struct peer *this = MM_SCHED_CONTAINER( task, struct peer, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( ;; ) {
+		MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+		this->len = mm_reactor_read( &this->io, this->buf, sizeof( this->sum ) );
+
+		if ( this->len < 0 && errno == EAGAIN ) {
+			continue;
+		}
+
+		if ( this->len != sizeof( this->sum ) ) {
+			break;
+		}
+
+		memcpy( &this->sum, this->buf, sizeof( this->sum ) );
+		++this->sum;
+		memcpy( this->buf, &this->sum, sizeof( this->sum ) );
+		++this->done;
+
+		MM_CO_AWAIT_WRITABLE( &this->co, task, &this->io );
+
+		if ( mm_reactor_write( &this->io, this->buf, sizeof( this->sum ) ) != sizeof( this->sum ) ) {
+			break;
+		}
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( socketpair_case, setup, teardown ) {
+	int fds[ 2 ];
+
+	MM_UNIT_ASSERT_EQ( socketpair( AF_UNIX, SOCK_STREAM, 0, fds ), 0 );
+	MM_UNIT_ASSERT_EQ( start( fds, echo_client, echo_server ), true );
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].done, ECHO_ROUNDS );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].done, ECHO_ROUNDS );
+
+	return MM_UNIT_DONE;
+}
+
+struct listener {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_reactor_fd io;
+	int fd;
+};
+
+static struct listener listener;
+
+// accepts a single connection and hands it to an echo server
+MM_COROUTINE( acceptor, struct mm_sched_task *task ) {
+	struct listener *this = MM_SCHED_CONTAINER( task, struct listener, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	do {
+		MM_CO_AWAIT_READABLE( &this->co, task, &this->io );
+		this->fd = accept( this->io.fd, NULL, NULL );
+
+		if ( this->fd < 0 && errno == EAGAIN ) {
+			mm_reactor_again( &this->io, MM_REACTOR_READABLE );
+		}
+	} while ( this->fd < 0 && errno == EAGAIN );
+
+	if ( this->fd >= 0 && set_nonblocking( this->fd ) && mm_reactor_add( &reactor, &peers[ 1 ].io, this->fd ) ) {
+		MM_CO_INIT( &peers[ 1 ].co );
+		mm_sched_spawn( &reactor.sched, &peers[ 1 ].task, echo_server );
+	}
+
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( loopback_case, setup, teardown ) {
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = 0 };
+	socklen_t addr_len = sizeof( addr );
+	int server = socket( AF_INET, SOCK_STREAM, 0 );
+	int client = socket( AF_INET, SOCK_STREAM, 0 );
+
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	MM_UNIT_ASSERT_NOT_EQ( server, -1 );
+	MM_UNIT_ASSERT_NOT_EQ( client, -1 );
+	MM_UNIT_ASSERT_EQ( bind( server, ( struct sockaddr* ) &addr, sizeof( addr ) ), 0 );
+	MM_UNIT_ASSERT_EQ( listen( server, 16 ), 0 );
+	MM_UNIT_ASSERT_EQ( getsockname( server, ( struct sockaddr* ) &addr, &addr_len ), 0 );
+	MM_UNIT_ASSERT_EQ( set_nonblocking( server ), true );
+	MM_UNIT_ASSERT_EQ( set_nonblocking( client ), true );
+
+	// the non blocking connect completes once the client turns writable
+	MM_UNIT_ASSERT_EQ( connect( client, ( struct sockaddr* ) &addr, sizeof( addr ) ) == 0 || errno == EINPROGRESS, true );
+
+	memset( peers, 0, sizeof( peers ) );
+	MM_CO_INIT( &listener.co );
+	MM_CO_INIT( &peers[ 0 ].co );
+	MM_UNIT_ASSERT_EQ( mm_reactor_add( &reactor, &listener.io, server ), true );
+	MM_UNIT_ASSERT_EQ( mm_reactor_add( &reactor, &peers[ 0 ].io, client ), true );
+	mm_sched_spawn( &reactor.sched, &listener.task, acceptor );
+	mm_sched_spawn( &reactor.sched, &peers[ 0 ].task, echo_client );
+
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+	MM_UNIT_ASSERT_EQ( peers[ 0 ].done, ECHO_ROUNDS );
+	MM_UNIT_ASSERT_EQ( peers[ 1 ].done, ECHO_ROUNDS );
+
+	return MM_UNIT_DONE;
+}
+
+struct notified {
+	struct mm_sched_task task;
+	struct mm_co co;
+	size_t seen;
+};
+
+#define NOTIFY_COUNT 10000
+
+static atomic_size_t posted;
+static struct notified notified;
+
+static int notifier( void *arg ) {
+	( void ) arg;
+
+	for ( size_t i = 0; i < NOTIFY_COUNT; ++i ) {
+		atomic_fetch_add( &posted, 1 );
+		mm_reactor_notify( &reactor );
+
+		if ( i % 128 == 0 ) {
+			thrd_yield();
+		}
+	}
+
+	return 0;
+}
+
+// every post is eventually seen, no matter how the notifies were coalesced
+MM_COROUTINE( notify_waiter, struct mm_sched_task *task ) {
+	struct notified *this = MM_SCHED_CONTAINER( task, struct notified, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	while ( this->seen < NOTIFY_COUNT ) {
+		MM_SCHED_AWAIT_UNTIL( &this->co, task, &reactor.notified, atomic_load( &posted ) > this->seen );
+		this->seen = atomic_load( &posted );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( notify_case, setup, teardown ) {
+	thrd_t thread;
+
+	atomic_store( &posted, 0 );
+	notified.seen = 0;
+	MM_CO_INIT( &notified.co );
+	mm_sched_spawn( &reactor.sched, &notified.task, notify_waiter );
+
+	MM_UNIT_ASSERT_EQ( thrd_create( &thread, notifier, NULL ), thrd_success );
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+	thrd_join( thread, NULL );
+	MM_UNIT_ASSERT_EQ( notified.seen, NOTIFY_COUNT );
+
+	return MM_UNIT_DONE;
+}
+
+struct sleeper {
+	struct mm_sched_task task;
+	struct mm_co co;
+	struct mm_reactor_timer timer;
+	struct mm_reactor_fd io;
+	uint_least64_t woke;
+	bool timed_out;
+};
+
+static struct sleeper sleepers[ 3 ];
+
+MM_COROUTINE( sleeper, struct mm_sched_task *task ) {
+	struct sleeper *this = MM_SCHED_CONTAINER( task, struct sleeper, task );
+
+	MM_CO_BEGIN( &this->co );
+	MM_CO_SLEEP( &this->co, &this->timer, 20 * ( size_t ) ( this - sleepers ) );
+	this->woke = mm_reactor_now();
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( sleep_case, setup, teardown ) {
+	uint_least64_t start = mm_reactor_now();
+
+	for ( size_t i = 0; i < MM_ARR_SIZE( sleepers ); ++i ) {
+		MM_CO_INIT( &sleepers[ i ].co );
+		mm_reactor_timer_init( &sleepers[ i ].timer, &reactor, &sleepers[ i ].task );
+		mm_sched_spawn( &reactor.sched, &sleepers[ i ].task, sleeper );
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+
+	// each task slept at least as long as asked, and they woke in order of their deadlines
+	for ( size_t i = 0; i < MM_ARR_SIZE( sleepers ); ++i ) {
+		MM_UNIT_ASSERT_LESS( start + 20 * i - 1, sleepers[ i ].woke );
+		MM_UNIT_ASSERT_EQ( sleepers[ i ].timer.expired, true );
+	}
+
+	MM_UNIT_ASSERT_LESS( sleepers[ 1 ].woke - 1, sleepers[ 2 ].woke );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &reactor.timers ), 0 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_COROUTINE( timeout_reader, struct mm_sched_task *task ) {
+	struct sleeper *this = MM_SCHED_CONTAINER( task, struct sleeper, task );
+
+	MM_CO_BEGIN( &this->co );
+	MM_CO_AWAIT_READABLE_TIMEOUT( &this->co, &this->timer, &this->io, 30 );
+	this->timed_out = this->timer.expired;
+	this->woke = mm_reactor_now();
+	mm_reactor_del( &reactor, &this->io );
+	close( this->io.fd );
+	MM_CO_END( &this->co );
+}
+
+// one pipe gets data before its deadline, the other one never does
+MM_UNIT_CASE( timeout_case, setup, teardown ) {
+	uint_least64_t start = mm_reactor_now();
+	int fds[ 2 ][ 2 ];
+
+	for ( size_t i = 0; i < 2; ++i ) {
+		MM_UNIT_ASSERT_EQ( pipe( fds[ i ] ), 0 );
+		MM_UNIT_ASSERT_EQ( set_nonblocking( fds[ i ][ 0 ] ), true );
+		MM_CO_INIT( &sleepers[ i ].co );
+		MM_UNIT_ASSERT_EQ( mm_reactor_add( &reactor, &sleepers[ i ].io, fds[ i ][ 0 ] ), true );
+		mm_reactor_timer_init( &sleepers[ i ].timer, &reactor, &sleepers[ i ].task );
+		mm_sched_spawn( &reactor.sched, &sleepers[ i ].task, timeout_reader );
+	}
+
+	MM_UNIT_ASSERT_EQ( write( fds[ 0 ][ 1 ], "x", 1 ), 1 );
+	MM_UNIT_ASSERT_EQ( mm_reactor_run( &reactor ), true );
+	MM_UNIT_ASSERT_EQ( sleepers[ 0 ].timed_out, false );
+	MM_UNIT_ASSERT_EQ( sleepers[ 1 ].timed_out, true );
+	MM_UNIT_ASSERT_LESS( start + 29, sleepers[ 1 ].woke );
+
+	// the satisfied wait cancelled its timer
+	MM_UNIT_ASSERT_EQ( mm_timer_pending( &sleepers[ 0 ].timer.timer ), false );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &reactor.timers ), 0 );
+	close( fds[ 0 ][ 1 ] );
+	close( fds[ 1 ][ 1 ] );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( reactor_suite ) {
+	MM_UNIT_RUN( pipe_case );
+	MM_UNIT_RUN( socketpair_case );
+	MM_UNIT_RUN( loopback_case );
+	MM_UNIT_RUN( notify_case );
+	MM_UNIT_RUN( sleep_case );
+	MM_UNIT_RUN( timeout_case );
+
+	return MM_UNIT_DONE;
+}
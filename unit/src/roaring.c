@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mm/bitset.h"
+#include "mm/endian.h"
+#include "mm/random.h"
+#include "mm/roaring.h"
+#include "mm/unit.h"
+
+// 16 containers
+#define UNIVERSE ( 1u << 20 )
+
+// a random container shape per key: empty, a handful, sparse, dense, long runs, short runs and right at the array limit
+static bool generate( struct mm_roaring *rb, struct mm_bitset *bs, struct mm_random *r ) {
+	mm_roaring_init( rb );
+
+	if ( !mm_bitset_init( bs, UNIVERSE ) ) {
+		return false;
+	}
+
+	for ( uint_least32_t key = 0; key < UNIVERSE >> 16; ++key ) {
+		unsigned long shape = mm_random_next( r, 0, 7 );
+		uint_least32_t shift = ( uint_least32_t ) mm_random_next( r, 0, 4096 );
+
+		for ( uint_least32_t low = 0; low < 65536; ++low ) {
+			bool set;
+
+			switch ( shape ) {
+			case 0: set = false; break;
+			case 1: set = mm_random_next( r, 0, 8192 ) == 0; break;
+			case 2: set = mm_random_next( r, 0, 256 ) == 0; break;
+			case 3: set = mm_random_next( r, 0, 2 ) == 0; break;
+			case 4: set = ( ( low + shift ) >> 11 ) % 3 == 0; break;
+			case 5: set = ( low + shift ) % 4096 < 64; break;
+			default: set = low % 16 == 0; break;
+			}
+
+			if ( set ) {
+				mm_bitset_set( bs, key << 16 | low );
+
+				if ( !mm_roaring_add( rb, key << 16 | low ) ) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+static struct mm_unit_err same( const struct mm_roaring *rb, const struct mm_bitset *bs ) {
+	size_t count = mm_bitset_count( bs );
+	uint_least32_t *values = malloc( sizeof( *values ) * ( count + 1 ) );
+	size_t i = 0;
+	size_t bit;
+
+	MM_UNIT_ASSERT( values, "malloc failed" );
+	MM_UNIT_ASSERT_EQ( count, mm_roaring_cardinality( rb ) );
+	MM_UNIT_ASSERT_EQ( count, mm_roaring_to_array( rb, values ) );
+
+	MM_BITSET_FOR_EACH( bs, bit ) {
+		if ( values[ i++ ] != bit ) {
+			free( values );
+			MM_UNIT_ASSERT( false, "values differ" );
+		}
+	}
+
+	free( values );
+
+	for ( size_t c = 0; c < rb->size; ++c ) {
+		MM_UNIT_ASSERT( rb->containers[ c ].cardinality, "empty container kept" );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( roaring_edit_case, NULL, NULL ) {
+	struct mm_roaring rb;
+	struct mm_bitset bs;
+	struct mm_random r;
+	struct mm_unit_err err;
+
+	mm_random_reset( &r, 42 );
+	mm_roaring_init( &rb );
+	MM_UNIT_ASSERT( !mm_roaring_contains( &rb, 7 ), "empty set contains 7" );
+	MM_UNIT_ASSERT( mm_roaring_remove( &rb, 7 ), "remove from empty failed" );
+	MM_UNIT_ASSERT( mm_roaring_add( &rb, UINT32_MAX ) && mm_roaring_add( &rb, 0 ), "add failed" );
+	MM_UNIT_ASSERT( mm_roaring_contains( &rb, UINT32_MAX ) && mm_roaring_contains( &rb, 0 ), "extremes missing" );
+	MM_UNIT_ASSERT_EQ( 2, mm_roaring_cardinality( &rb ) );
+	mm_roaring_destroy( &rb );
+
+	MM_UNIT_ASSERT( generate( &rb, &bs, &r ), "generate failed" );
+
+	// random edits on every shape, first with runs made from the generated shapes, then from what the edits left
+	for ( int round = 0; round < 2; ++round ) {
+		MM_UNIT_ASSERT( mm_roaring_optimize( &rb ), "optimize failed" );
+		err = same( &rb, &bs );
+
+		for ( int i = 0; i < 200000 && !err.err; ++i ) {
+			uint_least32_t value = ( uint_least32_t ) mm_random_next( &r, 0, UNIVERSE );
+
+			if ( mm_random_next( &r, 0, 2 ) ) {
+				mm_bitset_set( &bs, value );
+				MM_UNIT_ASSERT( mm_roaring_add( &rb, value ), "add failed" );
+			} else {
+				mm_bitset_clear( &bs, value );
+				MM_UNIT_ASSERT( mm_roaring_remove( &rb, value ), "remove failed" );
+			}
+
+			MM_UNIT_ASSERT_EQ( mm_bitset_test( &bs, value ), mm_roaring_contains( &rb, value ) );
+		}
+
+		if ( err.err || ( err = same( &rb, &bs ) ).err ) {
+			break;
+		}
+	}
+
+	// emptying a dense container one value at a time
+	for ( uint_least32_t i = 0; i < 65536 && !err.err; ++i ) {
+		mm_bitset_clear( &bs, 2 << 16 | i );
+		MM_UNIT_ASSERT( mm_roaring_remove( &rb, 2 << 16 | i ), "remove failed" );
+	}
+
+	if ( !err.err ) {
+		err = same( &rb, &bs );
+	}
+
+	mm_roaring_destroy( &rb );
+	mm_bitset_destroy( &bs );
+
+	return err;
+}
+
+// every pair of containers shapes, with and without runs, against the same operation on bitsets
+MM_UNIT_CASE( roaring_ops_case, NULL, NULL ) {
+	struct mm_roaring a, b, result;
+	struct mm_bitset x, y, expected;
+	struct mm_random r;
+	struct mm_unit_err err = MM_UNIT_DONE;
+
+	mm_random_reset( &r, 42 );
+
+	for ( int round = 0; round < 16 && !err.err; ++round ) {
+		MM_UNIT_ASSERT( generate( &a, &x, &r ) && generate( &b, &y, &r ), "generate failed" );
+
+		if ( round & 1 ) {
+			MM_UNIT_ASSERT( mm_roaring_optimize( &a ), "optimize failed" );
+		}
+
+		if ( round & 2 ) {
+			MM_UNIT_ASSERT( mm_roaring_optimize( &b ), "optimize failed" );
+		}
+
+		for ( int op = 0; op < 3 && !err.err; ++op ) {
+			bool made;
+			uint_least64_t cardinality;
+
+			MM_UNIT_ASSERT( mm_bitset_copy( &expected, &x ), "bitset copy failed" );
+
+			switch ( op ) {
+			case 0:
+				mm_bitset_and( &expected, &y );
+				made = mm_roaring_and( &result, &a, &b );
+				cardinality = mm_roaring_and_cardinality( &a, &b );
+				break;
+			case 1:
+				mm_bitset_or( &expected, &y );
+				made = mm_roaring_or( &result, &a, &b );
+				cardinality = mm_roaring_or_cardinality( &a, &b );
+				break;
+			default:
+				mm_bitset_andnot( &expected, &y );
+				made = mm_roaring_andnot( &result, &a, &b );
+				cardinality = mm_roaring_andnot_cardinality( &a, &b );
+				break;
+			}
+
+			MM_UNIT_ASSERT( made, "operation failed" );
+			MM_UNIT_ASSERT_EQ( mm_bitset_count( &expected ), cardinality );
+			err = same( &result, &expected );
+			mm_roaring_destroy( &result );
+			mm_bitset_destroy( &expected );
+		}
+
+		mm_roaring_destroy( &a );
+		mm_roaring_destroy( &b );
+		mm_bitset_destroy( &x );
+		mm_bitset_destroy( &y );
+	}
+
+	return err;
+}
+
+MM_UNIT_CASE( roaring_serialize_case, NULL, NULL ) {
+	struct mm_roaring rb, copy;
+	struct mm_bitset bs;
+	struct mm_random r;
+	struct mm_unit_err err;
+	uint_least32_t header[ 2 ];
+	uint_least64_t *buf;
+	size_t size;
+
+	mm_random_reset( &r, 42 );
+	MM_UNIT_ASSERT( generate( &rb, &bs, &r ), "generate failed" );
+	MM_UNIT_ASSERT( mm_roaring_optimize( &rb ), "optimize failed" );
+	size = mm_roaring_serialized_size( &rb );
+	buf = malloc( size + 8 );
+	MM_UNIT_ASSERT( buf, "malloc failed" );
+	MM_UNIT_ASSERT_EQ( size, mm_roaring_serialize( &rb, buf ) );
+
+	// the header is little endian whatever the host
+	memcpy( header, buf, sizeof( header ) );
+	MM_UNIT_ASSERT_EQ( 0x31524d4d, mm_le_to_host_32( header[ 0 ] ) );
+	MM_UNIT_ASSERT_EQ( rb.size, mm_le_to_host_32( header[ 1 ] ) );
+
+	MM_UNIT_ASSERT( mm_roaring_deserialize( &copy, buf, size ), "deserialize failed" );
+	err = same( &copy, &bs );
+	mm_roaring_destroy( &copy );
+
+#ifdef MM_LITTLE_ENDIAN
+	if ( !err.err ) {
+		struct mm_roaring other;
+
+		MM_UNIT_ASSERT( mm_roaring_view( &copy, buf, size ), "view failed" );
+		MM_UNIT_ASSERT( copy.frozen, "view not frozen" );
+		MM_UNIT_ASSERT( ( unsigned char* ) copy.containers[ 0 ].data < ( unsigned char* ) buf + size, "view copied" );
+		err = same( &copy, &bs );
+
+		// a view works as an operand like any other set
+		MM_UNIT_ASSERT( mm_roaring_and( &other, &copy, &rb ), "and failed" );
+		MM_UNIT_ASSERT_EQ( mm_roaring_cardinality( &rb ), mm_roaring_cardinality( &other ) );
+		mm_roaring_destroy( &other );
+
+		// and copies into a set that can be edited
+		MM_UNIT_ASSERT( mm_roaring_copy( &other, &copy ), "copy failed" );
+		MM_UNIT_ASSERT( !other.frozen && mm_roaring_add( &other, UNIVERSE ), "add to copy failed" );
+		MM_UNIT_ASSERT_EQ( mm_roaring_cardinality( &copy ) + 1, mm_roaring_cardinality( &other ) );
+		mm_roaring_destroy( &other );
+		mm_roaring_destroy( &copy );
+		MM_UNIT_ASSERT( !mm_roaring_view( &copy, ( unsigned char* ) buf + 2, size ), "misaligned view accepted" );
+	}
+#endif
+
+	// cut short anywhere but the padding, or with a header field changed, it is rejected rather than read out of bounds
+	for ( size_t cut = 0; cut + 8 <= size && !err.err; cut += 1 + cut / 8 ) {
+		MM_UNIT_ASSERT( !mm_roaring_deserialize( &copy, buf, cut ), "truncated buffer accepted" );
+	}
+
+	( ( unsigned char* ) buf )[ 0 ] ^= 1;
+	MM_UNIT_ASSERT( !mm_roaring_deserialize( &copy, buf, size ), "wrong magic accepted" );
+	( ( unsigned char* ) buf )[ 0 ] ^= 1;
+	( ( unsigned char* ) buf )[ 8 + 4 ] ^= 1;
+	MM_UNIT_ASSERT( !mm_roaring_deserialize( &copy, buf, size ), "wrong cardinality accepted" );
+
+	free( buf );
+	mm_roaring_destroy( &rb );
+	mm_bitset_destroy( &bs );
+
+	return err;
+}
+
+MM_UNIT_SUITE( roaring_suite ) {
+	MM_UNIT_RUN( roaring_edit_case );
+	MM_UNIT_RUN( roaring_ops_case );
+	MM_UNIT_RUN( roaring_serialize_case );
+	return MM_UNIT_DONE;
+}
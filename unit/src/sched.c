@@ -0,0 +1,198 @@
+#include "mm/sched.h"
+#include "mm/unit.h"
+
+#define TASKS 4
+#define ROUNDS 3
+
+struct worker {
+	struct mm_sched_task task;
+	struct mm_co co;
+	unsigned int id;
+	unsigned int round;
+};
+
+static struct mm_sched sched;
+static struct worker workers[ TASKS ];
+static unsigned int trace[ TASKS * ( ROUNDS + 1 ) ];
+static size_t traced;
+static size_t retired;
+
+static void retire( struct mm_sched_task *task, void *ctx ) {
+	( void ) task;
+	( void ) ctx;
+	++retired;
+}
+
+MM_COROUTINE( yielder, struct mm_sched_task *task ) {
+	struct worker *this = MM_SCHED_CONTAINER( task, struct worker, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->round = 0; this->round < ROUNDS; ++this->round ) {
+		trace[ traced++ ] = this->id;
+		MM_CO_YIELD( &this->co );
+	}
+
+	MM_CO_END( &this->co );
+}
+
+static void spawn( mm_sched_func_t func ) {
+	mm_sched_init( &sched, retire, NULL );
+	traced = 0;
+	retired = 0;
+
+	for ( unsigned int i = 0; i < TASKS; ++i ) {
+		workers[ i ].id = i;
+		MM_CO_INIT( &workers[ i ].co );
+		mm_sched_spawn( &sched, &workers[ i ].task, func );
+	}
+}
+
+MM_UNIT_CASE( round_robin_case, NULL, NULL ) {
+	spawn( yielder );
+	MM_UNIT_ASSERT_EQ( sched.count, TASKS );
+	MM_UNIT_ASSERT_EQ( mm_sched_run( &sched ), TASKS * ( ROUNDS + 1 ) );
+
+	// every task gets one step per round, in spawn order
+	MM_UNIT_ASSERT_EQ( traced, TASKS * ROUNDS );
+
+	for ( size_t i = 0; i < traced; ++i ) {
+		MM_UNIT_ASSERT_EQ( trace[ i ], i % TASKS );
+	}
+
+	MM_UNIT_ASSERT_EQ( sched.count, 0 );
+	MM_UNIT_ASSERT_EQ( retired, TASKS );
+	MM_UNIT_ASSERT_EQ( mm_sched_step( &sched ), false );
+
+	return MM_UNIT_DONE;
+}
+
+static struct mm_sched_event event;
+static unsigned int tokens;
+
+MM_COROUTINE( waiter, struct mm_sched_task *task ) {
+	struct worker *this = MM_SCHED_CONTAINER( task, struct worker, task );
+
+	MM_CO_BEGIN( &this->co );
+	MM_SCHED_AWAIT( &this->co, task, &event );
+	trace[ traced++ ] = this->id;
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( event_case, NULL, NULL ) {
+	spawn( waiter );
+	mm_sched_event_init( &event );
+
+	// everything parks, nothing is left to run but nothing finished either
+	MM_UNIT_ASSERT_EQ( mm_sched_run( &sched ), TASKS );
+	MM_UNIT_ASSERT_EQ( mm_sched_event_has_waiters( &event ), true );
+	MM_UNIT_ASSERT_EQ( sched.count, TASKS );
+	MM_UNIT_ASSERT_EQ( traced, 0 );
+
+	MM_UNIT_ASSERT_EQ( mm_sched_event_signal( &sched, &event ), true );
+	MM_UNIT_ASSERT_EQ( mm_sched_run( &sched ), 1 );
+	MM_UNIT_ASSERT_EQ( traced, 1 );
+	MM_UNIT_ASSERT_EQ( trace[ 0 ], 0 );
+
+	// the rest wake in the order they parked
+	mm_sched_event_broadcast( &sched, &event );
+	MM_UNIT_ASSERT_EQ( mm_sched_event_has_waiters( &event ), false );
+	MM_UNIT_ASSERT_EQ( mm_sched_run( &sched ), TASKS - 1 );
+	MM_UNIT_ASSERT_EQ( traced, TASKS );
+
+	for ( size_t i = 0; i < TASKS; ++i ) {
+		MM_UNIT_ASSERT_EQ( trace[ i ], i );
+	}
+
+	MM_UNIT_ASSERT_EQ( retired, TASKS );
+	MM_UNIT_ASSERT_EQ( mm_sched_event_signal( &sched, &event ), false );
+
+	return MM_UNIT_DONE;
+}
+
+MM_COROUTINE( consumer, struct mm_sched_task *task ) {
+	struct worker *this = MM_SCHED_CONTAINER( task, struct worker, task );
+
+	MM_CO_BEGIN( &this->co );
+
+	for ( this->round = 0; this->round < ROUNDS; ++this->round ) {
+		MM_SCHED_AWAIT_UNTIL( &this->co, task, &event, tokens > 0 );
+		--tokens;
+		trace[ traced++ ] = this->id;
+	}
+
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( await_until_case, NULL, NULL ) {
+	spawn( consumer );
+	mm_sched_event_init( &event );
+	tokens = 2;
+
+	// two tokens get consumed without parking, then everyone waits
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( traced, 2 );
+	MM_UNIT_ASSERT_EQ( tokens, 0 );
+
+	// a spurious wake rechecks the condition and parks again
+	mm_sched_event_broadcast( &sched, &event );
+	mm_sched_run( &sched );
+	MM_UNIT_ASSERT_EQ( traced, 2 );
+
+	while ( sched.count ) {
+		++tokens;
+		mm_sched_event_signal( &sched, &event );
+		mm_sched_run( &sched );
+	}
+
+	MM_UNIT_ASSERT_EQ( traced, TASKS * ROUNDS );
+	MM_UNIT_ASSERT_EQ( tokens, 0 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_COROUTINE( parker, struct mm_sched_task *task ) {
+	struct worker *this = MM_SCHED_CONTAINER( task, struct worker, task );
+
+	MM_CO_BEGIN( &this->co );
+	MM_SCHED_PARK( &this->co, task );
+	trace[ traced++ ] = this->id;
+	MM_CO_YIELD_UNTIL( &this->co, tokens == TASKS );
+	MM_CO_END( &this->co );
+}
+
+MM_UNIT_CASE( park_wake_case, NULL, NULL ) {
+	spawn( parker );
+	tokens = 0;
+	MM_UNIT_ASSERT_EQ( mm_sched_run( &sched ), TASKS );
+
+	for ( unsigned int i = TASKS; i-- > 0; ) {
+		mm_sched_wake( &sched, &workers[ i ].task );
+	}
+
+	// yield until keeps them cycling until the condition holds
+	for ( size_t i = 0; i < TASKS * 3; ++i ) {
+		MM_UNIT_ASSERT_EQ( mm_sched_step( &sched ), true );
+	}
+
+	MM_UNIT_ASSERT_EQ( retired, 0 );
+	tokens = TASKS;
+	mm_sched_run( &sched );
+
+	for ( size_t i = 0; i < TASKS; ++i ) {
+		MM_UNIT_ASSERT_EQ( trace[ i ], TASKS - 1 - i );
+	}
+
+	MM_UNIT_ASSERT_EQ( retired, TASKS );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( sched_suite ) {
+	MM_UNIT_RUN( round_robin_case );
+	MM_UNIT_RUN( event_case );
+	MM_UNIT_RUN( await_until_case );
+	MM_UNIT_RUN( park_wake_case );
+
+	return MM_UNIT_DONE;
+}
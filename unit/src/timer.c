@@ -0,0 +1,160 @@
+#include "mm/random.h"
+#include "mm/timer.h"
+#include "mm/unit.h"
+
+#define TIMERS 10000
+
+struct entry {
+	struct mm_timer timer;
+	uint_least64_t fired_at; //!< \brief wheel tick when the callback ran, 0 if it didn't
+	unsigned int fires;
+};
+
+static struct mm_timer_wheel wheel;
+static struct entry entries[ TIMERS ];
+static uint_least64_t last_expires;
+static bool out_of_order;
+
+static void on_expire( struct mm_timer *timer ) {
+	struct entry *entry = MM_TIMER_CONTAINER( timer, struct entry, timer );
+
+	out_of_order |= timer->expires < last_expires;
+	last_expires = timer->expires;
+	entry->fired_at = wheel.now;
+	++entry->fires;
+}
+
+static bool setup( void ) {
+	for ( size_t i = 0; i < TIMERS; ++i ) {
+		mm_timer_init( &entries[ i ].timer, on_expire );
+		entries[ i ].fired_at = 0;
+		entries[ i ].fires = 0;
+	}
+
+	last_expires = 0;
+	out_of_order = false;
+
+	return true;
+}
+
+// expiries spread from the next tick to beyond the range of the levels, advanced in uneven steps
+MM_UNIT_CASE( expiry_case, setup, NULL ) {
+	static const uint_least64_t ranges[] = { 10, 1000, 100000, 100000000, ( uint_least64_t ) 1 << 40 };
+	struct mm_random r;
+	uint_least64_t start = 123456789, now = start, end = 0;
+	size_t cancelled = 0, fired = 0;
+
+	mm_random_reset( &r, 7 );
+	mm_timer_wheel_init( &wheel, start );
+
+	for ( size_t i = 0; i < TIMERS; ++i ) {
+		uint_least64_t range = ranges[ i % MM_ARR_SIZE( ranges ) ];
+		uint_least64_t delta = ( ( uint_least64_t ) mm_random_next( &r, 0, 1ul << 31 ) << 31 | mm_random_next( &r, 0, 1ul << 31 ) ) % range;
+
+		mm_timer_add( &wheel, &entries[ i ].timer, start + 1 + delta );
+		end = start + 1 + delta > end ? start + 1 + delta : end;
+	}
+
+	// moving a pending timer counts once
+	mm_timer_add( &wheel, &entries[ 0 ].timer, start + 5 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &wheel ), TIMERS );
+
+	for ( size_t i = 0; i < TIMERS; i += 7 ) {
+		mm_timer_cancel( &wheel, &entries[ i ].timer );
+		mm_timer_cancel( &wheel, &entries[ i ].timer );
+		MM_UNIT_ASSERT_EQ( mm_timer_pending( &entries[ i ].timer ), false );
+		++cancelled;
+	}
+
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &wheel ), TIMERS - cancelled );
+
+	while ( now < end ) {
+		uint_least64_t next = mm_timer_wheel_next( &wheel );
+		uint_least64_t step = mm_random_next( &r, 1, 1000 );
+
+		MM_UNIT_ASSERT_LESS( now, next );
+
+		// big jumps to whatever comes next, so the far timers don't take forever
+		now = next - now > step ? next : now + step;
+		fired += mm_timer_wheel_advance( &wheel, now );
+	}
+
+	MM_UNIT_ASSERT_EQ( fired, TIMERS - cancelled );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &wheel ), 0 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_next( &wheel ), UINT_LEAST64_MAX );
+	MM_UNIT_ASSERT_EQ( out_of_order, false );
+
+	for ( size_t i = 0; i < TIMERS; ++i ) {
+		if ( i % 7 == 0 ) {
+			MM_UNIT_ASSERT_EQ( entries[ i ].fires, 0 );
+			continue;
+		}
+
+		// the wheel only moves in steps, but never fires early nor later than the step that crossed the expiry
+		MM_UNIT_ASSERT_EQ( entries[ i ].fires, 1 );
+		MM_UNIT_ASSERT_EQ( entries[ i ].fired_at, entries[ i ].timer.expires );
+	}
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_CASE( next_case, setup, NULL ) {
+	mm_timer_wheel_init( &wheel, 1000 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_next( &wheel ), UINT_LEAST64_MAX );
+
+	// already passed, fires on the next advance even without moving
+	mm_timer_add( &wheel, &entries[ 0 ].timer, 10 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_next( &wheel ), 1000 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_advance( &wheel, 1000 ), 1 );
+	MM_UNIT_ASSERT_EQ( entries[ 0 ].fired_at, 1000 );
+
+	mm_timer_add( &wheel, &entries[ 1 ].timer, 1010 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_next( &wheel ), 1010 );
+
+	// a far timer only reports when it gets moved down, which is never later than its expiry
+	mm_timer_cancel( &wheel, &entries[ 1 ].timer );
+	mm_timer_add( &wheel, &entries[ 2 ].timer, 1000000 );
+	MM_UNIT_ASSERT_LESS( mm_timer_wheel_next( &wheel ), 1000001 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_advance( &wheel, 999999 ), 0 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_next( &wheel ), 1000000 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_advance( &wheel, 5000000 ), 1 );
+	MM_UNIT_ASSERT_EQ( entries[ 2 ].fired_at, 1000000 );
+	MM_UNIT_ASSERT_EQ( wheel.now, 5000000 );
+
+	return MM_UNIT_DONE;
+}
+
+static unsigned int periodic_left;
+
+static void periodic( struct mm_timer *timer ) {
+	if ( --periodic_left ) {
+		mm_timer_add( &wheel, timer, timer->expires + 3 );
+	}
+
+	// cancelling a timer of the same batch keeps it from firing
+	mm_timer_cancel( &wheel, &entries[ 1 ].timer );
+}
+
+MM_UNIT_CASE( rearm_case, setup, NULL ) {
+	mm_timer_wheel_init( &wheel, 0 );
+	mm_timer_init( &entries[ 0 ].timer, periodic );
+	periodic_left = 10;
+	mm_timer_add( &wheel, &entries[ 0 ].timer, 3 );
+	mm_timer_add( &wheel, &entries[ 1 ].timer, 3 );
+
+	// every rearm lands within the advanced range, so one call runs them all
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_advance( &wheel, 30 ), 10 );
+	MM_UNIT_ASSERT_EQ( periodic_left, 0 );
+	MM_UNIT_ASSERT_EQ( entries[ 1 ].fires, 0 );
+	MM_UNIT_ASSERT_EQ( mm_timer_wheel_size( &wheel ), 0 );
+
+	return MM_UNIT_DONE;
+}
+
+MM_UNIT_SUITE( timer_suite ) {
+	MM_UNIT_RUN( expiry_case );
+	MM_UNIT_RUN( next_case );
+	MM_UNIT_RUN( rearm_case );
+
+	return MM_UNIT_DONE;
+}